@@ -38,11 +38,25 @@ public:
     {
     }
 
-    void initialise (const juce::String&) override
+    void initialise (const juce::String& commandLine) override
     {
+#if DROWAUDIO_UNIT_TESTS
+        if (commandLine.contains ("--gui-benchmarks"))
+        {
+            runBenchmarks();
+            return;
+        }
+#endif
+
 #if JUCE_DEBUG && DROWAUDIO_UNIT_TESTS
+        juce::Array<juce::UnitTest*> tests;
+
+        for (auto* test : juce::UnitTest::getAllTests())
+            if (test->getCategory() != "Benchmarks")
+                tests.add (test);
+
         juce::UnitTestRunner testRunner;
-        testRunner.runAllTests();
+        testRunner.runTests (tests);
 #endif
        
         mainWindow = std::make_unique<MainAppWindow>(); 
@@ -62,6 +76,24 @@ public:
 private:
     std::unique_ptr<MainAppWindow> mainWindow;
 
+#if DROWAUDIO_UNIT_TESTS
+    /** Runs the headless gui rendering benchmarks and quits, used by the CI builds. */
+    void runBenchmarks()
+    {
+        juce::UnitTestRunner testRunner;
+        testRunner.setAssertOnFailure (false);
+        testRunner.runTestsInCategory ("Benchmarks");
+
+        int numFailures = 0;
+
+        for (int i = 0; i < testRunner.getNumResults(); ++i)
+            numFailures += testRunner.getResult (i)->failures;
+
+        setApplicationReturnValue (numFailures > 0 ? 1 : 0);
+        quit();
+    }
+#endif
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (dRowAudioDemoApplication)
 };
 
@@ -55,9 +55,15 @@ MainComponent::MainComponent()
                             new AudioPlaybackDemo (audioFilePlayer, bufferTransformAudioSource),
                             true);
 
-    const juce::File libraryFile (juce::File::getSpecialLocation (juce::File::userDesktopDirectory).getChildFile ("dRowAudio Demo Library.xml"));
-    juce::ValueTree libraryTree (readValueTreeFromFile (libraryFile));
-    ITunesLibrary::getInstance()->setLibraryTree (libraryTree);
+    const juce::File desktop (juce::File::getSpecialLocation (juce::File::userDesktopDirectory));
+
+    if (! ITunesLibrary::getInstance()->setSnapshotFile (desktop.getChildFile ("dRowAudio Demo Library.snapshot")))
+    {
+        // fall back to a library saved as XML by older versions of the demo
+        juce::ValueTree libraryTree (readValueTreeFromFile (desktop.getChildFile ("dRowAudio Demo Library.xml")));
+        ITunesLibrary::getInstance()->setLibraryTree (libraryTree);
+    }
+
     ITunesLibrary::getInstance()->setLibraryFile (ITunesLibrary::getDefaultITunesLibraryFile());
     MusicLibraryTable* musicLibraryTable = new MusicLibraryTable();
     musicLibraryTable->setLibraryToUse (ITunesLibrary::getInstance());
@@ -134,10 +140,6 @@ MainComponent::~MainComponent()
 
     audioSourcePlayer.setSource (nullptr);
     audioDeviceManager.removeAudioCallback (this);
-
-    const juce::File libraryFile (juce::File::getSpecialLocation (juce::File::userDesktopDirectory).getChildFile ("dRowAudio Demo Library.xml"));
-    juce::ValueTree libraryTree (ITunesLibrary::getInstance()->getLibraryTree());
-    writeValueTreeToFile (libraryTree, libraryFile);
 }
 
 void MainComponent::resized()
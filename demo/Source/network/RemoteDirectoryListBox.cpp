@@ -37,23 +37,35 @@
 RemoteDirectoryListBoxModel::RemoteDirectoryListBoxModel() :
     curlSession (nullptr)
 {
+    RemoteDirectoryCache::getInstance()->addListener (this);
+}
+
+RemoteDirectoryListBoxModel::~RemoteDirectoryListBoxModel()
+{
+    RemoteDirectoryCache::getInstance()->removeListener (this);
 }
 
 void RemoteDirectoryListBoxModel::setCURLSession (CURLEasySession* sessionToControl)
 {
     curlSession = sessionToControl;
-    setContents (curlSession->getDirectoryListing());
-    sendChangeMessage();
+
+    if (curlSession->getRemotePath().isNotEmpty())
+        showDirectory (getDirectoryUrl());
 }
 
 void RemoteDirectoryListBoxModel::refresh()
 {
-    setContents (curlSession->getDirectoryListing());
+    if (curlSession == nullptr || curlSession->getRemotePath().isEmpty())
+        return;
+
+    // the connection may have changed so this always fetches the listing again
+    RemoteDirectoryCache::getInstance()->refresh (getDirectoryUrl(), curlSession->getUserNameAndPassword());
+    showDirectory (getDirectoryUrl());
 }
 
 int RemoteDirectoryListBoxModel::getNumRows()
 {
-    return itemList.size();
+    return entries.size();
 }
 
 void RemoteDirectoryListBoxModel::paintListBoxItem (int rowNumber, juce::Graphics& g,
@@ -65,47 +77,84 @@ void RemoteDirectoryListBoxModel::paintListBoxItem (int rowNumber, juce::Graphic
         g.fillAll();
     }
 
+    const RemoteDirectoryCache::Entry entry (entries[rowNumber]);
+    const int sizeWidth = entry.isDirectory ? 0 : juce::jmin (80, width / 3);
+
     g.setColour (juce::Colours::black);
-    g.drawFittedText (itemList[rowNumber],
-                      0, 0, width, height,
+    g.drawFittedText (entry.isDirectory ? entry.filename + "/" : entry.filename,
+                      2, 0, width - sizeWidth - 4, height,
                       juce::Justification::centredLeft, 1);
-}
 
-void RemoteDirectoryListBoxModel::setContents (const juce::StringArray& newContents)
-{
-    itemList = newContents;
+    if (entry.fileSize >= 0 && ! entry.isDirectory)
+        g.drawFittedText (juce::File::descriptionOfSizeInBytes (entry.fileSize),
+                          width - sizeWidth - 2, 0, sizeWidth, height,
+                          juce::Justification::centredRight, 1);
 }
 
 void RemoteDirectoryListBoxModel::listBoxItemDoubleClicked (int row, const juce::MouseEvent& /*e*/)
 {
-    //*** Need to navigate session here
-    if (itemList[row] == "..")
-    {
-        curlSession->setRemotePath (curlSession->getRemotePath().upToLastOccurrenceOf ("/", false, false));
-        setContents (curlSession->getDirectoryListing());
-    }
+    const RemoteDirectoryCache::Entry entry (entries[row]);
+
+    if (! entry.isDirectory)
+        return;
+
+    if (entry.filename == "..")
+        curlSession->setRemotePath (RemoteDirectoryCache::getParentUrl (getDirectoryUrl()));
     else
-    {
-        if (! itemList[row].contains ("."))
-        {
-            juce::String newCWD (curlSession->getRemotePath().upToLastOccurrenceOf ("/", true, false));
-            newCWD << itemList[row] << "/";
-            curlSession->setRemotePath (newCWD);
-            setContents (curlSession->getDirectoryListing());
-        }
-    }
+        curlSession->setRemotePath (getDirectoryUrl() + entry.filename + "/");
 
-    sendChangeMessage();
+    showDirectory (getDirectoryUrl());
 }
 
 juce::var RemoteDirectoryListBoxModel::getDragSourceDescription (const juce::SparseSet<int>& currentlySelectedRows)
 {
     if (curlSession != nullptr && currentlySelectedRows.size() > 0)
-        return curlSession->getRemotePath().upToLastOccurrenceOf ("/", true, false) + itemList[currentlySelectedRows[0]];
+        return getDirectoryUrl() + entries[currentlySelectedRows[0]].filename;
 
     return juce::String();
 }
 
+//==============================================================================
+juce::String RemoteDirectoryListBoxModel::getDirectoryUrl() const
+{
+    const juce::String path (curlSession->getRemotePath());
+
+    // a bare host name is the root directory
+    if (! path.fromFirstOccurrenceOf ("://", false, false).containsChar ('/'))
+        return path + "/";
+
+    return path.upToLastOccurrenceOf ("/", true, false);
+}
+
+void RemoteDirectoryListBoxModel::showDirectory (const juce::String& directoryUrl)
+{
+    setListing (RemoteDirectoryCache::getInstance()->getListing (directoryUrl, curlSession->getUserNameAndPassword()));
+}
+
+void RemoteDirectoryListBoxModel::setListing (const RemoteDirectoryCache::Listing::Ptr& newListing)
+{
+    listing = newListing;
+    entries = listing->getEntries();
+
+    if (RemoteDirectoryCache::getParentUrl (listing->getDirectoryUrl()).isNotEmpty())
+    {
+        RemoteDirectoryCache::Entry parent;
+        parent.filename = "..";
+        parent.isDirectory = true;
+        entries.insert (0, parent);
+    }
+
+    sendChangeMessage();
+}
+
+void RemoteDirectoryListBoxModel::remoteListingChanged (const RemoteDirectoryCache::Listing::Ptr& changedListing)
+{
+    if (curlSession != nullptr
+        && changedListing->getDirectoryUrl() == getDirectoryUrl()
+        && changedListing->getResult().wasOk())
+        setListing (changedListing);
+}
+
 //==============================================================================
 RemoteDirectoryListBox::RemoteDirectoryListBox() :
     isInterestedInDrag (false)
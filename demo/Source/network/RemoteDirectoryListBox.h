@@ -37,14 +37,16 @@
 #if DROWAUDIO_USE_CURL
 
 class RemoteDirectoryListBoxModel : public juce::ListBoxModel,
-public juce::ChangeBroadcaster
+                                    public juce::ChangeBroadcaster,
+                                    private RemoteDirectoryCache::Listener
 {
 public:
     RemoteDirectoryListBoxModel();
 
+    ~RemoteDirectoryListBoxModel() override;
+
     //==============================================================================
     void setCURLSession (CURLEasySession* sessionToControl);
-    void setContents (const juce::StringArray& newContents);
 
     void refresh();
 
@@ -60,9 +62,17 @@ public:
 
 private:
     //==============================================================================
-    juce::StringArray itemList;
+    juce::Array<RemoteDirectoryCache::Entry> entries;
+    RemoteDirectoryCache::Listing::Ptr listing;
     CURLEasySession* curlSession;
 
+    juce::String getDirectoryUrl() const;
+    void showDirectory (const juce::String& directoryUrl);
+    void setListing (const RemoteDirectoryCache::Listing::Ptr& newListing);
+
+    /** @internal */
+    void remoteListingChanged (const RemoteDirectoryCache::Listing::Ptr& changedListing) override;
+
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RemoteDirectoryListBoxModel)
 };
@@ -128,6 +128,8 @@ void AudioFilePlayer::getNextAudioBlock (const AudioSourceChannelInfo& bufferToF
 {
     if (masterSource != nullptr)
         masterSource->getNextAudioBlock (bufferToFill);
+
+    renderedPosition.publish (audioTransportSource.getCurrentPosition());
 }
 
 void AudioFilePlayer::setLooping (bool shouldLoop)
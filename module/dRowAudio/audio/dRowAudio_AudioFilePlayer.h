@@ -33,6 +33,7 @@
 #define DROWAUDIO_AUDIOFILEPLAYER_H
 
 #include "../streams/dRowAudio_StreamAndFileHandler.h"
+#include "../utility/dRowAudio_StatePublisher.h"
 
 /** This class can be used to load and play an audio file from disk.
 
@@ -98,6 +99,14 @@ public:
     /** Returns the position that the next data block will be read from in seconds.  */
     double getCurrentPosition() const { return audioTransportSource.getCurrentPosition(); }
 
+    /** Returns the position in seconds at the end of the last block that was played.
+
+        This is published by the audio thread without locking so is the best way
+        for several components to follow the playback position. It is only updated
+        whilst blocks are being rendered so use getCurrentPosition() when stopped.
+    */
+    double getLastRenderedPosition() const noexcept { return renderedPosition.read(); }
+
     /** Returns the stream's length in seconds. */
     double getLengthInSeconds() const { return audioTransportSource.getLengthInSeconds(); }
 
@@ -195,6 +204,7 @@ protected:
     juce::AudioTransportSource audioTransportSource;
 
     juce::ListenerList<Listener> listeners;
+    SeqLock<double> renderedPosition;
 
     //==============================================================================
     /** Sets up the audio chain when a new source is chosen.
@@ -51,6 +51,29 @@
 
 #include "dRowAudio.h"
 
+// system random number generators used by EncryptedString
+#if JUCE_MAC || JUCE_IOS
+ #include <Security/SecRandom.h>
+#elif JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+ #include <bcrypt.h>
+ #pragma comment (lib, "bcrypt.lib")
+#else
+ #include <fcntl.h>
+ #include <unistd.h>
+ #include <cerrno>
+ // getrandom() was only added in glibc 2.25, anything else reads /dev/urandom
+ #if JUCE_LINUX && defined (__GLIBC__) && defined (__GLIBC_PREREQ)
+  #if __GLIBC_PREREQ (2, 25)
+   #include <sys/random.h>
+   #define DROWAUDIO_USE_GETRANDOM 1
+  #endif
+ #endif
+#endif
+
 #if JUCE_MSVC
     #pragma warning (push)
     #pragma warning (disable: 4458)
@@ -95,10 +118,14 @@ namespace drow
     #include "audio/fft/dRowAudio_LTAS.cpp"
     #include "gui/dRowAudio_AudioFileDropTarget.cpp"
     #include "gui/dRowAudio_DefaultColours.cpp"
+    #include "gui/dRowAudio_VisualRefreshScheduler.cpp"
+    #include "gui/dRowAudio_AnalysisBus.cpp"
     #include "gui/dRowAudio_GraphicalComponent.cpp"
+    #include "gui/dRowAudio_PeakDecimator.cpp"
     #include "gui/dRowAudio_AudioOscilloscope.cpp"
     #include "gui/dRowAudio_AudioTransportCursor.cpp"
     #include "gui/dRowAudio_SegmentedMeter.cpp"
+    #include "gui/dRowAudio_SpectrumRasteriser.cpp"
     #include "gui/dRowAudio_Sonogram.cpp"
     #include "gui/dRowAudio_Spectrograph.cpp"
     #include "gui/dRowAudio_Spectroscope.cpp"
@@ -106,6 +133,9 @@ namespace drow
     #include "gui/dRowAudio_CpuMeter.cpp"
     #include "gui/dRowAudio_Clock.cpp"
     #include "gui/dRowAudio_MusicLibraryTable.cpp"
+    #include "gui/filebrowser/dRowAudio_DirectoryScanCache.cpp"
+    #include "gui/filebrowser/dRowAudio_AudioFileInfoCache.cpp"
+    #include "gui/filebrowser/dRowAudio_CachedFileListComponent.cpp"
     #include "gui/filebrowser/dRowAudio_BasicFileBrowser.cpp"
     #include "gui/filebrowser/dRowAudio_ColumnFileBrowser.cpp"
     #include "gui/audiothumbnail/dRowAudio_AudioThumbnailImage.cpp"
@@ -119,18 +149,35 @@ namespace drow
     #include "native/dRowAudio_IOSAudioConverter.mm"
    #endif
     #include "parameters/dRowAudio_PluginParameter.cpp"
+    #include "parameters/dRowAudio_ParameterAutomation.cpp"
+    #include "parameters/dRowAudio_AutomationLane.cpp"
    #if DROWAUDIO_USE_CURL
     #include "network/dRowAudio_CURLManager.cpp"
     #include "network/dRowAudio_CURLEasySession.cpp"
+    #include "network/dRowAudio_CURLChunkedDownload.cpp"
+    #include "network/dRowAudio_RemoteDirectoryCache.cpp"
+    #include "network/dRowAudio_CURLUnitTests.cpp"
    #endif
+    #include "streams/dRowAudio_AudioEncodingInputStream.cpp"
     #include "streams/dRowAudio_MemoryInputSource.cpp"
     #include "utility/dRowAudio_EncryptedString.cpp"
     #include "utility/dRowAudio_ITunesLibrary.cpp"
+    #include "utility/dRowAudio_MusicLibraryAnalyser.cpp"
+    #include "utility/dRowAudio_MusicLibraryDuplicateFinder.cpp"
+    #include "utility/dRowAudio_MusicLibraryIndex.cpp"
+    #include "utility/dRowAudio_MusicLibraryIndexUnitTests.cpp"
+    #include "utility/dRowAudio_MusicLibraryRowView.cpp"
+    #include "utility/dRowAudio_MusicLibrarySearchIndex.cpp"
+    #include "utility/dRowAudio_MusicLibrarySnapshot.cpp"
+    #include "utility/dRowAudio_PlistTokeniser.cpp"
+    #include "utility/dRowAudio_StatePublisherUnitTests.cpp"
     #include "utility/dRowAudio_ITunesLibraryParser.cpp"
     #include "utility/dRowAudio_UnityBuilder.cpp"
     #include "utility/dRowAudio_UnityProjectBuilder.cpp"
 }
 
+#include "gui/dRowAudio_GuiBenchmarks.cpp"
+
 #if JUCE_MSVC
     #pragma warning (pop)
 #endif
@@ -49,8 +49,8 @@ BEGIN_JUCE_MODULE_DECLARATION
 
     dependencies:   juce_audio_basics, juce_audio_devices, juce_audio_formats, juce_audio_utils, juce_core, juce_data_structures, juce_events, juce_graphics, juce_gui_basics
 
-    OSXFrameworks:   Accelerate
-    iOSFrameworks:   Accelerate AVFoundation MediaPlayer CoreMedia
+    OSXFrameworks:   Accelerate Security
+    iOSFrameworks:   Accelerate AVFoundation MediaPlayer CoreMedia Security
 
 END_JUCE_MODULE_DECLARATION
 
@@ -296,6 +296,7 @@ namespace drow
     #include "gui/audiothumbnail/dRowAudio_ColouredAudioThumbnail.h"
     #include "gui/audiothumbnail/dRowAudio_DraggableWaveDisplay.h"
     #include "gui/audiothumbnail/dRowAudio_PositionableWaveDisplay.h"
+    #include "gui/dRowAudio_AnalysisBus.h"
     #include "gui/dRowAudio_AudioFileDropTarget.h"
     #include "gui/dRowAudio_AudioOscilloscope.h"
     #include "gui/dRowAudio_AudioTransportCursor.h"
@@ -306,11 +307,17 @@ namespace drow
     #include "gui/dRowAudio_GraphicalComponent.h"
     #include "gui/dRowAudio_GuiHelpers.h"
     #include "gui/dRowAudio_MusicLibraryTable.h"
+    #include "gui/dRowAudio_PeakDecimator.h"
     #include "gui/dRowAudio_SegmentedMeter.h"
     #include "gui/dRowAudio_Sonogram.h"
     #include "gui/dRowAudio_Spectrograph.h"
     #include "gui/dRowAudio_Spectroscope.h"
+    #include "gui/dRowAudio_SpectrumRasteriser.h"
     #include "gui/dRowAudio_TriggeredScope.h"
+    #include "gui/dRowAudio_VisualRefreshScheduler.h"
+    #include "gui/filebrowser/dRowAudio_DirectoryScanCache.h"
+    #include "gui/filebrowser/dRowAudio_AudioFileInfoCache.h"
+    #include "gui/filebrowser/dRowAudio_CachedFileListComponent.h"
     #include "gui/filebrowser/dRowAudio_BasicFileBrowser.h"
     #include "gui/filebrowser/dRowAudio_ColumnFileBrowser.h"
     #include "gui/filebrowser/dRowAudio_ColumnFileBrowserLookAndFeel.h"
@@ -322,7 +329,12 @@ namespace drow
     #include "native/dRowAudio_IOSAudioConverter.h"
     #include "network/dRowAudio_CURLEasySession.h"
     #include "network/dRowAudio_CURLManager.h"
+    #include "network/dRowAudio_CURLChunkedDownload.h"
+    #include "network/dRowAudio_RemoteDirectoryCache.h"
     #include "parameters/dRowAudio_PluginParameter.h"
+    #include "parameters/dRowAudio_AutomationLane.h"
+    #include "parameters/dRowAudio_ParameterAutomation.h"
+    #include "streams/dRowAudio_AudioEncodingInputStream.h"
     #include "streams/dRowAudio_MemoryInputSource.h"
     #include "streams/dRowAudio_StreamAndFileHandler.h"
     #include "utility/dRowAudio_Comparators.h"
@@ -332,7 +344,15 @@ namespace drow
     #include "utility/dRowAudio_ITunesLibrary.h"
     #include "utility/dRowAudio_ITunesLibraryParser.h"
     #include "utility/dRowAudio_LockedPointer.h"
+    #include "utility/dRowAudio_MusicLibraryAnalyser.h"
+    #include "utility/dRowAudio_MusicLibraryDuplicateFinder.h"
     #include "utility/dRowAudio_MusicLibraryHelpers.h"
+    #include "utility/dRowAudio_MusicLibraryIndex.h"
+    #include "utility/dRowAudio_MusicLibraryRowView.h"
+    #include "utility/dRowAudio_MusicLibrarySearchIndex.h"
+    #include "utility/dRowAudio_MusicLibrarySnapshot.h"
+    #include "utility/dRowAudio_PlistTokeniser.h"
+    #include "utility/dRowAudio_StatePublisher.h"
     #include "utility/dRowAudio_StateVariable.h"
     #include "utility/dRowAudio_UnityBuilder.h"
     #include "utility/dRowAudio_UnityProjectBuilder.h"
@@ -0,0 +1,236 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+AnalysisBus::AnalysisBus (int numChannels_, int bufferSizeLog2)
+    : numChannels   (jmax (1, numChannels_)),
+      bufferSize    (1 << bufferSizeLog2),
+      bufferMask    (bufferSize - 1),
+      buffer        (numChannels, bufferSize),
+      writePosition (0)
+{
+    jassert (bufferSizeLog2 > 0 && bufferSizeLog2 < 31);
+    buffer.clear();
+}
+
+AnalysisBus::~AnalysisBus()
+{
+}
+
+//==============================================================================
+void AnalysisBus::writeSamples (const float* const* channelData, int numChannelsIn, int numSamples) noexcept
+{
+    if (numSamples <= 0)
+        return;
+
+    const juce::int64 startPosition = writePosition.load (std::memory_order_relaxed);
+    int offset = 0;
+
+    // only the last bufferSize samples can ever be read
+    if (numSamples > bufferSize)
+    {
+        offset = numSamples - bufferSize;
+        numSamples = bufferSize;
+    }
+
+    const int start = (int) ((startPosition + offset) & bufferMask);
+    const int size1 = jmin (numSamples, bufferSize - start);
+    const int size2 = numSamples - size1;
+
+    for (int c = 0; c < numChannels; ++c)
+    {
+        float* dest = buffer.getWritePointer (c);
+
+        if (c < numChannelsIn && channelData[c] != nullptr)
+        {
+            const float* src = channelData[c] + offset;
+            FloatVectorOperations::copy (dest + start, src, size1);
+
+            if (size2 > 0)
+                FloatVectorOperations::copy (dest, src + size1, size2);
+        }
+        else
+        {
+            FloatVectorOperations::clear (dest + start, size1);
+
+            if (size2 > 0)
+                FloatVectorOperations::clear (dest, size2);
+        }
+    }
+
+    writePosition.store (startPosition + offset + numSamples, std::memory_order_release);
+}
+
+void AnalysisBus::writeSamples (const AudioSampleBuffer& bufferToWrite) noexcept
+{
+    writeSamples (bufferToWrite.getArrayOfReadPointers(), bufferToWrite.getNumChannels(), bufferToWrite.getNumSamples());
+}
+
+//==============================================================================
+AnalysisBus::Reader::Reader (AnalysisBus& bus_, int channel_)
+    : bus           (bus_),
+      channel       (jlimit (-1, bus_.getNumChannels() - 1, channel_)),
+      readPosition  (bus_.getTotalNumWritten())
+{
+    if (channel < 0)
+        tempBlock.malloc ((size_t) bus.getBufferSize());
+}
+
+int AnalysisBus::Reader::getNumAvailable() const noexcept
+{
+    const juce::int64 numAvailable = bus.getTotalNumWritten() - readPosition;
+
+    return (int) jmin ((juce::int64) bus.getBufferSize(), numAvailable);
+}
+
+int AnalysisBus::Reader::readSamples (float* destSamples, int maxNumSamples) noexcept
+{
+    const juce::int64 currentWritePosition = bus.getTotalNumWritten();
+
+    // leave some headroom so the writer is unlikely to overwrite what is being read
+    const juce::int64 oldestSafePosition = currentWritePosition - (bus.getBufferSize() - (bus.getBufferSize() >> 2));
+
+    if (readPosition < oldestSafePosition)
+        readPosition = oldestSafePosition;
+
+    const int numToRead = (int) jmin ((juce::int64) maxNumSamples, currentWritePosition - readPosition);
+
+    if (numToRead <= 0)
+        return 0;
+
+    if (channel >= 0)
+    {
+        copyChannel (channel, readPosition, destSamples, numToRead);
+    }
+    else
+    {
+        copyChannel (0, readPosition, destSamples, numToRead);
+
+        for (int c = 1; c < bus.getNumChannels(); ++c)
+        {
+            copyChannel (c, readPosition, tempBlock, numToRead);
+
+            for (int i = 0; i < numToRead; ++i)
+                if (std::abs (tempBlock[i]) > std::abs (destSamples[i]))
+                    destSamples[i] = tempBlock[i];
+        }
+    }
+
+    readPosition += numToRead;
+
+    return numToRead;
+}
+
+void AnalysisBus::Reader::copyChannel (int channelIndex, juce::int64 startPosition, float* dest, int numSamples) const noexcept
+{
+    const float* src = bus.buffer.getReadPointer (channelIndex);
+    const int start = (int) (startPosition & bus.bufferMask);
+    const int size1 = jmin (numSamples, bus.getBufferSize() - start);
+
+    FloatVectorOperations::copy (dest, src + start, size1);
+
+    if (size1 < numSamples)
+        FloatVectorOperations::copy (dest + size1, src, numSamples - size1);
+}
+
+#if DROWAUDIO_USE_FFTREAL || DROWAUDIO_USE_VDSP
+
+//==============================================================================
+AnalysisBus::SharedFFT::SharedFFT (AnalysisBus& bus, int channel, int fftSizeLog2, Window::WindowType windowType_)
+    : reader        (bus, channel),
+      fftEngine     (fftSizeLog2),
+      windowType    (windowType_),
+      numBins       (fftEngine.getFFTProperties().fftSizeHalved + 1),
+      fftBlock      ((size_t) fftEngine.getFFTSize()),
+      numInBlock    (0),
+      history       ((size_t) (numHistoryFrames * numBins), true),
+      numFrames     (0)
+{
+    fftEngine.setWindowType (windowType);
+}
+
+juce::int64 AnalysisBus::SharedFFT::update()
+{
+    const ScopedLock sl (lock);
+    const int fftSize = fftEngine.getFFTSize();
+
+    for (;;)
+    {
+        numInBlock += reader.readSamples (fftBlock + numInBlock, fftSize - numInBlock);
+
+        if (numInBlock < fftSize)
+            break;
+
+        fftEngine.performFFT (fftBlock);
+        fftEngine.findMagnitudes();
+
+        float* frame = history + (int) (numFrames % numHistoryFrames) * numBins;
+        memcpy (frame, fftEngine.getMagnitudesBuffer().getData(), sizeof (float) * (size_t) numBins);
+
+        ++numFrames;
+        numInBlock = 0;
+    }
+
+    return numFrames;
+}
+
+bool AnalysisBus::SharedFFT::readFrame (juce::int64& nextFrameIndex, float* magnitudesToFill)
+{
+    const ScopedLock sl (lock);
+
+    if (nextFrameIndex >= numFrames)
+        return false;
+
+    nextFrameIndex = jmax (nextFrameIndex, numFrames - numHistoryFrames);
+
+    const float* frame = history + (int) (nextFrameIndex % numHistoryFrames) * numBins;
+    memcpy (magnitudesToFill, frame, sizeof (float) * (size_t) numBins);
+
+    ++nextFrameIndex;
+
+    return true;
+}
+
+//==============================================================================
+AnalysisBus::SharedFFT* AnalysisBus::getSharedFFT (int channel, int fftSizeLog2, Window::WindowType windowType)
+{
+    const ScopedLock sl (sharedFFTLock);
+    channel = jlimit (-1, numChannels - 1, channel);
+
+    for (auto* sharedFFT : sharedFFTs)
+        if (sharedFFT->getChannel() == channel
+             && sharedFFT->getFFTSizeLog2() == fftSizeLog2
+             && sharedFFT->getWindowType() == windowType)
+            return sharedFFT;
+
+    return sharedFFTs.add (new SharedFFT (*this, channel, fftSizeLog2, windowType));
+}
+
+#endif
@@ -0,0 +1,226 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef DROWAUDIO_ANALYSISBUS_H
+#define DROWAUDIO_ANALYSISBUS_H
+
+//==============================================================================
+/** A lock-free, multichannel buffer that can be shared between many visualisers.
+
+    Rather than passing the same block of samples to every GraphicalComponent from
+    the audio callback, which involves a copy under a lock for each one, create a
+    single AnalysisBus and write to it once per block. Any number of visualisers can
+    then read from it on their own background threads using an AnalysisBus::Reader,
+    each of which keeps its own read position.
+
+    The bus only ever has a single writer and never blocks it. If a reader falls too
+    far behind it will simply skip forward to the oldest samples still available.
+
+    Visualisers that perform the same size FFT with the same window on the same
+    channel can share the work through getSharedFFT().
+
+    @code
+        // in your audio callback
+        analysisBus.writeSamples (bufferToFill.buffer->getArrayOfReadPointers(),
+                                  bufferToFill.buffer->getNumChannels(),
+                                  bufferToFill.numSamples);
+
+        // when setting up your visualisers
+        sonogram.setAnalysisBus (&analysisBus, 0);
+        meter.setAnalysisBus (&analysisBus, 0);
+    @endcode
+
+    @see GraphicalComponent
+*/
+class AnalysisBus
+{
+public:
+    //==============================================================================
+    /** Creates an AnalysisBus with a number of channels.
+
+        The size of the internal buffer is given as a power of 2 so for example, to
+        keep 65536 samples of history per channel use 16 as the argument. This should
+        be several times larger than the largest FFT or block size you will be using.
+    */
+    AnalysisBus (int numChannels, int bufferSizeLog2 = 16);
+
+    /** Destructor. */
+    ~AnalysisBus();
+
+    //==============================================================================
+    /** Returns the number of channels the bus holds. */
+    int getNumChannels() const noexcept                 { return numChannels; }
+
+    /** Returns the number of samples held for each channel. */
+    int getBufferSize() const noexcept                  { return bufferSize; }
+
+    /** Returns the total number of samples that have been written to the bus. */
+    juce::int64 getTotalNumWritten() const noexcept     { return writePosition.load (std::memory_order_acquire); }
+
+    //==============================================================================
+    /** Writes a block of samples to the bus.
+
+        This is wait-free and should be called from a single thread, usually your
+        audio callback. If fewer channels are supplied than the bus holds, the
+        remaining channels will be silent.
+    */
+    void writeSamples (const float* const* channelData, int numChannelsIn, int numSamples) noexcept;
+
+    /** Writes the contents of an AudioSampleBuffer to the bus. */
+    void writeSamples (const juce::AudioSampleBuffer& buffer) noexcept;
+
+    //==============================================================================
+    /** Reads samples from an AnalysisBus, keeping track of its own position.
+
+        Create one of these for each consumer of the bus. A Reader must only be used by
+        a single thread at a time.
+    */
+    class Reader
+    {
+    public:
+        /** Creates a Reader for one of the bus's channels.
+
+            If the channel is -1 the channels will be combined, taking the sample with
+            the largest absolute value from each, the same as
+            GraphicalComponent::copySamples (float**, int, int).
+            The Reader will start at the most recent position of the bus.
+        */
+        Reader (AnalysisBus& bus, int channel);
+
+        /** Returns the channel this Reader reads from. */
+        int getChannel() const noexcept                 { return channel; }
+
+        /** Returns the number of samples ready to be read. */
+        int getNumAvailable() const noexcept;
+
+        /** Reads up to a maximum number of samples into a buffer.
+            @returns the number of samples actually read.
+        */
+        int readSamples (float* destSamples, int maxNumSamples) noexcept;
+
+    private:
+        //==============================================================================
+        AnalysisBus& bus;
+        const int channel;
+        juce::int64 readPosition;
+        juce::HeapBlock<float> tempBlock;
+
+        void copyChannel (int channelIndex, juce::int64 startPosition, float* dest, int numSamples) const noexcept;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Reader)
+    };
+
+   #if DROWAUDIO_USE_FFTREAL || DROWAUDIO_USE_VDSP || defined (DOXYGEN)
+    //==============================================================================
+    /** An FFT that is performed once for every visualiser using the same channel,
+        size and window.
+
+        Each consumer keeps its own frame index and calls readFrame() to retrieve the
+        magnitudes of any frames it hasn't yet seen. A short history of frames is kept
+        so consumers that update at different rates don't miss any.
+    */
+    class SharedFFT
+    {
+    public:
+        /** Processes any new samples on the bus.
+
+            This can be called by any of the consumers, it will only perform each FFT once.
+            @returns the total number of frames processed so far.
+        */
+        juce::int64 update();
+
+        /** Copies the magnitudes of a frame into a buffer.
+
+            The buffer must be at least getNumBins() long. If the requested frame has fallen
+            out of the history the oldest available one will be returned instead.
+            On success the frame index will be updated to point to the next frame to read.
+
+            @returns true if a frame was read, false if no new frames are available.
+        */
+        bool readFrame (juce::int64& nextFrameIndex, float* magnitudesToFill);
+
+        /** Returns the number of magnitude bins in each frame, this is fftSizeHalved + 1. */
+        int getNumBins() const noexcept                 { return numBins; }
+
+        /** Returns the size of the FFT as log2. */
+        int getFFTSizeLog2() const noexcept             { return fftEngine.getFFTProperties().fftSizeLog2; }
+
+        /** Returns the channel of the bus this FFT is performed on. */
+        int getChannel() const noexcept                 { return reader.getChannel(); }
+
+        /** Returns the Window applied before each FFT. */
+        Window::WindowType getWindowType() const noexcept { return windowType; }
+
+    private:
+        //==============================================================================
+        friend class AnalysisBus;
+        SharedFFT (AnalysisBus& bus, int channel, int fftSizeLog2, Window::WindowType windowType);
+
+        juce::CriticalSection lock;
+        Reader reader;
+        FFTEngine fftEngine;
+        const Window::WindowType windowType;
+        const int numBins;
+        juce::HeapBlock<float> fftBlock;
+        int numInBlock;
+        juce::HeapBlock<float> history;
+        juce::int64 numFrames;
+
+        enum { numHistoryFrames = 16 };
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SharedFFT)
+    };
+
+    /** Returns a SharedFFT for a given channel, size and window.
+
+        If one already exists with these properties it will be returned, otherwise a new
+        one is created. The bus retains ownership of the returned object so it will stay
+        valid for the lifetime of the bus. This should not be called from the audio thread.
+    */
+    SharedFFT* getSharedFFT (int channel, int fftSizeLog2, Window::WindowType windowType = Window::Hann);
+   #endif
+
+private:
+    //==============================================================================
+    const int numChannels, bufferSize, bufferMask;
+    juce::AudioSampleBuffer buffer;
+    std::atomic<juce::int64> writePosition;
+
+   #if DROWAUDIO_USE_FFTREAL || DROWAUDIO_USE_VDSP
+    juce::CriticalSection sharedFFTLock;
+    juce::OwnedArray<SharedFFT> sharedFFTs;
+   #endif
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnalysisBus)
+};
+
+#endif // DROWAUDIO_ANALYSISBUS_H
@@ -31,14 +31,10 @@
 
 AudioOscilloscope::AudioOscilloscope() :
     bufferSizeMask (2047),
-    currentMax (-1.0f),
-    currentMin (1.0f),
     bufferPos (0),
     lastBufferPos (0),
     bufferSize (2048), // Needs to be a power of 2 and larger than the width of your scope!
-    numSamplesIn (0),
-    bufferLastMax (-1.0f),
-    bufferLastMin (1.0f),
+    numSamplesPerPoint (128),
     verticalZoomFactor (1.0f),
     horizontalZoomFactor (1.0f),
     backgroundColour (Colours::black),
@@ -50,20 +46,35 @@ AudioOscilloscope::AudioOscilloscope() :
 
     setOpaque (true);
     resized(); //Initialises the image
-    startTimerHz (50);
+    VisualRefreshScheduler::getInstance()->addClient (this, *this, 50);
+}
+
+AudioOscilloscope::~AudioOscilloscope()
+{
+    if (VisualRefreshScheduler* scheduler = VisualRefreshScheduler::getInstanceWithoutCreating())
+        scheduler->removeClient (this);
 }
 
 //==============================================================================
 void AudioOscilloscope::processBlock (const float* inputChannelData,
                                       int numSamples)
 {
-    if (inputChannelData != nullptr)
-        for (int i = 0; i < numSamples; ++i)
-            addSample (inputChannelData [i]);
+    if (inputChannelData == nullptr)
+        return;
+
+    updateNumSamplesPerPoint();
+    decimator.process (inputChannelData, numSamples, [this] (float min, float max) { addPoint (min, max); });
+}
+
+void AudioOscilloscope::setHorizontalZoom (float newHorizontalZoomFactor)
+{
+    horizontalZoomFactor = newHorizontalZoomFactor;
+    numSamplesPerPoint = 1 + (int) (127.0 * horizontalZoomFactor);
 }
 
 void AudioOscilloscope::clear()
 {
+    decimator.reset();
     zeromem (circularBufferMax, sizeof (float) * size_t (bufferSize));
     zeromem (circularBufferMin, sizeof (float) * size_t (bufferSize));
 }
@@ -79,77 +90,81 @@ void AudioOscilloscope::resized()
 
     if (oldImage.isValid())
         waveformImage = oldImage.rescaled (waveformImage.getWidth(), waveformImage.getHeight());
+
+    traceMax.malloc ((size_t) waveformImage.getWidth());
+    traceMin.malloc ((size_t) waveformImage.getWidth());
 }
 
 void AudioOscilloscope::paint (Graphics& g)
 {
+    const VisualRefreshScheduler::ScopedPaintTimer spt (*this);
     g.drawImageAt (waveformImage, 0, 0);
 }
 
-void AudioOscilloscope::timerCallback()
+void AudioOscilloscope::refreshVisual()
 {
-    const int width = getWidth();
-    const float halfHeight = getHeight() * 0.5f;
+    const int width = waveformImage.getWidth();
+    const int height = waveformImage.getHeight();
+    const float halfHeight = height * 0.5f;
 
-    const int numPixelsToDraw = abs (bufferPos - lastBufferPos);
+    const int currentBufferPos = bufferPos.load();
+    const int numPixelsToDraw = jmin (width, (currentBufferPos - lastBufferPos) & bufferSizeMask);
     const int newSectionStart = width - numPixelsToDraw;
 
+    if (numPixelsToDraw == 0)
+        return;
+
     // shuffle image along
     waveformImage.moveImageSection (0, 0,
                                     numPixelsToDraw, 0,
-                                    newSectionStart, waveformImage.getHeight());
+                                    newSectionStart, height);
 
-    // draw new section
-    Graphics g (waveformImage);
-
-    g.setColour (backgroundColour);
-    g.fillRect (newSectionStart, 0, numPixelsToDraw, waveformImage.getHeight());
-    g.setColour (traceColour);
+    waveformImage.clear ({ newSectionStart, 0, numPixelsToDraw, height }, backgroundColour);
 
-    const int bp = bufferPos + bufferSize;
+    // redraw the last column too so the new section joins up with it
+    const int firstX = jmax (0, newSectionStart - 1);
+    const int numPoints = width - firstX;
 
-    for (int x = width; --x >= newSectionStart;)
+    for (int i = 0; i < numPoints; ++i)
     {
-        const int samplesAgo = width - x;
-
-        float max = circularBufferMax [(bp - samplesAgo) &bufferSizeMask];
-        float min = circularBufferMin [(bp - samplesAgo) &bufferSizeMask];
+        const int samplesAgo = width - (firstX + i);
+        const int index = (currentBufferPos - samplesAgo) & bufferSizeMask;
 
-        if (min > bufferLastMax)
-            min = bufferLastMax;
-        if (max < bufferLastMin)
-            max = bufferLastMin;
-
-        bufferLastMax = max;
-        bufferLastMin = min;
+        traceMax[i] = circularBufferMax[index];
+        traceMin[i] = circularBufferMin[index];
+    }
 
-        g.drawLine ((float) x, halfHeight + (halfHeight * verticalZoomFactor * max),
-                    (float) x, halfHeight + (halfHeight * verticalZoomFactor * min));
+    // draw new section
+    {
+        const Image::BitmapData destData (waveformImage, Image::BitmapData::readWrite);
+        PeakDecimator::renderTrace (destData, firstX, traceMin, traceMax, numPoints,
+                                    traceColour, halfHeight, -halfHeight * verticalZoomFactor);
     }
 
-    lastBufferPos = bufferPos.load();
+    lastBufferPos = currentBufferPos;
 
     repaint();
 }
 
 void AudioOscilloscope::addSample (const float sample)
 {
-    if (sample > currentMax)
-        currentMax = sample;
-    if (sample < currentMin)
-        currentMin = sample;
+    updateNumSamplesPerPoint();
+    decimator.addSample (sample, [this] (float min, float max) { addPoint (min, max); });
+}
+
+//==============================================================================
+void AudioOscilloscope::updateNumSamplesPerPoint() noexcept
+{
+    const int newNumSamplesPerPoint = numSamplesPerPoint.load (std::memory_order_relaxed);
 
-    const int samplesToAverage = 1 + (int) (127.0 * horizontalZoomFactor);
+    if (decimator.getNumSamplesPerPoint() != newNumSamplesPerPoint)
+        decimator.setNumSamplesPerPoint (newNumSamplesPerPoint);
+}
 
-    if (++numSamplesIn > samplesToAverage)
-    {
-        bufferPos = bufferPos & bufferSizeMask;
-        circularBufferMax [bufferPos.load()] = currentMax;
-        circularBufferMin [bufferPos.load()] = currentMin;
-        bufferPos++;
-
-        numSamplesIn = 0;
-        currentMin = 1.0e6f;
-        currentMax = -currentMin;
-    }
+void AudioOscilloscope::addPoint (float min, float max) noexcept
+{
+    const int pos = bufferPos.load();
+    circularBufferMax[pos] = max;
+    circularBufferMin[pos] = min;
+    bufferPos = (pos + 1) & bufferSizeMask;
 }
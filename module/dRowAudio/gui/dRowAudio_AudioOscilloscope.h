@@ -32,6 +32,9 @@
 #ifndef DROWAUDIO_AUDIOOSCILLOSCOPE_H
 #define DROWAUDIO_AUDIOOSCILLOSCOPE_H
 
+#include "dRowAudio_PeakDecimator.h"
+#include "dRowAudio_VisualRefreshScheduler.h"
+
 /** An oscilloscope class for displaying audio waveforms.
 
     This is a high-res version of the SimpleAudioScope class and as such is
@@ -40,7 +43,7 @@
     idea of what is passing through it.
  */
 class AudioOscilloscope : public juce::Component,
-                          public juce::Timer
+                          public VisualRefreshScheduler::Client
 {
 public:
     /** Creates an AudioOscilloscope.
@@ -50,6 +53,9 @@ public:
     */
     AudioOscilloscope();
 
+    /** Destructor. */
+    ~AudioOscilloscope() override;
+
     //==============================================================================
     /** Processes a number of samples displaying them on the scope.
 
@@ -79,7 +85,7 @@ public:
         difficult to see. Consider using Component::createComponentSnapshot() to
         capture an image of the scope.
      */
-    void setHorizontalZoom (float newHorizontalZoomFactor) { horizontalZoomFactor = newHorizontalZoomFactor; }
+    void setHorizontalZoom (float newHorizontalZoomFactor);
 
     /** Sets the background colour of the scope. */
     void setBackgroundColour (juce::Colour newBackgroundColour) { backgroundColour = newBackgroundColour; }
@@ -97,21 +103,26 @@ public:
     /** @internal */
     void paint (juce::Graphics& g) override;
     /** @internal */
-    void timerCallback() override;
+    void refreshVisual() override;
 
 private:
     //==============================================================================
     juce::HeapBlock<float> circularBufferMax, circularBufferMin;
     int bufferSizeMask;
-    float currentMax, currentMin;
-    std::atomic<int> bufferPos, lastBufferPos, bufferSize, numSamplesIn;
-    float bufferLastMax, bufferLastMin;
+    PeakDecimator decimator;
+    std::atomic<int> numSamplesPerPoint;
+    std::atomic<int> bufferPos, lastBufferPos, bufferSize;
+    juce::HeapBlock<float> traceMax, traceMin;
 
     juce::Image waveformImage;
 
     float verticalZoomFactor, horizontalZoomFactor;
     juce::Colour backgroundColour, traceColour;
 
+    //==============================================================================
+    void updateNumSamplesPerPoint() noexcept;
+    void addPoint (float min, float max) noexcept;
+
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioOscilloscope)
 };
@@ -36,7 +36,7 @@ AudioTransportCursor::AudioTransportCursor (AudioFilePlayer& sourceToBeUsed)
       currentSampleRate     (44100.0),
       zoomRatio             (1.0),
       startOffsetRatio      (0.0),
-      shouldStopTimer       (false),
+      shouldStopRefreshing  (false),
       showTransportCursor   (true)
 {
     refreshFromFilePlayer();
@@ -46,7 +46,7 @@ AudioTransportCursor::AudioTransportCursor (AudioFilePlayer& sourceToBeUsed)
 AudioTransportCursor::~AudioTransportCursor()
 {
     audioFilePlayer.removeListener (this);
-    stopTimer();
+    stopRefreshing();
 }
 
 void AudioTransportCursor::setZoomRatio (double newZoomRatio)
@@ -73,7 +73,7 @@ void AudioTransportCursor::setCursorDisplayed (bool shouldDisplayCursor)
 {
     showTransportCursor = shouldDisplayCursor;
 
-    startTimerIfNeeded();
+    startRefreshingIfNeeded();
 }
 
 //====================================================================================
@@ -88,18 +88,24 @@ void AudioTransportCursor::resized()
 
 void AudioTransportCursor::paint (Graphics &g)
 {
+    const VisualRefreshScheduler::ScopedPaintTimer spt (*this);
+
     if (showTransportCursor)
         g.drawImageAt (cursorImage, transportLineXCoord.getCurrent() - 1, 0);
 }
 
 //====================================================================================
-void AudioTransportCursor::timerCallback()
+void AudioTransportCursor::refreshVisual()
 {
     const int w = getWidth();
     const int h = getHeight();
 
+    // whilst playing use the position published by the audio thread rather than querying the sources
+    const double position = audioFilePlayer.isPlaying() ? audioFilePlayer.getLastRenderedPosition()
+                                                        : audioFilePlayer.getCurrentPosition();
+
     const int startPixel = roundToInt (w * startOffsetRatio);
-    transportLineXCoord = startPixel + roundToInt ((w * oneOverFileLength * audioFilePlayer.getCurrentPosition()) / zoomRatio);
+    transportLineXCoord = startPixel + roundToInt ((w * oneOverFileLength * position) / zoomRatio);
 
     // if the line has moved repaint the old and new positions of it
     if (! transportLineXCoord.areEqual())
@@ -108,10 +114,10 @@ void AudioTransportCursor::timerCallback()
         repaint (transportLineXCoord.getCurrent() - 2, 0, 5, h);
     }
 
-    if (shouldStopTimer)
+    if (shouldStopRefreshing)
     {
-        shouldStopTimer = false;
-        stopTimer();
+        shouldStopRefreshing = false;
+        stopRefreshing();
     }
 }
 
@@ -125,7 +131,7 @@ void AudioTransportCursor::fileChanged (AudioFilePlayer* player)
 void AudioTransportCursor::playerStoppedOrStarted (AudioFilePlayer* player)
 {
     if (player == &audioFilePlayer)
-        startTimerIfNeeded();
+        startRefreshingIfNeeded();
 }
 
 //==============================================================================
@@ -138,8 +144,8 @@ void AudioTransportCursor::mouseDown (const MouseEvent &e)
         currentXScale = (float) ((fileLength / getWidth()) * zoomRatio);
         setPlayerPosition (e.x, true);
 
-        shouldStopTimer = false;
-        startTimer (40);
+        shouldStopRefreshing = false;
+        startRefreshing();
 
         repaint();
     }
@@ -151,7 +157,7 @@ void AudioTransportCursor::mouseUp (const MouseEvent& /*e*/)
     {
         setMouseCursor (MouseCursor::NormalCursor);
 
-        startTimerIfNeeded();
+        startRefreshingIfNeeded();
     }
 }
 
@@ -184,22 +190,33 @@ void AudioTransportCursor::refreshFromFilePlayer()
         oneOverFileLength = 1.0;
     }
 
-    startTimerIfNeeded();
+    startRefreshingIfNeeded();
 }
 
-void AudioTransportCursor::startTimerIfNeeded()
+void AudioTransportCursor::startRefreshingIfNeeded()
 {
     if (showTransportCursor)
     {
-        shouldStopTimer = false;
-        startTimer (40);
+        shouldStopRefreshing = false;
+        startRefreshing();
     }
     else
     {
-        shouldStopTimer = true;
+        shouldStopRefreshing = true;
     }
 }
 
+void AudioTransportCursor::startRefreshing()
+{
+    VisualRefreshScheduler::getInstance()->addClient (this, *this, 25);
+}
+
+void AudioTransportCursor::stopRefreshing()
+{
+    if (VisualRefreshScheduler* scheduler = VisualRefreshScheduler::getInstanceWithoutCreating())
+        scheduler->removeClient (this);
+}
+
 void AudioTransportCursor::setPlayerPosition (int mousePosX, bool ignoreAnyLoopPoints)
 {
     const int startPixel = roundToInt (getWidth() * startOffsetRatio);
@@ -34,13 +34,14 @@
 
 #include "../utility/dRowAudio_StateVariable.h"
 #include "../audio/dRowAudio_AudioUtility.h"
+#include "dRowAudio_VisualRefreshScheduler.h"
 
 /** A class to display a scolling cursor to prepresent the position of an audio file.
 
     Clicking and dragging on the display will reposition the transport source.
 */
 class AudioTransportCursor : public juce::Component,
-                             public juce::Timer,
+                             public VisualRefreshScheduler::Client,
                              public AudioFilePlayer::Listener
 {
 public:
@@ -86,7 +87,7 @@ public:
     /** @internal */
     void mouseDrag (const juce::MouseEvent& e) override;
     /** @internal */
-    void timerCallback() override;
+    void refreshVisual() override;
 
 private:
     //==============================================================================
@@ -94,7 +95,7 @@ private:
 
     double fileLength, oneOverFileLength, currentSampleRate;
     double zoomRatio, startOffsetRatio;
-    bool shouldStopTimer;
+    bool shouldStopRefreshing;
 
     juce::Image cursorImage;
 
@@ -104,7 +105,9 @@ private:
 
     //==============================================================================
     void refreshFromFilePlayer();
-    void startTimerIfNeeded();
+    void startRefreshingIfNeeded();
+    void startRefreshing();
+    void stopRefreshing();
     void setPlayerPosition (int mousePosX, bool ignoreAnyLoopPoints);
 
     //==============================================================================
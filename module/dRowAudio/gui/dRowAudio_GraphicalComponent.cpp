@@ -33,11 +33,24 @@ GraphicalComponent::GraphicalComponent()
     : paused (false),
       needToProcess (true),
       sleepTime (5),
-      numSamples (0)
+      numSamples (0),
+      analysisBus (nullptr),
+      analysisBusChannel (-1)
 {
     samples.malloc (numSamples);
 
-    startTimer (30);
+    setRefreshRate (33);
+}
+
+GraphicalComponent::~GraphicalComponent()
+{
+    if (VisualRefreshScheduler* scheduler = VisualRefreshScheduler::getInstanceWithoutCreating())
+        scheduler->removeClient (this);
+}
+
+void GraphicalComponent::setRefreshRate (int refreshRateHz)
+{
+    VisualRefreshScheduler::getInstance()->addClient (this, *this, refreshRateHz);
 }
 
 int GraphicalComponent::useTimeSlice()
@@ -47,6 +60,13 @@ int GraphicalComponent::useTimeSlice()
         return sleepTime;
     }
 
+    {
+        const ScopedLock sl (busLock);
+
+        if (analysisBus != nullptr)
+            pullFromAnalysisBus();
+    }
+
     if (needToProcess)
     {
         process();
@@ -107,3 +127,32 @@ void GraphicalComponent::copySamples (float **values, int numSamples_, int numCh
 
     needToProcess = true;
 }
+
+//==============================================================================
+void GraphicalComponent::setAnalysisBus (AnalysisBus* busToUse, int channel)
+{
+    const ScopedLock sl (busLock);
+
+    analysisBus = busToUse;
+    analysisBusChannel = channel;
+    analysisBusReader.reset();
+
+    if (analysisBus != nullptr)
+    {
+        analysisBusReader = std::make_unique<AnalysisBus::Reader> (*analysisBus, channel);
+        analysisBusBlock.malloc ((size_t) analysisBus->getBufferSize());
+    }
+
+    analysisBusChanged();
+}
+
+void GraphicalComponent::pullFromAnalysisBus()
+{
+    if (analysisBusReader != nullptr)
+    {
+        const int numRead = analysisBusReader->readSamples (analysisBusBlock, analysisBus->getBufferSize());
+
+        if (numRead > 0)
+            copySamples (analysisBusBlock, numRead);
+    }
+}
@@ -32,6 +32,9 @@
 #ifndef DROWAUDIO_GRAPHICALCOMPONENT_H
 #define DROWAUDIO_GRAPHICALCOMPONENT_H
 
+#include "dRowAudio_AnalysisBus.h"
+#include "dRowAudio_VisualRefreshScheduler.h"
+
 /** This class is an abstract base blass for some kind of graphical component
     that requires some intenisve processing.
 
@@ -39,14 +42,27 @@
     to continually call the process() method where you can do your required
     processing on a background thread to avoid blocking the Message thread for too long.
 
-    @see SegmentedMeter
+    Rather than each running their own Timer, GraphicalComponents are refreshed by the
+    shared VisualRefreshScheduler which will call timerCallback() at the refresh rate,
+    as long as the component is visible.
+
+    @see SegmentedMeter, VisualRefreshScheduler
  */
 class GraphicalComponent : public juce::Component,
                            public juce::TimeSliceClient,
-                           public juce::Timer
+                           public juce::Timer,
+                           public VisualRefreshScheduler::Client
 {
 
 public:
+    /** Destructor. */
+    ~GraphicalComponent() override;
+
+    /** Sets the rate at which timerCallback() will be called by the VisualRefreshScheduler.
+        By default this is 33Hz.
+    */
+    void setRefreshRate (int refreshRateHz);
+
     /** Overload to do your processing.
 
         Once registered with a GraphicalComponentManager this will repeatedly get called.
@@ -79,11 +95,26 @@ public:
     */
     virtual void copySamples (float** values, int numSamples, int numChannels);
 
+    /** Reads samples from a shared AnalysisBus instead of having them pushed with copySamples().
+
+        This is the most efficient way to feed several visualisers from the same audio as
+        the audio thread only has to write to the bus once. Samples will be pulled from the
+        bus on the background thread before each call to process().
+        Pass a nullptr to go back to using copySamples().
+
+        @param busToUse     The bus to read from. This must outlive the component or be
+                            removed before it is deleted.
+        @param channel      The channel of the bus to read or -1 to combine all of them.
+    */
+    void setAnalysisBus (AnalysisBus* busToUse, int channel = -1);
+
     //==============================================================================
     /** @internal */
     int useTimeSlice() override;
     /** @internal */
     void timerCallback() override {}
+    /** @internal */
+    void refreshVisual() override { timerCallback(); }
 
 protected:
     //==============================================================================
@@ -93,13 +124,34 @@ protected:
     */
     GraphicalComponent();
 
+    /** Called on the background thread to pull any new samples from the AnalysisBus.
+
+        By default this reads from the bus and passes the samples on to copySamples().
+        Subclasses can override this to read from the bus in a more specialised way,
+        e.g. by using an AnalysisBus::SharedFFT.
+    */
+    virtual void pullFromAnalysisBus();
+
+    /** Called when a new AnalysisBus has been set, or the current one removed.
+        This is called with the bus lock held so pullFromAnalysisBus() won't be called concurrently.
+    */
+    virtual void analysisBusChanged() {}
+
     //==============================================================================
     juce::CriticalSection lock;
     bool paused, needToProcess;
     int sleepTime, numSamples;
     juce::HeapBlock<float> samples;
 
+    AnalysisBus* analysisBus;
+    int analysisBusChannel;
+    std::unique_ptr<AnalysisBus::Reader> analysisBusReader;
+    juce::HeapBlock<float> analysisBusBlock;
+
 private:
+    //==============================================================================
+    juce::CriticalSection busLock;
+
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GraphicalComponent)
 };
@@ -0,0 +1,422 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#if DROWAUDIO_UNIT_TESTS
+
+/*  Headless rendering benchmarks for the gui classes.
+
+    These render each component into a software Image, feeding it synthetic audio,
+    and log the average time spent processing and painting each frame at a few
+    different sizes. They are registered in the "Benchmarks" category so aren't
+    run along with the normal unit tests, use UnitTestRunner::runTestsInCategory()
+    or the demo's --gui-benchmarks option to run them.
+
+    If DROWAUDIO_COUNT_ALLOCATIONS is defined the global operator new is replaced
+    with a counting version so the number of allocations per frame can also be
+    reported, and the benchmarks will fail if anything done on the audio thread
+    allocates. Only define this in a benchmark build as it affects the whole app.
+
+    If the DROWAUDIO_BENCHMARK_RESULTS environment variable is set the results
+    will also be appended to that file as CSV, so they can be archived and compared
+    between builds.
+
+    This file is included outside of the drow namespace so it can replace the global
+    allocation functions.
+*/
+
+#if DROWAUDIO_COUNT_ALLOCATIONS
+namespace drow
+{
+    static std::atomic<juce::int64> numBenchmarkAllocations { 0 };
+}
+
+void* operator new (std::size_t size)
+{
+    ++drow::numBenchmarkAllocations;
+
+    if (void* p = std::malloc (size > 0 ? size : 1))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)
+{
+    return operator new (size);
+}
+
+void operator delete (void* p) noexcept                 { std::free (p); }
+void operator delete[] (void* p) noexcept               { std::free (p); }
+void operator delete (void* p, std::size_t) noexcept    { std::free (p); }
+void operator delete[] (void* p, std::size_t) noexcept  { std::free (p); }
+
+#if __cpp_aligned_new
+void* operator new (std::size_t size, std::align_val_t alignment)
+{
+    ++drow::numBenchmarkAllocations;
+
+    const std::size_t align = juce::jmax ((std::size_t) alignment, sizeof (void*));
+
+   #if JUCE_WINDOWS
+    if (void* p = _aligned_malloc (size > 0 ? size : 1, align))
+        return p;
+   #else
+    void* p = nullptr;
+
+    if (posix_memalign (&p, align, size > 0 ? size : 1) == 0)
+        return p;
+   #endif
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size, std::align_val_t alignment)
+{
+    return operator new (size, alignment);
+}
+
+static void freeAligned (void* p) noexcept
+{
+   #if JUCE_WINDOWS
+    _aligned_free (p);
+   #else
+    std::free (p);
+   #endif
+}
+
+void operator delete (void* p, std::align_val_t) noexcept                   { freeAligned (p); }
+void operator delete[] (void* p, std::align_val_t) noexcept                 { freeAligned (p); }
+void operator delete (void* p, std::size_t, std::align_val_t) noexcept      { freeAligned (p); }
+void operator delete[] (void* p, std::size_t, std::align_val_t) noexcept    { freeAligned (p); }
+#endif
+#endif
+
+namespace drow
+{
+using namespace juce;
+
+//==============================================================================
+class GuiRenderingBenchmarks  : public UnitTest
+{
+public:
+    GuiRenderingBenchmarks() : UnitTest ("GUI Rendering", "Benchmarks") {}
+
+    void runTest() override
+    {
+        createSyntheticAudio();
+
+        const Rectangle<int> sizes[] = { { 128, 64 }, { 512, 256 }, { 1920, 400 } };
+
+        for (auto& size : sizes)
+        {
+            beginTest ("Rendering at " + getSizeString (size));
+
+            benchmarkSegmentedMeter (size);
+            benchmarkAudioOscilloscope (size);
+            benchmarkTriggeredScope (size);
+           #if DROWAUDIO_USE_FFTREAL || DROWAUDIO_USE_VDSP
+            benchmarkSonogram (size);
+            benchmarkSpectroscope (size);
+           #endif
+            benchmarkColouredAudioThumbnail (size);
+        }
+    }
+
+private:
+    //==============================================================================
+    enum
+    {
+        sampleRate = 44100,
+        blockSize = 512,
+        numWarmUpFrames = 10,
+        numFrames = 100
+    };
+
+    struct Result
+    {
+        double processNs = 0.0, paintNs = 0.0;
+        double allocationsPerFrame = -1.0;
+        int64 audioThreadAllocations = -1;
+    };
+
+    AudioSampleBuffer syntheticAudio;
+    int readPosition = 0;
+
+    //==============================================================================
+    /** Fills a few seconds of buffer with a sweep and some noise so that all the
+        frequency bands and levels get exercised.
+    */
+    void createSyntheticAudio()
+    {
+        syntheticAudio.setSize (1, 4 * sampleRate);
+        readPosition = 0;
+
+        Random random (0x1234);
+        float* data = syntheticAudio.getWritePointer (0);
+        const int numSamples = syntheticAudio.getNumSamples();
+        double phase = 0.0;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const double proportion = i / (double) numSamples;
+            const double frequency = 20.0 * std::pow (1000.0, proportion);
+
+            phase += MathConstants<double>::twoPi * frequency / sampleRate;
+
+            const float envelope = 0.5f + 0.5f * std::sin (float (proportion * 20.0));
+            data[i] = envelope * (0.8f * (float) std::sin (phase) + 0.1f * (random.nextFloat() * 2.0f - 1.0f));
+        }
+    }
+
+    /** Returns the next block of synthetic audio, wrapping around at the end. */
+    const float* getNextBlock() noexcept
+    {
+        if (readPosition + blockSize > syntheticAudio.getNumSamples())
+            readPosition = 0;
+
+        const float* block = syntheticAudio.getReadPointer (0, readPosition);
+        readPosition += blockSize;
+
+        return block;
+    }
+
+    static int64 getNumAllocations() noexcept
+    {
+       #if DROWAUDIO_COUNT_ALLOCATIONS
+        return numBenchmarkAllocations.load();
+       #else
+        return -1;
+       #endif
+    }
+
+    static String getSizeString (const Rectangle<int>& size)
+    {
+        return String (size.getWidth()) + "x" + String (size.getHeight());
+    }
+
+    static Image createImage (const Rectangle<int>& size)
+    {
+        return Image (Image::ARGB, size.getWidth(), size.getHeight(), true, SoftwareImageType());
+    }
+
+    static void paintComponent (Component& component, Image& image)
+    {
+        Graphics g (image);
+        component.paintEntireComponent (g, true);
+    }
+
+    static void refreshComponent (VisualRefreshScheduler::Client& client)
+    {
+        client.refreshVisual();
+    }
+
+    //==============================================================================
+    /** Times a number of frames.
+        The audio function should only do what would be done on the audio thread,
+        the process function anything done on the component's background or timer
+        thread and the paint function the rendering.
+    */
+    template <typename AudioFunction, typename ProcessFunction, typename PaintFunction>
+    Result measure (AudioFunction&& audioFrame, ProcessFunction&& processFrame, PaintFunction&& paintFrame)
+    {
+        for (int i = 0; i < numWarmUpFrames; ++i)
+        {
+            audioFrame();
+            processFrame();
+            paintFrame();
+        }
+
+        int64 processTicks = 0, paintTicks = 0, audioThreadAllocations = 0;
+        const int64 allocationsBefore = getNumAllocations();
+
+        for (int i = 0; i < numFrames; ++i)
+        {
+            const int64 audioAllocationsBefore = getNumAllocations();
+            const int64 startTicks = Time::getHighResolutionTicks();
+            audioFrame();
+            audioThreadAllocations += getNumAllocations() - audioAllocationsBefore;
+            processFrame();
+            const int64 processedTicks = Time::getHighResolutionTicks();
+            paintFrame();
+            const int64 paintedTicks = Time::getHighResolutionTicks();
+
+            processTicks += processedTicks - startTicks;
+            paintTicks += paintedTicks - processedTicks;
+        }
+
+        const int64 allocationsAfter = getNumAllocations();
+        const double nsPerTick = 1.0e9 / (double) Time::getHighResolutionTicksPerSecond();
+
+        Result result;
+        result.processNs = processTicks * nsPerTick / numFrames;
+        result.paintNs = paintTicks * nsPerTick / numFrames;
+
+        if (allocationsBefore >= 0)
+        {
+            result.allocationsPerFrame = (allocationsAfter - allocationsBefore) / (double) numFrames;
+            result.audioThreadAllocations = audioThreadAllocations;
+        }
+
+        return result;
+    }
+
+    void report (const String& name, const Rectangle<int>& size, const Result& result)
+    {
+        const String allocations (result.allocationsPerFrame < 0.0 ? String ("-")
+                                                                   : String (result.allocationsPerFrame, 1));
+
+        logMessage (name.paddedRight (' ', 24)
+                    + getSizeString (size).paddedRight (' ', 10)
+                    + "process: " + String (roundToInt (result.processNs)).paddedLeft (' ', 9) + " ns/frame  "
+                    + "paint: " + String (roundToInt (result.paintNs)).paddedLeft (' ', 9) + " ns/frame  "
+                    + "allocations: " + allocations + "/frame");
+
+       #if DROWAUDIO_COUNT_ALLOCATIONS
+        expectEquals (result.audioThreadAllocations, (int64) 0, name + " allocated on the audio thread");
+       #endif
+
+        const String resultsPath (SystemStats::getEnvironmentVariable ("DROWAUDIO_BENCHMARK_RESULTS", {}));
+
+        if (resultsPath.isNotEmpty())
+        {
+            const File resultsFile (File::getCurrentWorkingDirectory().getChildFile (resultsPath));
+
+            if (! resultsFile.existsAsFile())
+                resultsFile.appendText ("component,width,height,process_ns,paint_ns,allocations\n");
+
+            resultsFile.appendText (name + "," + String (size.getWidth()) + "," + String (size.getHeight()) + ","
+                                    + String (roundToInt (result.processNs)) + "," + String (roundToInt (result.paintNs)) + ","
+                                    + allocations + "\n");
+        }
+    }
+
+    //==============================================================================
+    void benchmarkSegmentedMeter (const Rectangle<int>& size)
+    {
+        SegmentedMeter meter;
+        meter.setBounds (size);
+        Image image (createImage (size));
+
+        report ("SegmentedMeter", size,
+                measure ([&] { meter.copySamples (getNextBlock(), blockSize); },
+                         [&] { meter.process();
+                               meter.flagForRepaint();
+                               refreshComponent (meter); },
+                         [&] { paintComponent (meter, image); }));
+    }
+
+    void benchmarkAudioOscilloscope (const Rectangle<int>& size)
+    {
+        AudioOscilloscope oscilloscope;
+        oscilloscope.setBounds (size);
+        Image image (createImage (size));
+
+        report ("AudioOscilloscope", size,
+                measure ([&] { oscilloscope.processBlock (getNextBlock(), blockSize); },
+                         [&] { refreshComponent (oscilloscope); },
+                         [&] { paintComponent (oscilloscope, image); }));
+    }
+
+    void benchmarkTriggeredScope (const Rectangle<int>& size)
+    {
+        // The thread is never started so the rendering can be driven from here
+        TimeSliceThread thread ("TriggeredScope benchmark");
+        TriggeredScope scope (&thread);
+        scope.setTriggerMode (TriggeredScope::Up);
+        scope.setBounds (size);
+        Image image (createImage (size));
+
+        report ("TriggeredScope", size,
+                measure ([&] { scope.addSamples (getNextBlock(), blockSize); },
+                         [&] { scope.useTimeSlice();
+                               refreshComponent (scope); },
+                         [&] { paintComponent (scope, image); }));
+    }
+
+   #if DROWAUDIO_USE_FFTREAL || DROWAUDIO_USE_VDSP
+    void benchmarkSonogram (const Rectangle<int>& size)
+    {
+        Sonogram sonogram (10);
+        sonogram.setLogFrequencyDisplay (true);
+        sonogram.setBounds (size);
+        Image image (createImage (size));
+
+        report ("Sonogram", size,
+                measure ([&] { sonogram.copySamples (getNextBlock(), blockSize); },
+                         [&] { sonogram.process();
+                               refreshComponent (sonogram); },
+                         [&] { paintComponent (sonogram, image); }));
+    }
+
+    void benchmarkSpectroscope (const Rectangle<int>& size)
+    {
+        Spectroscope spectroscope (10);
+        spectroscope.setLogFrequencyDisplay (true);
+        spectroscope.setBounds (size);
+        Image image (createImage (size));
+
+        report ("Spectroscope", size,
+                measure ([&] { spectroscope.copySamples (getNextBlock(), blockSize); },
+                         [&] { spectroscope.process();
+                               refreshComponent (spectroscope); },
+                         [&] { paintComponent (spectroscope, image); }));
+    }
+   #endif
+
+    void benchmarkColouredAudioThumbnail (const Rectangle<int>& size)
+    {
+        AudioFormatManager formatManager;
+        AudioThumbnailCache cache (1);
+        ColouredAudioThumbnail thumbnail (blockSize, formatManager, cache);
+
+        const int numSamples = syntheticAudio.getNumSamples();
+        thumbnail.reset (1, sampleRate, numSamples);
+        thumbnail.addBlock (0, syntheticAudio, 0, numSamples);
+
+        const double length = numSamples / (double) sampleRate;
+        Image image (createImage (size));
+        double startTime = 0.0;
+
+        // scroll through the file a little each frame as the wave displays do
+        report ("ColouredAudioThumbnail", size,
+                measure ([] {},
+                         [&] { startTime = std::fmod (startTime + 0.01, length * 0.5); },
+                         [&] { Graphics g (image);
+                               g.fillAll (Colours::black);
+                               thumbnail.drawColouredChannel (g, size, startTime, startTime + length * 0.5, 0, 1.0f); }));
+    }
+};
+
+static GuiRenderingBenchmarks guiRenderingBenchmarks;
+
+} // namespace drow
+
+#endif // DROWAUDIO_UNIT_TESTS
@@ -29,12 +29,62 @@
   ==============================================================================
 */
 
+//==============================================================================
+class MusicLibraryTable::FilterJob : public ThreadPoolJob
+{
+public:
+    FilterJob (MusicLibraryTable& owner_, const String& filterText_,
+               const Array<int>* candidates, uint32 indexVersion_)
+        : ThreadPoolJob ("MusicLibraryTable filter"),
+          owner (owner_),
+          filterText (filterText_),
+          indexVersion (indexVersion_),
+          useCandidates (candidates != nullptr)
+    {
+        if (candidates != nullptr)
+            candidateRows = *candidates;
+    }
+
+    JobStatus runJob() override
+    {
+        Array<int> results;
+
+        if (! owner.searchIndex.search (filterText, useCandidates ? &candidateRows : nullptr, results,
+                                        [this] { return shouldExit(); }))
+            return jobHasFinished;
+
+        {
+            const ScopedLock sl (owner.filterResultsLock);
+            owner.filterResults.swapWith (results);
+            owner.filterResultsText = filterText;
+            owner.filterResultsVersion = indexVersion;
+        }
+
+        owner.triggerAsyncUpdate();
+
+        return jobHasFinished;
+    }
+
+private:
+    MusicLibraryTable& owner;
+    const String filterText;
+    const uint32 indexVersion;
+    const bool useCandidates;
+    Array<int> candidateRows;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FilterJob)
+};
+
+//==============================================================================
 MusicLibraryTable::MusicLibraryTable()
-    : font              (12.0f),
-      currentLibrary    (nullptr),
-      dataList          (MusicColumns::libraryIdentifier),
-      filteredNumRows   (dataList.getNumChildren()),
-      finishedLoading   (true)
+    : font                  (12.0f),
+      currentLibrary        (nullptr),
+      searchIndex           (index),
+      rowView               (index),
+      filterPool            (1),
+      filterResultsVersion  (0),
+      lastFilterVersion     (0),
+      finishedLoading       (true)
 {
     // Create our table component and add it to this component..
     addAndMakeVisible (&table);
@@ -74,54 +124,56 @@ MusicLibraryTable::MusicLibraryTable()
 
 MusicLibraryTable::~MusicLibraryTable()
 {
+    filterPool.removeAllJobs (true, 2000);
+    cancelPendingUpdate();
+
     if (currentLibrary != nullptr)
-        currentLibrary->removeListener(this);
+        currentLibrary->removeListener (this);
 }
 
 void MusicLibraryTable::setLibraryToUse (ITunesLibrary* library)
 {
+    if (currentLibrary != nullptr)
+        currentLibrary->removeListener (this);
+
     currentLibrary = library;
 
-    filteredDataList = dataList = library->getLibraryTree();
-    dataList = library->getLibraryTree();
-    library->addListener(this);
+    index.setLibraryTree (library->getLibraryTree(), library->getParserLock());
+    library->addListener (this);
+
+    updateTableFilteredAndSorted();
 }
 
 void MusicLibraryTable::setFilterText (const juce::String& filterString)
 {
     currentFilterText = filterString;
 
-    if (currentLibrary != nullptr)
-        currentLibrary->getParserLock().enter();
+    // don't wait for a running search, its results will be ignored when they arrive
+    filterPool.removeAllJobs (true, 0);
 
     if (filterString.isEmpty())
     {
-        filteredDataList = dataList;
-        filteredNumRows = filteredDataList.getNumChildren();
-    }
-    else
-    {
-        filteredDataList = juce::ValueTree (dataList.getType());
+        Array<int> allRows;
+        allRows.resize (index.getNumRecords());
 
-        for (int e = 0; e < dataList.getNumChildren(); ++e)
-        {
-            for (int i = 0; i < dataList.getChild (e).getNumProperties(); ++i)
-            {
-                if (dataList.getChild (e)[MusicColumns::columnNames[i]].toString().containsIgnoreCase (filterString))
-                {
-                    filteredDataList.addChild (dataList.getChild(e).createCopy(), -1, nullptr);
-                    break;
-                }
-            }
-        }
+        for (int i = 0; i < allRows.size(); ++i)
+            allRows.setUnchecked (i, i);
+
+        lastFilterText = String();
+        lastFilterRows.clearQuick();
 
-        filteredNumRows = filteredDataList.getNumChildren();
+        showRows (allRows);
+        return;
     }
 
-    if (currentLibrary != nullptr)
-        currentLibrary->getParserLock().exit();
+    // if the new text is a refinement of the last search we only need to look through its results
+    const bool canRefine = lastFilterVersion == index.getVersion()
+                            && MusicLibrarySearchIndex::isRefinement (lastFilterText, filterString);
 
-    table.getHeader().reSortTable();
+    filterPool.addJob (new FilterJob (*this, filterString,
+                                      canRefine ? &lastFilterRows : nullptr,
+                                      index.getVersion()),
+                       true);
 }
 
 //==============================================================================
@@ -130,14 +182,14 @@ void MusicLibraryTable::libraryChanged (ITunesLibrary* library)
     if (library == currentLibrary)
     {
         finishedLoading = false;
-        filteredDataList = dataList = currentLibrary->getLibraryTree();
+        index.setLibraryTree (currentLibrary->getLibraryTree(), currentLibrary->getParserLock());
         updateTableFilteredAndSorted();
     }
 }
 
 void MusicLibraryTable::libraryUpdated (ITunesLibrary* library)
 {
-    if (library == currentLibrary)
+    if (library == currentLibrary && index.update())
         updateTableFilteredAndSorted();
 }
 
@@ -146,6 +198,7 @@ void MusicLibraryTable::libraryFinished (ITunesLibrary* library)
     if (library == currentLibrary)
     {
         finishedLoading = true;
+        index.update();
         updateTableFilteredAndSorted();
     }
 }
@@ -153,7 +206,7 @@ void MusicLibraryTable::libraryFinished (ITunesLibrary* library)
 //==============================================================================
 int MusicLibraryTable::getNumRows()
 {
-    return filteredNumRows;
+    return rowView.getNumRows();
 }
 
 void MusicLibraryTable::paintRowBackground (Graphics& g, int, int, int, bool rowIsSelected)
@@ -181,24 +234,7 @@ void MusicLibraryTable::paintCell (Graphics& g,
 
     g.setFont (font);
 
-    {
-        const ScopedLock sl (currentLibrary->getParserLock());
-        const juce::ValueTree rowElement (filteredDataList.getChild (rowNumber));
-
-        if (rowElement.isValid())
-        {
-            juce::String text;
-
-            if (columnId == MusicColumns::Length)
-                text = secondsToTimeLength (rowElement[MusicColumns::columnNames[columnId]].toString().getIntValue());
-            else if (columnId == MusicColumns::Added || columnId == MusicColumns::Modified)
-                text = Time ((int64) rowElement[MusicColumns::columnNames[columnId]]).formatted ("%d/%m/%Y - %H:%M");
-            else
-                text = rowElement[MusicColumns::columnNames[columnId]].toString();
-
-            g.drawText (text, 2, 0, width - 4, height, Justification::centredLeft, true);
-        }
-    }
+    g.drawText (rowView.getCellText (rowNumber, columnId), 2, 0, width - 4, height, Justification::centredLeft, true);
 
     if (table.hasKeyboardFocus (true))
         g.setColour (DefaultColours::getInstance().findColour (*this, rowIsSelected ? selectedOutlineColourId : outlineColourId));
@@ -215,26 +251,7 @@ void MusicLibraryTable::sortOrderChanged (int newSortColumnId, bool isForwards)
 
     if (newSortColumnId != 0)
     {
-        const ScopedLock sl (currentLibrary->getParserLock());
-
-        if (newSortColumnId == MusicColumns::Length
-            || newSortColumnId == MusicColumns::BPM
-            || newSortColumnId == MusicColumns::LibID
-            || newSortColumnId == MusicColumns::ID
-            || newSortColumnId == MusicColumns::Added
-            || newSortColumnId == MusicColumns::Modified)
-        {
-            ValueTreeComparators::Numerical<double> sorter (MusicColumns::columnNames[newSortColumnId], isForwards);
-            filteredDataList.sort (sorter, nullptr, false);
-        }
-        else
-        {
-            ValueTreeComparators::LexicographicWithBackup sorter (MusicColumns::columnNames[newSortColumnId],
-                                                                  MusicColumns::columnNames[MusicColumns::LibID],
-                                                                  isForwards);
-            filteredDataList.sort (sorter, nullptr, false);
-        }
-
+        rowView.sort (newSortColumnId, isForwards);
         table.updateContent();
     }
 
@@ -246,18 +263,14 @@ int MusicLibraryTable::getColumnAutoSizeWidth (int columnId)
 {
     int widest = 32;
 
-    // find the widest bit of text in this column..
-    for (int i = getNumRows(); --i >= 0;)
-    {
-        const ScopedLock sl (currentLibrary->getParserLock());
-        const juce::ValueTree rowElement (filteredDataList.getChild (i));
+    // find the widest bit of text in the visible rows of this column, measuring
+    // every row would mean formatting the whole library
+    const int rowHeight = jmax (1, table.getRowHeight());
+    const int firstRow = table.getViewport()->getViewPositionY() / rowHeight;
+    const int lastRow = jmin (getNumRows(), firstRow + table.getViewport()->getViewHeight() / rowHeight + 1);
 
-        if (rowElement.isValid())
-        {
-            const juce::String text (rowElement[MusicColumns::columnNames[columnId]].toString());
-            widest = jmax (widest, font.getStringWidth (text));
-        }
-    }
+    for (int i = firstRow; i < lastRow; ++i)
+        widest = jmax (widest, font.getStringWidth (rowView.getCellText (i, columnId)));
 
     return widest + 8;
 }
@@ -277,16 +290,13 @@ var MusicLibraryTable::getDragSourceDescription (const SparseSet<int>& currently
 {
     var itemsArray;
 
-    if(! currentlySelectedRows.isEmpty())
+    for (int i = 0; i < currentlySelectedRows.getNumRanges(); ++i)
     {
-        for (int i = 0; i < currentlySelectedRows.size(); ++i)
-        {
-            const ScopedLock sl (currentLibrary->getParserLock());
+        const Range<int> range (currentlySelectedRows.getRange (i));
 
-            // get child from main tree with same LibID
-            const juce::ValueTree& tree (filteredDataList.getChild (currentlySelectedRows[i]));
-
-            ReferenceCountedValueTree::Ptr childTree = new ReferenceCountedValueTree (tree);
+        for (int row = range.getStart(); row < range.getEnd(); ++row)
+        {
+            ReferenceCountedValueTree::Ptr childTree = new ReferenceCountedValueTree (index.getItem (rowView.getRecord (row)));
             itemsArray.append (childTree.get());
         }
     }
@@ -295,6 +305,30 @@ var MusicLibraryTable::getDragSourceDescription (const SparseSet<int>& currently
 }
 
 //==============================================================================
+void MusicLibraryTable::handleAsyncUpdate()
+{
+    Array<int> results;
+    String resultsText;
+    uint32 resultsVersion;
+
+    {
+        const ScopedLock sl (filterResultsLock);
+        results.swapWith (filterResults);
+        resultsText = filterResultsText;
+        resultsVersion = filterResultsVersion;
+    }
+
+    // ignore any results that have been superseded
+    if (resultsText != currentFilterText || resultsVersion != index.getVersion())
+        return;
+
+    lastFilterText = resultsText;
+    lastFilterVersion = resultsVersion;
+    lastFilterRows = results;
+
+    showRows (results);
+}
+
 void MusicLibraryTable::updateTableFilteredAndSorted()
 {
     // make sure we still apply our filter
@@ -302,30 +336,27 @@ void MusicLibraryTable::updateTableFilteredAndSorted()
     setFilterText (currentFilterText);
 }
 
-void MusicLibraryTable::findSelectedRows()
+void MusicLibraryTable::showRows (const Array<int>& newRows)
 {
-    selectedRowsLibIds.clear();
-    const SparseSet<int> selectedRowNumbers (table.getSelectedRows());
+    findSelectedRows();
 
-    for (int i = 0; i < selectedRowNumbers.size(); ++i)
-    {
-        const int oldIndex = selectedRowNumbers[i];
-        const int libId = int (filteredDataList.getChild (oldIndex)[MusicColumns::columnNames[MusicColumns::LibID]]);
-        selectedRowsLibIds.add (libId);
-    }
+    rowView.setRecords (newRows);
+
+    const int sortColumnId = table.getHeader().getSortColumnId();
+
+    if (sortColumnId != 0)
+        rowView.sort (sortColumnId, table.getHeader().isSortedForwards());
+
+    table.updateContent();
+    setSelectedRows();
 }
 
-void MusicLibraryTable::setSelectedRows()
+void MusicLibraryTable::findSelectedRows()
 {
-    SparseSet<int> newSelectedRowNumbers;
-
-    for (int i = 0; i < selectedRowsLibIds.size(); ++i)
-    {
-        const int libId = selectedRowsLibIds.getReference (i);
-        const int index = filteredDataList.indexOf (filteredDataList.getChildWithProperty (MusicColumns::columnNames[MusicColumns::LibID],
-                                                                                           libId));
-        newSelectedRowNumbers.addRange (Range<int> (index, index + 1));
-    }
+    rowView.rememberSelection (table.getSelectedRows());
+}
 
-    table.setSelectedRows (newSelectedRowNumbers, sendNotification);
+void MusicLibraryTable::setSelectedRows()
+{
+    table.setSelectedRows (rowView.getRememberedSelection(), sendNotification);
 }
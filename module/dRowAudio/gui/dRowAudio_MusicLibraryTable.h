@@ -35,6 +35,9 @@
 #include "../audio/dRowAudio_AudioUtility.h"
 #include "../utility/dRowAudio_ITunesLibrary.h"
 #include "../utility/dRowAudio_Comparators.h"
+#include "../utility/dRowAudio_MusicLibraryIndex.h"
+#include "../utility/dRowAudio_MusicLibraryRowView.h"
+#include "../utility/dRowAudio_MusicLibrarySearchIndex.h"
 
 /** Table to display and interact with a music library.
     The easiest way to use this is to load a default or saved iTunes library like so:
@@ -43,16 +46,25 @@
         MusicLibraryTable table;
         table.setLibraryToUse (ITunesLibrary::getInstance());
 
-        File parsedLibraryFile (File::getSpecialLocation (File::userDesktopDirectory).getChildFile ("saved_library_file.xml"));
-        ValueTree libraryTree (readValueTreeFromFile (parsedLibraryFile));
+        File snapshotFile (File::getSpecialLocation (File::userApplicationDataDirectory).getChildFile ("MyApp/library.snapshot"));
 
-        ITunesLibrary::getInstance()->setLibraryTree (libraryTree);
+        ITunesLibrary::getInstance()->setSnapshotFile (snapshotFile);
         ITunesLibrary::getInstance()->setLibraryFile (ITunesLibrary::getDefaultITunesLibraryFile());
     @endcode
+
+    A library tree previously saved as XML with writeValueTreeToFile() can still
+    be loaded with readValueTreeFromFile() and ITunesLibrary::setLibraryTree()
+    but this has to parse the whole file every time.
+
+    The table reads its rows through a MusicLibraryRowView of a MusicLibraryIndex
+    so sorting doesn't touch the library tree itself, only the visible cells are
+    ever formatted as text, and filtering is performed on a background
+    thread, refining the previous results where possible.
 */
 class MusicLibraryTable : public juce::Component,
                           public juce::TableListBoxModel,
-                          public ITunesLibrary::Listener
+                          public ITunesLibrary::Listener,
+                          private juce::AsyncUpdater
 {
 public:
     /** Create the MusicLibraryTable.
@@ -70,7 +82,11 @@ public:
     /** Sets the ITunesLibrary to use. */
     void setLibraryToUse (ITunesLibrary* library);
 
-    /** Filters the table to only rows containing the given text. */
+    /** Filters the table to only rows matching the given search query.
+        Each word must be the start of a word in one of the text columns, or
+        can be restricted to a column e.g. "artist:daft bpm:120-128".
+        @see MusicLibrarySearchIndex
+    */
     void setFilterText (const juce::String& filterText);
 
     /** Returns the table list box component. */
@@ -150,23 +166,38 @@ public:
 
 private:
     //==============================================================================
+    class FilterJob;
+
     juce::Font font;
     ITunesLibrary* currentLibrary;
     juce::TableListBox table;
     juce::String currentFilterText;
 
-    juce::ValueTree dataList;
-    juce::ValueTree filteredDataList;
-    juce::SortedSet<int> selectedRowsLibIds;
+    MusicLibraryIndex index;
+    MusicLibrarySearchIndex searchIndex;
+    MusicLibraryRowView rowView;
+
+    juce::ThreadPool filterPool;
+    juce::CriticalSection filterResultsLock;
+    juce::Array<int> filterResults;
+    juce::String filterResultsText;
+    juce::uint32 filterResultsVersion;
+
+    juce::Array<int> lastFilterRows;
+    juce::String lastFilterText;
+    juce::uint32 lastFilterVersion;
 
-    int filteredNumRows;
     bool finishedLoading;
 
     //==============================================================================
     void updateTableFilteredAndSorted();
+    void showRows (const juce::Array<int>& newRows);
     void findSelectedRows();
     void setSelectedRows();
 
+    /** @internal */
+    void handleAsyncUpdate() override;
+
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MusicLibraryTable)
 };
@@ -0,0 +1,94 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+namespace PeakDecimatorHelpers
+{
+    template <class PixelType>
+    static void fillSpan (const Image::BitmapData& destData, int x, int top, int bottom,
+                          const PixelARGB& colour, bool isOpaque) noexcept
+    {
+        uint8* pixel = destData.getPixelPointer (x, top);
+
+        for (int y = top; y <= bottom; ++y)
+        {
+            if (isOpaque)
+                reinterpret_cast<PixelType*> (pixel)->set (colour);
+            else
+                reinterpret_cast<PixelType*> (pixel)->blend (colour);
+
+            pixel += destData.lineStride;
+        }
+    }
+}
+
+void PeakDecimator::renderTrace (const Image::BitmapData& destData, int startX,
+                                 const float* minValues, const float* maxValues, int numPoints,
+                                 Colour colour, float yOffset, float yScale) noexcept
+{
+    jassert (destData.pixelFormat == Image::ARGB || destData.pixelFormat == Image::RGB);
+
+    const int maxY = destData.height - 1;
+    const int endX = jmin (destData.width, startX + numPoints);
+    const PixelARGB pixelColour (colour.getPixelARGB());
+    const bool isOpaque = colour.isOpaque();
+    int previousTop = 0, previousBottom = 0;
+
+    if (maxY < 0)
+        return;
+
+    for (int x = jmax (0, startX); x < endX; ++x)
+    {
+        const int i = x - startX;
+        const float y1 = yOffset - (maxValues[i] * yScale);
+        const float y2 = yOffset - (minValues[i] * yScale);
+
+        const int pointTop = jlimit (0, maxY, (int) std::floor (jmin (y1, y2)));
+        const int pointBottom = jlimit (0, maxY, (int) std::ceil (jmax (y1, y2)));
+        int top = pointTop, bottom = pointBottom;
+
+        // join up with the previous column
+        if (x > jmax (0, startX))
+        {
+            if (previousBottom < top)
+                top = previousBottom;
+            else if (previousTop > bottom)
+                bottom = previousTop;
+        }
+
+        if (destData.pixelFormat == Image::ARGB)
+            PeakDecimatorHelpers::fillSpan<PixelARGB> (destData, x, top, bottom, pixelColour, isOpaque);
+        else
+            PeakDecimatorHelpers::fillSpan<PixelRGB> (destData, x, top, bottom, pixelColour, isOpaque);
+
+        previousTop = pointTop;
+        previousBottom = pointBottom;
+    }
+}
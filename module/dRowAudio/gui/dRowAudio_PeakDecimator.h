@@ -0,0 +1,148 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef DROWAUDIO_PEAKDECIMATOR_H
+#define DROWAUDIO_PEAKDECIMATOR_H
+
+//==============================================================================
+/** Reduces a stream of samples to pairs of minimum and maximum values.
+
+    This is used by the scopes to reduce the incoming audio to one point per pixel.
+    Rather than testing each sample individually, blocks of samples are scanned with
+    FloatVectorOperations::findMinAndMax() which is vectorised on most platforms.
+    This means the cost is dominated by the number of points produced rather than
+    the number of samples consumed.
+
+    @see TriggeredScope, AudioOscilloscope
+*/
+class PeakDecimator
+{
+public:
+    //==============================================================================
+    /** Creates a PeakDecimator that produces a point every 4 samples. */
+    PeakDecimator() noexcept
+        : numSamplesPerPoint (4),
+          numLeftForPoint (4),
+          currentMin (std::numeric_limits<float>::max()),
+          currentMax (std::numeric_limits<float>::lowest())
+    {
+    }
+
+    /** Sets the number of samples that make up each point.
+        This will take effect once the current point has been completed.
+    */
+    void setNumSamplesPerPoint (int newNumSamplesPerPoint) noexcept
+    {
+        jassert (newNumSamplesPerPoint > 0);
+        numSamplesPerPoint = juce::jmax (1, newNumSamplesPerPoint);
+    }
+
+    /** Returns the number of samples that make up each point. */
+    int getNumSamplesPerPoint() const noexcept         { return numSamplesPerPoint; }
+
+    /** Discards any partially completed point. */
+    void reset() noexcept
+    {
+        numLeftForPoint = numSamplesPerPoint;
+        currentMin = std::numeric_limits<float>::max();
+        currentMax = std::numeric_limits<float>::lowest();
+    }
+
+    /** Processes a block of samples.
+
+        Each time a point has been completed the callback will be called with its
+        minimum and maximum values e.g.
+        @code
+        decimator.process (samples, numSamples, [this] (float min, float max) { addPoint (min, max); });
+        @endcode
+    */
+    template <typename PointCallback>
+    void process (const float* samples, int numSamples, PointCallback&& pointCompleted)
+    {
+        while (numSamples > 0)
+        {
+            const int numThisTime = juce::jmin (numSamples, numLeftForPoint);
+            const juce::Range<float> range (juce::FloatVectorOperations::findMinAndMax (samples, numThisTime));
+
+            currentMin = juce::jmin (currentMin, range.getStart());
+            currentMax = juce::jmax (currentMax, range.getEnd());
+
+            samples += numThisTime;
+            numSamples -= numThisTime;
+            numLeftForPoint -= numThisTime;
+
+            if (numLeftForPoint == 0)
+            {
+                pointCompleted (currentMin, currentMax);
+                reset();
+            }
+        }
+    }
+
+    /** Processes a single sample.
+        This is quicker than calling process() with a block of one sample.
+    */
+    template <typename PointCallback>
+    void addSample (float sample, PointCallback&& pointCompleted)
+    {
+        currentMin = juce::jmin (currentMin, sample);
+        currentMax = juce::jmax (currentMax, sample);
+
+        if (--numLeftForPoint == 0)
+        {
+            pointCompleted (currentMin, currentMax);
+            reset();
+        }
+    }
+
+    //==============================================================================
+    /** Draws a trace of min/max points directly into a BitmapData.
+
+        Each point fills a vertical span of pixels in a single column, extending it to meet
+        the previous column if the two don't overlap so the trace stays continuous.
+        The y position of each value is yOffset - (value * yScale).
+
+        The BitmapData must be in either ARGB or RGB format.
+    */
+    static void renderTrace (const juce::Image::BitmapData& destData, int startX,
+                             const float* minValues, const float* maxValues, int numPoints,
+                             juce::Colour colour, float yOffset, float yScale) noexcept;
+
+private:
+    //==============================================================================
+    int numSamplesPerPoint, numLeftForPoint;
+    float currentMin, currentMax;
+
+    //==============================================================================
+    JUCE_LEAK_DETECTOR (PeakDecimator)
+};
+
+#endif // DROWAUDIO_PEAKDECIMATOR_H
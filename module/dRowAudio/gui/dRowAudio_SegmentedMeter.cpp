@@ -40,6 +40,7 @@ SegmentedMeter::SegmentedMeter()
       samplesToCount(2048),
       sampleMax     (0.0f),
       level         (0.0f),
+      peakLevel     (0.0f),
       needsRepaint  (true)
 {
     setOpaque (true);
@@ -47,12 +48,18 @@ SegmentedMeter::SegmentedMeter()
 
 void SegmentedMeter::calculateSegments()
 {
-    const float numDecibels = (float) toDecibels (level.getCurrent());
+    // the processing thread keeps the highest peak since the last time we looked
+    // so no windows are missed if several are published between timer callbacks
+    const float newPeak = peakLevel.exchange (0.0f, std::memory_order_relaxed);
+
+    if (newPeak > level)
+        level = newPeak;
+
+    const float numDecibels = (float) toDecibels (level);
     // map decibels to numSegs
     numSegs = jmax (0, roundToInt ((numDecibels / decibelsPerSeg) + (totalNumSegs - numRedSeg)));
 
     // impliment slow decay
-    //    level.set((0.5f * level.getCurrent()) + (0.1f * level.getPrevious()));
     level *= 0.8f;
 
     // only actually need to repaint if the numSegs has changed
@@ -119,6 +126,8 @@ void SegmentedMeter::resized()
 
 void SegmentedMeter::paint (Graphics &g)
 {
+    const VisualRefreshScheduler::ScopedPaintTimer spt (*this);
+
     const int w = getWidth();
     const int h = getHeight();
 
@@ -154,8 +163,11 @@ void SegmentedMeter::process()
 
             if (++sampleCount == samplesToCount)
             {
-                if (sampleMax > level.getCurrent())
-                    level = sampleMax;
+                float currentPeak = peakLevel.load (std::memory_order_relaxed);
+
+                while (sampleMax > currentPeak
+                        && ! peakLevel.compare_exchange_weak (currentPeak, sampleMax, std::memory_order_relaxed))
+                {}
 
                 sampleMax = 0.0f;
                 sampleCount = 0;
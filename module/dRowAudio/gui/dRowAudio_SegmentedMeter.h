@@ -128,8 +128,8 @@ private:
     float decibelsPerSeg;
     StateVariable<int> numSegs;
     int sampleCount, samplesToCount;
-    float sampleMax;
-    StateVariable<float> level;
+    float sampleMax, level;
+    std::atomic<float> peakLevel;
     bool needsRepaint;
 
     juce::Image onImage, offImage;
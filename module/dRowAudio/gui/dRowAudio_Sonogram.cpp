@@ -36,8 +36,11 @@ Sonogram::Sonogram (int fftSizeLog2)
     needsRepaint    (true),
     tempBlock       (fftEngine.getFFTSize()),
     circularBuffer  (int (fftEngine.getMagnitudesBuffer().getSize() * 4)),
+    sharedFFT       (nullptr),
+    nextFrameIndex  (0),
     logFrequency    (false),
-    scopeLineW      (1.0f)
+    scopeLineW      (1.0f),
+    writeX          (0)
 {
     setColour (lineColourId, Colours::white);
     setColour (backgroundColourId, Colours::transparentBlack);
@@ -50,23 +53,37 @@ Sonogram::Sonogram (int fftSizeLog2)
 
     scopeImage = Image (Image::ARGB, 100, 100, false);
     scopeImage.clear (scopeImage.getBounds(), Colours::transparentWhite);
+    rasteriser.setSize (numBins, scopeImage.getHeight());
 }
 
 void Sonogram::resized()
 {
     const ScopedLock sl (lock);
-    scopeImage = scopeImage.rescaled (jmax (1, getWidth()), jmax (1, getHeight()));
+
+    // unwrap the circular image so the history survives the rescale
+    Image unwrappedImage (Image::ARGB, scopeImage.getWidth(), scopeImage.getHeight(), true);
+
+    {
+        Graphics g (unwrappedImage);
+        drawScopeImage (g);
+    }
+
+    scopeImage = unwrappedImage.rescaled (jmax (1, getWidth()), jmax (1, getHeight()));
+    writeX = 0;
+
+    rasteriser.setSize (numBins, scopeImage.getHeight());
 }
 
 void Sonogram::paint(Graphics &g)
 {
+    const VisualRefreshScheduler::ScopedPaintTimer spt (*this);
     const ScopedLock sl (lock);
 
     g.setColour (findColour (backgroundColourId));
     g.fillRect (getLocalBounds());
 
     g.setOpacity (1.0f);
-    g.drawImageAt (scopeImage, 0, 0, false);
+    drawScopeImage (g);
     
     g.setColour (findColour (lineColourId));
     g.drawRect (getLocalBounds());
@@ -75,7 +92,9 @@ void Sonogram::paint(Graphics &g)
 //==============================================================================
 void Sonogram::setLogFrequencyDisplay (bool shouldDisplayLog)
 {
+    const ScopedLock sl (lock);
     logFrequency = shouldDisplayLog;
+    rasteriser.setLogFrequencyDisplay (logFrequency);
 }
 
 void Sonogram::setBlockWidth (int newBlockWidth)
@@ -118,6 +137,35 @@ void Sonogram::process()
     }
 }
 
+void Sonogram::analysisBusChanged()
+{
+    // share the FFT with any other visualisers using the same bus, size and window
+    sharedFFT = analysisBus != nullptr ? analysisBus->getSharedFFT (analysisBusChannel,
+                                                                     fftEngine.getFFTProperties().fftSizeLog2,
+                                                                     Window::Hann)
+                                       : nullptr;
+    nextFrameIndex = sharedFFT != nullptr ? sharedFFT->update() : 0;
+}
+
+void Sonogram::pullFromAnalysisBus()
+{
+    if (sharedFFT == nullptr)
+    {
+        GraphicalComponent::pullFromAnalysisBus();
+        return;
+    }
+
+    sharedFFT->update();
+
+    float* magnitudes = fftEngine.getMagnitudesBuffer().getData();
+
+    while (sharedFFT->readFrame (nextFrameIndex, magnitudes))
+    {
+        renderScopeLine();
+        needsRepaint = true;
+    }
+}
+
 void Sonogram::flagForRepaint()
 {
     needsRepaint = true;
@@ -128,47 +176,35 @@ void Sonogram::renderScopeLine()
 {
     const ScopedLock sl (lock);
 
-    scopeImage.moveImageSection (0, 0, (int) scopeLineW, 0,
-                                 scopeImage.getWidth(), scopeImage.getHeight());
-
-    const int h = scopeImage.getHeight();
-
-    Graphics g (scopeImage);
-    const int x = scopeImage.getWidth() - (int) scopeLineW;
-
-    const int numBinsX = int (fftEngine.getMagnitudesBuffer().getSize() - 1);
-    const float yScale = (float) h / (numBinsX + 1);
+    // the image is used as a circular buffer of columns so nothing needs to be moved
+    const int w = scopeImage.getWidth();
+    const int blockWidth = jmin ((int) scopeLineW, w);
+    const int numToEnd = jmin (blockWidth, w - writeX);
     const float* data = fftEngine.getMagnitudesBuffer().getData();
 
-    float amp = jlimit (0.0f, 1.0f, (float) (1 + (toDecibels (data[0]) / 100.0f)));
-    float y2, y1 = 0;
+    rasteriser.renderColumn (scopeImage, writeX, numToEnd, data);
 
-    if (logFrequency)
-    {
-        for (int i = 0; i < numBinsX; ++i)
-        {
-            amp = jlimit (0.0f, 1.0f, (float) (1 + (toDecibels (data[i]) / 100.0f)));
-            y2 = log10 (1 + 39 * ((i + 1.0f) / numBinsX)) / log10 (40.0f) * h;
+    if (numToEnd < blockWidth)
+        rasteriser.renderColumn (scopeImage, 0, blockWidth - numToEnd, data);
 
-            g.setColour (Colour::greyLevel (amp));
-            g.fillRect ((float)x, std::abs (h - y2), scopeLineW, std::abs (y1 - y2));
+    writeX = (writeX + blockWidth) % w;
+}
 
-            y1 = y2;
-        }
-    }
-    else
-    {
-        for (int i = 0; i < numBinsX; ++i)
-        {
-            amp = jlimit (0.0f, 1.0f, (float) (1 + (toDecibels (data[i]) / 100.0f)));
-            y2 = (i + 1) * yScale;
+void Sonogram::drawScopeImage (Graphics& g) const
+{
+    // the oldest column is at writeX so draw from there to the end, then wrap around
+    const int w = scopeImage.getWidth();
+    const int h = scopeImage.getHeight();
+    const int numToEnd = w - writeX;
 
-            g.setColour (Colour::greyLevel (amp));
-            g.fillRect ((float) x, h - y2, scopeLineW, y1 - y2);
+    g.drawImage (scopeImage,
+                 0, 0, numToEnd, h,
+                 writeX, 0, numToEnd, h);
 
-            y1 = y2;
-        }
-    }
+    if (writeX > 0)
+        g.drawImage (scopeImage,
+                     numToEnd, 0, writeX, h,
+                     0, 0, writeX, h);
 }
 
 #endif //DROWAUDIO_USE_FFTREAL
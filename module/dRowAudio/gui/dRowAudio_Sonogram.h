@@ -32,6 +32,8 @@
 #ifndef DROWAUDIO_SONOGRAM_H
 #define DROWAUDIO_SONOGRAM_H
 
+#include "dRowAudio_SpectrumRasteriser.h"
+
 #if DROWAUDIO_USE_FFTREAL || DROWAUDIO_USE_VDSP || defined (DOXYGEN)
 
 /** Creates a standard right-left scrolling greyscale Sonogram.
@@ -95,6 +97,13 @@ public:
     /** @internal */
     void flagForRepaint();
 
+protected:
+    //==============================================================================
+    /** @internal */
+    void analysisBusChanged() override;
+    /** @internal */
+    void pullFromAnalysisBus() override;
+
 private:
     //==============================================================================
     FFTEngine fftEngine;
@@ -102,11 +111,16 @@ private:
     bool needsRepaint;
     juce::HeapBlock<float> tempBlock;
     FifoBuffer<float> circularBuffer;
+    AnalysisBus::SharedFFT* sharedFFT;
+    juce::int64 nextFrameIndex;
     bool logFrequency;
     float scopeLineW;
-    juce::Image scopeImage, tempImage;
+    juce::Image scopeImage;
+    SpectrumRasteriser rasteriser;
+    int writeX;
 
     void renderScopeLine();
+    void drawScopeImage (juce::Graphics& g) const;
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Sonogram)
@@ -111,48 +111,18 @@ Image Spectrograph::createImage() const
     const int h = (int) std::ceil (bH * numBins);
 
     Image image (Image::RGB, w, h, false);
-    Graphics g (image);
-    g.fillAll (Colours::black);
+    image.clear (image.getBounds(), Colours::black);
 
-    float x1 = 0.0f;
+    SpectrumRasteriser rasteriser;
+    rasteriser.setLogFrequencyDisplay (logFrequency);
+    rasteriser.setSize (numBins, h);
 
     for (int i = 0; i < fftMagnitudesBlocks.size(); ++i)
     {
-        float x2 = x1 + bW;
-        const float yScale = (float) h / (numBins + 1);
-        const float* data = fftMagnitudesBlocks.getUnchecked (i);
+        const int x1 = (int) (i * bW);
+        const int x2 = jmax (x1 + 1, (int) ((i + 1) * bW));
 
-        float amp = jlimit (0.0f, 1.0f, (float) (1 + (toDecibels (data[0]) / 100.0f)));
-        float y1 = 0.0f;
-
-        if (logFrequency)
-        {
-            for (int k = 0; k < numBins; ++k)
-            {
-                amp = (float) jlimit (0.0, 1.0, 1.0 + (toDecibels (data[k]) / 100.0));
-                const float y2 = log10 (1 + 39 * ((k + 1.0f) / numBins)) / log10 (40.0f) * h;
-
-                g.setColour (Colour::greyLevel (amp));
-                g.fillRect (x1, h - y2, bW, y1 - y2);
-
-                y1 = y2;
-            }
-        }
-        else
-        {
-            for (int k = 0; k < numBins; ++k)
-            {
-                amp = (float) jlimit (0.0, 1.0, 1.0 + (toDecibels (data[k]) / 100.0));
-                const float y2 = (k + 1) * yScale;
-
-                g.setColour (Colour::greyLevel (amp));
-                g.fillRect (x1, h - y2, bW, y1 - y2);
-
-                y1 = y2;
-            }
-        }
-
-        x1 = x2;
+        rasteriser.renderColumn (image, x1, x2 - x1, fftMagnitudesBlocks.getUnchecked (i));
     }
 
     return image;
@@ -32,6 +32,8 @@
 #ifndef DROWAUDIO_SPECTROGRAPH_H
 #define DROWAUDIO_SPECTROGRAPH_H
 
+#include "dRowAudio_SpectrumRasteriser.h"
+
 #if DROWAUDIO_USE_FFTREAL || DROWAUDIO_USE_VDSP || defined (DOXYGEN)
 
 /** Creates a standard right-left greyscale Spectrograph. */
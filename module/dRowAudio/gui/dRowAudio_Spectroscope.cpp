@@ -36,6 +36,8 @@ Spectroscope::Spectroscope (int fftSizeLog2)
     needsRepaint    (true),
     tempBlock       (fftEngine.getFFTSize()),
     circularBuffer  (int (fftEngine.getMagnitudesBuffer().getSize() * 4)),
+    sharedFFT       (nullptr),
+    nextFrameIndex  (0),
     logFrequency    (false)
 {
     setColour (lineColourId, Colours::white);
@@ -58,6 +60,7 @@ void Spectroscope::resized()
 
 void Spectroscope::paint(Graphics& g)
 {
+    const VisualRefreshScheduler::ScopedPaintTimer spt (*this);
     g.setColour (findColour (lineColourId));
     g.drawRect (getLocalBounds());
 
@@ -102,6 +105,37 @@ void Spectroscope::process()
     }
 }
 
+void Spectroscope::analysisBusChanged()
+{
+    // share the FFT with any other visualisers using the same bus, size and window
+    sharedFFT = analysisBus != nullptr ? analysisBus->getSharedFFT (analysisBusChannel,
+                                                                     fftEngine.getFFTProperties().fftSizeLog2,
+                                                                     Window::Hann)
+                                       : nullptr;
+    nextFrameIndex = sharedFFT != nullptr ? sharedFFT->update() : 0;
+}
+
+void Spectroscope::pullFromAnalysisBus()
+{
+    if (sharedFFT == nullptr)
+    {
+        GraphicalComponent::pullFromAnalysisBus();
+        return;
+    }
+
+    sharedFFT->update();
+
+    float* magnitudes = fftEngine.getMagnitudesBuffer().getData();
+
+    while (sharedFFT->readFrame (nextFrameIndex, tempBlock))
+    {
+        for (int i = 0; i < sharedFFT->getNumBins(); ++i)
+            magnitudes[i] = jmax (magnitudes[i], tempBlock[i]);
+
+        needsRepaint = true;
+    }
+}
+
 void Spectroscope::flagForRepaint()
 {
     needsRepaint = true;
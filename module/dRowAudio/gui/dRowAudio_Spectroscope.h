@@ -90,6 +90,13 @@ public:
     /** @internal */
     void flagForRepaint();
 
+protected:
+    //==============================================================================
+    /** @internal */
+    void analysisBusChanged() override;
+    /** @internal */
+    void pullFromAnalysisBus() override;
+
 private:
     //==============================================================================
     FFTEngine fftEngine;
@@ -97,6 +104,8 @@ private:
     bool needsRepaint;
     juce::HeapBlock<float> tempBlock;
     FifoBuffer<float> circularBuffer;
+    AnalysisBus::SharedFFT* sharedFFT;
+    juce::int64 nextFrameIndex;
 
     bool logFrequency;
     juce::Image scopeImage;
@@ -0,0 +1,151 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+SpectrumRasteriser::SpectrumRasteriser()
+    : numBins (0),
+      numRows (0),
+      logFrequency (false)
+{
+    setColourGradient (ColourGradient (Colours::black, 0.0f, 0.0f,
+                                       Colours::white, 1.0f, 0.0f, false));
+}
+
+//==============================================================================
+void SpectrumRasteriser::setSize (int newNumBins, int newNumRows)
+{
+    jassert (newNumBins >= 0 && newNumRows >= 0);
+
+    if (numBins != newNumBins || numRows != newNumRows)
+    {
+        numBins = newNumBins;
+        numRows = newNumRows;
+
+        rowBinStart.malloc ((size_t) numRows);
+        rowBinEnd.malloc ((size_t) numRows);
+        rowLevels.malloc ((size_t) numRows);
+
+        updateRowMap();
+    }
+}
+
+void SpectrumRasteriser::setLogFrequencyDisplay (bool shouldDisplayLog)
+{
+    if (logFrequency != shouldDisplayLog)
+    {
+        logFrequency = shouldDisplayLog;
+        updateRowMap();
+    }
+}
+
+void SpectrumRasteriser::setColourGradient (const ColourGradient& gradient)
+{
+    for (int i = 0; i < 256; ++i)
+        colourTable[i] = gradient.getColourAtPosition (i / 255.0).getPixelARGB();
+}
+
+//==============================================================================
+void SpectrumRasteriser::renderColumn (Image& image, int x, int width, const float* magnitudes)
+{
+    jassert (image.getFormat() == Image::ARGB || image.getFormat() == Image::RGB);
+    jassert (image.getHeight() >= numRows);
+
+    const int startX = jmax (0, x);
+    const int endX = jmin (image.getWidth(), x + width);
+
+    if (numRows == 0 || numBins == 0 || endX <= startX)
+        return;
+
+    // find the level for each row once, regardless of the column width
+    for (int row = 0; row < numRows; ++row)
+    {
+        float maxMagnitude = magnitudes[rowBinStart[row]];
+
+        for (int bin = rowBinStart[row] + 1; bin < rowBinEnd[row]; ++bin)
+            maxMagnitude = jmax (maxMagnitude, magnitudes[bin]);
+
+        const float level = (float) jlimit (0.0, 1.0, 1.0 + (toDecibels (maxMagnitude) / 100.0));
+        rowLevels[row] = (uint8) roundToInt (level * 255.0f);
+    }
+
+    const Image::BitmapData bitmapData (image, startX, 0, endX - startX, numRows,
+                                        Image::BitmapData::writeOnly);
+    const int numCols = endX - startX;
+
+    // rows are stored top down, the row map bottom up
+    for (int row = 0; row < numRows; ++row)
+    {
+        const PixelARGB colour (colourTable[rowLevels[row]]);
+        uint8* pixel = bitmapData.getLinePointer (numRows - 1 - row);
+
+        if (bitmapData.pixelFormat == Image::ARGB)
+        {
+            for (int i = 0; i < numCols; ++i)
+            {
+                reinterpret_cast<PixelARGB*> (pixel)->set (colour);
+                pixel += bitmapData.pixelStride;
+            }
+        }
+        else
+        {
+            for (int i = 0; i < numCols; ++i)
+            {
+                reinterpret_cast<PixelRGB*> (pixel)->set (colour);
+                pixel += bitmapData.pixelStride;
+            }
+        }
+    }
+}
+
+//==============================================================================
+void SpectrumRasteriser::updateRowMap()
+{
+    if (numRows == 0 || numBins == 0)
+        return;
+
+    // maps a normalised row position to a fractional bin, matching the scales
+    // previously used by drawing each bin as a rectangle
+    auto binForProportion = [this] (double proportion) -> double
+    {
+        if (logFrequency)
+            return ((std::pow (40.0, proportion) - 1.0) / 39.0) * numBins;
+
+        return proportion * (numBins + 1);
+    };
+
+    for (int row = 0; row < numRows; ++row)
+    {
+        const int start = jlimit (0, numBins - 1, (int) binForProportion (row / (double) numRows));
+        const int end = jlimit (start + 1, numBins, (int) binForProportion ((row + 1) / (double) numRows));
+
+        rowBinStart[row] = start;
+        rowBinEnd[row] = end;
+    }
+}
@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef DROWAUDIO_SPECTRUMRASTERISER_H
+#define DROWAUDIO_SPECTRUMRASTERISER_H
+
+//==============================================================================
+/** Renders columns of FFT magnitudes directly into an Image.
+
+    Rather than drawing every bin with a Graphics::fillRect call this pre-computes
+    a map of which bins fall into each pixel row and a 256 entry colour look-up table.
+    Each column can then be written straight into the Image's BitmapData which is
+    many times quicker than going through the software renderer for large FFT sizes.
+
+    When more than one bin maps to the same row the loudest one is used, so peaks
+    are not lost when the image is shorter than the number of bins.
+
+    @see Sonogram, Spectrograph
+*/
+class SpectrumRasteriser
+{
+public:
+    //==============================================================================
+    /** Creates an empty SpectrumRasteriser.
+        You will need to call setSize() before rendering any columns.
+    */
+    SpectrumRasteriser();
+
+    //==============================================================================
+    /** Sets the number of bins and rows that the magnitudes will be mapped between.
+        This re-calculates the row to bin map so should only be called when one of these changes.
+    */
+    void setSize (int numBins, int numRows);
+
+    /** Sets the rows to represent a log or linear frequency scale. */
+    void setLogFrequencyDisplay (bool shouldDisplayLog);
+
+    /** Returns true if the rows represent a log frequency scale. */
+    bool getLogFrequencyDisplay() const noexcept        { return logFrequency; }
+
+    /** Sets the gradient used to colour the magnitudes.
+        The start of the gradient is used for silence and the end for full scale.
+        By default this is black to white.
+    */
+    void setColourGradient (const juce::ColourGradient& gradient);
+
+    //==============================================================================
+    /** Renders a column of magnitudes into an Image.
+
+        The magnitudes must contain at least the number of bins given to setSize().
+        The image must be at least as tall as the number of rows and be in either ARGB or RGB format.
+
+        @param image        The image to draw into.
+        @param x            The first pixel column to write.
+        @param width        The number of pixel columns to fill with this set of magnitudes.
+        @param magnitudes   The linear magnitudes to render.
+    */
+    void renderColumn (juce::Image& image, int x, int width, const float* magnitudes);
+
+private:
+    //==============================================================================
+    int numBins, numRows;
+    bool logFrequency;
+    juce::HeapBlock<int> rowBinStart, rowBinEnd;
+    juce::HeapBlock<juce::uint8> rowLevels;
+    juce::PixelARGB colourTable[256];
+
+    void updateRowMap();
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrumRasteriser)
+};
+
+#endif // DROWAUDIO_SPECTRUMRASTERISER_H
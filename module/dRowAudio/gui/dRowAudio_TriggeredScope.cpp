@@ -64,14 +64,15 @@ TriggeredScope::TriggeredScope (TimeSliceThread* tst) :
         c->maxBuffer.clear ((size_t) c->bufferSize);
     }
 
-    startTimer (1000 / 60);
+    VisualRefreshScheduler::getInstance()->addClient (this, *this, 60);
 }
 
 TriggeredScope::~TriggeredScope()
 {
     const ScopedLock sl (imageLock);
 
-    stopTimer();
+    if (VisualRefreshScheduler* scheduler = VisualRefreshScheduler::getInstanceWithoutCreating())
+        scheduler->removeClient (this);
 
     backgroundThreadToUse->removeTimeSliceClient (this);
 
@@ -90,6 +91,15 @@ void TriggeredScope::setNumChannels (int num)
     {
         c->minBuffer.clear ((size_t) c->bufferSize);
         c->maxBuffer.clear ((size_t) c->bufferSize);
+        c->decimator.setNumSamplesPerPoint (numSamplesPerPixel);
+    }
+
+    if (auto* c = channels.getFirst())
+    {
+        triggerMinBuffer.malloc ((size_t) c->bufferSize);
+        triggerMaxBuffer.malloc ((size_t) c->bufferSize);
+        traceMinBuffer.malloc ((size_t) c->bufferSize);
+        traceMaxBuffer.malloc ((size_t) c->bufferSize);
     }
 }
 
@@ -162,6 +172,7 @@ void TriggeredScope::resized()
 
 void TriggeredScope::paint (Graphics& g)
 {
+    const VisualRefreshScheduler::ScopedPaintTimer spt (*this);
     const ScopedLock sl (imageLock);
 
     g.drawImageAt (image, 0, 0);
@@ -183,7 +194,7 @@ void TriggeredScope::paint (Graphics& g)
     }
 }
 
-void TriggeredScope::timerCallback()
+void TriggeredScope::refreshVisual()
 {
     if (needToRepaint)
         repaint();
@@ -207,112 +218,120 @@ void TriggeredScope::processPendingSamples()
 {
     for (auto c : channels)
     {
-        int numSamples = c->samplesToProcess.getNumAvailable();
+        const int numSamples = c->samplesToProcess.getNumAvailable();
         c->samplesToProcess.readSamples (c->tempProcessingBlock, numSamples);
-        float* samples = c->tempProcessingBlock.getData();
 
-        while (--numSamples >= 0)
-        {
-            const float currentSample = *samples++;
+        c->decimator.setNumSamplesPerPoint (numSamplesPerPixel);
+        c->decimator.process (c->tempProcessingBlock, numSamples, [c] (float min, float max)
+                              {
+                                  c->minBuffer[c->bufferWritePos] = min;
+                                  c->maxBuffer[c->bufferWritePos] = max;
 
-            if (currentSample < c->currentMin)
-                c->currentMin = currentSample;
-            if (currentSample > c->currentMax)
-                c->currentMax = currentSample;
+                                  ++c->bufferWritePos %= c->bufferSize;
+                              });
+    }
+}
 
-            if (--c->numLeftToAverage == 0)
-            {
-                c->minBuffer[c->bufferWritePos] = c->currentMin;
-                c->maxBuffer[c->bufferWritePos] = c->currentMax;
+void TriggeredScope::fillTriggerBuffers (int bufferWritePos, int bufferSize, int startIndex, int numPoints)
+{
+    // unwraps a window of the circular buffers, where index 0 is the oldest value
+    auto unwrap = [bufferWritePos, bufferSize, startIndex, numPoints] (float* dest, const float* src)
+    {
+        const int first = (bufferWritePos + startIndex) % bufferSize;
+        const int numToEnd = jmin (numPoints, bufferSize - first);
+        FloatVectorOperations::copy (dest, src + first, numToEnd);
+        FloatVectorOperations::copy (dest + numToEnd, src, numPoints - numToEnd);
+    };
 
-                c->currentMax = -1.0f;
-                c->currentMin = 1.0f;
+    if (triggerChannel >= 0)
+    {
+        unwrap (triggerMinBuffer, channels[triggerChannel]->minBuffer);
+        unwrap (triggerMaxBuffer, channels[triggerChannel]->maxBuffer);
+        return;
+    }
 
-                ++c->bufferWritePos %= c->bufferSize;
-                c->numLeftToAverage = numSamplesPerPixel;
-            }
-        }
+    // average all the channels
+    FloatVectorOperations::clear (triggerMinBuffer, numPoints);
+    FloatVectorOperations::clear (triggerMaxBuffer, numPoints);
+
+    for (auto c : channels)
+    {
+        unwrap (traceMinBuffer, c->minBuffer);
+        unwrap (traceMaxBuffer, c->maxBuffer);
+
+        FloatVectorOperations::add (triggerMinBuffer, traceMinBuffer, numPoints);
+        FloatVectorOperations::add (triggerMaxBuffer, traceMaxBuffer, numPoints);
     }
+
+    const float scale = 1.0f / channels.size();
+    FloatVectorOperations::multiply (triggerMinBuffer, scale, numPoints);
+    FloatVectorOperations::multiply (triggerMaxBuffer, scale, numPoints);
 }
 
 int TriggeredScope::getTriggerPos()
 {
-    const int w = image.getWidth();
-    
-    int bufferReadPos = 0;
-    
-    auto minBuffer = [&] (int i) -> float
-    {
-        if (triggerChannel == -1)
-        {
-            float sum = 0;
-            for (auto c : channels)
-                sum += c->minBuffer[i];
-            
-            return sum / channels.size();
-        }
-        else
-        {
-            return channels[triggerChannel]->minBuffer[i];
-        }
-    };
-    
-    auto maxBuffer = [&] (int i) -> float
-    {
-        if (triggerChannel == -1)
-        {
-            float sum = 0;
-            for (auto c : channels)
-                sum += c->maxBuffer[i];
-            
-            return sum / channels.size();
-        }
-        else
-        {
-            return channels[triggerChannel]->maxBuffer[i];
-        }
-    };
-    
-    if (auto* c = triggerChannel >= 0 ? channels[triggerChannel] : channels.getFirst())
+    auto* c = triggerChannel >= 0 ? channels[triggerChannel] : channels.getFirst();
+
+    if (c == nullptr)
+        return 0;
+
+    const int w = jmin (image.getWidth(), c->bufferSize - 1);
+    const int bufferSize = c->bufferSize;
+    const int bufferWritePos = c->bufferWritePos;
+
+    int bufferReadPos = bufferWritePos - w;
+
+    if (bufferReadPos < 0)
+        bufferReadPos += bufferSize;
+
+    if (triggerMode == None)
+        return bufferReadPos;
+
+    // search backwards from a screen's width ago for the most recent trigger point,
+    // a screen's width at a time as the trigger is usually found in the first window
+    const float* mins = triggerMinBuffer;
+    const float* maxs = triggerMaxBuffer;
+    const float level = triggerLevel;
+    int windowEnd = bufferSize - w;
+
+    enum { searchBlockSize = 64 };
+
+    while (windowEnd > 0)
     {
-        bufferReadPos = c->bufferWritePos - w;
-        if (bufferReadPos < 0 )
-            bufferReadPos += c->bufferSize;
-        
-        if (triggerMode != None)
+        const int windowStart = jmax (0, windowEnd - jmax (1, w));
+        fillTriggerBuffers (bufferWritePos, bufferSize, windowStart, windowEnd - windowStart + 1);
+
+        // most blocks don't cross the level at all, so use the vectorised min and max
+        // to rule out a block's worth of points before checking them one at a time
+        for (int blockEnd = windowEnd; blockEnd > windowStart; blockEnd -= searchBlockSize)
         {
-            int posToTest = bufferReadPos;
-            int numToSearch = c->bufferSize;
-            while (--numToSearch >= 0)
+            const int blockStart = jmax (windowStart, blockEnd - searchBlockSize);
+            const int first = blockStart - windowStart;
+            const int num = blockEnd - blockStart;
+
+            const bool mayTrigger = triggerMode == Up
+                ? (FloatVectorOperations::findMinimum (mins + first, num) <= level
+                    && FloatVectorOperations::findMaximum (maxs + first + 1, num) > level)
+                : (FloatVectorOperations::findMaximum (mins + first, num) > level
+                    && FloatVectorOperations::findMinimum (maxs + first + 1, num) <= level);
+
+            if (! mayTrigger)
+                continue;
+
+            for (int index = blockEnd; index > blockStart; --index)
             {
-                int prevPosToTest = posToTest - 1;
-                if (prevPosToTest < 0)
-                    prevPosToTest += c->bufferSize;
-                
-                if (triggerMode == Up)
-                {
-                    if (minBuffer (prevPosToTest) <= triggerLevel
-                        && maxBuffer (posToTest) > triggerLevel)
-                    {
-                        bufferReadPos = posToTest;
-                        break;
-                    }
-                }
-                else
-                {
-                    if (minBuffer (prevPosToTest) > triggerLevel
-                        && maxBuffer (posToTest) <= triggerLevel)
-                    {
-                        bufferReadPos = posToTest;
-                        break;
-                    }
-                }
-                
-                if (--posToTest < 0)
-                    posToTest += c->bufferSize;
+                const int i = index - windowStart;
+                const bool triggered = triggerMode == Up ? (mins[i - 1] <= level && maxs[i] > level)
+                                                         : (mins[i - 1] > level && maxs[i] <= level);
+
+                if (triggered)
+                    return (bufferWritePos + index) % bufferSize;
             }
         }
+
+        windowEnd = windowStart;
     }
+
     return bufferReadPos;
 }
 
@@ -320,56 +339,41 @@ void TriggeredScope::renderImage()
 {
     const ScopedLock sl (imageLock);
 
-    image.clear ({0, 0, image.getWidth(), image.getHeight()}, Colours::transparentBlack);
-    
-    Graphics g (image);
+    image.clear (image.getBounds(), Colours::transparentBlack);
 
-    g.fillAll (Colours::transparentBlack);
+    if (channels.size() == 0)
+        return;
 
-    const int w = image.getWidth();
+    const int bufferSize = channels.getFirst()->bufferSize;
+    const int w = jmin (image.getWidth(), bufferSize);
     const int h = image.getHeight();
 
-    
-    
     int bufferReadPos = getTriggerPos();
-    
+
     bufferReadPos -= roundToInt (w * triggerPos);
     if (bufferReadPos < 0 )
-        bufferReadPos += channels[0]->bufferSize;
-    
+        bufferReadPos += bufferSize;
+
+    const Image::BitmapData destData (image, Image::BitmapData::readWrite);
+
     int ch = 0;
     for (auto c : channels)
     {
-        g.setColour (findColour (traceColourId + ch));
-        
-        int pos = bufferReadPos;
-        int currentX = 0;
-        Range<float> r0;
-        while (currentX < w)
-        {
-            ++pos;
-            if (pos == c->bufferSize)
-                pos = 0;
-
-            const float top = (1.0f - (0.5f + (0.5f * verticalZoomFactor * (verticalZoomOffset[ch] + c->maxBuffer[pos])))) * h;
-            const float bottom = (1.0f - (0.5f + (0.5f * verticalZoomFactor * (verticalZoomOffset[ch] + c->minBuffer[pos])))) * h;
-            
-            //jassert (top <= bottom);
-            
-            Range<float> r1 (top, bottom);
-
-            if (currentX == 0 || r1.intersects(r0))
-                g.drawVerticalLine (currentX, top, bottom);
-            else if (r0.getEnd() < r1.getStart())
-                g.drawLine (currentX - 1.0f, float (r0.getEnd()), float (currentX), float (r1.getEnd()));
-            else if (r0.getStart() > r1.getEnd())
-                g.drawLine (currentX - 1.0f, r0.getStart(), float (currentX), r1.getStart());
-            else
-                g.drawLine (currentX - 1.0f, top, float (currentX), bottom);
-            
-            ++currentX;
-            r0 = r1;
-        }
+        // gather the visible points into a contiguous block
+        const int start = (bufferReadPos + 1) % bufferSize;
+        const int numToEnd = jmin (w, bufferSize - start);
+
+        FloatVectorOperations::copy (traceMinBuffer, c->minBuffer + start, numToEnd);
+        FloatVectorOperations::copy (traceMaxBuffer, c->maxBuffer + start, numToEnd);
+        FloatVectorOperations::copy (traceMinBuffer + numToEnd, c->minBuffer, w - numToEnd);
+        FloatVectorOperations::copy (traceMaxBuffer + numToEnd, c->maxBuffer, w - numToEnd);
+
+        const float yScale = 0.5f * verticalZoomFactor * h;
+        const float yOffset = (0.5f * h) - (verticalZoomOffset[ch] * yScale);
+
+        PeakDecimator::renderTrace (destData, 0, traceMinBuffer, traceMaxBuffer, w,
+                                    findColour (traceColourId + ch), yOffset, yScale);
+
         ch++;
     }
 
@@ -32,6 +32,9 @@
 #ifndef DROWAUDIO_TRIGGERED_SCOPE_H
 #define DROWAUDIO_TRIGGERED_SCOPE_H
 
+#include "dRowAudio_PeakDecimator.h"
+#include "dRowAudio_VisualRefreshScheduler.h"
+
 /** Triggered Scope.
 
     This class is similar to the AudioOscilloscope except that it can be set to
@@ -45,7 +48,7 @@
     else happens later.
 */
 class TriggeredScope : public juce::Component,
-                       public juce::Timer,
+                       public VisualRefreshScheduler::Client,
                        public juce::TimeSliceClient
 {
 public:
@@ -124,7 +127,7 @@ public:
     /** @internal */
     void paint (juce::Graphics& g) override;
     /** @internal */
-    void timerCallback() override;
+    void refreshVisual() override;
     /** @internal */
     int useTimeSlice() override;
 
@@ -144,23 +147,19 @@ private:
     struct Channel
     {
         Channel() :
-          numLeftToAverage (4),
           bufferSize (4096),
           bufferWritePos (0),
           minBuffer ((size_t) bufferSize),
           maxBuffer ((size_t) bufferSize),
-          currentMax (-1.0f),
-          currentMin (1.0f),
           samplesToProcess (32768),
           tempProcessingBlock (32768)
         {}
-        
-        int numLeftToAverage;
+
         int bufferSize, bufferWritePos;
 
         juce::HeapBlock<float> minBuffer, maxBuffer;
 
-        float currentMax, currentMin;
+        PeakDecimator decimator;
         FifoBuffer<float> samplesToProcess;
         juce::HeapBlock<float> tempProcessingBlock;
     };
@@ -173,10 +172,13 @@ private:
     juce::Image image;
     juce::CriticalSection imageLock;
 
+    juce::HeapBlock<float> triggerMinBuffer, triggerMaxBuffer, traceMinBuffer, traceMaxBuffer;
+
     //==============================================================================
     void processPendingSamples();
     void renderImage();
     int getTriggerPos();
+    void fillTriggerBuffers (int bufferWritePos, int bufferSize, int startIndex, int numPoints);
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TriggeredScope)
@@ -0,0 +1,315 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+juce_ImplementSingleton (VisualRefreshScheduler)
+
+VisualRefreshScheduler::VisualRefreshScheduler()
+    : vBlankClient          (nullptr),
+      lastVBlankMs          (0.0),
+      lastFrameMs           (0.0),
+      frameBudgetMs         (0.0),
+      maximumRefreshRate    (60),
+      nextClientIndex       (0),
+      isPerformingFrame     (false)
+{
+}
+
+VisualRefreshScheduler::~VisualRefreshScheduler()
+{
+    stopTimer();
+    cancelPendingUpdate();
+    vBlankAttachment.reset();
+
+    clearSingletonInstance();
+}
+
+//==============================================================================
+void VisualRefreshScheduler::addClient (Client* client, Component& component, int refreshRateHz)
+{
+    JUCE_ASSERT_MESSAGE_MANAGER_IS_LOCKED
+    jassert (client != nullptr);
+    jassert (refreshRateHz > 0);
+
+    ClientInfo* info = findClient (client);
+
+    if (info == nullptr)
+    {
+        info = clients.add (new ClientInfo());
+        info->client = client;
+        info->lastRefreshMs = 0.0;
+    }
+
+    info->component = &component;
+    info->intervalMs = 1000.0 / jlimit (1, maximumRefreshRate, refreshRateHz);
+
+    triggerAsyncUpdate();
+
+    if (! isTimerRunning())
+        startTimerHz (maximumRefreshRate);
+}
+
+void VisualRefreshScheduler::removeClient (Client* client)
+{
+    JUCE_ASSERT_MESSAGE_MANAGER_IS_LOCKED
+
+    if (ClientInfo* info = findClient (client))
+    {
+        // clients may remove themselves during a frame so just mark them to be removed afterwards
+        info->client = nullptr;
+
+        if (! isPerformingFrame)
+            removeDeadClients();
+    }
+}
+
+bool VisualRefreshScheduler::isClientRegistered (Client* client) const
+{
+    return findClient (client) != nullptr;
+}
+
+//==============================================================================
+void VisualRefreshScheduler::setMaximumRefreshRate (int refreshRateHz)
+{
+    jassert (refreshRateHz > 0);
+    maximumRefreshRate = jmax (1, refreshRateHz);
+
+    for (auto* info : clients)
+        info->intervalMs = jmax (info->intervalMs, 1000.0 / maximumRefreshRate);
+
+    if (isTimerRunning())
+        startTimerHz (maximumRefreshRate);
+}
+
+void VisualRefreshScheduler::setFrameBudget (double budgetMs)
+{
+    frameBudgetMs = jmax (0.0, budgetMs);
+}
+
+//==============================================================================
+VisualRefreshScheduler::ClientStatistics VisualRefreshScheduler::getStatistics (Client* client) const
+{
+    if (ClientInfo* info = findClient (client))
+        return info->statistics;
+
+    return {};
+}
+
+void VisualRefreshScheduler::resetStatistics()
+{
+    for (auto* info : clients)
+        info->statistics = ClientStatistics();
+}
+
+//==============================================================================
+VisualRefreshScheduler::ScopedPaintTimer::ScopedPaintTimer (Client& clientToTime) noexcept
+    : client (clientToTime),
+      startTimeMs (Time::getMillisecondCounterHiRes())
+{
+}
+
+VisualRefreshScheduler::ScopedPaintTimer::~ScopedPaintTimer()
+{
+    if (VisualRefreshScheduler* scheduler = VisualRefreshScheduler::getInstanceWithoutCreating())
+        scheduler->addPaintTime (&client, Time::getMillisecondCounterHiRes() - startTimeMs);
+}
+
+//==============================================================================
+void VisualRefreshScheduler::timerCallback()
+{
+    // the timer is only a fallback for when there is no display to sync to
+    const double frameIntervalMs = 1000.0 / maximumRefreshRate;
+
+    if (Time::getMillisecondCounterHiRes() - lastVBlankMs > 2.0 * frameIntervalMs)
+        performFrame();
+}
+
+void VisualRefreshScheduler::handleAsyncUpdate()
+{
+    updateVBlankAttachment();
+}
+
+void VisualRefreshScheduler::performFrame()
+{
+    const double frameStartMs = Time::getMillisecondCounterHiRes();
+
+    // avoid refreshing twice if the vblank and the timer arrive close together
+    if (frameStartMs - lastFrameMs < 500.0 / maximumRefreshRate)
+        return;
+
+    lastFrameMs = frameStartMs;
+
+    const int numClients = clients.size();
+    const int startIndex = nextClientIndex < numClients ? nextClientIndex : 0;
+    double estimatedFrameMs = 0.0;
+    bool budgetExceeded = false;
+
+    isPerformingFrame = true;
+
+    for (int i = 0; i < numClients; ++i)
+    {
+        const int index = (startIndex + i) % numClients;
+        ClientInfo& info = *clients.getUnchecked (index);
+
+        if (info.client == nullptr || info.component == nullptr)
+            continue;
+
+        // allow a little slack so clients don't beat against the display rate
+        if (frameStartMs - info.lastRefreshMs < info.intervalMs - 2.0)
+            continue;
+
+        if (! isComponentVisible (*info.component))
+        {
+            ++info.statistics.numHidden;
+            info.lastRefreshMs = frameStartMs;
+            continue;
+        }
+
+        ClientStatistics& stats = info.statistics;
+        const double estimatedClientMs = stats.averageRefreshMs + stats.averagePaintMs;
+
+        if (budgetExceeded
+             || (frameBudgetMs > 0.0 && estimatedFrameMs > 0.0
+                 && estimatedFrameMs + estimatedClientMs > frameBudgetMs))
+        {
+            // start with this client next frame so nothing gets starved
+            if (! budgetExceeded)
+                nextClientIndex = index;
+
+            budgetExceeded = true;
+            ++stats.numDeferred;
+            continue;
+        }
+
+        const double refreshStartMs = Time::getMillisecondCounterHiRes();
+        info.client->refreshVisual();
+        const double refreshMs = Time::getMillisecondCounterHiRes() - refreshStartMs;
+
+        info.lastRefreshMs = frameStartMs;
+        stats.averageRefreshMs = stats.numRefreshes == 0 ? refreshMs
+                                                         : (0.9 * stats.averageRefreshMs) + (0.1 * refreshMs);
+        stats.peakFrameMs = jmax (stats.peakFrameMs, refreshMs);
+        ++stats.numRefreshes;
+
+        estimatedFrameMs += refreshMs + stats.averagePaintMs;
+    }
+
+    if (! budgetExceeded)
+        nextClientIndex = 0;
+
+    isPerformingFrame = false;
+
+    removeDeadClients();
+}
+
+void VisualRefreshScheduler::updateVBlankAttachment()
+{
+    if (vBlankClient != nullptr)
+        if (ClientInfo* info = findClient (vBlankClient))
+            if (info->component != nullptr)
+                return;
+
+    vBlankAttachment.reset();
+    vBlankClient = nullptr;
+
+    for (auto* info : clients)
+    {
+        if (info->client != nullptr && info->component != nullptr)
+        {
+            vBlankClient = info->client;
+            vBlankAttachment = std::make_unique<VBlankAttachment> (info->component.getComponent(),
+                                                                   [this]
+                                                                   {
+                                                                       lastVBlankMs = Time::getMillisecondCounterHiRes();
+                                                                       performFrame();
+                                                                   });
+            break;
+        }
+    }
+}
+
+void VisualRefreshScheduler::removeDeadClients()
+{
+    for (int i = clients.size(); --i >= 0;)
+        if (clients.getUnchecked (i)->client == nullptr)
+            clients.remove (i);
+
+    if (nextClientIndex >= clients.size())
+        nextClientIndex = 0;
+
+    // the attachment may be the one currently calling us so update it asynchronously
+    triggerAsyncUpdate();
+
+    if (clients.size() == 0)
+        stopTimer();
+}
+
+void VisualRefreshScheduler::addPaintTime (Client* client, double paintTimeMs)
+{
+    if (ClientInfo* info = findClient (client))
+    {
+        ClientStatistics& stats = info->statistics;
+        stats.averagePaintMs = stats.averagePaintMs == 0.0 ? paintTimeMs
+                                                           : (0.9 * stats.averagePaintMs) + (0.1 * paintTimeMs);
+        stats.peakFrameMs = jmax (stats.peakFrameMs, paintTimeMs);
+    }
+}
+
+VisualRefreshScheduler::ClientInfo* VisualRefreshScheduler::findClient (Client* client) const
+{
+    if (client != nullptr)
+        for (auto* info : clients)
+            if (info->client == client)
+                return info;
+
+    return nullptr;
+}
+
+bool VisualRefreshScheduler::isComponentVisible (const Component& component)
+{
+    if (! component.isShowing())
+        return false;
+
+    // walk up the hierarchy clipping to each parent, e.g. for components scrolled out of a Viewport
+    Rectangle<int> visibleArea (component.getLocalBounds());
+    const Component* current = &component;
+
+    while (const Component* parent = current->getParentComponent())
+    {
+        visibleArea = parent->getLocalArea (current, visibleArea).getIntersection (parent->getLocalBounds());
+
+        if (visibleArea.isEmpty())
+            return false;
+
+        current = parent;
+    }
+
+    return ! visibleArea.isEmpty();
+}
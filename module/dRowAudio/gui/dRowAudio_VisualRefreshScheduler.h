@@ -0,0 +1,190 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef DROWAUDIO_VISUALREFRESHSCHEDULER_H
+#define DROWAUDIO_VISUALREFRESHSCHEDULER_H
+
+//==============================================================================
+/** Drives the periodic refreshes of many visual components from a single source.
+
+    Rather than each meter or scope running its own Timer and waking the message
+    thread independently, components register themselves here along with the rate
+    at which they would like to be refreshed. All due components are then refreshed
+    together, aligned to the display's vertical blank where possible, so their
+    calls to repaint() are coalesced into a single paint by the peer.
+
+    Components that are hidden, or are scrolled out of view by their parents, are
+    skipped until they become visible again. The time each one takes to refresh and
+    paint is measured and can be used to hold a frame budget; when the budget is
+    exceeded the remaining components are deferred to the next frame.
+
+    All methods must be called on the message thread.
+
+    @see GraphicalComponent
+*/
+class VisualRefreshScheduler : private juce::Timer,
+                               private juce::AsyncUpdater,
+                               public juce::DeletedAtShutdown
+{
+public:
+    //==============================================================================
+    juce_DeclareSingleton (VisualRefreshScheduler, false)
+
+    /** Creates a VisualRefreshScheduler.
+        Usually you will use the singleton instance so all components share the same one.
+    */
+    VisualRefreshScheduler();
+
+    /** Destructor. */
+    ~VisualRefreshScheduler() override;
+
+    //==============================================================================
+    /** An object that can be periodically refreshed by a VisualRefreshScheduler. */
+    class Client
+    {
+    public:
+        /** Destructor. */
+        virtual ~Client() {}
+
+        /** Called on the message thread when the client is due to be refreshed.
+            This is where you would update any state and call repaint().
+        */
+        virtual void refreshVisual() = 0;
+    };
+
+    /** Registers a client to be refreshed at a given rate.
+
+        @param client           The client to call. If it is already registered this will update its rate.
+        @param component        The component that displays the client. This is used to determine
+                                if the client is visible and to find the display's refresh.
+        @param refreshRateHz    The rate at which to refresh the client. This will be limited to
+                                the maximum refresh rate of the scheduler.
+    */
+    void addClient (Client* client, juce::Component& component, int refreshRateHz);
+
+    /** Removes a previously registered client.
+        It's safe to call this from within a Client::refreshVisual() callback.
+    */
+    void removeClient (Client* client);
+
+    /** Returns true if a client is currently registered. */
+    bool isClientRegistered (Client* client) const;
+
+    //==============================================================================
+    /** Sets the maximum rate at which any client will be refreshed. The default is 60Hz. */
+    void setMaximumRefreshRate (int refreshRateHz);
+
+    /** Sets the time in milliseconds that refreshing and painting all clients should fit into.
+        If clients exceed this some will be deferred to subsequent frames.
+        A value of 0 disables the budget which is the default.
+    */
+    void setFrameBudget (double budgetMs);
+
+    //==============================================================================
+    /** Timing information for a single client. */
+    struct ClientStatistics
+    {
+        double averageRefreshMs = 0.0;  /**< The smoothed time spent in refreshVisual(). */
+        double averagePaintMs = 0.0;    /**< The smoothed time spent painting, if measured with a ScopedPaintTimer. */
+        double peakFrameMs = 0.0;       /**< The longest refresh or paint measured. */
+        juce::int64 numRefreshes = 0;   /**< The number of times the client has been refreshed. */
+        juce::int64 numHidden = 0;      /**< The number of refreshes skipped because the client wasn't visible. */
+        juce::int64 numDeferred = 0;    /**< The number of refreshes deferred to keep within the frame budget. */
+    };
+
+    /** Returns the timing information for a client. */
+    ClientStatistics getStatistics (Client* client) const;
+
+    /** Resets the statistics of all clients. */
+    void resetStatistics();
+
+    //==============================================================================
+    /** Measures the time taken to paint a client.
+
+        Create one of these at the start of your paint method to include the paint time
+        in the client's statistics and frame budget.
+
+        @code
+        void MyMeter::paint (Graphics& g)
+        {
+            const VisualRefreshScheduler::ScopedPaintTimer spt (*this);
+            ...
+        }
+        @endcode
+    */
+    class ScopedPaintTimer
+    {
+    public:
+        /** Starts timing a paint. */
+        explicit ScopedPaintTimer (Client& clientToTime) noexcept;
+
+        /** Stops timing and adds the time to the client's statistics. */
+        ~ScopedPaintTimer();
+
+    private:
+        Client& client;
+        const double startTimeMs;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedPaintTimer)
+    };
+
+private:
+    //==============================================================================
+    struct ClientInfo
+    {
+        Client* client;
+        juce::Component::SafePointer<juce::Component> component;
+        double intervalMs, lastRefreshMs;
+        ClientStatistics statistics;
+    };
+
+    juce::OwnedArray<ClientInfo> clients;
+    std::unique_ptr<juce::VBlankAttachment> vBlankAttachment;
+    Client* vBlankClient;
+    double lastVBlankMs, lastFrameMs, frameBudgetMs;
+    int maximumRefreshRate, nextClientIndex;
+    bool isPerformingFrame;
+
+    //==============================================================================
+    void timerCallback() override;
+    void handleAsyncUpdate() override;
+    void performFrame();
+    void updateVBlankAttachment();
+    void removeDeadClients();
+    void addPaintTime (Client* client, double paintTimeMs);
+    ClientInfo* findClient (Client* client) const;
+    static bool isComponentVisible (const juce::Component& component);
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VisualRefreshScheduler)
+};
+
+#endif // DROWAUDIO_VISUALREFRESHSCHEDULER_H
@@ -0,0 +1,376 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+//==============================================================================
+class AudioFileInfoCache::ReadJob : public ThreadPoolJob
+{
+public:
+    ReadJob (AudioFileInfoCache& owner_, const File& fileToRead)
+        : ThreadPoolJob ("AudioFileInfoCache read"),
+          owner (owner_),
+          file (fileToRead)
+    {
+    }
+
+    const File& getFile() const noexcept    { return file; }
+
+    JobStatus runJob() override
+    {
+        Info::Ptr info (new Info (file));
+        info->modificationTime = file.getLastModificationTime();
+
+        std::unique_ptr<AudioFormatReader> reader (owner.formatManager.createReaderFor (file));
+
+        if (reader != nullptr)
+        {
+            info->valid             = true;
+            info->lengthInSamples   = reader->lengthInSamples;
+            info->sampleRate        = reader->sampleRate;
+            info->numChannels       = reader->numChannels;
+            info->bitsPerSample     = reader->bitsPerSample;
+            info->formatName        = reader->getFormatName();
+            info->metadata          = reader->metadataValues;
+        }
+
+        const bool makeWaveform = reader != nullptr && reader->lengthInSamples > 0
+                                    && owner.createWaveforms.load();
+
+        // show the length straight away as the waveform takes a bit longer
+        owner.addResult (info.get(), ! makeWaveform, false);
+
+        if (makeWaveform)
+        {
+            Array<float> peaks;
+            const bool completed = readPeaks (*reader, peaks);
+
+            if (completed)
+            {
+                info->waveformImage = createWaveformImage (peaks);
+                info->waveformReady = true;
+            }
+
+            owner.addResult (info.get(), true, ! completed);
+        }
+
+        return jobHasFinished;
+    }
+
+private:
+    enum
+    {
+        numWaveformPoints = 56,
+        maxSamplesPerPoint = 16384,
+        waveformImageWidth = 56,
+        waveformImageHeight = 28
+    };
+
+    AudioFileInfoCache& owner;
+    const File file;
+
+    /*  Rather than reading the whole file this only reads a short section for
+        each point so long or compressed files don't hold up the pool.
+    */
+    bool readPeaks (AudioFormatReader& reader, Array<float>& peaks)
+    {
+        const int numChannels = jmin ((int) reader.numChannels, 2);
+        const int64 samplesPerPoint = reader.lengthInSamples / numWaveformPoints;
+        HeapBlock<Range<float>> levels ((size_t) jmax (1, numChannels));
+
+        for (int i = 0; i < numWaveformPoints; ++i)
+        {
+            if (shouldExit())
+                return false;
+
+            const int64 numSamples = jlimit ((int64) 1, (int64) maxSamplesPerPoint, samplesPerPoint);
+            reader.readMaxLevels (i * samplesPerPoint, numSamples, levels, numChannels);
+
+            float peak = 0.0f;
+
+            for (int c = 0; c < numChannels; ++c)
+                peak = jmax (peak, std::abs (levels[c].getStart()), std::abs (levels[c].getEnd()));
+
+            peaks.add (jmin (1.0f, peak));
+        }
+
+        return true;
+    }
+
+    static Image createWaveformImage (const Array<float>& peaks)
+    {
+        Image image (Image::ARGB, waveformImageWidth, waveformImageHeight, true, SoftwareImageType());
+        Graphics g (image);
+        g.setColour (Colours::grey);
+
+        const float centre = waveformImageHeight * 0.5f;
+        const float pointWidth = waveformImageWidth / (float) peaks.size();
+
+        for (int i = 0; i < peaks.size(); ++i)
+        {
+            const float halfHeight = jmax (0.5f, peaks.getUnchecked (i) * centre);
+            g.fillRect (i * pointWidth, centre - halfHeight, pointWidth, halfHeight * 2.0f);
+        }
+
+        return image;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ReadJob)
+};
+
+//==============================================================================
+class AudioFileInfoCache::WantedJobSelector : public ThreadPool::JobSelector
+{
+public:
+    WantedJobSelector (AudioFileInfoCache& owner_, const std::unordered_set<String>& wantedPaths_)
+        : owner (owner_),
+          wantedPaths (wantedPaths_)
+    {
+    }
+
+    bool isJobSuitable (ThreadPoolJob* job) override
+    {
+        auto* readJob = dynamic_cast<ReadJob*> (job);
+
+        if (readJob == nullptr)
+            return false;
+
+        const String path (readJob->getFile().getFullPathName());
+
+        if (wantedPaths.count (path) > 0)
+            return false;
+
+        // it may be read again if it's wanted later
+        owner.queuedPaths.erase (path);
+        return true;
+    }
+
+private:
+    AudioFileInfoCache& owner;
+    const std::unordered_set<String>& wantedPaths;
+};
+
+//==============================================================================
+AudioFileInfoCache::Info::Info (const File& sourceFile)
+    : file (sourceFile),
+      valid (false),
+      lengthInSamples (0),
+      sampleRate (0.0),
+      numChannels (0),
+      bitsPerSample (0),
+      waveformReady (false),
+      lastUsedTime (Time::getMillisecondCounter())
+{
+}
+
+double AudioFileInfoCache::Info::getLengthInSeconds() const noexcept
+{
+    return sampleRate > 0.0 ? lengthInSamples / sampleRate : 0.0;
+}
+
+Image AudioFileInfoCache::Info::getWaveformImage() const
+{
+    return waveformReady.load() ? waveformImage : Image();
+}
+
+//==============================================================================
+juce_ImplementSingleton (AudioFileInfoCache)
+
+AudioFileInfoCache::AudioFileInfoCache()
+    : pool (2),
+      createWaveforms (true),
+      maxNumCachedFiles (4096)
+{
+    formatManager.registerBasicFormats();
+}
+
+AudioFileInfoCache::~AudioFileInfoCache()
+{
+    pool.removeAllJobs (true, 10000);
+    cancelPendingUpdate();
+
+    clearSingletonInstance();
+}
+
+//==============================================================================
+void AudioFileInfoCache::addListener (Listener* listener)
+{
+    listeners.add (listener);
+}
+
+void AudioFileInfoCache::removeListener (Listener* listener)
+{
+    listeners.remove (listener);
+    setWantedFiles (listener, {});
+}
+
+//==============================================================================
+AudioFileInfoCache::Info::Ptr AudioFileInfoCache::getInfo (const File& file)
+{
+    auto found = infos.find (file.getFullPathName());
+
+    if (found == infos.end())
+        return nullptr;
+
+    found->second->lastUsedTime = Time::getMillisecondCounter();
+    return found->second;
+}
+
+void AudioFileInfoCache::setWantedFiles (Listener* client, const Array<File>& files)
+{
+    bool found = false;
+
+    for (int i = clients.size(); --i >= 0;)
+    {
+        Client& c = clients.getReference (i);
+
+        if (c.listener == client)
+        {
+            found = true;
+
+            if (files.isEmpty())
+                clients.remove (i);
+            else
+                c.files = files;
+        }
+    }
+
+    if (! found && ! files.isEmpty())
+        clients.add ({ client, files });
+
+    cancelUnwantedReads();
+
+    for (auto& file : files)
+    {
+        const String path (file.getFullPathName());
+
+        if (infos.count (path) == 0 && queuedPaths.count (path) == 0 && isAudioFile (file))
+        {
+            queuedPaths.insert (path);
+            pool.addJob (new ReadJob (*this, file), true);
+        }
+    }
+}
+
+void AudioFileInfoCache::invalidate (const File& file)
+{
+    infos.erase (file.getFullPathName());
+}
+
+bool AudioFileInfoCache::isAudioFile (const File& file) const
+{
+    return file.hasFileExtension (formatManager.getWildcardForAllFormats().removeCharacters ("*"));
+}
+
+void AudioFileInfoCache::setMaxNumCachedFiles (int newMaximum)
+{
+    maxNumCachedFiles = jmax (1, newMaximum);
+    removeOldInfos();
+}
+
+//==============================================================================
+void AudioFileInfoCache::cancelUnwantedReads()
+{
+    std::unordered_set<String> wantedPaths;
+
+    for (auto& c : clients)
+        for (auto& file : c.files)
+            wantedPaths.insert (file.getFullPathName());
+
+    // this doesn't wait, any running reads will stop at the next section of the waveform
+    WantedJobSelector selector (*this, wantedPaths);
+    pool.removeAllJobs (true, 0, &selector);
+}
+
+void AudioFileInfoCache::removeOldInfos()
+{
+    if ((int) infos.size() <= maxNumCachedFiles)
+        return;
+
+    // throw away the least recently used quarter so this doesn't happen for every file
+    std::vector<uint32> times;
+    times.reserve (infos.size());
+
+    for (auto& i : infos)
+        times.push_back (i.second->lastUsedTime);
+
+    const size_t numToKeep = (size_t) jmax (1, maxNumCachedFiles * 3 / 4);
+    std::nth_element (times.begin(), times.end() - (std::ptrdiff_t) numToKeep, times.end());
+    const uint32 oldestTimeToKeep = *(times.end() - (std::ptrdiff_t) numToKeep);
+
+    for (auto i = infos.begin(); i != infos.end();)
+    {
+        if (i->second->lastUsedTime < oldestTimeToKeep)
+            i = infos.erase (i);
+        else
+            ++i;
+    }
+}
+
+void AudioFileInfoCache::addResult (Info* info, bool finished, bool cancelled)
+{
+    {
+        const ScopedLock sl (resultLock);
+        results.add ({ info, finished, cancelled });
+    }
+
+    triggerAsyncUpdate();
+}
+
+void AudioFileInfoCache::handleAsyncUpdate()
+{
+    Array<Result> newResults;
+
+    {
+        const ScopedLock sl (resultLock);
+        newResults.swapWith (results);
+    }
+
+    for (auto& r : newResults)
+    {
+        const String path (r.info->getFile().getFullPathName());
+
+        if (r.finished)
+            queuedPaths.erase (path);
+
+        // forget it so the waveform is made if it's wanted again
+        if (r.cancelled)
+        {
+            infos.erase (path);
+            continue;
+        }
+
+        infos[path] = r.info;
+
+        const Info::Ptr info (r.info);
+        listeners.call ([&info] (Listener& l) { l.audioFileInfoChanged (info); });
+    }
+
+    removeOldInfos();
+}
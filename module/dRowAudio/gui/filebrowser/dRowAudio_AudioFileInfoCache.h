@@ -0,0 +1,224 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef DROWAUDIO_AUDIOFILEINFOCACHE_H
+#define DROWAUDIO_AUDIOFILEINFOCACHE_H
+
+//==============================================================================
+/** Reads the details of audio files on a shared pool of background threads and
+    caches the results.
+
+    This is used by the file browsers to show the length and a small waveform for
+    audio files without having to load them. Only the reader's header is needed
+    for the length, sample rate, channels and tags. Optionally, a rough waveform
+    is then made by reading short sections spread over the file.
+
+    Clients tell the cache which files they're about to show with setWantedFiles().
+    Only these are read, and reads for files that no client wants any more are
+    cancelled. This keeps the number of open readers and queued reads bounded
+    while someone scrolls quickly through a large directory.
+
+    @see CachedFileListComponent, DirectoryScanCache
+*/
+class AudioFileInfoCache : public juce::DeletedAtShutdown,
+                           private juce::AsyncUpdater
+{
+public:
+    //==============================================================================
+    juce_DeclareSingleton (AudioFileInfoCache, false)
+
+    /** Creates an AudioFileInfoCache.
+        You'll normally want to use the singleton instance.
+    */
+    AudioFileInfoCache();
+
+    /** Destructor. */
+    ~AudioFileInfoCache() override;
+
+    //==============================================================================
+    /** The details read from an audio file. */
+    class Info : public juce::ReferenceCountedObject
+    {
+    public:
+        using Ptr = juce::ReferenceCountedObjectPtr<Info>;
+
+        /** Returns the file these are the details of. */
+        const juce::File& getFile() const noexcept                  { return file; }
+
+        /** Returns the modification time of the file when it was read. */
+        juce::Time getModificationTime() const noexcept             { return modificationTime; }
+
+        /** Returns true if the file could be opened as an audio file. */
+        bool isValid() const noexcept                               { return valid; }
+
+        /** Returns the length of the file in samples. */
+        juce::int64 getLengthInSamples() const noexcept             { return lengthInSamples; }
+
+        /** Returns the sample rate of the file. */
+        double getSampleRate() const noexcept                       { return sampleRate; }
+
+        /** Returns the length of the file in seconds. */
+        double getLengthInSeconds() const noexcept;
+
+        /** Returns the number of channels in the file. */
+        unsigned int getNumChannels() const noexcept                { return numChannels; }
+
+        /** Returns the bit depth of the file. */
+        unsigned int getBitsPerSample() const noexcept              { return bitsPerSample; }
+
+        /** Returns the name of the format the file was read with. */
+        const juce::String& getFormatName() const noexcept          { return formatName; }
+
+        /** Returns the tags found in the file. */
+        const juce::StringPairArray& getMetadata() const noexcept   { return metadata; }
+
+        /** Returns true once the waveform has been made. */
+        bool hasWaveform() const noexcept                           { return waveformReady.load(); }
+
+        /** Returns a small image of the waveform.
+            This will be invalid until hasWaveform() returns true.
+        */
+        juce::Image getWaveformImage() const;
+
+    private:
+        friend class AudioFileInfoCache;
+
+        explicit Info (const juce::File& sourceFile);
+
+        const juce::File file;
+        juce::Time modificationTime;
+        bool valid;
+        juce::int64 lengthInSamples;
+        double sampleRate;
+        unsigned int numChannels, bitsPerSample;
+        juce::String formatName;
+        juce::StringPairArray metadata;
+
+        juce::Image waveformImage;
+        std::atomic<bool> waveformReady;
+        juce::uint32 lastUsedTime;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Info)
+    };
+
+    //==============================================================================
+    /** Receives callbacks on the message thread as files are read. */
+    class Listener
+    {
+    public:
+        /** Destructor. */
+        virtual ~Listener() = default;
+
+        /** Called when the details of a file have been read or its waveform has been made. */
+        virtual void audioFileInfoChanged (const Info::Ptr& info) = 0;
+    };
+
+    /** Adds a listener. */
+    void addListener (Listener* listener);
+
+    /** Removes a previously added listener.
+        Any files it wanted will no longer be read for it.
+    */
+    void removeListener (Listener* listener);
+
+    //==============================================================================
+    /** Returns the details of a file if they have been read, otherwise nullptr. */
+    Info::Ptr getInfo (const juce::File& file);
+
+    /** Sets the files a listener is about to show, most important first.
+        Any that haven't been read yet will be queued, and any queued or running
+        reads that no listener wants any more are cancelled.
+    */
+    void setWantedFiles (Listener* client, const juce::Array<juce::File>& files);
+
+    /** Throws away the details of a file, e.g. if it has changed since it was read. */
+    void invalidate (const juce::File& file);
+
+    /** Returns true if the file's extension is one of the known audio formats. */
+    bool isAudioFile (const juce::File& file) const;
+
+    //==============================================================================
+    /** Sets whether waveforms should be made after the details have been read. */
+    void setCreatesWaveforms (bool shouldCreateWaveforms) noexcept  { createWaveforms = shouldCreateWaveforms; }
+
+    /** Sets the maximum number of files to keep the details of. */
+    void setMaxNumCachedFiles (int newMaximum);
+
+    /** Returns the AudioFormatManager used to open files.
+        You can register extra formats with this before any files are read.
+    */
+    juce::AudioFormatManager& getAudioFormatManager() noexcept      { return formatManager; }
+
+private:
+    //==============================================================================
+    class ReadJob;
+    class WantedJobSelector;
+
+    struct Client
+    {
+        Listener* listener;
+        juce::Array<juce::File> files;
+    };
+
+    struct Result
+    {
+        Info::Ptr info;
+        bool finished, cancelled;
+    };
+
+    juce::AudioFormatManager formatManager;
+    juce::ThreadPool pool;
+    std::atomic<bool> createWaveforms;
+
+    std::unordered_map<juce::String, Info::Ptr> infos;
+    std::unordered_set<juce::String> queuedPaths;
+    int maxNumCachedFiles;
+
+    juce::Array<Client> clients;
+    juce::ListenerList<Listener> listeners;
+
+    juce::CriticalSection resultLock;
+    juce::Array<Result> results;
+
+    //==============================================================================
+    bool isWanted (const juce::File& file) const;
+    void cancelUnwantedReads();
+    void removeOldInfos();
+    void addResult (Info* info, bool finished, bool cancelled);
+
+    /** @internal */
+    void handleAsyncUpdate() override;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioFileInfoCache)
+};
+
+#endif // DROWAUDIO_AUDIOFILEINFOCACHE_H
@@ -38,7 +38,6 @@ BasicFileBrowser::BasicFileBrowser (int flags_,
     : FileFilter (""),
       fileFilter (fileFilter_),
       flags (flags_),
-      thread ("Juce BasicFileBrowser"),
       showResizer(true)
 {
     // You need to specify one or other of the open/save flags..
@@ -65,9 +64,7 @@ BasicFileBrowser::BasicFileBrowser (int flags_,
         filename = initialFileOrDirectory.getFileName();
     }
 
-    fileList = std::make_unique<DirectoryContentsList> ((FileFilter*)this, thread);
-
-    FileListComponent* const list = new FileListComponent (*fileList);
+    CachedFileListComponent* const list = new CachedFileListComponent (this);
     fileListComponent.reset (list);
     list->setOutlineThickness (0);
     list->getViewport()->setScrollBarThickness (10);
@@ -86,16 +83,11 @@ BasicFileBrowser::BasicFileBrowser (int flags_,
     resizer->setMouseCursor (MouseCursor::LeftRightResizeCursor);
 
     setRoot (currentRoot);
-
-    thread.startThread();
 }
 
 BasicFileBrowser::~BasicFileBrowser()
 {
     fileListComponent = nullptr;
-    fileList = nullptr;
-
-    thread.stopThread (10000);
 }
 
 //==============================================================================
@@ -192,7 +184,7 @@ void BasicFileBrowser::setRoot (const File& newRootDirectory)
     }
 
     currentRoot = newRootDirectory;
-    fileList->setDirectory (currentRoot, true, true);
+    fileListComponent->setDirectory (currentRoot);
 
     if (callListeners)
     {
@@ -203,7 +195,7 @@ void BasicFileBrowser::setRoot (const File& newRootDirectory)
 
 void BasicFileBrowser::refresh()
 {
-    fileList->refresh();
+    fileListComponent->refresh();
 }
 
 void BasicFileBrowser::setFileFilter (const FileFilter* const newFileFilter)
@@ -211,7 +203,9 @@ void BasicFileBrowser::setFileFilter (const FileFilter* const newFileFilter)
     if (fileFilter != newFileFilter)
     {
         fileFilter = newFileFilter;
-        refresh();
+
+        // the cached entries are still valid, they just need filtering again
+        fileListComponent->setFileFilter (this);
     }
 }
 
@@ -222,26 +216,27 @@ String BasicFileBrowser::getActionVerb() const
 
 int BasicFileBrowser::getLongestWidth()
 {
-    const int noFiles = fileList->getNumFiles();
+    const int noFiles = fileListComponent->getNumFiles();
     int stringWidth = 0;
 
-    FileListComponent* list = dynamic_cast<FileListComponent*> (fileListComponent.get());
-    if (list != nullptr)
+    Font temp (fileListComponent->getRowHeight() * 0.7f);
+    for (int i = 0; i < noFiles; ++i)
     {
-        Font temp (list->getRowHeight() * 0.7f);
-        for (int i = 0; i < noFiles; ++i)
-        {
-            int itemWidth = temp.getStringWidth (fileList->getFile(i).getFileName());
-            if (itemWidth >    stringWidth)
-                stringWidth = itemWidth;
-        }
-        stringWidth += (2 * list->getRowHeight()) + 30;
+        int itemWidth = temp.getStringWidth (fileListComponent->getFileName (i));
+        if (itemWidth >    stringWidth)
+            stringWidth = itemWidth;
     }
+    stringWidth += (2 * fileListComponent->getRowHeight()) + 30;
 
     return stringWidth;
 }
 
-DirectoryContentsDisplayComponent* BasicFileBrowser::getDisplayComponent() const noexcept
+void BasicFileBrowser::setShowsAudioFileInfo (bool shouldShowAudioFileInfo)
+{
+    fileListComponent->setShowsAudioFileInfo (shouldShowAudioFileInfo);
+}
+
+CachedFileListComponent* BasicFileBrowser::getDisplayComponent() const noexcept
 {
     return fileListComponent.get();
 }
@@ -252,26 +247,21 @@ void BasicFileBrowser::resized()
     const int height = getHeight();
     const int width = getWidth();
 
-    FileListComponent* list = dynamic_cast<FileListComponent*> (fileListComponent.get());
+    fileListComponent->setBounds (0, 0, width, height);
+    ScrollBar& bar = fileListComponent->getVerticalScrollBar();
+    const int size = roundToInt (bar.getWidth() * 1.5f);
 
-    if (list != nullptr)
+    if (showResizer)
     {
-        list->setBounds (0, 0, width, height);
-        ScrollBar& bar = list->getVerticalScrollBar();
-        const int size = roundToInt (bar.getWidth() * 1.5f);
+        bar.setTransform (AffineTransform::scale (1, (height - (float) size) / height));
 
-        if (showResizer)
-        {
-            bar.setTransform (AffineTransform::scale (1, (height - (float) size) / height));
-
-            resizeLimits.setSizeLimits (150, height, 1600, height);
-            resizer->setBounds (roundToInt (width - size * (2.0f / 3.0f)), height - size,
-                                roundToInt (size * (2.0f / 3.0f)), size);
-        }
-        else
-        {
-            bar.setTransform ({});
-        }
+        resizeLimits.setSizeLimits (150, height, 1600, height);
+        resizer->setBounds (roundToInt (width - size * (2.0f / 3.0f)), height - size,
+                            roundToInt (size * (2.0f / 3.0f)), size);
+    }
+    else
+    {
+        bar.setTransform ({});
     }
 }
 
@@ -338,8 +328,7 @@ bool BasicFileBrowser::keyPressed (const KeyPress& key)
     if (key.getModifiers().isCommandDown()
         && (key.getKeyCode() == 'H' || key.getKeyCode() == 'h'))
     {
-        fileList->setIgnoresHiddenFiles (! fileList->ignoresHiddenFiles());
-        fileList->refresh();
+        fileListComponent->setIgnoresHiddenFiles (! fileListComponent->ignoresHiddenFiles());
         return true;
     }
 #endif
@@ -32,10 +32,15 @@
 #ifndef DROWAUDIO_BASICFILEBROWSER_H
 #define DROWAUDIO_BASICFILEBROWSER_H
 
+#include "dRowAudio_CachedFileListComponent.h"
+
 /** A BasicFileBrowser with an optional corner resizer.
 
     This is very similar to a FileBrowserComponent expect it does not have the file
     list box, go up button etc.
+
+    Directories are read through the shared DirectoryScanCache so they are
+    scanned in the background and revisiting one is instant.
  */
 class  BasicFileBrowser : public juce::Component,
                           private juce::FileBrowserListener,
@@ -169,6 +174,11 @@ public:
      */
     int getLongestWidth();
 
+    /** Sets whether the length and a small waveform of audio files should be shown.
+        These are read in the background by the AudioFileInfoCache.
+     */
+    void setShowsAudioFileInfo (bool shouldShowAudioFileInfo);
+
     //==============================================================================
     /** @internal */
     void resized() override;
@@ -190,11 +200,10 @@ public:
     bool isDirectorySuitable (const juce::File&) const override;
 
     /** @internal */
-    juce::DirectoryContentsDisplayComponent* getDisplayComponent() const noexcept;
+    CachedFileListComponent* getDisplayComponent() const noexcept;
 
 private:
     //==============================================================================
-    std::unique_ptr<juce::DirectoryContentsList> fileList;
     const FileFilter* fileFilter;
 
     int flags;
@@ -202,9 +211,7 @@ private:
     juce::Array<juce::File> chosenFiles;
     juce::ListenerList <FileBrowserListener> listeners;
 
-    std::unique_ptr<juce::DirectoryContentsDisplayComponent> fileListComponent;
-
-    juce::TimeSliceThread thread;
+    std::unique_ptr<CachedFileListComponent> fileListComponent;
 
     void sendListenerChangeMessage();
     bool isFileOrDirSuitable (const juce::File& f) const;
@@ -0,0 +1,405 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+CachedFileListComponent::CachedFileListComponent (const FileFilter* fileFilter_)
+    : ListBox ({}, nullptr),
+      DirectoryContentsDisplayComponent (DirectoryScanCache::getInstance()->getPlaceholderContentsList()),
+      fileFilter (fileFilter_),
+      ignoreHiddenFiles (true),
+      showAudioFileInfo (false),
+      numEntriesChecked (0)
+{
+    setModel (this);
+    getVerticalScrollBar().addListener (this);
+    DirectoryScanCache::getInstance()->addListener (this);
+}
+
+CachedFileListComponent::~CachedFileListComponent()
+{
+    setShowsAudioFileInfo (false);
+    getVerticalScrollBar().removeListener (this);
+    DirectoryScanCache::getInstance()->removeListener (this);
+}
+
+//==============================================================================
+void CachedFileListComponent::setDirectory (const File& newDirectory)
+{
+    if (newDirectory == directory && contents != nullptr)
+        return;
+
+    directory = newDirectory;
+    showContents (DirectoryScanCache::getInstance()->getContents (directory));
+    scrollToTop();
+}
+
+void CachedFileListComponent::refresh()
+{
+    // this will call back with the new contents
+    DirectoryScanCache::getInstance()->rescan (directory);
+}
+
+void CachedFileListComponent::setFileFilter (const FileFilter* newFileFilter)
+{
+    fileFilter = newFileFilter;
+    updateRows (true);
+}
+
+void CachedFileListComponent::setIgnoresHiddenFiles (bool shouldIgnoreHiddenFiles)
+{
+    if (ignoreHiddenFiles != shouldIgnoreHiddenFiles)
+    {
+        ignoreHiddenFiles = shouldIgnoreHiddenFiles;
+        updateRows (true);
+    }
+}
+
+bool CachedFileListComponent::isStillLoading() const noexcept
+{
+    return contents != nullptr && ! contents->isComplete();
+}
+
+void CachedFileListComponent::setShowsAudioFileInfo (bool shouldShowAudioFileInfo)
+{
+    if (showAudioFileInfo == shouldShowAudioFileInfo)
+        return;
+
+    showAudioFileInfo = shouldShowAudioFileInfo;
+
+    if (showAudioFileInfo)
+    {
+        AudioFileInfoCache::getInstance()->addListener (this);
+        updateWantedAudioFiles();
+    }
+    else
+    {
+        AudioFileInfoCache::getInstance()->removeListener (this);
+    }
+
+    repaint();
+}
+
+//==============================================================================
+File CachedFileListComponent::getFile (int index) const
+{
+    if (auto* entry = getEntry (index))
+        return directory.getChildFile (entry->filename);
+
+    return {};
+}
+
+String CachedFileListComponent::getFileName (int index) const
+{
+    if (auto* entry = getEntry (index))
+        return entry->filename;
+
+    return {};
+}
+
+//==============================================================================
+int CachedFileListComponent::getNumSelectedFiles() const
+{
+    return getNumSelectedRows();
+}
+
+File CachedFileListComponent::getSelectedFile (int index) const
+{
+    return getFile (getSelectedRow (index));
+}
+
+void CachedFileListComponent::deselectAllFiles()
+{
+    deselectAllRows();
+}
+
+void CachedFileListComponent::scrollToTop()
+{
+    getVerticalScrollBar().setCurrentRangeStart (0);
+}
+
+void CachedFileListComponent::resized()
+{
+    ListBox::resized();
+    updateWantedAudioFiles();
+}
+
+void CachedFileListComponent::setSelectedFile (const File& file)
+{
+    if (file.getParentDirectory() == directory)
+    {
+        const String filename (file.getFileName());
+
+        for (int i = 0; i < rows.size(); ++i)
+        {
+            if (getEntry (i)->filename == filename)
+            {
+                selectRow (i);
+                return;
+            }
+        }
+    }
+
+    deselectAllRows();
+}
+
+//==============================================================================
+void CachedFileListComponent::showContents (const DirectoryScanCache::Contents::Ptr& newContents)
+{
+    contents = newContents;
+    entries.clearQuick();
+    contents->copyEntries (entries, 0);
+    updateRows (true);
+}
+
+void CachedFileListComponent::updateRows (bool rebuild)
+{
+    // rows will move as entries are added so the selection is restored by name
+    std::unordered_set<String> selectedNames;
+
+    for (int i = 0; i < getNumSelectedRows(); ++i)
+        if (auto* entry = getEntry (getSelectedRow (i)))
+            selectedNames.insert (entry->filename);
+
+    if (rebuild)
+    {
+        rows.clearQuick();
+        numEntriesChecked = 0;
+    }
+
+    const int numOldRows = rows.size();
+
+    for (int i = numEntriesChecked; i < entries.size(); ++i)
+        if (isEntrySuitable (entries.getReference (i)))
+            rows.add (i);
+
+    numEntriesChecked = entries.size();
+
+    // directories first, then in the same order as a DirectoryContentsList
+    auto comesBefore = [this] (int first, int second)
+    {
+        const DirectoryScanCache::Entry& a = entries.getReference (first);
+        const DirectoryScanCache::Entry& b = entries.getReference (second);
+
+        if (a.isDirectory != b.isDirectory)
+            return a.isDirectory;
+
+        return a.filename.compareNatural (b.filename) < 0;
+    };
+
+    std::sort (rows.begin() + numOldRows, rows.end(), comesBefore);
+    std::inplace_merge (rows.begin(), rows.begin() + numOldRows, rows.end(), comesBefore);
+
+    updateContent();
+
+    if (! selectedNames.empty())
+    {
+        SparseSet<int> selection;
+
+        for (int i = 0; i < rows.size(); ++i)
+            if (selectedNames.count (getEntry (i)->filename) > 0)
+                selection.addRange (Range<int> (i, i + 1));
+
+        setSelectedRows (selection, dontSendNotification);
+    }
+
+    updateWantedAudioFiles();
+    repaint();
+}
+
+bool CachedFileListComponent::isEntrySuitable (const DirectoryScanCache::Entry& entry) const
+{
+    if (ignoreHiddenFiles && entry.isHidden)
+        return false;
+
+    if (fileFilter == nullptr)
+        return true;
+
+    const File file (directory.getChildFile (entry.filename));
+
+    return entry.isDirectory ? fileFilter->isDirectorySuitable (file)
+                             : fileFilter->isFileSuitable (file);
+}
+
+const DirectoryScanCache::Entry* CachedFileListComponent::getEntry (int row) const noexcept
+{
+    return isPositiveAndBelow (row, rows.size()) ? &entries.getReference (rows.getUnchecked (row))
+                                                 : nullptr;
+}
+
+//==============================================================================
+int CachedFileListComponent::getNumRows()
+{
+    return rows.size();
+}
+
+void CachedFileListComponent::paintListBoxItem (int row, Graphics& g, int width, int height, bool rowIsSelected)
+{
+    if (auto* entry = getEntry (row))
+    {
+        const File file (directory.getChildFile (entry->filename));
+        String sizeDescription;
+        Image waveform;
+
+        if (! entry->isDirectory)
+        {
+            sizeDescription = File::descriptionOfSizeInBytes (entry->fileSize);
+
+            if (showAudioFileInfo)
+            {
+                if (auto info = AudioFileInfoCache::getInstance()->getInfo (file))
+                {
+                    if (info->isValid())
+                        sizeDescription = secondsToTimeLength (info->getLengthInSeconds() * 1000.0) + "  " + sizeDescription;
+
+                    waveform = info->getWaveformImage();
+                }
+            }
+        }
+
+        getLookAndFeel().drawFileBrowserRow (g, width, height,
+                                             file, entry->filename, waveform.isValid() ? &waveform : nullptr,
+                                             sizeDescription, entry->modificationTime.toString (true, true),
+                                             entry->isDirectory, rowIsSelected, row, *this);
+    }
+}
+
+void CachedFileListComponent::selectedRowsChanged (int lastRowSelected)
+{
+    sendSelectionChangeMessage();
+
+    // the user is likely to open a directory they've selected so start scanning it
+    const DirectoryScanCache::Entry* entry = getNumSelectedRows() == 1 ? getEntry (lastRowSelected) : nullptr;
+
+    if (entry != nullptr && entry->isDirectory)
+        DirectoryScanCache::getInstance()->prefetch (getFile (lastRowSelected));
+    else
+        DirectoryScanCache::getInstance()->cancelPrefetch();
+}
+
+void CachedFileListComponent::listBoxItemClicked (int row, const MouseEvent& e)
+{
+    // the base class only sends messages for its own DirectoryContentsList
+    const File file (getFile (row));
+    Component::BailOutChecker checker (this);
+    listeners.callChecked (checker, &FileBrowserListener::fileClicked, file, e);
+}
+
+void CachedFileListComponent::listBoxItemDoubleClicked (int row, const MouseEvent&)
+{
+    sendDoubleClick (row);
+}
+
+void CachedFileListComponent::returnKeyPressed (int lastRowSelected)
+{
+    sendDoubleClick (lastRowSelected);
+}
+
+void CachedFileListComponent::updateWantedAudioFiles()
+{
+    if (! showAudioFileInfo)
+        return;
+
+    AudioFileInfoCache* infoCache = AudioFileInfoCache::getInstance();
+    Array<File> wantedFiles;
+
+    const int firstVisibleRow = jmax (0, getRowContainingPosition (0, 0));
+    const int numVisibleRows = getNumRowsOnScreen();
+
+    auto addRow = [&] (int row)
+    {
+        if (auto* entry = getEntry (row))
+        {
+            if (entry->isDirectory)
+                return;
+
+            const File file (directory.getChildFile (entry->filename));
+
+            // the file has changed since it was read
+            if (auto info = infoCache->getInfo (file))
+                if (info->getModificationTime() != entry->modificationTime)
+                    infoCache->invalidate (file);
+
+            wantedFiles.add (file);
+        }
+    };
+
+    // the visible rows first, then the page below and the page above
+    for (int i = 0; i < numVisibleRows; ++i)
+        addRow (firstVisibleRow + i);
+
+    for (int i = 0; i < numVisibleRows; ++i)
+        addRow (firstVisibleRow + numVisibleRows + i);
+
+    for (int i = 1; i <= numVisibleRows; ++i)
+        addRow (firstVisibleRow - i);
+
+    infoCache->setWantedFiles (this, wantedFiles);
+}
+
+void CachedFileListComponent::sendDoubleClick (int row)
+{
+    // the base class only sends messages for its own DirectoryContentsList
+    const File file (getFile (row));
+    Component::BailOutChecker checker (this);
+    listeners.callChecked (checker, &FileBrowserListener::fileDoubleClicked, file);
+}
+
+void CachedFileListComponent::scrollBarMoved (ScrollBar*, double)
+{
+    updateWantedAudioFiles();
+}
+
+void CachedFileListComponent::directoryContentsChanged (const DirectoryScanCache::Contents::Ptr& changedContents)
+{
+    if (changedContents->getDirectory() != directory)
+        return;
+
+    if (changedContents != contents)
+    {
+        showContents (changedContents);
+    }
+    else
+    {
+        const int numOldEntries = entries.size();
+        contents->copyEntries (entries, numOldEntries);
+
+        if (entries.size() != numOldEntries)
+            updateRows (false);
+    }
+
+    if (onContentsChanged != nullptr)
+        onContentsChanged();
+}
+
+void CachedFileListComponent::audioFileInfoChanged (const AudioFileInfoCache::Info::Ptr& info)
+{
+    if (info->getFile().getParentDirectory() == directory)
+        repaint();
+}
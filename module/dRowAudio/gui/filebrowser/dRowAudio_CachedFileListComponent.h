@@ -0,0 +1,170 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef DROWAUDIO_CACHEDFILELISTCOMPONENT_H
+#define DROWAUDIO_CACHEDFILELISTCOMPONENT_H
+
+#include "dRowAudio_DirectoryScanCache.h"
+#include "dRowAudio_AudioFileInfoCache.h"
+
+//==============================================================================
+/** A list of the files in a directory that reads from the DirectoryScanCache.
+
+    This looks and behaves like a FileListComponent but rather than scanning
+    the directory itself it shows the cached results, adding files as they're
+    found. Directories are listed first, then files in natural order.
+
+    When a single directory is selected it is prefetched so opening it is quick.
+
+    If setShowsAudioFileInfo() is turned on, the length and a small waveform of
+    audio files are shown once the AudioFileInfoCache has read them. Only the
+    visible rows and a page either side of them are read.
+
+    @see BasicFileBrowser, DirectoryScanCache
+*/
+class CachedFileListComponent : public juce::ListBox,
+                                public juce::DirectoryContentsDisplayComponent,
+                                private juce::ListBoxModel,
+                                private juce::ScrollBar::Listener,
+                                private DirectoryScanCache::Listener,
+                                private AudioFileInfoCache::Listener
+{
+public:
+    //==============================================================================
+    /** Creates a list.
+        The filter is used to decide which files to show, if it is nullptr all
+        files will be shown.
+    */
+    explicit CachedFileListComponent (const juce::FileFilter* fileFilter);
+
+    /** Destructor. */
+    ~CachedFileListComponent() override;
+
+    //==============================================================================
+    /** Changes the directory being shown. */
+    void setDirectory (const juce::File& newDirectory);
+
+    /** Returns the directory being shown. */
+    const juce::File& getDirectory() const noexcept         { return directory; }
+
+    /** Scans the directory again. */
+    void refresh();
+
+    /** Changes the filter used to decide which files to show. */
+    void setFileFilter (const juce::FileFilter* newFileFilter);
+
+    /** Sets whether hidden files should be shown. */
+    void setIgnoresHiddenFiles (bool shouldIgnoreHiddenFiles);
+
+    /** Returns true if hidden files are not being shown. */
+    bool ignoresHiddenFiles() const noexcept                { return ignoreHiddenFiles; }
+
+    /** Returns true if the directory is still being scanned. */
+    bool isStillLoading() const noexcept;
+
+    /** Sets whether the length and waveform of audio files should be shown. */
+    void setShowsAudioFileInfo (bool shouldShowAudioFileInfo);
+
+    /** Returns true if the length and waveform of audio files are being shown. */
+    bool showsAudioFileInfo() const noexcept                { return showAudioFileInfo; }
+
+    //==============================================================================
+    /** Returns the number of files being shown. */
+    int getNumFiles() const noexcept                        { return rows.size(); }
+
+    /** Returns one of the files being shown. */
+    juce::File getFile (int index) const;
+
+    /** Returns the name of one of the files being shown. */
+    juce::String getFileName (int index) const;
+
+    /** Called when files are found for the directory being shown or its scan finishes. */
+    std::function<void()> onContentsChanged;
+
+    //==============================================================================
+    /** @internal */
+    int getNumSelectedFiles() const override;
+    /** @internal */
+    juce::File getSelectedFile (int index = 0) const override;
+    /** @internal */
+    void deselectAllFiles() override;
+    /** @internal */
+    void scrollToTop() override;
+    /** @internal */
+    void setSelectedFile (const juce::File&) override;
+    /** @internal */
+    void resized() override;
+
+private:
+    //==============================================================================
+    const juce::FileFilter* fileFilter;
+    bool ignoreHiddenFiles, showAudioFileInfo;
+
+    juce::File directory;
+    DirectoryScanCache::Contents::Ptr contents;
+    juce::Array<DirectoryScanCache::Entry> entries;
+
+    // indexes of the entries being shown, in display order
+    juce::Array<int> rows;
+    int numEntriesChecked;
+
+    //==============================================================================
+    void showContents (const DirectoryScanCache::Contents::Ptr& newContents);
+    void updateRows (bool rebuild);
+    bool isEntrySuitable (const DirectoryScanCache::Entry& entry) const;
+    const DirectoryScanCache::Entry* getEntry (int row) const noexcept;
+    void sendDoubleClick (int row);
+    void updateWantedAudioFiles();
+
+    /** @internal */
+    int getNumRows() override;
+    /** @internal */
+    void paintListBoxItem (int row, juce::Graphics& g, int width, int height, bool rowIsSelected) override;
+    /** @internal */
+    void selectedRowsChanged (int lastRowSelected) override;
+    /** @internal */
+    void listBoxItemClicked (int row, const juce::MouseEvent& e) override;
+    /** @internal */
+    void listBoxItemDoubleClicked (int row, const juce::MouseEvent& e) override;
+    /** @internal */
+    void returnKeyPressed (int lastRowSelected) override;
+    /** @internal */
+    void scrollBarMoved (juce::ScrollBar* scrollBar, double newRangeStart) override;
+    /** @internal */
+    void directoryContentsChanged (const DirectoryScanCache::Contents::Ptr& changedContents) override;
+    /** @internal */
+    void audioFileInfoChanged (const AudioFileInfoCache::Info::Ptr& info) override;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CachedFileListComponent)
+};
+
+#endif // DROWAUDIO_CACHEDFILELISTCOMPONENT_H
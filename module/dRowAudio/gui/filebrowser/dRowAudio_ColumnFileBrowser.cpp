@@ -45,6 +45,7 @@ public:
           fileDragEnabled (false)
     {
         addMouseListener (this, true);
+        setShowsAudioFileInfo (true);
     }
     
     ~BrowserColumn()
@@ -105,7 +106,8 @@ class ColumnFileBrowserContents   : public Component,
 public:
     ColumnFileBrowserContents (WildcardFileFilter* filesToDisplay_, Viewport* parentViewport)
         : filesToDisplay (filesToDisplay_),
-          viewport (parentViewport)
+          viewport (parentViewport),
+          columnAwaitingFocus (nullptr)
     {
         activeLookAndFeel = std::make_unique<ColumnFileBrowserLookAndFeel>();
         activeLookAndFeel->setColour (DirectoryContentsDisplayComponent::highlightColourId,
@@ -127,6 +129,7 @@ public:
         column->addListener (this);
         column->addChangeListener (this);
         column->addComponentListener (this);
+        column->getDisplayComponent()->onContentsChanged = [this, column] { columnContentsChanged (column); };
     }
 
     void resized() override
@@ -205,6 +208,7 @@ public:
     void changeListenerCallback (ChangeBroadcaster* changedComponent) override
     {
         auto changedColumn = static_cast<BrowserColumn*> (changedComponent);
+        columnAwaitingFocus = nullptr;
 
         if (changedColumn->getHighlightedFile().getFileName().isNotEmpty())
         {
@@ -227,10 +231,11 @@ public:
     {
         if (key.isKeyCode (KeyPress::leftKey))
         {
+            columnAwaitingFocus = nullptr;
+
             if (activeColumn != 0)
             {
-                FileListComponent* list = dynamic_cast<FileListComponent*> (columns[activeColumn]->getDisplayComponent());
-                list->deselectAllRows();
+                columns[activeColumn]->getDisplayComponent()->deselectAllRows();
 
                 int newActiveColumn = jmax (0, activeColumn - 1);
                 columns[newActiveColumn]->selectionChanged();
@@ -242,28 +247,16 @@ public:
 
         if (key.isKeyCode (KeyPress::rightKey))
         {
+            // selected directories are prefetched so the new column is usually filled
+            // straight away, if not focus moves to it once the scan finds something
             if (columns[activeColumn]->getNumSelectedFiles() == 1
-                && columns[activeColumn]->getSelectedFile (0).isDirectory()
-                && getNumValidChildFiles (columns[activeColumn]->getSelectedFile (0)) > 0)
+                && columns[activeColumn]->getSelectedFile (0).isDirectory())
             {
                 int newActiveColumn = activeColumn + 1;
                 addColumn (columns[activeColumn]->getSelectedFile (0));
 
-                FileListComponent* list = dynamic_cast<FileListComponent*> (columns[newActiveColumn]->getDisplayComponent());
-
-                if (list != nullptr)
-                {
-                    ListBoxModel* model = list->getModel();
-
-                    if (model != nullptr)
-                    {
-                        if (model->getNumRows() > 0)
-                        {
-                            columns[newActiveColumn]->grabKeyboardFocus();
-                            list->selectRow (0);
-                        }
-                    }
-                }
+                columnAwaitingFocus = columns[newActiveColumn];
+                columnContentsChanged (columnAwaitingFocus);
             }
 
             return true;
@@ -272,6 +265,26 @@ public:
         return false;
     }
 
+    void columnContentsChanged (BrowserColumn* column)
+    {
+        if (column == nullptr || column != columnAwaitingFocus)
+            return;
+
+        CachedFileListComponent* list = column->getDisplayComponent();
+
+        if (list->getNumFiles() > 0)
+        {
+            columnAwaitingFocus = nullptr;
+            column->grabKeyboardFocus();
+            list->selectRow (0);
+        }
+        else if (! list->isStillLoading())
+        {
+            // nothing to move into
+            columnAwaitingFocus = nullptr;
+        }
+    }
+
     void selectionChanged() override {}
     void fileClicked (const File&, const MouseEvent&) override {}
     void fileDoubleClicked (const File&) override {}
@@ -287,18 +300,10 @@ private:
     OwnedArray <BrowserColumn> columns;
 
     int activeColumn;
+    BrowserColumn* columnAwaitingFocus;
 
     friend class ColumnFileBrowser;
 
-    //==================================================================================
-    int getNumValidChildFiles (const File& sourceFile) const
-    {
-        return sourceFile.getNumberOfChildFiles (File::findFilesAndDirectories + juce::File::ignoreHiddenFiles,
-                                                 filesToDisplay == nullptr
-                                                    ? "*"
-                                                    : filesToDisplay->getDescription().fromFirstOccurrenceOf ("(", false, false).upToFirstOccurrenceOf (")", false, false));
-    }
-
     //==================================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ColumnFileBrowserContents)
 };
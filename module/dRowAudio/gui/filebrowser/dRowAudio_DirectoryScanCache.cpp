@@ -0,0 +1,343 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+//==============================================================================
+class DirectoryScanCache::ScanJob : public ThreadPoolJob
+{
+public:
+    ScanJob (DirectoryScanCache& owner_, Contents* contents_)
+        : ThreadPoolJob ("DirectoryScanCache scan"),
+          owner (owner_),
+          contents (contents_)
+    {
+    }
+
+    bool isScanning (const Contents* c) const noexcept     { return contents.get() == c; }
+
+    JobStatus runJob() override
+    {
+        const File& directory (contents->getDirectory());
+
+        // taken before scanning so any changes made during the scan will cause another one
+        contents->directoryModificationTime = directory.getLastModificationTime();
+
+        Array<Entry> batch;
+        uint32 lastBatchTime = Time::getMillisecondCounter();
+
+        for (const auto& file : RangedDirectoryIterator (directory, false, "*", File::findFilesAndDirectories))
+        {
+            if (shouldExit() || contents->cancelled.load())
+                return jobHasFinished;
+
+            Entry entry;
+            entry.filename          = file.getFile().getFileName();
+            entry.fileSize          = file.getFileSize();
+            entry.modificationTime  = file.getModificationTime();
+            entry.isDirectory       = file.isDirectory();
+            entry.isHidden          = file.isHidden();
+            entry.isReadOnly        = file.isReadOnly();
+            batch.add (entry);
+
+            const uint32 now = Time::getMillisecondCounter();
+
+            if (batch.size() >= maxBatchSize || now - lastBatchTime >= maxBatchInterval)
+            {
+                addBatch (batch);
+                lastBatchTime = now;
+            }
+        }
+
+        contents->complete = true;
+        addBatch (batch);
+
+        return jobHasFinished;
+    }
+
+private:
+    enum
+    {
+        maxBatchSize = 1024,
+        maxBatchInterval = 100
+    };
+
+    DirectoryScanCache& owner;
+    const Contents::Ptr contents;
+
+    void addBatch (Array<Entry>& batch)
+    {
+        {
+            const ScopedLock sl (contents->lock);
+            contents->entries.addArray (batch);
+        }
+
+        batch.clearQuick();
+        owner.contentsChanged (contents.get());
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ScanJob)
+};
+
+//==============================================================================
+class DirectoryScanCache::CheckJob : public ThreadPoolJob
+{
+public:
+    CheckJob (DirectoryScanCache& owner_, Contents* contents_)
+        : ThreadPoolJob ("DirectoryScanCache check"),
+          owner (owner_),
+          contents (contents_)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        const File& directory (contents->getDirectory());
+
+        if (! directory.isDirectory()
+            || directory.getLastModificationTime() != contents->directoryModificationTime)
+        {
+            contents->needsRescan = true;
+            owner.contentsChanged (contents.get());
+        }
+
+        return jobHasFinished;
+    }
+
+private:
+    DirectoryScanCache& owner;
+    const Contents::Ptr contents;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CheckJob)
+};
+
+//==============================================================================
+DirectoryScanCache::Contents::Contents (const File& directoryToScan)
+    : directory (directoryToScan),
+      complete (false),
+      cancelled (false),
+      needsRescan (false),
+      lastCheckTime (Time::getMillisecondCounter())
+{
+}
+
+int DirectoryScanCache::Contents::getNumEntries() const
+{
+    const ScopedLock sl (lock);
+    return entries.size();
+}
+
+int DirectoryScanCache::Contents::copyEntries (Array<Entry>& destination, int startIndex) const
+{
+    const ScopedLock sl (lock);
+
+    for (int i = jmax (0, startIndex); i < entries.size(); ++i)
+        destination.add (entries.getReference (i));
+
+    return entries.size();
+}
+
+//==============================================================================
+juce_ImplementSingleton (DirectoryScanCache)
+
+DirectoryScanCache::DirectoryScanCache()
+    : pool (2),
+      maxNumCachedDirectories (64),
+      placeholderThread ("DirectoryScanCache placeholder"),
+      placeholderList (nullptr, placeholderThread)
+{
+}
+
+DirectoryScanCache::~DirectoryScanCache()
+{
+    for (auto& contents : cache)
+        contents->cancelled = true;
+
+    prefetchedContents = nullptr;
+    pool.removeAllJobs (true, 10000);
+    cancelPendingUpdate();
+
+    clearSingletonInstance();
+}
+
+//==============================================================================
+DirectoryScanCache::Contents::Ptr DirectoryScanCache::getContents (const File& directory)
+{
+    Contents::Ptr contents (findContents (directory));
+
+    if (contents == nullptr)
+        return startScan (directory);
+
+    // once something has asked for a prefetched directory it mustn't be cancelled
+    if (contents == prefetchedContents)
+        prefetchedContents = nullptr;
+
+    // keep the most recently used directories at the end
+    cache.removeFirstMatchingValue (contents);
+    cache.add (contents);
+
+    const uint32 now = Time::getMillisecondCounter();
+
+    if (contents->isComplete() && now - contents->lastCheckTime > 2000)
+    {
+        contents->lastCheckTime = now;
+        pool.addJob (new CheckJob (*this, contents.get()), true);
+    }
+
+    return contents;
+}
+
+void DirectoryScanCache::prefetch (const File& directory)
+{
+    if (prefetchedContents != nullptr && prefetchedContents->getDirectory() == directory)
+        return;
+
+    cancelPrefetch();
+
+    if (findContents (directory) == nullptr)
+        prefetchedContents = startScan (directory);
+}
+
+void DirectoryScanCache::cancelPrefetch()
+{
+    if (prefetchedContents == nullptr)
+        return;
+
+    if (! prefetchedContents->isComplete())
+    {
+        struct PrefetchJobSelector  : public ThreadPool::JobSelector
+        {
+            PrefetchJobSelector (const Contents* c) : contents (c) {}
+
+            bool isJobSuitable (ThreadPoolJob* job) override
+            {
+                auto* scanJob = dynamic_cast<ScanJob*> (job);
+                return scanJob != nullptr && scanJob->isScanning (contents);
+            }
+
+            const Contents* contents;
+        };
+
+        // a job that has already started will see it's been cancelled and stop
+        removeFromCache (prefetchedContents);
+
+        PrefetchJobSelector selector (prefetchedContents.get());
+        pool.removeAllJobs (false, 0, &selector);
+    }
+
+    prefetchedContents = nullptr;
+}
+
+void DirectoryScanCache::rescan (const File& directory)
+{
+    if (Contents::Ptr contents = findContents (directory))
+        removeFromCache (contents);
+
+    Contents::Ptr newContents (startScan (directory));
+    listeners.call ([&newContents] (Listener& l) { l.directoryContentsChanged (newContents); });
+}
+
+void DirectoryScanCache::setMaxNumCachedDirectories (int newMaximum)
+{
+    maxNumCachedDirectories = jmax (1, newMaximum);
+}
+
+//==============================================================================
+DirectoryScanCache::Contents::Ptr DirectoryScanCache::findContents (const File& directory) const
+{
+    for (auto& contents : cache)
+        if (contents->getDirectory() == directory)
+            return contents;
+
+    return nullptr;
+}
+
+DirectoryScanCache::Contents::Ptr DirectoryScanCache::startScan (const File& directory)
+{
+    Contents::Ptr contents (new Contents (directory));
+    cache.add (contents);
+
+    // only throw away results nothing else is using
+    for (int i = 0; i < cache.size() && cache.size() > maxNumCachedDirectories;)
+    {
+        if (cache.getUnchecked (i)->getReferenceCount() == 1)
+            cache.remove (i);
+        else
+            ++i;
+    }
+
+    pool.addJob (new ScanJob (*this, contents.get()), true);
+
+    return contents;
+}
+
+void DirectoryScanCache::removeFromCache (const Contents::Ptr& contents)
+{
+    contents->cancelled = true;
+    cache.removeFirstMatchingValue (contents);
+}
+
+void DirectoryScanCache::contentsChanged (Contents* contents)
+{
+    {
+        const ScopedLock sl (changedLock);
+        changedContents.addIfNotAlreadyThere (contents);
+    }
+
+    triggerAsyncUpdate();
+}
+
+void DirectoryScanCache::handleAsyncUpdate()
+{
+    Array<Contents::Ptr> changed;
+
+    {
+        const ScopedLock sl (changedLock);
+        changed.swapWith (changedContents);
+    }
+
+    for (auto& contents : changed)
+    {
+        if (contents->needsRescan.load())
+        {
+            // it may have already been replaced
+            if (! cache.contains (contents))
+                continue;
+
+            removeFromCache (contents);
+
+            Contents::Ptr newContents (startScan (contents->getDirectory()));
+            listeners.call ([&newContents] (Listener& l) { l.directoryContentsChanged (newContents); });
+        }
+        else
+        {
+            listeners.call ([&contents] (Listener& l) { l.directoryContentsChanged (contents); });
+        }
+    }
+}
@@ -0,0 +1,196 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef DROWAUDIO_DIRECTORYSCANCACHE_H
+#define DROWAUDIO_DIRECTORYSCANCACHE_H
+
+//==============================================================================
+/** Scans directories on a shared pool of background threads and caches the results.
+
+    All the file browsers share this so the columns of a ColumnFileBrowser don't
+    each need their own thread, and going back to a directory that has already
+    been scanned is instant. Results are passed on to listeners in batches as
+    they're found so large or slow directories can be shown straight away.
+
+    A cached directory is checked again in the background when it's asked for.
+    If its modification time has changed it is scanned again. Note that this
+    will pick up files being added, removed or renamed but not necessarily
+    changes to the files themselves, use rescan() for that.
+
+    @see CachedFileListComponent, BasicFileBrowser
+*/
+class DirectoryScanCache : public juce::DeletedAtShutdown,
+                           private juce::AsyncUpdater
+{
+public:
+    //==============================================================================
+    juce_DeclareSingleton (DirectoryScanCache, false)
+
+    /** Creates a DirectoryScanCache.
+        You'll normally want to use the singleton instance.
+    */
+    DirectoryScanCache();
+
+    /** Destructor. */
+    ~DirectoryScanCache() override;
+
+    //==============================================================================
+    /** The details of a file found by a scan. */
+    struct Entry
+    {
+        juce::String filename;
+        juce::int64 fileSize = 0;
+        juce::Time modificationTime;
+        bool isDirectory = false;
+        bool isHidden = false;
+        bool isReadOnly = false;
+    };
+
+    //==============================================================================
+    /** The results of scanning a directory.
+        The entries are in the order they were found and are added to as the scan progresses.
+    */
+    class Contents : public juce::ReferenceCountedObject
+    {
+    public:
+        using Ptr = juce::ReferenceCountedObjectPtr<Contents>;
+
+        /** Returns the directory that was scanned. */
+        const juce::File& getDirectory() const noexcept     { return directory; }
+
+        /** Returns true once the whole directory has been scanned. */
+        bool isComplete() const noexcept                    { return complete.load(); }
+
+        /** Returns the number of entries found so far. */
+        int getNumEntries() const;
+
+        /** Adds the entries from startIndex onwards to an array.
+            @returns the number of entries found so far
+        */
+        int copyEntries (juce::Array<Entry>& destination, int startIndex) const;
+
+    private:
+        friend class DirectoryScanCache;
+
+        explicit Contents (const juce::File& directoryToScan);
+
+        const juce::File directory;
+        juce::Time directoryModificationTime;
+
+        juce::CriticalSection lock;
+        juce::Array<Entry> entries;
+
+        std::atomic<bool> complete, cancelled, needsRescan;
+        juce::uint32 lastCheckTime;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Contents)
+    };
+
+    //==============================================================================
+    /** Returns the contents of a directory.
+        If it hasn't been scanned yet this will start a scan and return the empty
+        contents, listeners will be told as entries are found.
+    */
+    Contents::Ptr getContents (const juce::File& directory);
+
+    /** Starts scanning a directory that is likely to be shown soon.
+        Only the most recent prefetch is kept, if the previous one hasn't been
+        asked for with getContents() and is still scanning it will be cancelled.
+    */
+    void prefetch (const juce::File& directory);
+
+    /** Cancels the scan started by the last call to prefetch() if nothing has asked for it yet. */
+    void cancelPrefetch();
+
+    /** Throws away any cached results for a directory and scans it again. */
+    void rescan (const juce::File& directory);
+
+    /** Sets the maximum number of directories to keep the results of. */
+    void setMaxNumCachedDirectories (int newMaximum);
+
+    //==============================================================================
+    /** Receives callbacks on the message thread as directories are scanned. */
+    class Listener
+    {
+    public:
+        /** Destructor. */
+        virtual ~Listener() = default;
+
+        /** Called when some new entries have been found for a directory or it has
+            been rescanned, in which case the contents will be a new object.
+        */
+        virtual void directoryContentsChanged (const Contents::Ptr& contents) = 0;
+    };
+
+    /** Adds a listener. */
+    void addListener (Listener* listener)                   { listeners.add (listener); }
+
+    /** Removes a previously added listener. */
+    void removeListener (Listener* listener)                { listeners.remove (listener); }
+
+    //==============================================================================
+    /** Returns a DirectoryContentsList that never scans anything.
+        Display components that read from the cache still need to give their
+        DirectoryContentsDisplayComponent base class a list.
+    */
+    juce::DirectoryContentsList& getPlaceholderContentsList() noexcept  { return placeholderList; }
+
+private:
+    //==============================================================================
+    class ScanJob;
+    class CheckJob;
+
+    juce::ThreadPool pool;
+    juce::Array<Contents::Ptr> cache;
+    Contents::Ptr prefetchedContents;
+    int maxNumCachedDirectories;
+
+    juce::CriticalSection changedLock;
+    juce::Array<Contents::Ptr> changedContents;
+    juce::ListenerList<Listener> listeners;
+
+    juce::TimeSliceThread placeholderThread;
+    juce::DirectoryContentsList placeholderList;
+
+    //==============================================================================
+    Contents::Ptr findContents (const juce::File& directory) const;
+    Contents::Ptr startScan (const juce::File& directory);
+    void removeFromCache (const Contents::Ptr& contents);
+    void contentsChanged (Contents* contents);
+
+    /** @internal */
+    void handleAsyncUpdate() override;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DirectoryScanCache)
+};
+
+#endif // DROWAUDIO_DIRECTORYSCANCACHE_H
@@ -0,0 +1,705 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#if DROWAUDIO_USE_CURL
+
+namespace CURLChunkedDownloadHelpers
+{
+    /** Updates a CRC-32 checksum with a block of data, starting from 0. */
+    static uint32 updateChecksum (uint32 checksum, const void* data, size_t numBytes) noexcept
+    {
+        struct Table
+        {
+            Table() noexcept
+            {
+                for (uint32 i = 0; i < 256; ++i)
+                {
+                    uint32 value = i;
+
+                    for (int bit = 0; bit < 8; ++bit)
+                        value = (value & 1) != 0 ? (0xedb88320 ^ (value >> 1)) : (value >> 1);
+
+                    values[i] = value;
+                }
+            }
+
+            uint32 values[256];
+        };
+
+        static const Table table;
+
+        const uint8* bytes = static_cast<const uint8*> (data);
+        checksum = ~checksum;
+
+        for (size_t i = 0; i < numBytes; ++i)
+            checksum = table.values[(checksum ^ bytes[i]) & 0xff] ^ (checksum >> 8);
+
+        return ~checksum;
+    }
+
+    static const char* const journalTag = "CHUNKED_DOWNLOAD";
+    static const char* const chunkTag = "CHUNK";
+}
+
+//==============================================================================
+/*  Writes the data of a chunk into its place in the partial file, keeping track
+    of what has been received in the Worker and the checksum of what was written.
+    Any more data than the chunk should hold is refused, which stops the transfer.
+    Once the whole chunk has arrived it is flushed to the file.
+
+    The file is shared by all the chunks and owned by the download, as some
+    platforms won't let it be opened for writing more than once.
+*/
+class CURLChunkedDownload::ChunkStream : public OutputStream
+{
+public:
+    ChunkStream (Worker& owner, CURLChunkedDownload* download_, int64 startPosition_, int64 maxLength,
+                 std::atomic<int64>& totalBytesReceived)
+        : worker (owner),
+          download (download_),
+          startPosition (startPosition_),
+          length (maxLength),
+          totalReceived (totalBytesReceived)
+    {
+    }
+
+    bool write (const void* data, size_t numBytes) override
+    {
+        if (length >= 0 && worker.numBytesReceived + (int64) numBytes > length)
+            return false;
+
+        // with no download the data is only counted, which is used to probe the server
+        if (download != nullptr
+             && ! download->writeToPartialFile (startPosition + worker.numBytesReceived, data, numBytes))
+            return false;
+
+        worker.checksum = CURLChunkedDownloadHelpers::updateChecksum (worker.checksum, data, numBytes);
+        worker.numBytesReceived += (int64) numBytes;
+        totalReceived += (int64) numBytes;
+
+        if (worker.numBytesReceived == length)
+            flush();
+
+        return true;
+    }
+
+    void flush() override                       { if (download != nullptr) download->flushPartialFile(); }
+    int64 getPosition() override                { return worker.numBytesReceived; }
+    bool setPosition (int64) override           { return false; }
+
+private:
+    Worker& worker;
+    CURLChunkedDownload* const download;
+    const int64 startPosition, length;
+    std::atomic<int64>& totalReceived;
+
+    JUCE_DECLARE_NON_COPYABLE (ChunkStream)
+};
+
+//==============================================================================
+CURLChunkedDownload::CURLChunkedDownload (const String& remotePath_,
+                                          const File& destinationFile_,
+                                          const String& username_,
+                                          const String& password_)
+    : remotePath (remotePath_),
+      username (username_),
+      password (password_),
+      destinationFile (destinationFile_),
+      chunkSize (8 * 1024 * 1024),
+      totalLength (-1),
+      maxConcurrentChunks (4),
+      maxRetriesPerChunk (3),
+      usesRanges (false),
+      downloading (false),
+      stopping (false),
+      numBytesDownloaded (0),
+      result (Result::ok()),
+      verificationPool (1)
+{
+}
+
+CURLChunkedDownload::~CURLChunkedDownload()
+{
+    OwnedArray<Worker> oldWorkers;
+
+    {
+        const ScopedLock sl (lock);
+        stopping = true;
+        downloading = false;
+        oldWorkers.swapWith (workers);
+    }
+
+    verificationPool.removeAllJobs (true, -1);
+
+    // deleting a session waits for the CURLManager to let go of it, which might
+    // be waiting for the lock in transferEnded()
+    oldWorkers.clear();
+    closePartialFile();
+}
+
+//==============================================================================
+void CURLChunkedDownload::setChunkSize (int64 newChunkSize)
+{
+    const ScopedLock sl (lock);
+    chunkSize = jmax ((int64) 1024, newChunkSize);
+}
+
+void CURLChunkedDownload::setMaxConcurrentChunks (int newMaxConcurrentChunks)
+{
+    const ScopedLock sl (lock);
+    maxConcurrentChunks = jmax (1, newMaxConcurrentChunks);
+}
+
+void CURLChunkedDownload::setMaxRetriesPerChunk (int newMaxRetries)
+{
+    const ScopedLock sl (lock);
+    maxRetriesPerChunk = jmax (0, newMaxRetries);
+}
+
+//==============================================================================
+bool CURLChunkedDownload::start()
+{
+    bool hasFinished = false;
+
+    {
+        const ScopedLock sl (lock);
+
+        if (downloading)
+            return true;
+
+        stopping = false;
+        result = Result::ok();
+
+        findRemoteLength();
+
+        if (! restoreJournal())
+        {
+            getJournalFile().deleteFile();
+            getPartialFile().deleteFile();
+            createChunks();
+
+            if (! getPartialFile().create())
+            {
+                result = Result::fail ("Couldn't create " + getPartialFile().getFullPathName());
+                return false;
+            }
+        }
+
+        if (! openPartialFile())
+        {
+            result = Result::fail ("Couldn't open " + getPartialFile().getFullPathName());
+            return false;
+        }
+
+        int64 numBytesFinished = 0;
+
+        for (auto& chunk : chunks)
+            if (chunk.finished)
+                numBytesFinished += chunk.length;
+
+        numBytesDownloaded = numBytesFinished;
+        writeJournal();
+
+        downloading = true;
+        startChunks();
+
+        if (! isAnyChunkInProgress())
+            hasFinished = allChunksFinished();
+    }
+
+    if (hasFinished)
+        listeners.call (&Listener::chunkedDownloadFinished, this);
+
+    return true;
+}
+
+void CURLChunkedDownload::stop()
+{
+    const ScopedLock sl (lock);
+
+    if (! downloading || stopping)
+        return;
+
+    stopping = true;
+    result = Result::fail ("The download was stopped");
+
+    for (auto* worker : workers)
+        if (worker->chunkIndex >= 0)
+            worker->session->stopTransfer();
+}
+
+Result CURLChunkedDownload::getResult() const
+{
+    const ScopedLock sl (lock);
+    return result;
+}
+
+float CURLChunkedDownload::getProgress() const
+{
+    if (totalLength > 0)
+        return (float) (numBytesDownloaded.load() / (double) totalLength);
+
+    return downloading.load() ? 0.0f : 1.0f;
+}
+
+File CURLChunkedDownload::getPartialFile() const
+{
+    return destinationFile.getSiblingFile (destinationFile.getFileName() + ".part");
+}
+
+File CURLChunkedDownload::getJournalFile() const
+{
+    return destinationFile.getSiblingFile (destinationFile.getFileName() + ".journal");
+}
+
+//==============================================================================
+void CURLChunkedDownload::addListener (Listener* const listener)
+{
+    listeners.add (listener);
+}
+
+void CURLChunkedDownload::removeListener (Listener* const listener)
+{
+    listeners.remove (listener);
+}
+
+//==============================================================================
+void CURLChunkedDownload::transferProgressUpdate (CURLEasySession*)
+{
+    listeners.call (&Listener::chunkedDownloadProgress, this);
+}
+
+void CURLChunkedDownload::transferEnded (CURLEasySession* session)
+{
+    bool hasFinished = false;
+
+    {
+        const ScopedLock sl (lock);
+
+        for (auto* worker : workers)
+        {
+            if (worker->session.get() == session && worker->chunkIndex >= 0)
+            {
+                finishChunk (*worker, session->getLastError().isEmpty());
+                break;
+            }
+        }
+
+        if (downloading && ! isAnyChunkInProgress())
+            hasFinished = allChunksFinished();
+    }
+
+    if (hasFinished)
+        listeners.call (&Listener::chunkedDownloadFinished, this);
+}
+
+//==============================================================================
+void CURLChunkedDownload::findRemoteLength()
+{
+    CURLEasySession session;
+    session.enableFullDebugging (false);
+    session.setRemotePath (remotePath);
+
+    if (username.isNotEmpty())
+        session.setUserNameAndPassword (username, password);
+
+    totalLength = session.getRemoteFileSize();
+    usesRanges = false;
+
+    if (totalLength <= chunkSize)
+        return;
+
+    // ask for a single byte to see if the server will send part of the file
+    Worker probe { nullptr, 0, 0, 0 };
+    std::atomic<int64> numProbeBytes (0);
+
+    session.setByteRange (0, 1);
+    session.setOutputStream (new ChunkStream (probe, nullptr, 0, 1, numProbeBytes));
+    session.beginTransfer (false, false);
+
+    usesRanges = session.getLastError().isEmpty() && probe.numBytesReceived == 1;
+}
+
+void CURLChunkedDownload::createChunks()
+{
+    chunks.clearQuick();
+
+    if (! usesRanges)
+    {
+        chunks.add ({ 0, totalLength, 0, false, false, 0 });
+        return;
+    }
+
+    for (int64 start = 0; start < totalLength; start += chunkSize)
+        chunks.add ({ start, jmin (chunkSize, totalLength - start), 0, false, false, 0 });
+}
+
+bool CURLChunkedDownload::restoreJournal()
+{
+    using namespace CURLChunkedDownloadHelpers;
+
+    // without ranges the file has to be downloaded in one go
+    if (! usesRanges || ! getPartialFile().existsAsFile())
+        return false;
+
+    std::unique_ptr<XmlElement> journal (XmlDocument::parse (getJournalFile()));
+
+    if (journal == nullptr
+        || ! journal->hasTagName (journalTag)
+        || journal->getStringAttribute ("url") != remotePath
+        || journal->getStringAttribute ("length").getLargeIntValue() != totalLength)
+        return false;
+
+    // the chunks have to line up with the ones that were recorded
+    const int64 journalChunkSize = journal->getStringAttribute ("chunkSize").getLargeIntValue();
+
+    if (journalChunkSize <= 0)
+        return false;
+
+    chunkSize = journalChunkSize;
+    createChunks();
+
+    for (auto* e = journal->getChildByName (chunkTag); e != nullptr; e = e->getNextElementWithTagName (chunkTag))
+    {
+        const int index = (int) (e->getStringAttribute ("start").getLargeIntValue() / chunkSize);
+
+        if (! isPositiveAndBelow (index, chunks.size()))
+            continue;
+
+        Chunk& chunk = chunks.getReference (index);
+
+        if (chunk.start != e->getStringAttribute ("start").getLargeIntValue()
+            || chunk.length != e->getStringAttribute ("length").getLargeIntValue())
+            continue;
+
+        // anything that has changed since it was written is downloaded again
+        chunk.checksum = (uint32) e->getStringAttribute ("checksum").getHexValue32();
+        chunk.finished = verifyChunk (chunk);
+    }
+
+    return true;
+}
+
+bool CURLChunkedDownload::writeJournal() const
+{
+    using namespace CURLChunkedDownloadHelpers;
+
+    if (! usesRanges)
+        return false;
+
+    XmlElement journal (journalTag);
+    journal.setAttribute ("url", remotePath);
+    journal.setAttribute ("length", String (totalLength));
+    journal.setAttribute ("chunkSize", String (chunkSize));
+
+    for (auto& chunk : chunks)
+    {
+        if (! chunk.finished)
+            continue;
+
+        XmlElement* e = journal.createNewChildElement (chunkTag);
+        e->setAttribute ("start", String (chunk.start));
+        e->setAttribute ("length", String (chunk.length));
+        e->setAttribute ("checksum", String::toHexString ((int) chunk.checksum));
+    }
+
+    // written to a temporary file first so an interrupted write can't lose the old journal
+    TemporaryFile tempFile (getJournalFile());
+
+    return journal.writeTo (tempFile.getFile())
+            && tempFile.overwriteTargetFileWithTemporary();
+}
+
+bool CURLChunkedDownload::verifyChunk (const Chunk& chunk) const
+{
+    FileInputStream in (getPartialFile());
+
+    if (in.failedToOpen()
+        || in.getTotalLength() < chunk.start + chunk.length
+        || ! in.setPosition (chunk.start))
+        return false;
+
+    HeapBlock<char> buffer (65536);
+    uint32 checksum = 0;
+
+    for (int64 numLeft = chunk.length; numLeft > 0;)
+    {
+        const int numRead = in.read (buffer, (int) jmin ((int64) 65536, numLeft));
+
+        if (numRead <= 0)
+            return false;
+
+        checksum = CURLChunkedDownloadHelpers::updateChecksum (checksum, buffer, (size_t) numRead);
+        numLeft -= numRead;
+    }
+
+    return checksum == chunk.checksum;
+}
+
+//==============================================================================
+bool CURLChunkedDownload::openPartialFile()
+{
+    const ScopedLock sl (writeLock);
+
+    partialFileStream = getPartialFile().createOutputStream();
+
+    if (partialFileStream == nullptr)
+        return false;
+
+    // allocate the whole file so the chunks can be written in any order
+    if (totalLength > 0 && partialFileStream->getPosition() < totalLength)
+        return partialFileStream->setPosition (totalLength - 1)
+                && partialFileStream->writeByte (0);
+
+    return true;
+}
+
+void CURLChunkedDownload::closePartialFile()
+{
+    const ScopedLock sl (writeLock);
+    partialFileStream.reset();
+}
+
+bool CURLChunkedDownload::writeToPartialFile (int64 position, const void* data, size_t numBytes)
+{
+    const ScopedLock sl (writeLock);
+
+    return partialFileStream != nullptr
+            && partialFileStream->setPosition (position)
+            && partialFileStream->write (data, numBytes);
+}
+
+void CURLChunkedDownload::flushPartialFile()
+{
+    const ScopedLock sl (writeLock);
+
+    if (partialFileStream != nullptr)
+        partialFileStream->flush();
+}
+
+//==============================================================================
+void CURLChunkedDownload::startChunks()
+{
+    if (stopping)
+        return;
+
+    int numInProgress = 0;
+
+    for (auto& chunk : chunks)
+        if (chunk.inProgress)
+            ++numInProgress;
+
+    for (int i = 0; i < chunks.size() && numInProgress < maxConcurrentChunks; ++i)
+    {
+        Chunk& chunk = chunks.getReference (i);
+
+        if (chunk.finished || chunk.inProgress)
+            continue;
+
+        Worker* worker = getIdleWorker();
+        worker->chunkIndex = i;
+        worker->numBytesReceived = 0;
+        worker->checksum = 0;
+        chunk.inProgress = true;
+        ++numInProgress;
+
+        worker->session->setByteRange (chunk.start, usesRanges ? chunk.length : -1);
+        worker->session->setOutputStream (new ChunkStream (*worker, this, chunk.start,
+                                                           chunk.length, numBytesDownloaded));
+        worker->session->beginTransfer (false);
+    }
+}
+
+CURLChunkedDownload::Worker* CURLChunkedDownload::getIdleWorker()
+{
+    for (auto* worker : workers)
+        if (worker->chunkIndex < 0)
+            return worker;
+
+    Worker* worker = workers.add (new Worker { std::make_unique<CURLEasySession>(), -1, 0, 0 });
+    worker->session->enableFullDebugging (false);
+    worker->session->setRemotePath (remotePath);
+
+    if (username.isNotEmpty())
+        worker->session->setUserNameAndPassword (username, password);
+
+    worker->session->addListener (this);
+
+    return worker;
+}
+
+bool CURLChunkedDownload::isAnyChunkInProgress() const
+{
+    for (auto& chunk : chunks)
+        if (chunk.inProgress)
+            return true;
+
+    return false;
+}
+
+void CURLChunkedDownload::finishChunk (Worker& worker, bool succeeded)
+{
+    Chunk& chunk = chunks.getReference (worker.chunkIndex);
+    worker.chunkIndex = -1;
+    chunk.inProgress = false;
+
+    if (chunk.length < 0 && succeeded)
+        chunk.length = worker.numBytesReceived;
+
+    if (succeeded && worker.numBytesReceived == chunk.length)
+    {
+        // the checksum was worked out as the data was written, the chunk is read
+        // back and checked against it on the verification thread once they've
+        // all arrived, rather than holding up the CURLManager here
+        chunk.checksum = worker.checksum;
+        chunk.finished = true;
+    }
+
+    if (chunk.finished)
+    {
+        writeJournal();
+    }
+    else
+    {
+        numBytesDownloaded -= worker.numBytesReceived;
+
+        if (! stopping && ++chunk.numFailures > maxRetriesPerChunk)
+        {
+            const String error (worker.session->getLastError());
+
+            stopping = true;
+            result = Result::fail ("The chunk at byte " + String (chunk.start) + " failed"
+                                    + (error.isNotEmpty() ? ": " + error : String()));
+
+            for (auto* other : workers)
+                if (other->chunkIndex >= 0)
+                    other->session->stopTransfer();
+        }
+    }
+
+    startChunks();
+}
+
+bool CURLChunkedDownload::allChunksFinished()
+{
+    if (! result.wasOk())
+    {
+        finishDownload();
+        return true;
+    }
+
+    verificationPool.addJob ([this] { verifyDownload(); });
+    return false;
+}
+
+void CURLChunkedDownload::verifyDownload()
+{
+    Array<Chunk> chunksToVerify;
+
+    // the file is closed while it's read back, nothing else will write to it as
+    // all the chunks have finished
+    {
+        const ScopedLock sl (lock);
+        closePartialFile();
+        chunksToVerify = chunks;
+    }
+
+    Array<int> corruptChunks;
+
+    for (int i = 0; i < chunksToVerify.size() && ! stopping; ++i)
+        if (! verifyChunk (chunksToVerify.getReference (i)))
+            corruptChunks.add (i);
+
+    bool hasFinished = false;
+
+    {
+        const ScopedLock sl (lock);
+
+        if (! downloading)
+            return;
+
+        for (auto index : corruptChunks)
+        {
+            Chunk& chunk = chunks.getReference (index);
+            chunk.finished = false;
+            numBytesDownloaded -= chunk.length;
+
+            if (++chunk.numFailures > maxRetriesPerChunk && result.wasOk())
+            {
+                stopping = true;
+                result = Result::fail ("The chunk at byte " + String (chunk.start) + " was corrupt");
+            }
+        }
+
+        if (! corruptChunks.isEmpty())
+        {
+            writeJournal();
+
+            if (result.wasOk() && ! openPartialFile())
+            {
+                stopping = true;
+                result = Result::fail ("Couldn't open " + getPartialFile().getFullPathName());
+            }
+
+            startChunks();
+        }
+
+        if (! isAnyChunkInProgress())
+        {
+            finishDownload();
+            hasFinished = true;
+        }
+    }
+
+    if (hasFinished)
+        listeners.call (&Listener::chunkedDownloadFinished, this);
+}
+
+void CURLChunkedDownload::finishDownload()
+{
+    downloading = false;
+
+    // the file has to be closed before it can be moved
+    closePartialFile();
+
+    if (! result.wasOk())
+        return;
+
+    if (! getPartialFile().replaceFileIn (destinationFile))
+    {
+        result = Result::fail ("Couldn't move the download to " + destinationFile.getFullPathName());
+        return;
+    }
+
+    getJournalFile().deleteFile();
+}
+
+#endif //DROWAUDIO_USE_CURL
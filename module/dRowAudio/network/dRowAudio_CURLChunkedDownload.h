@@ -0,0 +1,227 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef DROWAUDIO_CURLCHUNKEDDOWNLOAD_H
+#define DROWAUDIO_CURLCHUNKEDDOWNLOAD_H
+
+#if DROWAUDIO_USE_CURL || DOXYGEN
+
+#include "dRowAudio_CURLEasySession.h"
+
+//==============================================================================
+/** Downloads a large file in chunks that can be fetched in parallel and resumed.
+
+    The remote file is split into byte ranges which are downloaded by a number
+    of CURLEasySessions at once into a partial file next to the destination.
+    A journal of the finished chunks and their checksums is kept alongside it so
+    a download that was stopped, failed or interrupted by the application
+    quitting carries on from the last finished chunk when it's started again.
+
+    All the chunks are written through a single stream to the partial file, which
+    is allocated up front. A checksum of each chunk is worked out as its data is
+    written and stored in the journal, and chunks from a previous run are checked
+    against it before they're trusted. Once every chunk has arrived the partial
+    file is read back on a background thread and any chunks that don't match
+    their checksums are downloaded again. Only when every chunk has been verified
+    is the partial file renamed over the destination.
+
+    If the server doesn't support byte ranges, or the size of the file can't be
+    found, the file is downloaded as a single chunk.
+
+    @see CURLEasySession, CURLManager
+*/
+class CURLChunkedDownload : private CURLEasySession::Listener
+{
+public:
+    //==============================================================================
+    /** Creates a download of a remote file to a local one.
+        Call start() to begin downloading.
+    */
+    CURLChunkedDownload (const juce::String& remotePath,
+                         const juce::File& destinationFile,
+                         const juce::String& username = juce::String(),
+                         const juce::String& password = juce::String());
+
+    /** Destructor.
+        Any chunks in progress are stopped and the journal is kept so the download
+        can be resumed.
+    */
+    ~CURLChunkedDownload() override;
+
+    //==============================================================================
+    /** Sets the size of the chunks to download, the default is 8MB.
+        This only affects downloads that haven't already been started.
+    */
+    void setChunkSize (juce::int64 newChunkSize);
+
+    /** Sets the number of chunks that can be downloaded at once, the default is 4. */
+    void setMaxConcurrentChunks (int newMaxConcurrentChunks);
+
+    /** Sets how many times a chunk is tried again before the download fails, the default is 3. */
+    void setMaxRetriesPerChunk (int newMaxRetries);
+
+    //==============================================================================
+    /** Starts or resumes the download.
+
+        This blocks while the size of the remote file is found and any chunks from
+        a previous run are checked. The chunks are then downloaded in the background.
+        Returns false if the download couldn't be started.
+    */
+    bool start();
+
+    /** Stops the download, keeping the chunks that have finished so it can be resumed. */
+    void stop();
+
+    /** Returns true if the download is running. */
+    bool isDownloading() const noexcept                 { return downloading.load(); }
+
+    /** Returns the result of the last download once it has finished. */
+    juce::Result getResult() const;
+
+    /** Returns the progress of the download from 0 to 1. */
+    float getProgress() const;
+
+    /** Returns the size of the remote file or -1 if it isn't known. */
+    juce::int64 getTotalLength() const noexcept         { return totalLength; }
+
+    /** Returns the number of bytes received, including any from a previous run. */
+    juce::int64 getNumBytesDownloaded() const noexcept  { return numBytesDownloaded.load(); }
+
+    //==============================================================================
+    /** Returns the destination of the download. */
+    const juce::File& getDestinationFile() const noexcept   { return destinationFile; }
+
+    /** Returns the file the chunks are written to before it's moved to the destination. */
+    juce::File getPartialFile() const;
+
+    /** Returns the file the finished chunks are recorded in. */
+    juce::File getJournalFile() const;
+
+    //==============================================================================
+    /** A class for receiving callbacks from a CURLChunkedDownload.
+
+        These are called from the CURLManager's thread, or the thread the chunks are
+        verified on, so make sure any code within them is thread safe! The download
+        can't be deleted from within them.
+    */
+    class Listener
+    {
+    public:
+        /** Destructor. */
+        virtual ~Listener() {}
+
+        /** Called as data is received. */
+        virtual void chunkedDownloadProgress (CURLChunkedDownload* /*download*/) {}
+
+        /** Called when the download has finished, failed or been stopped.
+            Use getResult() to find out which.
+        */
+        virtual void chunkedDownloadFinished (CURLChunkedDownload* /*download*/) {}
+    };
+
+    /** Adds a listener to be called as the download progresses. */
+    void addListener (Listener* listener);
+
+    /** Removes a previously-registered listener. */
+    void removeListener (Listener* listener);
+
+    //==============================================================================
+    /** @internal */
+    void transferProgressUpdate (CURLEasySession* session) override;
+    /** @internal */
+    void transferEnded (CURLEasySession* session) override;
+
+private:
+    //==============================================================================
+    class ChunkStream;
+
+    struct Chunk
+    {
+        juce::int64 start, length;
+        juce::uint32 checksum;
+        bool finished, inProgress;
+        int numFailures;
+    };
+
+    struct Worker
+    {
+        std::unique_ptr<CURLEasySession> session;
+        int chunkIndex;
+        juce::int64 numBytesReceived;
+        juce::uint32 checksum;
+    };
+
+    const juce::String remotePath, username, password;
+    const juce::File destinationFile;
+
+    juce::int64 chunkSize, totalLength;
+    int maxConcurrentChunks, maxRetriesPerChunk;
+    bool usesRanges;
+
+    juce::CriticalSection lock;
+    juce::Array<Chunk> chunks;
+    juce::OwnedArray<Worker> workers;
+    std::atomic<bool> downloading, stopping;
+    std::atomic<juce::int64> numBytesDownloaded;
+    juce::Result result;
+
+    juce::ListenerList<Listener> listeners;
+
+    juce::CriticalSection writeLock;
+    std::unique_ptr<juce::FileOutputStream> partialFileStream;
+    juce::ThreadPool verificationPool;
+
+    //==============================================================================
+    void findRemoteLength();
+    void createChunks();
+    bool restoreJournal();
+    bool writeJournal() const;
+    bool verifyChunk (const Chunk& chunk) const;
+
+    bool openPartialFile();
+    void closePartialFile();
+    bool writeToPartialFile (juce::int64 position, const void* data, size_t numBytes);
+    void flushPartialFile();
+
+    void startChunks();
+    Worker* getIdleWorker();
+    bool isAnyChunkInProgress() const;
+    void finishChunk (Worker& worker, bool succeeded);
+    bool allChunksFinished();
+    void verifyDownload();
+    void finishDownload();
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CURLChunkedDownload)
+};
+
+#endif //DROWAUDIO_USE_CURL || DOXYGEN
+#endif //DROWAUDIO_CURLCHUNKEDDOWNLOAD_H
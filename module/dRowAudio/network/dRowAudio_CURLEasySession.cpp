@@ -44,11 +44,16 @@ namespace drow
 
 //==============================================================================
 CURLEasySession::CURLEasySession()
-    : handle (CURLManager::getInstance()->createEasyCurlHandle()),
+    : handle (CURLManager::getInstance()->acquireEasyCurlHandle (String(), String())),
+      isUpload (false),
+      fullDebugging (true),
+      transferInForeground (false),
+      shouldStopTransfer (false),
+      waitingForUploadData (false),
+      lastResult (CURLE_OK),
       progress (1.0f)
 {
-    enableFullDebugging (true);
-    curl_easy_setopt (handle, CURLOPT_NOPROGRESS, false);
+    applyOptions();
 }
 
 CURLEasySession::CURLEasySession (const juce::String& localPath,
@@ -56,11 +61,16 @@ CURLEasySession::CURLEasySession (const juce::String& localPath,
                                   bool upload,
                                   const juce::String& username,
                                   const juce::String& password)
-    : handle (CURLManager::getInstance()->createEasyCurlHandle())
+    : handle (CURLManager::getInstance()->acquireEasyCurlHandle (String(), String())),
+      isUpload (upload),
+      fullDebugging (true),
+      transferInForeground (false),
+      shouldStopTransfer (false),
+      waitingForUploadData (false),
+      lastResult (CURLE_OK),
+      progress (1.0f)
 {
-    handle = CURLManager::getInstance()->createEasyCurlHandle();
-    enableFullDebugging (true);
-    curl_easy_setopt (handle, CURLOPT_NOPROGRESS, false);
+    applyOptions();
 
     setLocalFile (localPath);
     setRemotePath (remotePath);
@@ -70,11 +80,12 @@ CURLEasySession::CURLEasySession (const juce::String& localPath,
 
 CURLEasySession::~CURLEasySession()
 {
-    CURLManager::getInstance()->removeTimeSliceClient (this);
-    if (CURLManager::getInstance()->getNumClients() == 0)
-        CURLManager::getInstance()->stopThread (1000);
+    CURLManager::getInstance()->removeSession (this);
+
+    if (auto* encoder = dynamic_cast<AudioEncodingInputStream*> (inputStream.get()))
+        encoder->setDataReadyCallback (nullptr);
 
-    CURLManager::getInstance()->cleanUpEasyCurlHandle (handle);
+    CURLManager::getInstance()->releaseEasyCurlHandle (handle, remotePath, userNameAndPassword);
 }
 
 //==============================================================================
@@ -90,19 +101,39 @@ void CURLEasySession::setLocalFile (const File& newLocalFile)
     inputStream = localFile.createInputStream();
 }
 
+void CURLEasySession::setOutputStream (OutputStream* newOutputStream)
+{
+    outputStream = rawToUniquePtr (newOutputStream);
+}
+
+void CURLEasySession::setByteRange (int64 startByte, int64 numBytes)
+{
+    if (numBytes < 0)
+        byteRange = String();
+    else
+        byteRange = String (startByte) + "-" + String (startByte + numBytes - 1);
+}
+
 void CURLEasySession::setRemotePath (const juce::String& newRemotePath)
 {
-    remotePath = newRemotePath;
+    String newPath (newRemotePath);
+
+    if (newPath.getLastCharacters (1) == "/")
+        newPath  = newPath << localFile.getFileName();
 
-    if (remotePath.getLastCharacters (1) == "/")
-        remotePath  = remotePath << localFile.getFileName();
+    changeHandleIfNeeded (newPath, userNameAndPassword);
+    remotePath = newPath;
 
     curl_easy_setopt (handle, CURLOPT_URL, remotePath.toUTF8().getAddress());
 }
 
 void CURLEasySession::setUserNameAndPassword (const juce::String& username, const juce::String& password)
 {
-    userNameAndPassword = username + ":" + password;
+    const String newUserNameAndPassword (username + ":" + password);
+
+    changeHandleIfNeeded (remotePath, newUserNameAndPassword);
+    userNameAndPassword = newUserNameAndPassword;
+
     curl_easy_setopt (handle, CURLOPT_USERPWD, userNameAndPassword.toUTF8().getAddress());
 }
 
@@ -134,6 +165,10 @@ StringArray CURLEasySession::getDirectoryListing()
     // perform the tranfer
     progress = 0.0f;
     CURLcode result = curl_easy_perform (handle);
+
+    if (result == CURLE_OK)
+        CURLManager::getInstance()->updateConnectionStatistics (handle);
+
     reset();
 
     if (result == CURLE_OK)
@@ -146,6 +181,61 @@ StringArray CURLEasySession::getDirectoryListing()
     return juce::StringArray (curl_easy_strerror (result));
 }
 
+String CURLEasySession::getDetailedDirectoryListing()
+{
+    const String remoteUrl (remotePath.upToLastOccurrenceOf ("/", true, false));
+    const bool isFtp = remoteUrl.startsWithIgnoreCase ("ftp");
+
+    // MLSD gives the details in a standard form but older servers only have LIST
+    const char* const commands[] = { isFtp ? "MLSD" : nullptr, nullptr };
+    CURLcode result = CURLE_OK;
+
+    for (int i = 0; i < (isFtp ? 2 : 1); ++i)
+    {
+        curl_easy_setopt (handle, CURLOPT_URL, remoteUrl.toUTF8().getAddress());
+        curl_easy_setopt (handle, CURLOPT_NOPROGRESS, 1L);
+        curl_easy_setopt (handle, CURLOPT_UPLOAD, 0L);
+        curl_easy_setopt (handle, CURLOPT_DIRLISTONLY, 0L);
+        curl_easy_setopt (handle, CURLOPT_CUSTOMREQUEST, commands[i]);
+        curl_easy_setopt (handle, CURLOPT_WRITEDATA, this);
+        curl_easy_setopt (handle, CURLOPT_WRITEFUNCTION, directoryListingCallback);
+
+        directoryContentsList.setSize (0);
+        result = curl_easy_perform (handle);
+
+        if (result == CURLE_OK)
+        {
+            CURLManager::getInstance()->updateConnectionStatistics (handle);
+            break;
+        }
+    }
+
+    reset();
+    lastResult = result;
+
+    return result == CURLE_OK ? directoryContentsList.toString() : String();
+}
+
+int64 CURLEasySession::getRemoteFileSize()
+{
+    curl_easy_setopt (handle, CURLOPT_URL, remotePath.toUTF8().getAddress());
+    curl_easy_setopt (handle, CURLOPT_NOBODY, 1L);
+    curl_easy_setopt (handle, CURLOPT_NOPROGRESS, 1L);
+
+    curl_off_t size = -1;
+    CURLcode result = curl_easy_perform (handle);
+
+    if (result == CURLE_OK)
+    {
+        CURLManager::getInstance()->updateConnectionStatistics (handle);
+        result = curl_easy_getinfo (handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &size);
+    }
+
+    reset();
+
+    return result == CURLE_OK ? (int64) size : -1;
+}
+
 // not yet ready
 //String CURLEasySession::getContentType()
 //{
@@ -168,36 +258,47 @@ StringArray CURLEasySession::getDirectoryListing()
 //==============================================================================
 void CURLEasySession::enableFullDebugging (bool shouldEnableFullDebugging)
 {
+    fullDebugging = shouldEnableFullDebugging;
     curl_easy_setopt (handle, CURLOPT_VERBOSE, shouldEnableFullDebugging ? 1L : 0L);
 }
 
 void CURLEasySession::beginTransfer (bool transferIsUpload, bool performOnBackgroundThread)
 {
     isUpload = transferIsUpload;
+    transferInForeground = ! performOnBackgroundThread;
     shouldStopTransfer = false;
+    prepareTransfer (isUpload);
 
     if (performOnBackgroundThread)
     {
-        CURLManager::getInstance()->addTimeSliceClient (this);
-        CURLManager::getInstance()->startThread();
+        CURLManager::getInstance()->addSession (this);
     }
     else
     {
-        performTransfer (isUpload);
+        transferStarting();
+        transferFinished (curl_easy_perform (handle));
     }
 }
 
 void CURLEasySession::stopTransfer()
 {
     shouldStopTransfer = true;
+
+    if (CURLManager* manager = CURLManager::getInstanceWithoutCreating())
+        manager->wakeUp();
+}
+
+String CURLEasySession::getLastError() const
+{
+    const CURLcode result = (CURLcode) lastResult.load();
+
+    return result == CURLE_OK ? String() : String (curl_easy_strerror (result));
 }
 
 void CURLEasySession::reset()
 {
-    curl_easy_reset (handle);
-    curl_easy_setopt (handle, CURLOPT_URL, remotePath.toUTF8().getAddress());
-    curl_easy_setopt (handle, CURLOPT_USERPWD, userNameAndPassword.toUTF8().getAddress());
-    curl_easy_setopt (handle, CURLOPT_NOPROGRESS, false);
+    CURLManager::getInstance()->resetEasyCurlHandle (handle);
+    applyOptions();
 }
 
 //==============================================================================
@@ -211,26 +312,18 @@ void CURLEasySession::removeListener (CURLEasySession::Listener* const listener)
     listeners.remove (listener);
 }
 
-//==============================================================================
-int CURLEasySession::useTimeSlice()
-{
-    performTransfer (isUpload);
-
-    return -1;
-}
-
 //==============================================================================
 size_t CURLEasySession::writeCallback (void* sourcePointer, size_t blockSize, size_t numBlocks, CURLEasySession* session)
 {
-    if (session != nullptr)
+    if (session != nullptr && ! CURLManager::wasRemovedDuringPerform (session))
     {
-        if (session->outputStream->failedToOpen())
+        if (session->outputStream == nullptr
+             || ! session->outputStream->write (sourcePointer, blockSize * numBlocks))
         {
-            /* failure, can't open file to write */
+            /* failure, can't open file to write or the stream refused the data */
             return ! (blockSize * numBlocks); // return a value not equal to (blockSize * numBlocks)
         }
 
-        session->outputStream->write (sourcePointer, blockSize * numBlocks);
         return blockSize * numBlocks;
     }
 
@@ -239,11 +332,15 @@ size_t CURLEasySession::writeCallback (void* sourcePointer, size_t blockSize, si
 
 size_t CURLEasySession::readCallback (void* destinationPointer, size_t blockSize, size_t numBlocks, CURLEasySession* session)
 {
-    if (session != nullptr)
+    if (session != nullptr && ! CURLManager::wasRemovedDuringPerform (session))
     {
         if (session->inputStream.get() == nullptr)
             return CURL_READFUNC_ABORT; /* failure, can't open file to read */
 
+        if (auto* encoder = dynamic_cast<AudioEncodingInputStream*> (session->inputStream.get()))
+            if (! session->transferInForeground)
+                return session->readEncodedData (destinationPointer, blockSize * numBlocks, *encoder);
+
         return (size_t) session->inputStream->read (destinationPointer, (int) (blockSize * numBlocks));
     }
 
@@ -252,7 +349,7 @@ size_t CURLEasySession::readCallback (void* destinationPointer, size_t blockSize
 
 size_t CURLEasySession::directoryListingCallback (void* sourcePointer, size_t blockSize, size_t numBlocks, CURLEasySession* session)
 {
-    if (session != nullptr)
+    if (session != nullptr && ! CURLManager::wasRemovedDuringPerform (session))
     {
         session->directoryContentsList.append (sourcePointer, (size_t) (blockSize * numBlocks));
 
@@ -264,18 +361,59 @@ size_t CURLEasySession::directoryListingCallback (void* sourcePointer, size_t bl
 
 int CURLEasySession::internalProgressCallback (CURLEasySession* session, double dltotal, double dlnow, double /*ultotal*/, double ulnow)
 {
-    session->progress = (float) (session->isUpload ? (ulnow / session->inputStream->getTotalLength()) : (dlnow / dltotal));
+    if (CURLManager::wasRemovedDuringPerform (session))
+        return 1;
+
+    if (session->isUpload)
+    {
+        // streams that are still being written don't know their length
+        const int64 totalLength = session->inputStream->getTotalLength();
+        session->progress = totalLength > 0 ? (float) (ulnow / totalLength) : 0.0f;
+    }
+    else
+    {
+        session->progress = (float) (dlnow / dltotal);
+    }
 
     session->listeners.call (&CURLEasySession::Listener::transferProgressUpdate, session);
 
+    // a listener may have deleted the session, in which case the transfer is aborted
+    if (CURLManager::wasRemovedDuringPerform (session))
+        return 1;
+
     return (int) session->shouldStopTransfer;
 }
 
 //==============================================================================
-int CURLEasySession::performTransfer (bool transferIsUpload)
+void CURLEasySession::applyOptions()
+{
+    curl_easy_setopt (handle, CURLOPT_URL, remotePath.toUTF8().getAddress());
+    curl_easy_setopt (handle, CURLOPT_USERPWD, userNameAndPassword.isNotEmpty() ? userNameAndPassword.toUTF8().getAddress() : nullptr);
+    curl_easy_setopt (handle, CURLOPT_NOPROGRESS, false);
+    curl_easy_setopt (handle, CURLOPT_VERBOSE, fullDebugging ? 1L : 0L);
+}
+
+void CURLEasySession::changeHandleIfNeeded (const String& newRemotePath, const String& newUserNameAndPassword)
+{
+    if (CURLManager::getHandleKey (newRemotePath, newUserNameAndPassword)
+          == CURLManager::getHandleKey (remotePath, userNameAndPassword))
+        return;
+
+    // swap to a handle that was last used with the new server so it may still be logged in
+    CURLManager* manager = CURLManager::getInstance();
+    manager->releaseEasyCurlHandle (handle, remotePath, userNameAndPassword);
+    handle = manager->acquireEasyCurlHandle (newRemotePath, newUserNameAndPassword);
+
+    remotePath = newRemotePath;
+    userNameAndPassword = newUserNameAndPassword;
+    applyOptions();
+}
+
+void CURLEasySession::prepareTransfer (bool transferIsUpload)
 {
     curl_easy_setopt (handle, CURLOPT_URL, remotePath.toUTF8().getAddress());
     curl_easy_setopt (handle, CURLOPT_UPLOAD, (long) transferIsUpload);
+    curl_easy_setopt (handle, CURLOPT_RANGE, byteRange.isNotEmpty() && ! transferIsUpload ? byteRange.toRawUTF8() : nullptr);
     curl_easy_setopt (handle, CURLOPT_PROGRESSDATA, this);
     curl_easy_setopt (handle, CURLOPT_PROGRESSFUNCTION, internalProgressCallback);
 
@@ -285,6 +423,9 @@ int CURLEasySession::performTransfer (bool transferIsUpload)
         curl_easy_setopt (handle, CURLOPT_READDATA, this);
         curl_easy_setopt (handle, CURLOPT_READFUNCTION, readCallback);
         inputStream->setPosition (0);
+
+        if (auto* encoder = dynamic_cast<AudioEncodingInputStream*> (inputStream.get()))
+            encoder->setDataReadyCallback ([this] { uploadDataReady(); });
     }
     else
     {
@@ -292,23 +433,63 @@ int CURLEasySession::performTransfer (bool transferIsUpload)
         curl_easy_setopt (handle, CURLOPT_WRITEDATA, this);
         curl_easy_setopt (handle, CURLOPT_WRITEFUNCTION, writeCallback);
 
-        // create local file to recieve transfer
-        if (localFile.existsAsFile())
-            localFile = localFile.getNonexistentSibling();
+        // create local file to recieve transfer unless a stream has been given
+        if (outputStream == nullptr)
+        {
+            if (localFile.existsAsFile())
+                localFile = localFile.getNonexistentSibling();
 
-        outputStream = localFile.createOutputStream();
+            outputStream = localFile.createOutputStream();
+        }
     }
+}
 
-    //perform the transfer
+void CURLEasySession::transferStarting()
+{
     progress = 0.0f;
     listeners.call (&CURLEasySession::Listener::transferAboutToStart, this);
-    CURLcode result = curl_easy_perform (handle);
+}
+
+void CURLEasySession::transferFinished (int result)
+{
+    lastResult = result;
+
+    if (result == CURLE_OK)
+        CURLManager::getInstance()->updateConnectionStatistics (handle);
 
     // delete the streams to flush the buffers
     outputStream = nullptr;
+
+    // this must be last as listeners may delete the session
     listeners.call (&CURLEasySession::Listener::transferEnded, this);
+}
+
+size_t CURLEasySession::readEncodedData (void* destinationPointer, size_t numBytes, AudioEncodingInputStream& encoder)
+{
+    // rather than blocking the other transfers the upload is paused until more has been encoded
+    int numRead = encoder.readAvailable (destinationPointer, (int) numBytes);
+
+    if (numRead == 0 && ! encoder.isExhausted())
+    {
+        waitingForUploadData = true;
+
+        // some data may have arrived before the flag was set
+        numRead = encoder.readAvailable (destinationPointer, (int) numBytes);
 
-    return result;
+        if (numRead == 0 && ! encoder.isExhausted())
+            return CURL_READFUNC_PAUSE;
+
+        waitingForUploadData = false;
+    }
+
+    return (size_t) numRead;
+}
+
+void CURLEasySession::uploadDataReady()
+{
+    if (waitingForUploadData.exchange (false))
+        if (CURLManager* manager = CURLManager::getInstanceWithoutCreating())
+            manager->resumeSession (this);
 }
 
 #endif //DROWAUDIO_USE_CURL
@@ -36,6 +36,8 @@
 
 #include "dRowAudio_CURLManager.h"
 
+class AudioEncodingInputStream;
+
 /** Creates a CURLEasySession.
 
     One of these is used to handle a specific transfer optionally on a
@@ -43,10 +45,15 @@
     when it goes out of scope it will clean up after itself or create an object
     to re-use and use the various methods to control the transfer.
 
+    Background transfers are performed by the CURLManager alongside any others
+    that are running, see CURLManager::setMaxConcurrentTransfers(). Sessions use
+    pooled handles from the CURLManager so connections and logins to a server
+    are reused between them.
+
     @todo directory list is returned if this is found before a file transfer
     @todo rename remote file if it already exists
 */
-class CURLEasySession : public juce::TimeSliceClient
+class CURLEasySession
 {
 public:
     /** Creates an uninitialised CURLEasySession.
@@ -67,12 +74,32 @@ public:
     ~CURLEasySession();
 
     //==============================================================================
-    /** Sets the the source of an upload to an input stream. */
+    /** Sets the the source of an upload to an input stream.
+
+        If this is an AudioEncodingInputStream a background transfer will pause while
+        it waits for more audio to be encoded rather than holding up other transfers.
+    */
     void setInputStream (juce::InputStream* newInputStream);
 
     /** Sets the local file to either upload or download into. */
     void setLocalFile (const juce::File& newLocalFile);
 
+    /** Sets a stream to download into instead of the local file.
+
+        The session takes ownership of the stream and deletes it when the transfer
+        ends, so this needs to be called again before each transfer that uses one.
+        The transfer fails if the stream refuses any of the data written to it.
+    */
+    void setOutputStream (juce::OutputStream* newOutputStream);
+
+    /** Limits downloads to part of the remote file.
+
+        This uses an HTTP Range or FTP REST command so only numBytes starting at
+        startByte are fetched. Pass a negative numBytes to download whole files again.
+        Servers that don't support ranges may send the whole file anyway.
+    */
+    void setByteRange (juce::int64 startByte, juce::int64 numBytes);
+
     /** Returns the local file being used.
 
         If an input stream has been specified this will return File::nonexistent.
@@ -93,6 +120,9 @@ public:
     */
     const juce::String& getRemotePath() const { return remotePath; }
 
+    /** Returns the user name and password in the form "username:password". */
+    const juce::String& getUserNameAndPassword() const { return userNameAndPassword; }
+
     /** Sets the user name and password of the connection.
         This is only used if required by the connection to the server.
     */
@@ -105,6 +135,22 @@ public:
     /**    Returns the directory listing of the remote file. */
     juce::StringArray getDirectoryListing();
 
+    /** Returns the raw listing of the remote file's directory including the details
+        of each entry.
+
+        FTP servers are sent an MLSD command, falling back to LIST if they don't
+        support it. This blocks while the listing is fetched and returns an empty
+        string if it fails, use getLastError() to find out why.
+
+        @see RemoteDirectoryCache::parseListing
+    */
+    juce::String getDetailedDirectoryListing();
+
+    /** Returns the size in bytes of the remote file, or -1 if it can't be found.
+        This blocks while the server is asked for the size.
+    */
+    juce::int64 getRemoteFileSize();
+
     /** Returns the content type of the current remote path. */
     //String getContentType(); // not yet ready
 
@@ -117,15 +163,21 @@ public:
 
     /** Begins the transfer.
 
-        Returns an error code or an empty String if everything is set up ok.
         The transfer will actually take place on a background thread so use getLastError()
         to determine the last error that occured.
     */
     void beginTransfer (bool transferIsUpload, bool performOnBackgroundThread = true);
 
-    /** Stops the current transfer. */
+    /** Stops the current transfer.
+        A background transfer will stop straight away rather than at the next progress update.
+    */
     void stopTransfer();
 
+    /** Returns a description of the error that ended the last transfer or an
+        empty String if it succeeded.
+    */
+    juce::String getLastError() const;
+
     /** Resets the state of the session to the parameters that have been specified. */
     void reset();
 
@@ -136,7 +188,9 @@ public:
     /** A class for receiving callbacks from a CURLEasySession.
 
         Note that these callbacks will be called from the transfer thread so make sure
-        any code within them is thread safe!
+        any code within them is thread safe! A session can be deleted from its
+        transferEnded() callback. For background transfers sessions can also be
+        deleted from any of the callbacks, which stops their transfers.
      */
     class Listener
     {
@@ -160,19 +214,19 @@ public:
     /** Removes a previously-registered listener. */
     void removeListener (Listener* listener);
 
-    //==============================================================================
-    /** @internal */
-    int useTimeSlice() override;
-
 private:
     //==============================================================================
+    friend class CURLManager;
+
     CURL* handle;
-    juce::String remotePath, userNameAndPassword;
-    bool isUpload, shouldStopTransfer;
+    juce::String remotePath, userNameAndPassword, byteRange;
+    bool isUpload, fullDebugging, transferInForeground;
+    std::atomic<bool> shouldStopTransfer, waitingForUploadData;
+    std::atomic<int> lastResult;
     juce::Atomic<float> progress;
 
     juce::File localFile;
-    std::unique_ptr<juce::FileOutputStream> outputStream;
+    std::unique_ptr<juce::OutputStream> outputStream;
     std::unique_ptr<juce::InputStream> inputStream;
     juce::MemoryBlock directoryContentsList;
 
@@ -180,7 +234,13 @@ private:
     juce::ListenerList<Listener> listeners;
 
     //==============================================================================
-    int performTransfer (bool transferIsUpload);
+    void applyOptions();
+    void changeHandleIfNeeded (const juce::String& newRemotePath, const juce::String& newUserNameAndPassword);
+    void prepareTransfer (bool transferIsUpload);
+    void transferStarting();
+    void transferFinished (int result);
+    size_t readEncodedData (void* destinationPointer, size_t numBytes, AudioEncodingInputStream& encoder);
+    void uploadDataReady();
 
     static size_t writeCallback (void* sourcePointer, size_t blockSize, size_t numBlocks, CURLEasySession* session);
     static size_t readCallback (void* destinationPointer, size_t blockSize, size_t numBlocks, CURLEasySession* session);
@@ -42,27 +42,82 @@
 namespace drow
 {
 
+//==============================================================================
+namespace CURLManagerHelpers
+{
+    static void lockShare (CURL*, curl_lock_data data, curl_lock_access, void* userData)
+    {
+        static_cast<OwnedArray<CriticalSection>*> (userData)->getUnchecked ((int) data)->enter();
+    }
+
+    static void unlockShare (CURL*, curl_lock_data data, void* userData)
+    {
+        static_cast<OwnedArray<CriticalSection>*> (userData)->getUnchecked ((int) data)->exit();
+    }
+
+    enum { maxNumIdleHandles = 16 };
+}
+
 //==============================================================================
 juce_ImplementSingleton (CURLManager);
 
 CURLManager::CURLManager()
-    : TimeSliceThread ("cURL Thread")
+    : Thread ("cURL Thread"),
+      multiHandle (nullptr),
+      shareHandle (nullptr),
+      maxIdleTimeMs (60000),
+      numHandlePoolHits (0),
+      numHandlePoolMisses (0),
+      numConnectionsReused (0),
+      numNewConnections (0),
+      maxTransfers (8),
+      maxTransfersPerHost (4),
+      finishingSession (nullptr),
+      isPerforming (false)
 {
     CURLcode result = curl_global_init (CURL_GLOBAL_ALL);
 
     (void) result;
     jassert (result == CURLE_OK);
+
+    multiHandle = curl_multi_init();
+
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; ++i)
+        shareLocks.add (new CriticalSection());
+
+    shareHandle = curl_share_init();
+    curl_share_setopt (shareHandle, CURLSHOPT_LOCKFUNC, CURLManagerHelpers::lockShare);
+    curl_share_setopt (shareHandle, CURLSHOPT_UNLOCKFUNC, CURLManagerHelpers::unlockShare);
+    curl_share_setopt (shareHandle, CURLSHOPT_USERDATA, &shareLocks);
+    curl_share_setopt (shareHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt (shareHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    curl_share_setopt (shareHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
 }
 
 CURLManager::~CURLManager()
 {
+    signalThreadShouldExit();
+    wakeUp();
+    stopThread (5000);
+
+    for (auto& transfer : activeTransfers)
+        curl_multi_remove_handle (multiHandle, transfer.session->handle);
+
+    for (auto& idle : idleHandles)
+        curl_easy_cleanup (idle.handle);
+
+    curl_multi_cleanup (multiHandle);
+    curl_share_cleanup (shareHandle);
     curl_global_cleanup();
     clearSingletonInstance();
 }
 
 CURL* CURLManager::createEasyCurlHandle()
 {
-    return curl_easy_init();
+    CURL* handle = curl_easy_init();
+    resetEasyCurlHandle (handle);
+
+    return handle;
 }
 
 void CURLManager::cleanUpEasyCurlHandle (CURL* handle)
@@ -71,6 +126,72 @@ void CURLManager::cleanUpEasyCurlHandle (CURL* handle)
     handle = nullptr;
 }
 
+CURL* CURLManager::acquireEasyCurlHandle (const String& url, const String& userNameAndPassword)
+{
+    const String key (getHandleKey (url, userNameAndPassword));
+
+    {
+        const ScopedLock sl (poolLock);
+        reapIdleHandles();
+
+        // the most recently used is the most likely to still have a live connection
+        for (int i = idleHandles.size(); --i >= 0;)
+        {
+            if (idleHandles.getReference (i).key == key)
+            {
+                ++numHandlePoolHits;
+                return idleHandles.removeAndReturn (i).handle;
+            }
+        }
+    }
+
+    ++numHandlePoolMisses;
+    return createEasyCurlHandle();
+}
+
+void CURLManager::releaseEasyCurlHandle (CURL* handle, const String& url, const String& userNameAndPassword)
+{
+    if (handle == nullptr)
+        return;
+
+    {
+        // the handle of a session deleted during curl_multi_perform can't be
+        // touched until it has been removed from the multi handle
+        const ScopedLock sl (lock);
+
+        for (auto& removed : removedDuringPerform)
+        {
+            if (removed.handle == handle)
+            {
+                handlesToRelease.add ({ handle, getHandleKey (url, userNameAndPassword), 0 });
+                return;
+            }
+        }
+    }
+
+    addIdleHandle (handle, getHandleKey (url, userNameAndPassword));
+}
+
+void CURLManager::addIdleHandle (CURL* handle, const String& key)
+{
+    resetEasyCurlHandle (handle);
+
+    const ScopedLock sl (poolLock);
+    idleHandles.add ({ handle, key, Time::getMillisecondCounter() });
+
+    while (idleHandles.size() > CURLManagerHelpers::maxNumIdleHandles)
+        curl_easy_cleanup (idleHandles.removeAndReturn (0).handle);
+
+    reapIdleHandles();
+}
+
+void CURLManager::resetEasyCurlHandle (CURL* handle)
+{
+    curl_easy_reset (handle);
+    curl_easy_setopt (handle, CURLOPT_SHARE, shareHandle);
+    curl_easy_setopt (handle, CURLOPT_MAXAGE_CONN, (long) (maxIdleTimeMs.load() / 1000));
+}
+
 StringArray CURLManager::getSupportedProtocols()
 {
     if (curl_version_info_data* info = curl_version_info (CURLVERSION_NOW))
@@ -79,4 +200,441 @@ StringArray CURLManager::getSupportedProtocols()
     return juce::StringArray();
 }
 
+//==============================================================================
+void CURLManager::setMaxConcurrentTransfers (int newMaximum)
+{
+    maxTransfers = jmax (1, newMaximum);
+    wakeUp();
+}
+
+void CURLManager::setMaxConcurrentTransfersPerHost (int newMaximum)
+{
+    maxTransfersPerHost = jmax (1, newMaximum);
+    wakeUp();
+}
+
+void CURLManager::setMaxIdleTime (RelativeTime newMaxIdleTime)
+{
+    maxIdleTimeMs = jmax (0, (int) newMaxIdleTime.inMilliseconds());
+
+    const ScopedLock sl (poolLock);
+    reapIdleHandles();
+}
+
+int CURLManager::getNumActiveTransfers() const
+{
+    const ScopedLock sl (lock);
+    return activeTransfers.size();
+}
+
+int CURLManager::getNumQueuedTransfers() const
+{
+    const ScopedLock sl (lock);
+    return queuedTransfers.size();
+}
+
+//==============================================================================
+void CURLManager::run()
+{
+    while (! threadShouldExit())
+    {
+        removeSessions();
+        resumePausedTransfers();
+        cancelStoppedTransfers();
+        startQueuedTransfers();
+
+        int numRunning = 0;
+        isPerforming = true;
+        curl_multi_perform (multiHandle, &numRunning);
+        isPerforming = false;
+
+        removeDeferredHandles();
+        finishTransfers();
+
+        // this returns as soon as any of the transfers can progress or wakeUp() is called
+        curl_multi_poll (multiHandle, nullptr, 0, 1000, nullptr);
+
+        {
+            const ScopedLock sl (poolLock);
+            reapIdleHandles();
+        }
+    }
+}
+
+//==============================================================================
+void CURLManager::addSession (CURLEasySession* session)
+{
+    {
+        const ScopedLock sl (lock);
+        queuedTransfers.add ({ session, URL (session->getRemotePath()).getDomain() });
+    }
+
+    if (! isThreadRunning())
+        startThread();
+
+    wakeUp();
+}
+
+void CURLManager::removeSession (CURLEasySession* session)
+{
+    {
+        const ScopedLock sl (lock);
+
+        for (int i = queuedTransfers.size(); --i >= 0;)
+            if (queuedTransfers.getReference (i).session == session)
+                queuedTransfers.remove (i);
+
+        sessionsToResume.removeFirstMatchingValue (session);
+
+        if (! isUsingSession (session))
+            return;
+
+        // on the transfer thread this is from a listener callback. The progress callbacks
+        // are made from inside curl_multi_perform, where handles can't be removed, so the
+        // handle is only removed once it returns and kept out of the pool until then.
+        // libcurl may still call back with the deleted session until it's removed so the
+        // callbacks check wasRemovedDuringPerform() before using it
+        if (Thread::getCurrentThreadId() == getThreadId())
+        {
+            for (int i = activeTransfers.size(); --i >= 0;)
+            {
+                if (activeTransfers.getReference (i).session == session)
+                {
+                    if (isPerforming)
+                        removedDuringPerform.add ({ session, session->handle });
+                    else
+                        curl_multi_remove_handle (multiHandle, session->handle);
+
+                    activeTransfers.remove (i);
+                }
+            }
+
+            return;
+        }
+
+        sessionsToRemove.addIfNotAlreadyThere (session);
+    }
+
+    // the multi handle can only be used by the transfer thread so wait for it to let go
+    wakeUp();
+
+    while (isThreadRunning())
+    {
+        {
+            const ScopedLock sl (lock);
+
+            if (! isUsingSession (session))
+                return;
+        }
+
+        sessionRemovedEvent.wait (10);
+    }
+}
+
+void CURLManager::resumeSession (CURLEasySession* session)
+{
+    {
+        const ScopedLock sl (lock);
+        sessionsToResume.addIfNotAlreadyThere (session);
+    }
+
+    wakeUp();
+}
+
+void CURLManager::wakeUp()
+{
+    curl_multi_wakeup (multiHandle);
+}
+
+//==============================================================================
+String CURLManager::getHandleKey (const String& url, const String& userNameAndPassword)
+{
+    const URL u (url);
+
+    // the credentials are hashed so they aren't kept around in the pool
+    return u.getScheme() + "://" + String::toHexString (userNameAndPassword.hashCode64())
+            + "@" + u.getDomain() + ":" + String (u.getPort());
+}
+
+void CURLManager::reapIdleHandles()
+{
+    const uint32 now = Time::getMillisecondCounter();
+
+    for (int i = idleHandles.size(); --i >= 0;)
+    {
+        if (now - idleHandles.getReference (i).releaseTime > (uint32) maxIdleTimeMs.load())
+            curl_easy_cleanup (idleHandles.removeAndReturn (i).handle);
+    }
+}
+
+void CURLManager::updateConnectionStatistics (CURL* handle)
+{
+    long numConnects = 0;
+
+    if (curl_easy_getinfo (handle, CURLINFO_NUM_CONNECTS, &numConnects) == CURLE_OK)
+    {
+        if (numConnects > 0)
+            numNewConnections += numConnects;
+        else
+            ++numConnectionsReused;
+    }
+}
+
+//==============================================================================
+bool CURLManager::isUsingSession (CURLEasySession* session) const
+{
+    if (finishingSession == session)
+        return true;
+
+    for (auto& transfer : activeTransfers)
+        if (transfer.session == session)
+            return true;
+
+    return false;
+}
+
+int CURLManager::getNumActiveTransfers (const String& host) const
+{
+    int numTransfers = 0;
+
+    for (auto& transfer : activeTransfers)
+        if (transfer.host == host)
+            ++numTransfers;
+
+    return numTransfers;
+}
+
+int CURLManager::findNextQueuedTransfer() const
+{
+    StringArray hosts;
+
+    for (auto& transfer : queuedTransfers)
+        hosts.addIfNotAlreadyThere (transfer.host);
+
+    // take turns between the hosts, starting after the last one to have a transfer started
+    const int firstHost = hosts.indexOf (lastStartedHost) + 1;
+
+    for (int i = 0; i < hosts.size(); ++i)
+    {
+        const String& host = hosts[(firstHost + i) % hosts.size()];
+
+        if (getNumActiveTransfers (host) >= maxTransfersPerHost.load())
+            continue;
+
+        for (int j = 0; j < queuedTransfers.size(); ++j)
+            if (queuedTransfers.getReference (j).host == host)
+                return j;
+    }
+
+    return -1;
+}
+
+//==============================================================================
+bool CURLManager::wasRemovedDuringPerform (CURLEasySession* session)
+{
+    CURLManager* manager = getInstanceWithoutCreating();
+
+    // the list is only changed on the transfer thread so it can be read there without the lock
+    if (manager == nullptr || Thread::getCurrentThreadId() != manager->getThreadId())
+        return false;
+
+    for (auto& removed : manager->removedDuringPerform)
+        if (removed.session == session)
+            return true;
+
+    return false;
+}
+
+void CURLManager::removeSessions()
+{
+    Array<CURLEasySession*> sessions;
+
+    {
+        const ScopedLock sl (lock);
+        sessions.swapWith (sessionsToRemove);
+    }
+
+    if (sessions.isEmpty())
+        return;
+
+    for (auto* session : sessions)
+    {
+        const ScopedLock sl (lock);
+
+        for (int i = activeTransfers.size(); --i >= 0;)
+        {
+            if (activeTransfers.getReference (i).session == session)
+            {
+                curl_multi_remove_handle (multiHandle, session->handle);
+                activeTransfers.remove (i);
+            }
+        }
+    }
+
+    sessionRemovedEvent.signal();
+}
+
+void CURLManager::removeDeferredHandles()
+{
+    Array<RemovedTransfer> removed;
+    Array<IdleHandle> handlesToPool;
+
+    {
+        const ScopedLock sl (lock);
+        removed.swapWith (removedDuringPerform);
+        handlesToPool.swapWith (handlesToRelease);
+    }
+
+    for (auto& transfer : removed)
+        curl_multi_remove_handle (multiHandle, transfer.handle);
+
+    for (auto& idle : handlesToPool)
+        addIdleHandle (idle.handle, idle.key);
+}
+
+void CURLManager::resumePausedTransfers()
+{
+    Array<CURLEasySession*> sessions;
+
+    {
+        const ScopedLock sl (lock);
+
+        for (auto* session : sessionsToResume)
+            if (isUsingSession (session))
+                sessions.add (session);
+
+        sessionsToResume.clearQuick();
+    }
+
+    // unpausing can call back into the sessions so this is done without the lock held,
+    // and as with curl_multi_perform any sessions deleted then are removed afterwards
+    isPerforming = true;
+
+    for (auto* session : sessions)
+        if (! wasRemovedDuringPerform (session))
+            curl_easy_pause (session->handle, CURLPAUSE_CONT);
+
+    isPerforming = false;
+    removeDeferredHandles();
+}
+
+void CURLManager::cancelStoppedTransfers()
+{
+    Array<CURLEasySession*> stoppedSessions;
+
+    {
+        const ScopedLock sl (lock);
+
+        for (int i = queuedTransfers.size(); --i >= 0;)
+        {
+            if (queuedTransfers.getReference (i).session->shouldStopTransfer.load())
+            {
+                stoppedSessions.add (queuedTransfers.getReference (i).session);
+                queuedTransfers.remove (i);
+            }
+        }
+
+        // removing these here rather than waiting for the progress callback means they stop straight away
+        for (int i = activeTransfers.size(); --i >= 0;)
+        {
+            CURLEasySession* session = activeTransfers.getReference (i).session;
+
+            if (session->shouldStopTransfer.load())
+            {
+                curl_multi_remove_handle (multiHandle, session->handle);
+                stoppedSessions.add (session);
+            }
+        }
+    }
+
+    for (auto* session : stoppedSessions)
+        finishTransfer (session, CURLE_ABORTED_BY_CALLBACK);
+}
+
+void CURLManager::startQueuedTransfers()
+{
+    for (;;)
+    {
+        CURLEasySession* session = nullptr;
+
+        {
+            const ScopedLock sl (lock);
+
+            if (activeTransfers.size() >= maxTransfers.load())
+                return;
+
+            const int index = findNextQueuedTransfer();
+
+            if (index < 0)
+                return;
+
+            const Transfer transfer (queuedTransfers.removeAndReturn (index));
+            activeTransfers.add (transfer);
+            lastStartedHost = transfer.host;
+            session = transfer.session;
+        }
+
+        session->transferStarting();
+
+        // a listener may have deleted the session as it was starting
+        const ScopedLock sl (lock);
+
+        for (auto& transfer : activeTransfers)
+            if (transfer.session == session)
+                curl_multi_add_handle (multiHandle, session->handle);
+    }
+}
+
+void CURLManager::finishTransfers()
+{
+    int numMessagesLeft = 0;
+
+    while (CURLMsg* message = curl_multi_info_read (multiHandle, &numMessagesLeft))
+    {
+        if (message->msg != CURLMSG_DONE)
+            continue;
+
+        // the message is invalid once the handle has been removed
+        CURL* handle = message->easy_handle;
+        const CURLcode result = message->data.result;
+        CURLEasySession* session = nullptr;
+
+        curl_multi_remove_handle (multiHandle, handle);
+
+        {
+            const ScopedLock sl (lock);
+
+            for (auto& transfer : activeTransfers)
+                if (transfer.session->handle == handle)
+                    session = transfer.session;
+        }
+
+        if (session != nullptr)
+            finishTransfer (session, result);
+    }
+}
+
+void CURLManager::finishTransfer (CURLEasySession* session, int result)
+{
+    {
+        const ScopedLock sl (lock);
+
+        for (int i = activeTransfers.size(); --i >= 0;)
+            if (activeTransfers.getReference (i).session == session)
+                activeTransfers.remove (i);
+
+        finishingSession = session;
+    }
+
+    // a listener may delete or restart the session so it can't be used after this
+    session->transferFinished (result);
+
+    {
+        const ScopedLock sl (lock);
+        finishingSession = nullptr;
+    }
+
+    sessionRemovedEvent.signal();
+}
+
 #endif //DROWAUDIO_USE_CURL
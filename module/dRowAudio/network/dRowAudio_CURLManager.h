@@ -37,12 +37,30 @@
 }
 
 typedef void CURL;
+typedef void CURLM;
+typedef void CURLSH;
 
 namespace drow
 {
 
+class CURLEasySession;
+
 //==============================================================================
-class CURLManager : public juce::TimeSliceThread,
+/** Performs the transfers of CURLEasySessions on a background thread.
+
+    All the background transfers are driven by a single cURL multi handle so
+    many of them can progress at once and a slow one won't hold up the others.
+    The number of transfers running at once can be limited, both in total and
+    to any one host. Transfers waiting for a free slot are started in turn from
+    each host so a large batch to one server won't starve the rest.
+
+    Easy handles are kept in a pool when sessions have finished with them so
+    they can be reused for the same host and credentials. All handles share DNS,
+    TLS session and connection caches, so a new session to a server that has
+    recently been used doesn't have to connect and log in again. Handles that
+    have been idle for a while are cleaned up, see setMaxIdleTime().
+*/
+class CURLManager : public juce::Thread,
                     public juce::DeletedAtShutdown
 {
 public:
@@ -51,7 +69,7 @@ public:
 
     CURLManager();
 
-    ~CURLManager();
+    ~CURLManager() override;
 
     //==============================================================================
     /** Creates a new easy curl session handle.
@@ -70,10 +88,132 @@ public:
     */
     void cleanUpEasyCurlHandle (CURL* handle);
 
+    /** Returns a handle for transfers to a URL with some credentials.
+
+        This will be an idle handle from the pool that was last used for the same
+        scheme, host, port and credentials if there is one, otherwise a new one.
+        Give it back with releaseEasyCurlHandle() rather than cleaning it up.
+    */
+    CURL* acquireEasyCurlHandle (const juce::String& url, const juce::String& userNameAndPassword);
+
+    /** Resets a handle and puts it back in the pool to be reused.
+        The url and credentials should be the ones it was last used with.
+    */
+    void releaseEasyCurlHandle (CURL* handle, const juce::String& url, const juce::String& userNameAndPassword);
+
+    /** Resets the options of a handle, keeping it connected to the shared caches. */
+    void resetEasyCurlHandle (CURL* handle);
+
     /** Returns a list of the supported protocols. */
     juce::StringArray getSupportedProtocols();
 
+    //==============================================================================
+    /** Sets the maximum number of transfers that can run at once, the default is 8. */
+    void setMaxConcurrentTransfers (int newMaximum);
+
+    /** Returns the maximum number of transfers that can run at once. */
+    int getMaxConcurrentTransfers() const noexcept          { return maxTransfers.load(); }
+
+    /** Sets the maximum number of transfers to any one host that can run at once, the default is 4. */
+    void setMaxConcurrentTransfersPerHost (int newMaximum);
+
+    /** Returns the maximum number of transfers to any one host that can run at once. */
+    int getMaxConcurrentTransfersPerHost() const noexcept   { return maxTransfersPerHost.load(); }
+
+    /** Returns the number of transfers currently running. */
+    int getNumActiveTransfers() const;
+
+    /** Returns the number of transfers waiting to start. */
+    int getNumQueuedTransfers() const;
+
+    //==============================================================================
+    /** Sets how long idle handles and connections are kept for, the default is 60 seconds. */
+    void setMaxIdleTime (juce::RelativeTime newMaxIdleTime);
+
+    /** Returns the number of times a handle was reused from the pool. */
+    juce::int64 getNumHandlePoolHits() const noexcept       { return numHandlePoolHits.load(); }
+
+    /** Returns the number of times a new handle had to be created. */
+    juce::int64 getNumHandlePoolMisses() const noexcept     { return numHandlePoolMisses.load(); }
+
+    /** Returns the number of transfers that reused an existing connection. */
+    juce::int64 getNumConnectionsReused() const noexcept    { return numConnectionsReused.load(); }
+
+    /** Returns the number of transfers that had to make a new connection. */
+    juce::int64 getNumNewConnections() const noexcept       { return numNewConnections.load(); }
+
+    //==============================================================================
+    /** @internal */
+    void run() override;
+
 private:
+    //==============================================================================
+    friend class CURLEasySession;
+
+    struct Transfer
+    {
+        CURLEasySession* session;
+        juce::String host;
+    };
+
+    struct RemovedTransfer
+    {
+        CURLEasySession* session;
+        CURL* handle;
+    };
+
+    struct IdleHandle
+    {
+        CURL* handle;
+        juce::String key;
+        juce::uint32 releaseTime;
+    };
+
+    CURLM* multiHandle;
+    CURLSH* shareHandle;
+    juce::OwnedArray<juce::CriticalSection> shareLocks;
+
+    juce::CriticalSection poolLock;
+    juce::Array<IdleHandle> idleHandles;
+    std::atomic<int> maxIdleTimeMs;
+    std::atomic<juce::int64> numHandlePoolHits, numHandlePoolMisses, numConnectionsReused, numNewConnections;
+
+    std::atomic<int> maxTransfers, maxTransfersPerHost;
+
+    juce::CriticalSection lock;
+    juce::Array<Transfer> queuedTransfers, activeTransfers;
+    juce::Array<CURLEasySession*> sessionsToRemove, sessionsToResume;
+    juce::Array<RemovedTransfer> removedDuringPerform;
+    juce::Array<IdleHandle> handlesToRelease;
+    CURLEasySession* finishingSession;
+    bool isPerforming;
+    juce::String lastStartedHost;
+    juce::WaitableEvent sessionRemovedEvent;
+
+    //==============================================================================
+    void addSession (CURLEasySession* session);
+    void removeSession (CURLEasySession* session);
+    void resumeSession (CURLEasySession* session);
+    void wakeUp();
+
+    static juce::String getHandleKey (const juce::String& url, const juce::String& userNameAndPassword);
+    void addIdleHandle (CURL* handle, const juce::String& key);
+    void reapIdleHandles();
+    void updateConnectionStatistics (CURL* handle);
+
+    bool isUsingSession (CURLEasySession* session) const;
+    int getNumActiveTransfers (const juce::String& host) const;
+    int findNextQueuedTransfer() const;
+
+    static bool wasRemovedDuringPerform (CURLEasySession* session);
+    void removeSessions();
+    void removeDeferredHandles();
+    void resumePausedTransfers();
+    void cancelStoppedTransfers();
+    void startQueuedTransfers();
+    void finishTransfers();
+    void finishTransfer (CURLEasySession* session, int result);
+
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CURLManager)
 };
@@ -0,0 +1,601 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#if DROWAUDIO_UNIT_TESTS && DROWAUDIO_USE_CURL
+
+//==============================================================================
+/*  A minimal HTTP server on the loopback interface so transfers can be tested
+    without a network connection.
+
+    A GET for /bytes/<n>/<ms> sends n bytes in 1k blocks, pausing for ms
+    milliseconds before each block so slow servers can be simulated. Byte i
+    of the file is always 'a' + i % 26. HEAD requests and a single byte range
+    per request are supported and connections are kept alive between requests.
+*/
+class LocalTestServer : private Thread
+{
+public:
+    LocalTestServer()
+        : Thread ("LocalTestServer")
+    {
+    }
+
+    ~LocalTestServer() override
+    {
+        stop();
+    }
+
+    bool start()
+    {
+        for (int p = 28080; p < 28180; ++p)
+        {
+            if (socket.createListener (p, "127.0.0.1"))
+            {
+                port = p;
+                startThread();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void stop()
+    {
+        signalThreadShouldExit();
+        socket.close();
+        stopThread (5000);
+        connections.clear();
+    }
+
+    String getUrl (const String& path) const
+    {
+        return "http://127.0.0.1:" + String (port) + path;
+    }
+
+    int getNumRequests() const noexcept     { return numRequests.load(); }
+
+private:
+    //==============================================================================
+    class Connection : public Thread
+    {
+    public:
+        Connection (StreamingSocket* clientSocket, std::atomic<int>& requestCounter)
+            : Thread ("LocalTestServer connection"),
+              client (clientSocket),
+              numRequests (requestCounter)
+        {
+            startThread();
+        }
+
+        ~Connection() override
+        {
+            signalThreadShouldExit();
+            client->close();
+            stopThread (5000);
+        }
+
+        void run() override
+        {
+            // connections are kept alive so clients can reuse them
+            while (! threadShouldExit())
+            {
+                const String request (readRequest());
+
+                if (request.isEmpty() || ! respond (request))
+                    return;
+            }
+        }
+
+    private:
+        std::unique_ptr<StreamingSocket> client;
+        std::atomic<int>& numRequests;
+
+        String readRequest()
+        {
+            MemoryBlock request;
+            char buffer[1024];
+
+            while (! threadShouldExit() && ! request.toString().contains ("\r\n\r\n"))
+            {
+                const int ready = client->waitUntilReady (true, 100);
+
+                if (ready < 0)
+                    break;
+
+                if (ready == 0)
+                    continue;
+
+                const int numRead = client->read (buffer, sizeof (buffer), false);
+
+                if (numRead <= 0)
+                    break;
+
+                request.append (buffer, (size_t) numRead);
+            }
+
+            return request.toString();
+        }
+
+        bool respond (const String& request)
+        {
+            const StringArray path (StringArray::fromTokens (request.fromFirstOccurrenceOf (" ", false, false)
+                                                                    .upToFirstOccurrenceOf (" ", false, false),
+                                                             "/", {}));
+
+            ++numRequests;
+
+            if (path[1] != "bytes")
+                return write ("HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+
+            const int fileSize = path[2].getIntValue();
+            const int blockInterval = path[3].getIntValue();
+            int first = 0, last = fileSize - 1;
+            String range;
+
+            for (auto& line : StringArray::fromLines (request))
+                if (line.startsWithIgnoreCase ("Range:"))
+                    range = line.fromFirstOccurrenceOf ("bytes=", false, true).trim();
+
+            if (range.isNotEmpty())
+            {
+                first = range.upToFirstOccurrenceOf ("-", false, false).getIntValue();
+                last = jmin (last, range.fromFirstOccurrenceOf ("-", false, false).getIntValue());
+            }
+
+            const int numBytes = jmax (0, last - first + 1);
+
+            if (! write ((range.isNotEmpty() ? "HTTP/1.1 206 Partial Content\r\nContent-Range: bytes "
+                                                  + String (first) + "-" + String (last) + "/" + String (fileSize) + "\r\n"
+                                             : String ("HTTP/1.1 200 OK\r\n"))
+                         + "Content-Length: " + String (numBytes) + "\r\n\r\n"))
+                return false;
+
+            if (request.startsWith ("HEAD"))
+                return true;
+
+            HeapBlock<char> block (1024);
+
+            for (int sent = 0; sent < numBytes;)
+            {
+                if (blockInterval > 0)
+                    wait (blockInterval);
+
+                if (threadShouldExit())
+                    return false;
+
+                const int numToSend = jmin (1024, numBytes - sent);
+
+                for (int i = 0; i < numToSend; ++i)
+                    block[i] = (char) ('a' + (first + sent + i) % 26);
+
+                if (client->write (block, numToSend) != numToSend)
+                    return false;
+
+                sent += numToSend;
+            }
+
+            return true;
+        }
+
+        bool write (const String& text)
+        {
+            const int numBytes = (int) text.getNumBytesAsUTF8();
+            return client->write (text.toRawUTF8(), numBytes) == numBytes;
+        }
+    };
+
+    StreamingSocket socket;
+    int port = 0;
+    OwnedArray<Connection> connections;
+    std::atomic<int> numRequests { 0 };
+
+    void run() override
+    {
+        while (! threadShouldExit())
+            if (StreamingSocket* client = socket.waitForNextConnection())
+                connections.add (new Connection (client, numRequests));
+    }
+};
+
+//==============================================================================
+class CURLManagerTests  : public UnitTest
+{
+public:
+    CURLManagerTests() : UnitTest ("CURLManager") {}
+
+    struct TransferLog : public CURLEasySession::Listener
+    {
+        void transferAboutToStart (CURLEasySession* session) override
+        {
+            const ScopedLock sl (lock);
+            events.add ("start " + session->getRemotePath().fromLastOccurrenceOf ("#", false, false));
+        }
+
+        void transferEnded (CURLEasySession* session) override
+        {
+            {
+                const ScopedLock sl (lock);
+                events.add ("end " + session->getRemotePath().fromLastOccurrenceOf ("#", false, false));
+            }
+
+            endedEvent.signal();
+        }
+
+        StringArray getEvents() const
+        {
+            const ScopedLock sl (lock);
+            return events;
+        }
+
+        bool hasEnded (const String& name) const
+        {
+            return getEvents().contains ("end " + name);
+        }
+
+        CriticalSection lock;
+        StringArray events;
+        WaitableEvent endedEvent;
+    };
+
+    /*  The fragment isn't sent to the server so it's used to name the transfers. */
+    static CURLEasySession* createDownload (const String& url, const String& name,
+                                            const File& destination, TransferLog& log)
+    {
+        auto* session = new CURLEasySession();
+        session->enableFullDebugging (false);
+        session->setLocalFile (destination);
+        session->setRemotePath (url + "#" + name);
+        session->addListener (&log);
+
+        return session;
+    }
+
+    static bool waitFor (TransferLog& log, const String& name, int timeoutMs)
+    {
+        const uint32 endTime = Time::getMillisecondCounter() + (uint32) timeoutMs;
+
+        while (! log.hasEnded (name))
+        {
+            if (Time::getMillisecondCounter() >= endTime)
+                return false;
+
+            log.endedEvent.wait (20);
+        }
+
+        return true;
+    }
+
+    void runTest() override
+    {
+        LocalTestServer server;
+
+        beginTest ("Local server");
+        expect (server.start());
+
+        TemporaryFile slowFile, fastFile, firstFile, secondFile;
+
+        beginTest ("Slow transfers don't block others");
+        {
+            TransferLog log;
+            std::unique_ptr<CURLEasySession> slow (createDownload (server.getUrl ("/bytes/8192/250"), "slow", slowFile.getFile(), log));
+            std::unique_ptr<CURLEasySession> fast (createDownload (server.getUrl ("/bytes/4096/0"), "fast", fastFile.getFile(), log));
+
+            slow->beginTransfer (false);
+            fast->beginTransfer (false);
+
+            expect (waitFor (log, "fast", 1000));
+            expect (! log.hasEnded ("slow"));
+            expectEquals (fastFile.getFile().getSize(), (int64) 4096);
+
+            beginTest ("Cancellation");
+            const uint32 stopTime = Time::getMillisecondCounter();
+            slow->stopTransfer();
+
+            expect (waitFor (log, "slow", 500));
+            expect (Time::getMillisecondCounter() - stopTime < 500);
+            expect (slow->getLastError().isNotEmpty());
+        }
+
+        beginTest ("Deleting a session from another's progress callback");
+        {
+            struct SessionDeleter : public CURLEasySession::Listener
+            {
+                void transferProgressUpdate (CURLEasySession*) override
+                {
+                    if (sessionToDelete != nullptr && sessionToDelete->getProgress() > 0.0f)
+                    {
+                        sessionToDelete = nullptr;
+                        deleted = true;
+                    }
+                }
+
+                std::unique_ptr<CURLEasySession> sessionToDelete;
+                std::atomic<bool> deleted { false };
+            };
+
+            TransferLog log;
+            SessionDeleter deleter;
+            std::unique_ptr<CURLEasySession> deleting (createDownload (server.getUrl ("/bytes/8192/100"), "deleting", firstFile.getFile(), log));
+            deleter.sessionToDelete.reset (createDownload (server.getUrl ("/bytes/8192/100"), "deleted", secondFile.getFile(), log));
+            deleting->addListener (&deleter);
+
+            deleter.sessionToDelete->beginTransfer (false);
+            deleting->beginTransfer (false);
+
+            expect (waitFor (log, "deleting", 5000));
+            expect (deleter.deleted.load());
+            expect (deleting->getLastError().isEmpty());
+            expectEquals (firstFile.getFile().getSize(), (int64) 8192);
+            expect (! log.hasEnded ("deleted"));
+            expectEquals (CURLManager::getInstance()->getNumActiveTransfers(), 0);
+        }
+
+        beginTest ("Per host limit");
+        {
+            CURLManager* manager = CURLManager::getInstance();
+            const int oldLimit = manager->getMaxConcurrentTransfersPerHost();
+            manager->setMaxConcurrentTransfersPerHost (1);
+
+            TransferLog log;
+            std::unique_ptr<CURLEasySession> first (createDownload (server.getUrl ("/bytes/2048/100"), "first", firstFile.getFile(), log));
+            std::unique_ptr<CURLEasySession> second (createDownload (server.getUrl ("/bytes/2048/100"), "second", secondFile.getFile(), log));
+
+            first->beginTransfer (false);
+            second->beginTransfer (false);
+
+            expect (waitFor (log, "first", 2000));
+            expect (waitFor (log, "second", 2000));
+            expectEquals (log.getEvents().joinIntoString (", "), String ("start first, end first, start second, end second"));
+
+            manager->setMaxConcurrentTransfersPerHost (oldLimit);
+        }
+
+        beginTest ("Handle and connection reuse");
+        {
+            CURLManager* manager = CURLManager::getInstance();
+            TransferLog log;
+
+            {
+                std::unique_ptr<CURLEasySession> session (createDownload (server.getUrl ("/bytes/1024/0"), "first", firstFile.getFile(), log));
+                session->beginTransfer (false, false);
+            }
+
+            const int64 numHits = manager->getNumHandlePoolHits();
+            const int64 numReused = manager->getNumConnectionsReused();
+
+            {
+                std::unique_ptr<CURLEasySession> session (createDownload (server.getUrl ("/bytes/1024/0"), "second", secondFile.getFile(), log));
+                session->beginTransfer (false, false);
+                expect (session->getLastError().isEmpty());
+            }
+
+            expect (manager->getNumHandlePoolHits() > numHits);
+            expect (manager->getNumConnectionsReused() > numReused);
+        }
+    }
+};
+
+static CURLManagerTests curlManagerTests;
+
+//==============================================================================
+class CURLChunkedDownloadTests  : public UnitTest
+{
+public:
+    CURLChunkedDownloadTests() : UnitTest ("CURLChunkedDownload") {}
+
+    struct FinishedListener : public CURLChunkedDownload::Listener
+    {
+        void chunkedDownloadFinished (CURLChunkedDownload*) override    { finished.signal(); }
+
+        WaitableEvent finished;
+    };
+
+    bool hasExpectedContents (const File& file, int expectedSize)
+    {
+        MemoryBlock data;
+
+        if (! file.loadFileAsData (data) || (int) data.getSize() != expectedSize)
+            return false;
+
+        for (int i = 0; i < expectedSize; ++i)
+            if (data[i] != (char) ('a' + i % 26))
+                return false;
+
+        return true;
+    }
+
+    void runTest() override
+    {
+        LocalTestServer server;
+
+        beginTest ("Local server");
+        expect (server.start());
+
+        beginTest ("Chunked download");
+        {
+            TemporaryFile destination;
+            FinishedListener listener;
+
+            CURLChunkedDownload download (server.getUrl ("/bytes/10000/0"), destination.getFile());
+            download.setChunkSize (1024);
+            download.addListener (&listener);
+
+            expect (download.start());
+            expect (listener.finished.wait (5000));
+            expect (download.getResult().wasOk());
+            expectEquals (download.getTotalLength(), (int64) 10000);
+            expect (hasExpectedContents (destination.getFile(), 10000));
+            expect (! download.getPartialFile().exists());
+            expect (! download.getJournalFile().exists());
+        }
+
+        beginTest ("Resuming a download");
+        {
+            TemporaryFile destination;
+            const String url (server.getUrl ("/bytes/8192/100"));
+
+            {
+                FinishedListener listener;
+                CURLChunkedDownload download (url, destination.getFile());
+                download.setChunkSize (1024);
+                download.setMaxConcurrentChunks (1);
+                download.addListener (&listener);
+
+                expect (download.start());
+
+                for (int i = 0; i < 250 && download.getNumBytesDownloaded() < 3072; ++i)
+                    Thread::sleep (20);
+
+                download.stop();
+                expect (listener.finished.wait (5000));
+                expect (download.getResult().failed());
+                expect (download.getJournalFile().existsAsFile());
+
+                // a damaged chunk should be found and downloaded again
+                FileOutputStream out (download.getPartialFile());
+                out.setPosition (0);
+                out.writeByte ('!');
+            }
+
+            const int numRequests = server.getNumRequests();
+            FinishedListener listener;
+            CURLChunkedDownload download (url, destination.getFile());
+            download.setChunkSize (1024);
+            download.addListener (&listener);
+
+            expect (download.start());
+            expect (listener.finished.wait (5000));
+            expect (download.getResult().wasOk());
+            expect (hasExpectedContents (destination.getFile(), 8192));
+
+            // one request for the size, one to probe for ranges and no more than 7 chunks
+            expect (server.getNumRequests() - numRequests <= 9);
+        }
+
+        beginTest ("Corrupt chunks are downloaded again before finishing");
+        {
+            TemporaryFile destination;
+            FinishedListener listener;
+
+            CURLChunkedDownload download (server.getUrl ("/bytes/8192/100"), destination.getFile());
+            download.setChunkSize (1024);
+            download.setMaxConcurrentChunks (1);
+            download.addListener (&listener);
+
+            const int numRequests = server.getNumRequests();
+            expect (download.start());
+
+            for (int i = 0; i < 250 && download.getNumBytesDownloaded() < 3072; ++i)
+                Thread::sleep (20);
+
+            // damage a chunk that has already been written while the rest are downloading
+            {
+                std::unique_ptr<FileOutputStream> out (download.getPartialFile().createOutputStream());
+                expect (out != nullptr);
+                out->setPosition (0);
+                out->writeByte ('!');
+            }
+
+            expect (listener.finished.wait (10000));
+            expect (download.getResult().wasOk());
+            expect (hasExpectedContents (destination.getFile(), 8192));
+
+            // the damaged chunk has to be fetched twice
+            expect (server.getNumRequests() - numRequests >= 11);
+        }
+    }
+};
+
+static CURLChunkedDownloadTests curlChunkedDownloadTests;
+
+//==============================================================================
+class RemoteDirectoryCacheTests  : public UnitTest
+{
+public:
+    RemoteDirectoryCacheTests() : UnitTest ("RemoteDirectoryCache") {}
+
+    void runTest() override
+    {
+        typedef RemoteDirectoryCache::Entry Entry;
+
+        beginTest ("MLSD listings");
+        {
+            const Array<Entry> entries (RemoteDirectoryCache::parseListing ("type=cdir;modify=20130102030405; .\r\n"
+                                                                            "type=dir;modify=20130102030405; Samples\r\n"
+                                                                            "type=file;size=1024;modify=20130102030405.123; my track.wav\r\n"));
+            expectEquals (entries.size(), 2);
+            expect (entries[0].isDirectory);
+            expectEquals (entries[0].filename, String ("Samples"));
+            expect (! entries[1].isDirectory);
+            expectEquals (entries[1].filename, String ("my track.wav"));
+            expectEquals (entries[1].fileSize, (int64) 1024);
+            expect (entries[1].modificationTime == Time (2013, 0, 2, 3, 4, 5, 0, false));
+        }
+
+        beginTest ("Unix listings");
+        {
+            const Array<Entry> entries (RemoteDirectoryCache::parseListing ("total 8\n"
+                                                                            "drwxr-xr-x  2 owner group  4096 Jan  2  2013 Samples\n"
+                                                                            "-rw-r--r--  1 owner  2048 Mar 15  2012 no group.aif\n"
+                                                                            "lrwxrwxrwx  1 owner group    12 Feb  3  2011 link -> target\n"));
+            expectEquals (entries.size(), 3);
+            expect (entries[0].isDirectory);
+            expectEquals (entries[0].filename, String ("Samples"));
+            expect (entries[0].modificationTime == Time (2013, 0, 2, 0, 0));
+            expectEquals (entries[1].filename, String ("no group.aif"));
+            expectEquals (entries[1].fileSize, (int64) 2048);
+            expectEquals (entries[2].filename, String ("link"));
+        }
+
+        beginTest ("DOS listings");
+        {
+            const Array<Entry> entries (RemoteDirectoryCache::parseListing ("01-02-13  03:04PM       <DIR>          Samples\r\n"
+                                                                            "12-31-2012  11:59AM             4096 song.mp3\r\n"));
+            expectEquals (entries.size(), 2);
+            expect (entries[0].isDirectory);
+            expect (entries[0].modificationTime == Time (2013, 0, 2, 15, 4));
+            expectEquals (entries[1].filename, String ("song.mp3"));
+            expectEquals (entries[1].fileSize, (int64) 4096);
+        }
+
+        beginTest ("Parent URLs");
+        {
+            expectEquals (RemoteDirectoryCache::getParentUrl ("ftp://host/a/b/"), String ("ftp://host/a/"));
+            expectEquals (RemoteDirectoryCache::getParentUrl ("ftp://host/a/"), String ("ftp://host/"));
+            expectEquals (RemoteDirectoryCache::getParentUrl ("ftp://host/"), String());
+        }
+    }
+};
+
+static RemoteDirectoryCacheTests remoteDirectoryCacheTests;
+
+#endif
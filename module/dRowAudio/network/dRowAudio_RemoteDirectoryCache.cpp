@@ -0,0 +1,570 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#if DROWAUDIO_USE_CURL
+
+namespace RemoteDirectoryCacheHelpers
+{
+    typedef RemoteDirectoryCache::Entry Entry;
+
+    /** Splits a line at spaces, keeping where each token started. */
+    static void tokenise (const String& line, StringArray& tokens, Array<int>& starts)
+    {
+        const int length = line.length();
+
+        for (int i = 0; i < length;)
+        {
+            while (i < length && CharacterFunctions::isWhitespace (line[i]))
+                ++i;
+
+            const int start = i;
+
+            while (i < length && ! CharacterFunctions::isWhitespace (line[i]))
+                ++i;
+
+            if (i > start)
+            {
+                tokens.add (line.substring (start, i));
+                starts.add (start);
+            }
+        }
+    }
+
+    static int getMonthIndex (const String& name)
+    {
+        static const char* const months[] = { "jan", "feb", "mar", "apr", "may", "jun",
+                                              "jul", "aug", "sep", "oct", "nov", "dec" };
+
+        for (int i = 0; i < 12; ++i)
+            if (name.equalsIgnoreCase (months[i]))
+                return i;
+
+        return -1;
+    }
+
+    /** MLSD times are UTC in the form YYYYMMDDHHMMSS with optional fractions. */
+    static Time parseMLSDTime (const String& value)
+    {
+        if (value.length() < 14 || ! value.substring (0, 14).containsOnly ("0123456789"))
+            return Time();
+
+        return Time (value.substring (0, 4).getIntValue(),
+                     value.substring (4, 6).getIntValue() - 1,
+                     value.substring (6, 8).getIntValue(),
+                     value.substring (8, 10).getIntValue(),
+                     value.substring (10, 12).getIntValue(),
+                     value.substring (12, 14).getIntValue(),
+                     0, false);
+    }
+
+    /** e.g. "type=file;size=1024;modify=20130102030405; name" */
+    static bool parseMLSDLine (const String& line, Entry& entry)
+    {
+        // facts can't contain spaces so the name is everything after the first one
+        const int nameStart = line.indexOfChar (' ');
+
+        if (nameStart <= 0 || ! line.substring (0, nameStart).containsChar ('='))
+            return false;
+
+        String type;
+
+        for (auto& fact : StringArray::fromTokens (line.substring (0, nameStart), ";", String()))
+        {
+            const String name (fact.upToFirstOccurrenceOf ("=", false, false).toLowerCase());
+            const String value (fact.fromFirstOccurrenceOf ("=", false, false));
+
+            if (name == "type")
+                type = value.toLowerCase();
+            else if (name == "size" || name == "sizd")
+                entry.fileSize = value.getLargeIntValue();
+            else if (name == "modify")
+                entry.modificationTime = parseMLSDTime (value);
+        }
+
+        // these are the directory itself and its parent
+        if (type == "cdir" || type == "pdir")
+            return false;
+
+        entry.filename = line.substring (nameStart + 1);
+        entry.isDirectory = type == "dir";
+
+        return entry.filename.isNotEmpty();
+    }
+
+    /** e.g. "drwxr-xr-x 2 owner group 4096 Jan 2 03:04 name" */
+    static bool parseUnixLine (const String& line, Entry& entry)
+    {
+        StringArray tokens;
+        Array<int> starts;
+        tokenise (line, tokens, starts);
+
+        if (tokens.size() < 7 || ! String ("-dlbcps").containsChar (tokens[0][0]))
+            return false;
+
+        // some servers leave out the owner or group so the date is found from the month
+        int monthIndex = -1;
+
+        for (int i = 2; i + 3 < tokens.size() && monthIndex < 0; ++i)
+            if (getMonthIndex (tokens[i]) >= 0 && tokens[i + 1].containsOnly ("0123456789"))
+                monthIndex = i;
+
+        if (monthIndex < 0)
+            return false;
+
+        const int month = getMonthIndex (tokens[monthIndex]);
+        const int day = tokens[monthIndex + 1].getIntValue();
+        const String& timeOrYear = tokens[monthIndex + 2];
+
+        if (timeOrYear.containsChar (':'))
+        {
+            // recent files show the time instead of the year
+            const Time now (Time::getCurrentTime());
+            Time time (now.getYear(), month, day,
+                       timeOrYear.upToFirstOccurrenceOf (":", false, false).getIntValue(),
+                       timeOrYear.fromFirstOccurrenceOf (":", false, false).getIntValue());
+
+            if (time > now + RelativeTime::days (1))
+                time = Time (now.getYear() - 1, month, day, time.getHours(), time.getMinutes());
+
+            entry.modificationTime = time;
+        }
+        else
+        {
+            entry.modificationTime = Time (timeOrYear.getIntValue(), month, day, 0, 0);
+        }
+
+        entry.fileSize = tokens[monthIndex - 1].getLargeIntValue();
+        entry.isDirectory = tokens[0][0] == 'd';
+        entry.filename = line.substring (starts[monthIndex + 3]);
+
+        if (tokens[0][0] == 'l')
+            entry.filename = entry.filename.upToFirstOccurrenceOf (" -> ", false, false);
+
+        return entry.filename.isNotEmpty() && entry.filename != "." && entry.filename != "..";
+    }
+
+    /** e.g. "01-02-13  03:04PM       <DIR>          name" */
+    static bool parseDOSLine (const String& line, Entry& entry)
+    {
+        StringArray tokens;
+        Array<int> starts;
+        tokenise (line, tokens, starts);
+
+        if (tokens.size() < 4
+            || ! tokens[0].containsOnly ("0123456789-")
+            || ! tokens[1].containsChar (':'))
+            return false;
+
+        const StringArray date (StringArray::fromTokens (tokens[0], "-", String()));
+
+        if (date.size() != 3)
+            return false;
+
+        int year = date[2].getIntValue();
+
+        if (date[2].length() <= 2)
+            year += year < 70 ? 2000 : 1900;
+
+        const String& time = tokens[1];
+        int hours = time.upToFirstOccurrenceOf (":", false, false).getIntValue() % 12;
+
+        if (time.endsWithIgnoreCase ("PM"))
+            hours += 12;
+
+        entry.modificationTime = Time (year, date[0].getIntValue() - 1, date[1].getIntValue(), hours,
+                                       time.fromFirstOccurrenceOf (":", false, false).getIntValue());
+        entry.isDirectory = tokens[2].equalsIgnoreCase ("<DIR>");
+        entry.fileSize = entry.isDirectory ? -1 : tokens[2].getLargeIntValue();
+        entry.filename = line.substring (starts[3]);
+
+        return entry.filename != "." && entry.filename != "..";
+    }
+}
+
+//==============================================================================
+class RemoteDirectoryCache::FetchJob : public ThreadPoolJob
+{
+public:
+    FetchJob (RemoteDirectoryCache& owner_, Listing* listing_)
+        : ThreadPoolJob ("RemoteDirectoryCache fetch"),
+          owner (owner_),
+          listing (listing_)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        if (shouldExit() || listing->cancelled.load())
+            return jobHasFinished;
+
+        const String& credentials (listing->userNameAndPassword);
+
+        CURLEasySession session;
+        session.enableFullDebugging (false);
+        session.setRemotePath (listing->getDirectoryUrl());
+
+        if (credentials.isNotEmpty())
+            session.setUserNameAndPassword (credentials.upToFirstOccurrenceOf (":", false, false),
+                                            credentials.fromFirstOccurrenceOf (":", false, false));
+
+        const String text (session.getDetailedDirectoryListing());
+        const String error (session.getLastError());
+
+        {
+            const ScopedLock sl (listing->lock);
+
+            if (error.isEmpty())
+                listing->entries = parseListing (text);
+            else
+                listing->result = Result::fail (error);
+
+            listing->fetchTime = Time::getMillisecondCounter();
+        }
+
+        listing->complete = true;
+        owner.listingFetched (listing.get());
+
+        return jobHasFinished;
+    }
+
+private:
+    RemoteDirectoryCache& owner;
+    const Listing::Ptr listing;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FetchJob)
+};
+
+//==============================================================================
+bool RemoteDirectoryCache::Entry::operator== (const Entry& other) const noexcept
+{
+    return filename == other.filename
+        && fileSize == other.fileSize
+        && modificationTime == other.modificationTime
+        && isDirectory == other.isDirectory;
+}
+
+//==============================================================================
+RemoteDirectoryCache::Listing::Listing (const String& directoryUrl_, const String& userNameAndPassword_)
+    : directoryUrl (directoryUrl_),
+      userNameAndPassword (userNameAndPassword_),
+      result (Result::ok()),
+      complete (false),
+      cancelled (false),
+      fetchTime (Time::getMillisecondCounter()),
+      wasRequested (false),
+      isBeingRevalidated (false)
+{
+}
+
+Result RemoteDirectoryCache::Listing::getResult() const
+{
+    const ScopedLock sl (lock);
+    return result;
+}
+
+Array<RemoteDirectoryCache::Entry> RemoteDirectoryCache::Listing::getEntries() const
+{
+    const ScopedLock sl (lock);
+    return entries;
+}
+
+//==============================================================================
+juce_ImplementSingleton (RemoteDirectoryCache)
+
+RemoteDirectoryCache::RemoteDirectoryCache()
+    : pool (3),
+      timeToLiveMs (30000),
+      numSubdirectoriesToPrefetch (4),
+      maxNumCachedDirectories (128)
+{
+}
+
+RemoteDirectoryCache::~RemoteDirectoryCache()
+{
+    for (auto& listing : cache)
+        listing->cancelled = true;
+
+    pool.removeAllJobs (true, 10000);
+    cancelPendingUpdate();
+
+    clearSingletonInstance();
+}
+
+//==============================================================================
+RemoteDirectoryCache::Listing::Ptr RemoteDirectoryCache::getListing (const String& url, const String& userNameAndPassword)
+{
+    const String directoryUrl (url.endsWithChar ('/') ? url : url + "/");
+    Listing::Ptr listing (findListing (directoryUrl, userNameAndPassword));
+
+    if (listing == nullptr)
+    {
+        listing = startFetch (directoryUrl, userNameAndPassword);
+        listing->wasRequested = true;
+        return listing;
+    }
+
+    // keep the most recently used directories at the end
+    cache.removeFirstMatchingValue (listing);
+    cache.add (listing);
+
+    if (! listing->wasRequested)
+    {
+        listing->wasRequested = true;
+
+        if (listing->isComplete())
+            prefetchAround (listing);
+    }
+
+    // the old listing is used until the new one arrives so the directory can be shown straight away
+    if (listing->isComplete() && ! listing->isBeingRevalidated
+        && Time::getMillisecondCounter() - listing->fetchTime > (uint32) timeToLiveMs)
+    {
+        Listing::Ptr newListing (new Listing (directoryUrl, userNameAndPassword));
+        newListing->replacing = listing;
+        newListing->wasRequested = true;
+        listing->isBeingRevalidated = true;
+
+        pool.addJob (new FetchJob (*this, newListing.get()), true);
+    }
+
+    return listing;
+}
+
+void RemoteDirectoryCache::prefetch (const String& url, const String& userNameAndPassword)
+{
+    const String directoryUrl (url.endsWithChar ('/') ? url : url + "/");
+
+    if (findListing (directoryUrl, userNameAndPassword) != nullptr)
+        return;
+
+    for (auto& pending : prefetchQueue)
+        if (pending.directoryUrl == directoryUrl && pending.userNameAndPassword == userNameAndPassword)
+            return;
+
+    // the most recent guesses are the most useful
+    if (prefetchQueue.size() >= 32)
+        prefetchQueue.remove (0);
+
+    prefetchQueue.add ({ directoryUrl, userNameAndPassword });
+    startNextPrefetch();
+}
+
+void RemoteDirectoryCache::refresh (const String& url, const String& userNameAndPassword)
+{
+    const String directoryUrl (url.endsWithChar ('/') ? url : url + "/");
+
+    if (Listing::Ptr listing = findListing (directoryUrl, userNameAndPassword))
+        removeFromCache (listing);
+
+    startFetch (directoryUrl, userNameAndPassword)->wasRequested = true;
+}
+
+void RemoteDirectoryCache::setTimeToLive (RelativeTime newTimeToLive)
+{
+    timeToLiveMs = jmax (0, (int) newTimeToLive.inMilliseconds());
+}
+
+void RemoteDirectoryCache::setNumSubdirectoriesToPrefetch (int newNumSubdirectories)
+{
+    numSubdirectoriesToPrefetch = jmax (0, newNumSubdirectories);
+}
+
+void RemoteDirectoryCache::setMaxNumCachedDirectories (int newMaximum)
+{
+    maxNumCachedDirectories = jmax (1, newMaximum);
+}
+
+//==============================================================================
+String RemoteDirectoryCache::getParentUrl (const String& directoryUrl)
+{
+    const String path (directoryUrl.trimCharactersAtEnd ("/"));
+    const int pathStart = path.indexOf ("://") + 3;
+
+    if (pathStart < 3 || path.indexOfChar (pathStart, '/') < 0)
+        return String();
+
+    return path.upToLastOccurrenceOf ("/", true, false);
+}
+
+Array<RemoteDirectoryCache::Entry> RemoteDirectoryCache::parseListing (const String& listing)
+{
+    using namespace RemoteDirectoryCacheHelpers;
+
+    Array<Entry> entries;
+
+    for (auto& line : StringArray::fromLines (listing))
+    {
+        const String trimmedLine (line.trimCharactersAtEnd ("\r"));
+        Entry entry;
+
+        if (parseMLSDLine (trimmedLine, entry)
+            || parseUnixLine (trimmedLine, entry)
+            || parseDOSLine (trimmedLine, entry))
+            entries.add (entry);
+    }
+
+    return entries;
+}
+
+//==============================================================================
+RemoteDirectoryCache::Listing::Ptr RemoteDirectoryCache::findListing (const String& directoryUrl,
+                                                                      const String& userNameAndPassword) const
+{
+    for (auto& listing : cache)
+        if (listing->getDirectoryUrl() == directoryUrl && listing->userNameAndPassword == userNameAndPassword)
+            return listing;
+
+    return nullptr;
+}
+
+RemoteDirectoryCache::Listing::Ptr RemoteDirectoryCache::startFetch (const String& directoryUrl,
+                                                                     const String& userNameAndPassword)
+{
+    Listing::Ptr listing (new Listing (directoryUrl, userNameAndPassword));
+    cache.add (listing);
+
+    // only throw away listings nothing else is using
+    for (int i = 0; i < cache.size() && cache.size() > maxNumCachedDirectories;)
+    {
+        if (cache.getUnchecked (i)->getReferenceCount() == 1)
+            cache.remove (i);
+        else
+            ++i;
+    }
+
+    pool.addJob (new FetchJob (*this, listing.get()), true);
+
+    return listing;
+}
+
+void RemoteDirectoryCache::startNextPrefetch()
+{
+    // prefetches are done one at a time so they don't hold up directories that are being shown
+    while (currentPrefetch == nullptr && ! prefetchQueue.isEmpty())
+    {
+        const PendingPrefetch next (prefetchQueue.removeAndReturn (prefetchQueue.size() - 1));
+
+        if (findListing (next.directoryUrl, next.userNameAndPassword) == nullptr)
+            currentPrefetch = startFetch (next.directoryUrl, next.userNameAndPassword);
+    }
+}
+
+void RemoteDirectoryCache::prefetchAround (const Listing::Ptr& listing)
+{
+    const String parentUrl (getParentUrl (listing->getDirectoryUrl()));
+    int numSubdirectories = 0;
+
+    // queued in reverse as the most recently added are fetched first
+    const Array<Entry> entries (listing->getEntries());
+    StringArray urls;
+
+    for (auto& entry : entries)
+    {
+        if (numSubdirectories >= numSubdirectoriesToPrefetch)
+            break;
+
+        if (entry.isDirectory)
+        {
+            urls.add (listing->getDirectoryUrl() + entry.filename + "/");
+            ++numSubdirectories;
+        }
+    }
+
+    if (parentUrl.isNotEmpty())
+        urls.add (parentUrl);
+
+    for (int i = urls.size(); --i >= 0;)
+        prefetch (urls[i], listing->userNameAndPassword);
+}
+
+void RemoteDirectoryCache::removeFromCache (const Listing::Ptr& listing)
+{
+    listing->cancelled = true;
+    cache.removeFirstMatchingValue (listing);
+}
+
+void RemoteDirectoryCache::listingFetched (Listing* listing)
+{
+    {
+        const ScopedLock sl (fetchedLock);
+        fetchedListings.add (listing);
+    }
+
+    triggerAsyncUpdate();
+}
+
+void RemoteDirectoryCache::handleAsyncUpdate()
+{
+    Array<Listing::Ptr> fetched;
+
+    {
+        const ScopedLock sl (fetchedLock);
+        fetched.swapWith (fetchedListings);
+    }
+
+    for (auto& listing : fetched)
+    {
+        if (listing == currentPrefetch)
+            currentPrefetch = nullptr;
+
+        if (Listing::Ptr previous = listing->replacing)
+        {
+            listing->replacing = nullptr;
+            previous->isBeingRevalidated = false;
+
+            // keep showing the old listing if the server couldn't be reached
+            if (! cache.contains (previous) || listing->getResult().failed())
+                continue;
+
+            if (listing->getEntries() == previous->getEntries())
+            {
+                previous->fetchTime = listing->fetchTime;
+                continue;
+            }
+
+            previous->cancelled = true;
+            cache.set (cache.indexOf (previous), listing);
+        }
+        else if (listing->cancelled.load())
+        {
+            continue;
+        }
+
+        listeners.call ([&listing] (Listener& l) { l.remoteListingChanged (listing); });
+
+        if (listing->wasRequested)
+            prefetchAround (listing);
+    }
+
+    startNextPrefetch();
+}
+
+#endif //DROWAUDIO_USE_CURL
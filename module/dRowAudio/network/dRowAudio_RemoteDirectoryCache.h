@@ -0,0 +1,210 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef DROWAUDIO_REMOTEDIRECTORYCACHE_H
+#define DROWAUDIO_REMOTEDIRECTORYCACHE_H
+
+#if DROWAUDIO_USE_CURL || DOXYGEN
+
+//==============================================================================
+/** Fetches the listings of remote directories in the background and caches them.
+
+    Listings include the size, modification time and type of each entry, parsed
+    from an FTP MLSD response if the server supports it or a LIST one otherwise.
+    Once a directory has been shown its parent and first few subdirectories are
+    prefetched one at a time, so moving around a remote tree is usually instant.
+
+    A cached listing older than the time to live is still returned straight away
+    but is fetched again in the background. If it has changed, listeners are told
+    about the new listing, see setTimeToLive().
+
+    @see CURLEasySession
+*/
+class RemoteDirectoryCache : public juce::DeletedAtShutdown,
+                             private juce::AsyncUpdater
+{
+public:
+    //==============================================================================
+    juce_DeclareSingleton (RemoteDirectoryCache, false)
+
+    /** Creates a RemoteDirectoryCache.
+        You'll normally want to use the singleton instance.
+    */
+    RemoteDirectoryCache();
+
+    /** Destructor. */
+    ~RemoteDirectoryCache() override;
+
+    //==============================================================================
+    /** The details of an entry in a listing.
+        The size is -1 and the time is null if the server didn't give them.
+    */
+    struct Entry
+    {
+        juce::String filename;
+        juce::int64 fileSize = -1;
+        juce::Time modificationTime;
+        bool isDirectory = false;
+
+        bool operator== (const Entry& other) const noexcept;
+        bool operator!= (const Entry& other) const noexcept    { return ! operator== (other); }
+    };
+
+    //==============================================================================
+    /** The listing of a remote directory. */
+    class Listing : public juce::ReferenceCountedObject
+    {
+    public:
+        using Ptr = juce::ReferenceCountedObjectPtr<Listing>;
+
+        /** Returns the URL of the directory, which always ends with a '/'. */
+        const juce::String& getDirectoryUrl() const noexcept    { return directoryUrl; }
+
+        /** Returns true once the listing has been fetched. */
+        bool isComplete() const noexcept                        { return complete.load(); }
+
+        /** Returns an error if the listing couldn't be fetched. */
+        juce::Result getResult() const;
+
+        /** Returns the entries, which will be empty until the listing is complete. */
+        juce::Array<Entry> getEntries() const;
+
+    private:
+        friend class RemoteDirectoryCache;
+
+        Listing (const juce::String& directoryUrl, const juce::String& userNameAndPassword);
+
+        const juce::String directoryUrl, userNameAndPassword;
+
+        juce::CriticalSection lock;
+        juce::Array<Entry> entries;
+        juce::Result result;
+
+        std::atomic<bool> complete, cancelled;
+        juce::uint32 fetchTime;
+        bool wasRequested, isBeingRevalidated;
+        Ptr replacing;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Listing)
+    };
+
+    //==============================================================================
+    /** Returns the listing of a remote directory.
+
+        If it hasn't been fetched yet this starts fetching it and returns the empty
+        listing, listeners will be told when it's complete. The credentials are
+        in the same "username:password" form used by CURLEasySession.
+    */
+    Listing::Ptr getListing (const juce::String& directoryUrl,
+                             const juce::String& userNameAndPassword = juce::String());
+
+    /** Queues a directory that's likely to be shown soon to be fetched. */
+    void prefetch (const juce::String& directoryUrl,
+                   const juce::String& userNameAndPassword = juce::String());
+
+    /** Throws away the cached listing of a directory and fetches it again. */
+    void refresh (const juce::String& directoryUrl,
+                  const juce::String& userNameAndPassword = juce::String());
+
+    /** Sets how long a listing is used for before it's fetched again, the default is 30 seconds. */
+    void setTimeToLive (juce::RelativeTime newTimeToLive);
+
+    /** Sets how many subdirectories of a directory that has been shown are prefetched, the default is 4. */
+    void setNumSubdirectoriesToPrefetch (int newNumSubdirectories);
+
+    /** Sets the maximum number of listings to keep. */
+    void setMaxNumCachedDirectories (int newMaximum);
+
+    //==============================================================================
+    /** Returns the URL of the directory containing another, or an empty string at the root. */
+    static juce::String getParentUrl (const juce::String& directoryUrl);
+
+    /** Parses the response to an MLSD or LIST command.
+        This understands MLSD, Unix style and DOS style listings.
+    */
+    static juce::Array<Entry> parseListing (const juce::String& listing);
+
+    //==============================================================================
+    /** Receives callbacks on the message thread as listings are fetched. */
+    class Listener
+    {
+    public:
+        /** Destructor. */
+        virtual ~Listener() = default;
+
+        /** Called when a listing has been fetched or has changed since it was last
+            fetched, in which case it will be a new object.
+        */
+        virtual void remoteListingChanged (const Listing::Ptr& listing) = 0;
+    };
+
+    /** Adds a listener. */
+    void addListener (Listener* listener)                   { listeners.add (listener); }
+
+    /** Removes a previously added listener. */
+    void removeListener (Listener* listener)                { listeners.remove (listener); }
+
+private:
+    //==============================================================================
+    class FetchJob;
+
+    struct PendingPrefetch
+    {
+        juce::String directoryUrl, userNameAndPassword;
+    };
+
+    juce::ThreadPool pool;
+    juce::Array<Listing::Ptr> cache;
+    juce::Array<PendingPrefetch> prefetchQueue;
+    Listing::Ptr currentPrefetch;
+    int timeToLiveMs, numSubdirectoriesToPrefetch, maxNumCachedDirectories;
+
+    juce::CriticalSection fetchedLock;
+    juce::Array<Listing::Ptr> fetchedListings;
+    juce::ListenerList<Listener> listeners;
+
+    //==============================================================================
+    Listing::Ptr findListing (const juce::String& directoryUrl, const juce::String& userNameAndPassword) const;
+    Listing::Ptr startFetch (const juce::String& directoryUrl, const juce::String& userNameAndPassword);
+    void startNextPrefetch();
+    void prefetchAround (const Listing::Ptr& listing);
+    void removeFromCache (const Listing::Ptr& listing);
+    void listingFetched (Listing* listing);
+
+    /** @internal */
+    void handleAsyncUpdate() override;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RemoteDirectoryCache)
+};
+
+#endif //DROWAUDIO_USE_CURL || DOXYGEN
+#endif //DROWAUDIO_REMOTEDIRECTORYCACHE_H
@@ -0,0 +1,353 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+AutomationLane::AutomationLane()
+    : interpolationType (linearInterpolation)
+{
+}
+
+AutomationLane::~AutomationLane()
+{
+}
+
+//==============================================================================
+void AutomationLane::addBreakpoint (int64 time, double value)
+{
+    const ScopedLock sl (lock);
+    const int index = findFirstAfter (time);
+
+    if (index > 0 && breakpoints.getReference (index - 1).time == time)
+        breakpoints.getReference (index - 1).value = value;
+    else
+        breakpoints.insert (index, { time, value });
+}
+
+void AutomationLane::removeBreakpoints (int64 startTime, int64 endTime)
+{
+    if (endTime <= startTime)
+        return;
+
+    const ScopedLock sl (lock);
+    const int startIndex = findFirstAfter (startTime - 1);
+    const int endIndex = findFirstAfter (endTime - 1);
+
+    breakpoints.removeRange (startIndex, endIndex - startIndex);
+}
+
+void AutomationLane::clear()
+{
+    const ScopedLock sl (lock);
+    breakpoints.clearQuick();
+}
+
+void AutomationLane::ensureStorageAllocated (int minNumBreakpoints)
+{
+    const ScopedLock sl (lock);
+    breakpoints.ensureStorageAllocated (minNumBreakpoints);
+}
+
+int AutomationLane::getNumBreakpoints() const
+{
+    const ScopedLock sl (lock);
+    return breakpoints.size();
+}
+
+AutomationLane::Breakpoint AutomationLane::getBreakpoint (int index) const
+{
+    const ScopedLock sl (lock);
+
+    if (isPositiveAndBelow (index, breakpoints.size()))
+        return breakpoints.getUnchecked (index);
+
+    return {};
+}
+
+int AutomationLane::getIndexOfFirstBreakpointAfter (int64 time) const
+{
+    const ScopedLock sl (lock);
+    return findFirstAfter (time);
+}
+
+//==============================================================================
+void AutomationLane::setInterpolationType (InterpolationType newType)
+{
+    const ScopedLock sl (lock);
+    interpolationType = newType;
+}
+
+//==============================================================================
+double AutomationLane::getValueAt (int64 time, double defaultValue) const
+{
+    const ScopedLock sl (lock);
+
+    if (breakpoints.isEmpty())
+        return defaultValue;
+
+    return interpolate (findFirstAfter (time), time);
+}
+
+bool AutomationLane::fillBlock (int64 startTime, float* destination, int numSamples) const noexcept
+{
+    jassert (destination != nullptr);
+
+    const ScopedTryLock sl (lock);
+
+    if (! sl.isLocked() || breakpoints.isEmpty())
+        return false;
+
+    const Breakpoint* const points = breakpoints.begin();
+    const int numPoints = breakpoints.size();
+    int index = findFirstAfter (startTime);
+    int i = 0;
+
+    // each pass fills up to the next breakpoint, or the end of the block
+    while (i < numSamples)
+    {
+        const int64 time = startTime + i;
+
+        if (index >= numPoints)
+        {
+            FloatVectorOperations::fill (destination + i, (float) points[numPoints - 1].value, numSamples - i);
+            break;
+        }
+
+        const int numInSegment = (int) jmin ((int64) (numSamples - i), points[index].time - time);
+
+        if (index == 0 || interpolationType == stepInterpolation)
+        {
+            FloatVectorOperations::fill (destination + i, (float) points[jmax (0, index - 1)].value, numInSegment);
+        }
+        else
+        {
+            const Breakpoint& start = points[index - 1];
+            const Breakpoint& end = points[index];
+            const double slope = (end.value - start.value) / (double) (end.time - start.time);
+            const double offset = start.value + slope * (double) (time - start.time);
+            float* const segment = destination + i;
+
+            for (int j = 0; j < numInSegment; ++j)
+                segment[j] = (float) (offset + slope * j);
+        }
+
+        i += numInSegment;
+        ++index;
+    }
+
+    return true;
+}
+
+bool AutomationLane::getValueForBlock (int64 startTime, int numSamples, double& value) const noexcept
+{
+    const ScopedTryLock sl (lock);
+
+    if (! sl.isLocked() || breakpoints.isEmpty())
+        return false;
+
+    const int64 lastSampleTime = startTime + jmax (0, numSamples - 1);
+    value = interpolate (findFirstAfter (lastSampleTime), lastSampleTime);
+
+    return true;
+}
+
+//==============================================================================
+void AutomationLane::writeXml (XmlElement& xmlState, const String& laneName) const
+{
+    const ScopedLock sl (lock);
+
+    MemoryOutputStream data;
+
+    for (auto& point : breakpoints)
+    {
+        data.writeInt64 (point.time);
+        data.writeDouble (point.value);
+    }
+
+    XmlElement* laneXml = xmlState.createNewChildElement ("AUTOMATION");
+    laneXml->setAttribute ("name", laneName);
+    laneXml->setAttribute ("interpolation", (int) interpolationType);
+    laneXml->setAttribute ("data", data.getMemoryBlock().toBase64Encoding());
+}
+
+void AutomationLane::readXml (const XmlElement* xmlState, const String& laneName)
+{
+    if (xmlState == nullptr)
+        return;
+
+    for (auto* laneXml = xmlState->getChildByName ("AUTOMATION"); laneXml != nullptr;
+         laneXml = laneXml->getNextElementWithTagName ("AUTOMATION"))
+    {
+        if (laneXml->getStringAttribute ("name") != laneName)
+            continue;
+
+        MemoryBlock data;
+        data.fromBase64Encoding (laneXml->getStringAttribute ("data"));
+
+        Array<Breakpoint> newBreakpoints;
+        MemoryInputStream input (data, false);
+
+        while (input.getNumBytesRemaining() >= (int64) (sizeof (int64) + sizeof (double)))
+        {
+            const int64 time = input.readInt64();
+            const double value = input.readDouble();
+
+            // guard against hand-edited data being out of order
+            if (newBreakpoints.isEmpty() || newBreakpoints.getLast().time < time)
+                newBreakpoints.add ({ time, value });
+        }
+
+        const ScopedLock sl (lock);
+        interpolationType = laneXml->getIntAttribute ("interpolation") == stepInterpolation ? stepInterpolation
+                                                                                           : linearInterpolation;
+        breakpoints.swapWith (newBreakpoints);
+
+        break;
+    }
+}
+
+//==============================================================================
+int AutomationLane::findFirstAfter (int64 time) const noexcept
+{
+    const Breakpoint* const first = breakpoints.begin();
+    const Breakpoint* const last = breakpoints.end();
+
+    return (int) (std::upper_bound (first, last, time,
+                                    [] (int64 t, const Breakpoint& point) { return t < point.time; }) - first);
+}
+
+double AutomationLane::interpolate (int indexAfter, int64 time) const noexcept
+{
+    const int numPoints = breakpoints.size();
+
+    if (indexAfter <= 0)
+        return breakpoints.getReference (0).value;
+
+    const Breakpoint& start = breakpoints.getReference (indexAfter - 1);
+
+    if (indexAfter >= numPoints || interpolationType == stepInterpolation)
+        return start.value;
+
+    const Breakpoint& end = breakpoints.getReference (indexAfter);
+    const double proportion = (double) (time - start.time) / (double) (end.time - start.time);
+
+    return start.value + (end.value - start.value) * proportion;
+}
+
+//==============================================================================
+#if DROWAUDIO_UNIT_TESTS
+
+class AutomationLaneTests  : public UnitTest
+{
+public:
+    AutomationLaneTests() : UnitTest ("AutomationLane") {}
+
+    void runTest() override
+    {
+        beginTest ("Breakpoints");
+        {
+            AutomationLane lane;
+            expectEquals (lane.getValueAt (100, 0.5), 0.5);
+
+            lane.addBreakpoint (200, 1.0);
+            lane.addBreakpoint (100, 0.0);
+            lane.addBreakpoint (300, 0.0);
+            lane.addBreakpoint (200, 0.8);
+
+            expectEquals (lane.getNumBreakpoints(), 3);
+            expectEquals (lane.getIndexOfFirstBreakpointAfter (99), 0);
+            expectEquals (lane.getIndexOfFirstBreakpointAfter (100), 1);
+            expectEquals (lane.getIndexOfFirstBreakpointAfter (300), 3);
+
+            expectEquals (lane.getValueAt (0), 0.0);
+            expectWithinAbsoluteError (lane.getValueAt (150), 0.4, 0.000001);
+            expectEquals (lane.getValueAt (200), 0.8);
+            expectEquals (lane.getValueAt (1000), 0.0);
+
+            lane.setInterpolationType (AutomationLane::stepInterpolation);
+            expectEquals (lane.getValueAt (299), 0.8);
+
+            lane.removeBreakpoints (150, 300);
+            expectEquals (lane.getNumBreakpoints(), 2);
+        }
+
+        beginTest ("Sample-accurate playback");
+        {
+            AutomationLane lane;
+            lane.addBreakpoint (10, 0.0);
+            lane.addBreakpoint (20, 1.0);
+            lane.addBreakpoint (25, 0.5);
+
+            HeapBlock<float> block (40);
+            expect (lane.fillBlock (0, block, 40));
+
+            for (int i = 0; i < 40; ++i)
+                expectWithinAbsoluteError (block[i], (float) lane.getValueAt (i), 0.00001f);
+
+            double value = 0.0;
+            expect (lane.getValueForBlock (0, 16, value));
+            expectWithinAbsoluteError (value, 0.5, 0.000001);
+        }
+
+        beginTest ("Recording");
+        {
+            PluginParameter parameter;
+            ParameterAutomation automation (parameter);
+            AutomationLane& lane = automation.getLane();
+
+            lane.addBreakpoint (50, 0.3);
+            automation.recordValue (0, 0.1);
+            automation.recordValue (100, 0.2);
+            expectEquals (lane.getNumBreakpoints(), 2);
+
+            automation.setMode (ParameterAutomation::readMode);
+            automation.processBlock (0, 64);
+            expectWithinAbsoluteError (parameter.getValue(), 0.1 + 0.1 * 63.0 / 100.0, 0.000001);
+        }
+
+        beginTest ("XML");
+        {
+            AutomationLane lane, restored;
+            lane.addBreakpoint (1, 0.25);
+            lane.addBreakpoint (1000000000000, 0.75);
+
+            XmlElement xml ("STATE");
+            lane.writeXml (xml, "gain");
+            restored.readXml (&xml, "gain");
+
+            expectEquals (restored.getNumBreakpoints(), 2);
+            expectEquals (restored.getBreakpoint (1).time, (int64) 1000000000000);
+            expectEquals (restored.getBreakpoint (1).value, 0.75);
+        }
+    }
+};
+
+static AutomationLaneTests automationLaneTests;
+
+#endif // DROWAUDIO_UNIT_TESTS
@@ -0,0 +1,155 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef DROWAUDIO_AUTOMATIONLANE_H
+#define DROWAUDIO_AUTOMATIONLANE_H
+
+//==============================================================================
+/** A list of time-stamped values describing how a parameter changes over time.
+
+    Breakpoints are kept sorted by their time in samples so any position can be
+    found with a binary search. Between breakpoints the value is either linearly
+    interpolated or held until the next one. Before the first breakpoint the lane
+    has the first breakpoint's value and after the last the last one's.
+
+    Lanes are usually edited on the message thread and read on the audio thread.
+    The audio thread methods, fillBlock() and getValueForBlock(), never allocate or
+    block; if the lane is being edited at the time they will simply return false.
+
+    @see ParameterAutomation
+*/
+class AutomationLane
+{
+public:
+    //==============================================================================
+    /** A single point in a lane. */
+    struct Breakpoint
+    {
+        juce::int64 time;   /**< The position of the breakpoint in samples. */
+        double value;       /**< The value of the parameter at this position. */
+    };
+
+    /** The ways in which values are calculated between breakpoints. */
+    enum InterpolationType
+    {
+        linearInterpolation,    /**< Values are ramped linearly between breakpoints. */
+        stepInterpolation       /**< The value of each breakpoint is held until the next one. */
+    };
+
+    //==============================================================================
+    /** Creates an empty lane. */
+    AutomationLane();
+
+    /** Destructor. */
+    ~AutomationLane();
+
+    //==============================================================================
+    /** Adds a breakpoint, replacing any that already exists at the same time. */
+    void addBreakpoint (juce::int64 time, double value);
+
+    /** Removes all the breakpoints with times in the range startTime <= time < endTime. */
+    void removeBreakpoints (juce::int64 startTime, juce::int64 endTime);
+
+    /** Removes all the breakpoints. */
+    void clear();
+
+    /** Pre-allocates space for a number of breakpoints.
+        Use this before recording to avoid re-allocating whilst the lane is locked.
+    */
+    void ensureStorageAllocated (int minNumBreakpoints);
+
+    /** Returns the number of breakpoints in the lane. */
+    int getNumBreakpoints() const;
+
+    /** Returns one of the breakpoints. */
+    Breakpoint getBreakpoint (int index) const;
+
+    /** Returns the index of the first breakpoint later than a given time.
+        This will be getNumBreakpoints() if there are no later breakpoints.
+    */
+    int getIndexOfFirstBreakpointAfter (juce::int64 time) const;
+
+    //==============================================================================
+    /** Sets how values are calculated between breakpoints. */
+    void setInterpolationType (InterpolationType newType);
+
+    /** Returns the current InterpolationType. */
+    InterpolationType getInterpolationType() const noexcept     { return interpolationType; }
+
+    //==============================================================================
+    /** Returns the value of the lane at a given time.
+        If the lane is empty this will return defaultValue.
+    */
+    double getValueAt (juce::int64 time, double defaultValue = 0.0) const;
+
+    /** Fills a buffer with the values of the lane for each sample in a block.
+
+        This is intended to be called from the audio thread so won't allocate or
+        block. If the lane is empty or currently being edited nothing is written
+        and false is returned.
+    */
+    bool fillBlock (juce::int64 startTime, float* destination, int numSamples) const noexcept;
+
+    /** Finds the value at the last sample of a block.
+
+        This is intended to be called from the audio thread so won't allocate or
+        block. If the lane is empty or currently being edited false is returned.
+    */
+    bool getValueForBlock (juce::int64 startTime, int numSamples, double& value) const noexcept;
+
+    //==============================================================================
+    /** Writes the lane as a compact child element of an XmlElement. */
+    void writeXml (juce::XmlElement& xmlState, const juce::String& laneName) const;
+
+    /** Restores a lane previously saved with writeXml. */
+    void readXml (const juce::XmlElement* xmlState, const juce::String& laneName);
+
+    //==============================================================================
+    /** Returns the lock used to guard the breakpoints.
+        Hold this to make several edits appear to the audio thread at once.
+    */
+    const juce::CriticalSection& getLock() const noexcept       { return lock; }
+
+private:
+    //==============================================================================
+    juce::CriticalSection lock;
+    juce::Array<Breakpoint> breakpoints;
+    InterpolationType interpolationType;
+
+    //==============================================================================
+    int findFirstAfter (juce::int64 time) const noexcept;
+    double interpolate (int indexAfter, juce::int64 time) const noexcept;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AutomationLane)
+};
+
+#endif // DROWAUDIO_AUTOMATIONLANE_H
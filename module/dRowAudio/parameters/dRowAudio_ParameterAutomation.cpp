@@ -0,0 +1,129 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+ParameterAutomation::ParameterAutomation (PluginParameter& parameterToAutomate)
+    : parameter (parameterToAutomate),
+      mode (offMode),
+      lastBlockEnd (0),
+      lastBlockSize (0),
+      lastBlockTimeMs (0.0),
+      sampleRate (44100.0),
+      lastRecordedTime (-1)
+{
+    parameter.getValueObject().addListener (this);
+}
+
+ParameterAutomation::~ParameterAutomation()
+{
+    parameter.getValueObject().removeListener (this);
+}
+
+//==============================================================================
+void ParameterAutomation::setMode (Mode newMode)
+{
+    if (newMode == writeMode)
+        lane.ensureStorageAllocated (lane.getNumBreakpoints() + 1024);
+
+    endRecordingPass();
+    mode = newMode;
+}
+
+void ParameterAutomation::setSampleRate (double newSampleRate)
+{
+    jassert (newSampleRate > 0.0);
+    sampleRate = newSampleRate;
+}
+
+//==============================================================================
+void ParameterAutomation::processBlock (int64 startSample, int numSamples, float* destination) noexcept
+{
+    if (numSamples <= 0)
+        return;
+
+    lastBlockEnd.store (startSample + numSamples);
+    lastBlockSize.store (numSamples);
+    lastBlockTimeMs.store (Time::getMillisecondCounterHiRes());
+
+    if (mode.load() == readMode)
+    {
+        double value;
+
+        if (lane.getValueForBlock (startSample, numSamples, value))
+            parameter.setValue (value);
+
+        if (destination != nullptr && lane.fillBlock (startSample, destination, numSamples))
+            return;
+    }
+
+    if (destination != nullptr)
+        FloatVectorOperations::fill (destination, (float) parameter.getValue(), numSamples);
+}
+
+int64 ParameterAutomation::getCurrentPosition() const noexcept
+{
+    // extrapolate by no more than a block so a stalled audio thread doesn't run away
+    const double elapsedMs = Time::getMillisecondCounterHiRes() - lastBlockTimeMs.load();
+    const int64 elapsedSamples = (int64) (jmax (0.0, elapsedMs) * sampleRate.load() / 1000.0);
+
+    return lastBlockEnd.load() + jmin (elapsedSamples, (int64) lastBlockSize.load());
+}
+
+//==============================================================================
+void ParameterAutomation::recordValue (double value)
+{
+    recordValue (getCurrentPosition(), value);
+}
+
+void ParameterAutomation::recordValue (int64 time, double value)
+{
+    const ScopedLock sl (lane.getLock());
+
+    // overwrite anything since the last value of this pass,
+    // if the transport has moved backwards this just starts a new one
+    if (lastRecordedTime >= 0 && time > lastRecordedTime)
+        lane.removeBreakpoints (lastRecordedTime + 1, time);
+
+    lane.addBreakpoint (time, value);
+    lastRecordedTime = time;
+}
+
+void ParameterAutomation::endRecordingPass()
+{
+    const ScopedLock sl (lane.getLock());
+    lastRecordedTime = -1;
+}
+
+//==============================================================================
+void ParameterAutomation::valueChanged (Value& value)
+{
+    if (mode.load() == writeMode)
+        recordValue (jlimit (parameter.getMin(), parameter.getMax(), (double) value.getValue()));
+}
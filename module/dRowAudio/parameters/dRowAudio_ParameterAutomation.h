@@ -0,0 +1,153 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef DROWAUDIO_PARAMETERAUTOMATION_H
+#define DROWAUDIO_PARAMETERAUTOMATION_H
+
+#include "dRowAudio_PluginParameter.h"
+#include "dRowAudio_AutomationLane.h"
+
+//==============================================================================
+/** Records and plays back the automation of a PluginParameter.
+
+    In write mode any changes made to the parameter's Value object, usually by
+    the UI, are time-stamped with the current playback position and added to
+    the lane, replacing whatever was there before. In read mode the lane drives
+    the parameter from the audio thread.
+
+    Call processBlock() from your getNextAudioBlock() or processBlock() method with
+    the position of the block in samples. This will update the parameter and can
+    optionally fill a buffer with the value for each sample in the block so the
+    automation can be applied sample-accurately. This never allocates so replaying
+    a performance for an offline render gives the same result every time.
+
+    @code
+    void getNextAudioBlock (const AudioSourceChannelInfo& info) override
+    {
+        gainAutomation.processBlock (position, info.numSamples, gainBuffer);
+
+        for (int c = 0; c < info.buffer->getNumChannels(); ++c)
+            FloatVectorOperations::multiply (info.buffer->getWritePointer (c, info.startSample),
+                                             gainBuffer, info.numSamples);
+
+        position += info.numSamples;
+    }
+    @endcode
+
+    @see AutomationLane, PluginParameter
+*/
+class ParameterAutomation  : private juce::Value::Listener
+{
+public:
+    //==============================================================================
+    /** The automation modes. */
+    enum Mode
+    {
+        offMode,    /**< The parameter is left alone. */
+        readMode,   /**< The lane drives the parameter. */
+        writeMode   /**< Changes to the parameter are recorded into the lane. */
+    };
+
+    //==============================================================================
+    /** Creates a ParameterAutomation for a parameter.
+        The parameter must outlive this object.
+    */
+    explicit ParameterAutomation (PluginParameter& parameterToAutomate);
+
+    /** Destructor. */
+    ~ParameterAutomation() override;
+
+    //==============================================================================
+    /** Returns the parameter being automated. */
+    PluginParameter& getParameter() const noexcept          { return parameter; }
+
+    /** Returns the lane holding the automation. */
+    AutomationLane& getLane() noexcept                      { return lane; }
+
+    //==============================================================================
+    /** Sets the automation mode. */
+    void setMode (Mode newMode);
+
+    /** Returns the current automation mode. */
+    Mode getMode() const noexcept                           { return mode.load(); }
+
+    /** Sets the sample rate used to time-stamp changes made between blocks. */
+    void setSampleRate (double newSampleRate);
+
+    //==============================================================================
+    /** Updates the parameter for a block of audio.
+
+        In read mode the parameter is set to the lane's value at the end of the block.
+        If destination is not nullptr it is filled with the value for each sample,
+        either from the lane in read mode or the parameter's current value otherwise.
+
+        This is intended to be called from the audio thread and won't allocate or block.
+    */
+    void processBlock (juce::int64 startSample, int numSamples, float* destination = nullptr) noexcept;
+
+    /** Returns an estimate of the current playback position in samples.
+        This is based on the last block processed and the time that has elapsed since.
+    */
+    juce::int64 getCurrentPosition() const noexcept;
+
+    //==============================================================================
+    /** Records a value at the current playback position. */
+    void recordValue (double value);
+
+    /** Records a value at a given position.
+        Any breakpoints between the last recorded position and this one are removed.
+    */
+    void recordValue (juce::int64 time, double value);
+
+    /** Ends the current recording pass.
+        The next recorded value will start a new pass rather than overwriting from the last one.
+    */
+    void endRecordingPass();
+
+private:
+    //==============================================================================
+    PluginParameter& parameter;
+    AutomationLane lane;
+
+    std::atomic<Mode> mode;
+    std::atomic<juce::int64> lastBlockEnd;
+    std::atomic<int> lastBlockSize;
+    std::atomic<double> lastBlockTimeMs, sampleRate;
+    juce::int64 lastRecordedTime;
+
+    //==============================================================================
+    void valueChanged (juce::Value& value) override;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParameterAutomation)
+};
+
+#endif // DROWAUDIO_PARAMETERAUTOMATION_H
@@ -29,8 +29,77 @@
     ==============================================================================
 */
 
+//==============================================================================
+/** Collects the parameters whose values have been changed away from the message
+    thread and pushes them to their Value objects in a single timer callback.
+*/
+class PluginParameter::ValueUpdater  : private Timer,
+                                       public DeletedAtShutdown
+{
+public:
+    juce_DeclareSingleton (ValueUpdater, false)
+
+    ValueUpdater() {}
+
+    ~ValueUpdater() override
+    {
+        stopTimer();
+        clearSingletonInstance();
+    }
+
+    void addParameter (PluginParameter* parameter)
+    {
+        const ScopedLock sl (lock);
+        parameters.add (parameter);
+
+        // parameters may be created before the message loop, e.g. as statics
+        if (! isTimerRunning() && MessageManager::getInstanceWithoutCreating() != nullptr)
+            startTimerHz (30);
+    }
+
+    void removeParameter (PluginParameter* parameter)
+    {
+        const ScopedLock sl (lock);
+        parameters.removeFirstMatchingValue (parameter);
+    }
+
+    void updateAll()
+    {
+        const ScopedLock sl (lock);
+
+        for (auto* parameter : parameters)
+            if (parameter->valueObjectNeedsUpdate.load (std::memory_order_acquire))
+                parameter->updateValueObject();
+    }
+
+private:
+    CriticalSection lock;
+    Array<PluginParameter*> parameters;
+
+    void timerCallback() override
+    {
+        updateAll();
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (ValueUpdater)
+};
+
+juce_ImplementSingleton (PluginParameter::ValueUpdater)
+
+//==============================================================================
 PluginParameter::PluginParameter()
+    : currentValue (0.0),
+      smoothValue (0.0),
+      valueObjectNeedsUpdate (false),
+      lastValueObjectValue (0.0),
+      smoothingType (exponentialSmoothing),
+      rampTarget (0.0),
+      rampIncrement (0.0),
+      rampStepsRemaining (0)
 {
+    ValueUpdater::getInstance()->addParameter (this);
+    valueObject.addListener (this);
+
     init ("parameter",      // name
           UnitGeneric,      // unit
           "A parameter",        // description
@@ -45,6 +114,38 @@ PluginParameter::PluginParameter()
 }
 
 PluginParameter::PluginParameter (const PluginParameter& other)
+    : currentValue (0.0),
+      smoothValue (0.0),
+      valueObjectNeedsUpdate (false),
+      lastValueObjectValue (0.0),
+      smoothingType (exponentialSmoothing),
+      rampTarget (0.0),
+      rampIncrement (0.0),
+      rampStepsRemaining (0)
+{
+    ValueUpdater::getInstance()->addParameter (this);
+    valueObject.addListener (this);
+
+    copyPropertiesFrom (other);
+}
+
+PluginParameter& PluginParameter::operator= (const PluginParameter& other)
+{
+    if (this != &other)
+        copyPropertiesFrom (other);
+
+    return *this;
+}
+
+PluginParameter::~PluginParameter()
+{
+    valueObject.removeListener (this);
+
+    if (ValueUpdater* updater = ValueUpdater::getInstanceWithoutCreating())
+        updater->removeParameter (this);
+}
+
+void PluginParameter::copyPropertiesFrom (const PluginParameter& other)
 {
     name = other.name;
     description = other.description;
@@ -53,11 +154,13 @@ PluginParameter::PluginParameter (const PluginParameter& other)
     max = other.max;
     defaultValue = other.defaultValue;
     smoothCoeff = other.smoothCoeff;
-    smoothValue = other.smoothValue;
+    smoothingType = other.smoothingType;
     skewFactor = other.skewFactor;
     step = other.step;
     unit = other.unit;
-    setValue (static_cast<double> (other.valueObject.getValue()));
+    setValue (other.getValue());
+    smoothValue.store (other.getSmoothedValue(), std::memory_order_relaxed);
+    rampStepsRemaining = 0;
 }
 
 void PluginParameter::init (const juce::String& name_, ParameterUnit unit_, juce::String description_,
@@ -74,7 +177,7 @@ void PluginParameter::init (const juce::String& name_, ParameterUnit unit_, juce
     defaultValue = default_;
 
     smoothCoeff = smoothCoeff_;
-    smoothValue = getValue();
+    resetSmoothing();
 
     skewFactor = skewFactor_;
     step = step_;
@@ -108,7 +211,12 @@ void PluginParameter::init (const juce::String& name_, ParameterUnit unit_, juce
 
 void PluginParameter::setValue (double value)
 {
-    valueObject = jlimit (min, max, value);
+    currentValue.store (jlimit (min, max, value), std::memory_order_relaxed);
+
+    if (MessageManager::existsAndIsCurrentThread())
+        updateValueObject();
+    else
+        valueObjectNeedsUpdate.store (true, std::memory_order_release);
 }
 
 void PluginParameter::setNormalisedValue (double normalisedValue)
@@ -121,20 +229,169 @@ void PluginParameter::setUnitSuffix (const juce::String& newSuffix)
     unitSuffix = newSuffix;
 }
 
-void PluginParameter::smooth()
+//==============================================================================
+void PluginParameter::setSmoothingType (SmoothingType newType) noexcept
+{
+    smoothingType = newType;
+    rampStepsRemaining = 0;
+}
+
+void PluginParameter::smooth() noexcept
+{
+    getNextSmoothedValue();
+}
+
+void PluginParameter::smooth (int numSteps) noexcept
+{
+    const double target = getValue();
+
+    if (numSteps <= 0 || ! prepareRamp (target))
+        return;
+
+    double newValue = target;
+
+    if (smoothingType == linearSmoothing)
+    {
+        if (numSteps < rampStepsRemaining)
+        {
+            newValue = getSmoothedValue() + rampIncrement * numSteps;
+            rampStepsRemaining -= numSteps;
+        }
+        else
+        {
+            rampStepsRemaining = 0;
+        }
+    }
+    else
+    {
+        newValue = target + (getSmoothedValue() - target) * std::pow (1.0 - smoothCoeff, (double) numSteps);
+
+        if (almostEqual (newValue, target))
+            newValue = target;
+    }
+
+    smoothValue.store (newValue, std::memory_order_relaxed);
+}
+
+double PluginParameter::getNextSmoothedValue() noexcept
+{
+    const double target = getValue();
+
+    if (! prepareRamp (target))
+        return getSmoothedValue();
+
+    double newValue = target;
+
+    if (smoothingType == linearSmoothing)
+    {
+        if (--rampStepsRemaining > 0)
+            newValue = getSmoothedValue() + rampIncrement;
+    }
+    else
+    {
+        newValue = ((target - getSmoothedValue()) * smoothCoeff) + getSmoothedValue();
+
+        if (almostEqual (newValue, target))
+            newValue = target;
+    }
+
+    smoothValue.store (newValue, std::memory_order_relaxed);
+
+    return newValue;
+}
+
+void PluginParameter::fillRamp (float* destination, int numSamples) noexcept
 {
-    if (smoothValue != getValue())
+    jassert (destination != nullptr);
+
+    if (numSamples <= 0)
+        return;
+
+    const double target = getValue();
+
+    if (! prepareRamp (target))
+    {
+        FloatVectorOperations::fill (destination, (float) getSmoothedValue(), numSamples);
+        return;
+    }
+
+    const double start = getSmoothedValue();
+    double newValue = target;
+    int numRampSamples = numSamples;
+
+    if (smoothingType == linearSmoothing)
     {
-        if (smoothCoeff == 1.0 || almostEqual (smoothValue, getValue()))
-            smoothValue = getValue();
+        numRampSamples = jmin (numSamples, rampStepsRemaining);
+
+        for (int i = 0; i < numRampSamples; ++i)
+            destination[i] = (float) (start + rampIncrement * (i + 1));
+
+        rampStepsRemaining -= numRampSamples;
+
+        if (rampStepsRemaining > 0)
+            newValue = start + rampIncrement * numRampSamples;
         else
-            smoothValue = ((getValue() - smoothValue) * smoothCoeff) + smoothValue;
+            destination[numRampSamples - 1] = (float) target;
+    }
+    else
+    {
+        // the number of steps before the remaining distance falls within the snapping threshold
+        const double ratio = 1.0 - smoothCoeff;
+        const double distance = start - target;
+        const double stepsToTarget = std::ceil (std::log (0.00001 / std::abs (distance)) / std::log (ratio));
+        numRampSamples = (int) jlimit (1.0, (double) numSamples, stepsToTarget);
+
+        // each lane moves by ratio^4 per iteration so the lanes are independent of each other
+        const int numLanes = 4;
+        const double laneRatio = ratio * ratio * ratio * ratio;
+        double lanes[numLanes];
+        double gain = ratio;
+
+        for (int lane = 0; lane < numLanes; ++lane)
+        {
+            lanes[lane] = distance * gain;
+            gain *= ratio;
+        }
+
+        int i = 0;
+
+        for (; i + numLanes <= numRampSamples; i += numLanes)
+        {
+            for (int lane = 0; lane < numLanes; ++lane)
+            {
+                destination[i + lane] = (float) (target + lanes[lane]);
+                lanes[lane] *= laneRatio;
+            }
+        }
+
+        for (int lane = 0; i < numRampSamples; ++i, ++lane)
+            destination[i] = (float) (target + lanes[lane]);
+
+        if (numRampSamples < stepsToTarget)
+        {
+            newValue = target + distance * std::pow (ratio, (double) numRampSamples);
+
+            if (almostEqual (newValue, target))
+                newValue = target;
+        }
     }
+
+    if (numRampSamples < numSamples)
+        FloatVectorOperations::fill (destination + numRampSamples, (float) target, numSamples - numRampSamples);
+
+    smoothValue.store (newValue, std::memory_order_relaxed);
+}
+
+void PluginParameter::resetSmoothing() noexcept
+{
+    smoothValue.store (getValue(), std::memory_order_relaxed);
+    rampStepsRemaining = 0;
 }
 
 void PluginParameter::setSmoothCoeff (double newSmoothCoef)
 {
     smoothCoeff = newSmoothCoef;
+    rampStepsRemaining = 0;
 }
 
 void PluginParameter::setSkewFactor (double newSkewFactor)
@@ -171,7 +428,146 @@ void PluginParameter::setupSlider (Slider& slider)
     slider.setTextValueSuffix   (unitSuffix);
 }
 
+//==============================================================================
+void PluginParameter::updateAllValueObjects()
+{
+    JUCE_ASSERT_MESSAGE_MANAGER_IS_LOCKED
+
+    if (ValueUpdater* updater = ValueUpdater::getInstanceWithoutCreating())
+        updater->updateAll();
+}
+
+void PluginParameter::valueChanged (Value& value)
+{
+    const double newValue = value.getValue();
+
+    // ignore our own updates as the parameter may have moved on since they were made
+    if (newValue != lastValueObjectValue)
+    {
+        lastValueObjectValue = newValue;
+        currentValue.store (jlimit (min, max, newValue), std::memory_order_relaxed);
+    }
+}
+
+//==============================================================================
 double PluginParameter::normaliseValue (double scaledValue) const noexcept
 {
     return (scaledValue - min) / (max - min);
 }
+
+void PluginParameter::updateValueObject()
+{
+    valueObjectNeedsUpdate.store (false, std::memory_order_relaxed);
+
+    lastValueObjectValue = getValue();
+    valueObject = lastValueObjectValue;
+}
+
+bool PluginParameter::prepareRamp (double target) noexcept
+{
+    const double current = getSmoothedValue();
+
+    if (current == target || smoothCoeff <= 0.0)
+    {
+        rampStepsRemaining = 0;
+        return false;
+    }
+
+    if (smoothCoeff >= 1.0 || almostEqual (current, target))
+    {
+        smoothValue.store (target, std::memory_order_relaxed);
+        rampStepsRemaining = 0;
+        return false;
+    }
+
+    // a new linear ramp is started from wherever the last one had got to whenever the value changes
+    if (smoothingType == linearSmoothing && (rampStepsRemaining <= 0 || target != rampTarget))
+    {
+        rampStepsRemaining = jmax (1, roundToInt (1.0 / smoothCoeff));
+        rampIncrement = (target - current) / rampStepsRemaining;
+    }
+
+    rampTarget = target;
+
+    return true;
+}
+
+//==============================================================================
+#if DROWAUDIO_UNIT_TESTS
+
+class PluginParameterTests  : public UnitTest
+{
+public:
+    PluginParameterTests() : UnitTest ("PluginParameter") {}
+
+    void runTest() override
+    {
+        beginTest ("Exponential smoothing");
+        {
+            PluginParameter sequential, block, ramp;
+
+            for (auto* p : { &sequential, &block, &ramp })
+            {
+                p->init ("exp", UnitGeneric, {}, 0.0, 0.0, 1.0, 0.0, 1.0, 0.05);
+                p->setValue (1.0);
+            }
+
+            HeapBlock<float> buffer (512);
+            ramp.fillRamp (buffer, 64);
+            block.smooth (64);
+
+            for (int i = 0; i < 64; ++i)
+                expectWithinAbsoluteError (buffer[i], (float) sequential.getNextSmoothedValue(), 0.0001f);
+
+            expectWithinAbsoluteError (block.getSmoothedValue(), sequential.getSmoothedValue(), 0.000001);
+            expectWithinAbsoluteError (ramp.getSmoothedValue(), sequential.getSmoothedValue(), 0.000001);
+
+            ramp.fillRamp (buffer, 512);
+            expectEquals (buffer[511], 1.0f);
+            expect (! ramp.isSmoothing());
+        }
+
+        beginTest ("Linear smoothing");
+        {
+            PluginParameter p;
+            p.init ("lin", UnitGeneric, {}, 0.0, 0.0, 1.0, 0.0, 1.0, 0.1);
+            p.setSmoothingType (PluginParameter::linearSmoothing);
+            p.setValue (1.0);
+
+            HeapBlock<float> buffer (16);
+            p.fillRamp (buffer, 4);
+
+            for (int i = 0; i < 4; ++i)
+                expectWithinAbsoluteError (buffer[i], 0.1f * (i + 1), 0.0001f);
+
+            p.smooth (5);
+            expectWithinAbsoluteError (p.getSmoothedValue(), 0.9, 0.000001);
+
+            p.fillRamp (buffer, 16);
+            expectEquals (buffer[0], 1.0f);
+            expectEquals (buffer[15], 1.0f);
+            expect (! p.isSmoothing());
+
+            // changing the value mid-ramp restarts from the current position
+            p.setValue (0.0);
+            p.smooth (5);
+            expectWithinAbsoluteError (p.getSmoothedValue(), 0.5, 0.000001);
+        }
+
+        beginTest ("Value object");
+        {
+            PluginParameter p;
+            p.init ("value", UnitGeneric, {}, 0.0, 0.0, 2.0);
+
+            p.setValue (5.0);
+            expectEquals (p.getValue(), 2.0);
+
+            if (MessageManager::existsAndIsCurrentThread())
+                expectEquals ((double) p.getValueObject().getValue(), 2.0);
+        }
+    }
+};
+
+static PluginParameterTests pluginParameterTests;
+
+#endif // DROWAUDIO_UNIT_TESTS
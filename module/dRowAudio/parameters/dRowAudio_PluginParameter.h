@@ -74,8 +74,20 @@ enum ParameterUnit
 
     Both full-scale and normalised values must be present for
     AU and VST host campatability.
+
+    The current value is held atomically so it can be read and written wait-free
+    from the audio thread. The juce::Value returned by getValueObject() is kept
+    in sync with it on the message thread so it can still be used to bind sliders
+    etc. Changes made from other threads are collected and pushed to the Value
+    objects of all the parameters that have changed in a single timer callback,
+    so automating many parameters at once doesn't flood the message thread.
+
+    To avoid zipper noise the parameter also provides a smoothed version of its
+    value which can be advanced either per-block using smooth(), or per-sample
+    using getNextSmoothedValue() and fillRamp(). These should only be called from
+    a single thread, usually the audio thread.
 */
-class PluginParameter
+class PluginParameter : private juce::Value::Listener
 {
 public:
     /** Create a default parameter.
@@ -90,6 +102,12 @@ public:
     /** Creates a copy of another parameter. */
     PluginParameter (const PluginParameter& other);
 
+    /** Copies the properties and value of another parameter. */
+    PluginParameter& operator= (const PluginParameter& other);
+
+    /** Destructor. */
+    ~PluginParameter() override;
+
     //==============================================================================
     /** Initialise the parameter.
 
@@ -99,23 +117,80 @@ public:
                double value_ = 0.0, double min_ = 0.0, double max_ = 1.0, double default_ = 0.0,
                double skewFactor_ = 1.0, double smoothCoeff_ = 0.1, double step_ = 0.01, juce::String unitSuffix_ = {});
 
+    /** Returns the Value object that mirrors this parameter on the message thread.
+        Changes made to this will be picked up by the parameter when the Value's
+        listeners are called.
+    */
     juce::Value& getValueObject() { return valueObject; }
 
-    double getValue() const                                     { return double (valueObject.getValue()); }
-    double getNormalisedValue() const                           { return normaliseValue (getValue()); }
+    /** Returns the current value. This is wait-free so can be called from any thread. */
+    double getValue() const noexcept                            { return currentValue.load (std::memory_order_relaxed); }
+    double getNormalisedValue() const noexcept                  { return normaliseValue (getValue()); }
+
+    /** Sets the value of the parameter.
+        This is wait-free so can be called from the audio thread. If called from any
+        thread other than the message thread the Value object will be updated shortly
+        afterwards, along with any other parameters that have changed.
+    */
     void setValue (double value);
     void setNormalisedValue (double normalisedValue);
-    double getSmoothedValue() const                             { return smoothValue; }
-    double getSmoothedNormalisedValue() const                   { return normaliseValue (smoothValue); }
+    double getSmoothedValue() const noexcept                    { return smoothValue.load (std::memory_order_relaxed); }
+    double getSmoothedNormalisedValue() const noexcept          { return normaliseValue (getSmoothedValue()); }
 
     double getMin() const                                       { return min; }
     double getMax() const                                       { return max; }
     double getDefault() const                                   { return defaultValue; }
 
-    void smooth();
+    //==============================================================================
+    /** The ways in which the smoothed value can approach the parameter's value. */
+    enum SmoothingType
+    {
+        exponentialSmoothing,   /**< Moves a proportion, the smooth coefficient, of the remaining distance each step. */
+        linearSmoothing         /**< Moves in equal steps, reaching the value after 1 / smooth coefficient steps. */
+    };
+
+    /** Sets how the smoothed value will approach the parameter's value.
+        This should be called from the same thread that does the smoothing.
+    */
+    void setSmoothingType (SmoothingType newType) noexcept;
+
+    /** Returns the current SmoothingType. */
+    SmoothingType getSmoothingType() const noexcept             { return smoothingType; }
+
+    /** Advances the smoothed value by a single step.
+        Call this once per block for block-rate smoothing.
+    */
+    void smooth() noexcept;
+
+    /** Advances the smoothed value by a number of steps in one go.
+        This is the same as calling smooth() numSteps times so can be used to
+        keep per-sample smoothing times when only the block rate value is needed.
+    */
+    void smooth (int numSteps) noexcept;
+
+    /** Advances the smoothed value by one step and returns it.
+        Use this for per-sample smoothing.
+    */
+    double getNextSmoothedValue() noexcept;
+
+    /** Fills a buffer with the next numSamples smoothed values and advances the
+        smoothed value past them.
+        The ramp is calculated in closed form for each sample, rather than using
+        the previous one, so it can be vectorised by the compiler. Once the value
+        has been reached the rest of the buffer is simply filled.
+    */
+    void fillRamp (float* destination, int numSamples) noexcept;
+
+    /** Returns true if the smoothed value hasn't yet reached the parameter's value. */
+    bool isSmoothing() const noexcept                           { return getSmoothedValue() != getValue(); }
+
+    /** Jumps the smoothed value to the current value, ending any ramp. */
+    void resetSmoothing() noexcept;
+
     void setSmoothCoeff (double newSmoothCoef);
     double getSmoothCoeff() const                               { return smoothCoeff; }
 
+    //==============================================================================
     void setSkewFactor (double newSkewFactor);
     void setSkewFactorFromMidPoint (double valueToShowAtMidPoint);
     double getSkewFactor() const                                { return skewFactor; }
@@ -134,17 +209,41 @@ public:
     /** Sets up a given slider with the parmeters properties. */
     void setupSlider (juce::Slider& slider);
 
+    //==============================================================================
+    /** Pushes any pending changes to the Value objects of all parameters.
+        This is called periodically on the message thread but can be called
+        manually if you need the Value objects to be up to date immediately.
+        Must be called on the message thread.
+    */
+    static void updateAllValueObjects();
+
+    /** @internal */
+    void valueChanged (juce::Value& value) override;
+
 private:
     //==============================================================================
+    class ValueUpdater;
+
     juce::Value valueObject;
     juce::String name, description, unitSuffix;
     double min, max, defaultValue;
-    double smoothCoeff, smoothValue;
+    double smoothCoeff;
     double skewFactor, step;
     ParameterUnit unit;
 
+    std::atomic<double> currentValue, smoothValue;
+    std::atomic<bool> valueObjectNeedsUpdate;
+    double lastValueObjectValue;
+
+    SmoothingType smoothingType;
+    double rampTarget, rampIncrement;
+    int rampStepsRemaining;
+
     //==============================================================================
     double normaliseValue (double scaledValue) const noexcept;
+    void copyPropertiesFrom (const PluginParameter& other);
+    void updateValueObject();
+    bool prepareRamp (double target) noexcept;
 
     //==============================================================================
     JUCE_LEAK_DETECTOR (PluginParameter)
@@ -0,0 +1,421 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+//==============================================================================
+/*  Writes the encoded data into the buffer, waiting for space to be freed when
+    it's full. Writes made after the writer has tried to seek back are dropped
+    as that data has already been read.
+*/
+class AudioEncodingInputStream::BufferOutputStream : public OutputStream
+{
+public:
+    BufferOutputStream (AudioEncodingInputStream& owner_)
+        : owner (owner_),
+          numWritten (0),
+          hasSeeked (false)
+    {
+    }
+
+    bool write (const void* data, size_t numBytes) override
+    {
+        if (hasSeeked)
+            return true;
+
+        const char* source = static_cast<const char*> (data);
+
+        while (numBytes > 0)
+        {
+            const int numToWrite = jmin ((int) numBytes, owner.buffer.getNumFree());
+
+            if (numToWrite > 0)
+            {
+                owner.buffer.writeSamples (source, numToWrite);
+                owner.sendDataReady();
+
+                source += numToWrite;
+                numBytes -= (size_t) numToWrite;
+                numWritten += numToWrite;
+            }
+            else if (owner.threadShouldExit())
+            {
+                return false;
+            }
+            else
+            {
+                owner.spaceAvailable.wait (50);
+            }
+        }
+
+        return true;
+    }
+
+    void flush() override                   {}
+    int64 getPosition() override            { return numWritten; }
+
+    bool setPosition (int64 newPosition) override
+    {
+        if (newPosition == numWritten)
+            return true;
+
+        hasSeeked = true;
+        return false;
+    }
+
+private:
+    AudioEncodingInputStream& owner;
+    int64 numWritten;
+    bool hasSeeked;
+
+    JUCE_DECLARE_NON_COPYABLE (BufferOutputStream)
+};
+
+//==============================================================================
+AudioEncodingInputStream::AudioEncodingInputStream (AudioFormat& format,
+                                                    AudioFormatReader* sourceReader,
+                                                    bool deleteReaderWhenThisIsDeleted,
+                                                    int bitsPerSample,
+                                                    const StringPairArray& metadataValues,
+                                                    int qualityOptionIndex,
+                                                    int bufferSizeBytes)
+    : Thread ("AudioEncodingInputStream"),
+      reader (sourceReader, deleteReaderWhenThisIsDeleted),
+      sampleRate (sourceReader != nullptr ? sourceReader->sampleRate : 0.0),
+      numChannels (sourceReader != nullptr ? (int) sourceReader->numChannels : 0),
+      numSamplesToEncode (sourceReader != nullptr ? sourceReader->lengthInSamples : 0),
+      buffer (jmax (16384, bufferSizeBytes)),
+      finished (false),
+      shouldFinish (false),
+      position (0),
+      result (Result::ok())
+{
+    createWriter (format, bitsPerSample, metadataValues, qualityOptionIndex);
+}
+
+AudioEncodingInputStream::AudioEncodingInputStream (AudioFormat& format,
+                                                    AudioSource* source_,
+                                                    bool deleteSourceWhenThisIsDeleted,
+                                                    double sampleRate_,
+                                                    int numChannels_,
+                                                    int64 numSamplesToEncode_,
+                                                    int bitsPerSample,
+                                                    const StringPairArray& metadataValues,
+                                                    int qualityOptionIndex,
+                                                    int bufferSizeBytes)
+    : Thread ("AudioEncodingInputStream"),
+      source (source_, deleteSourceWhenThisIsDeleted),
+      sampleRate (sampleRate_),
+      numChannels (numChannels_),
+      numSamplesToEncode (numSamplesToEncode_),
+      buffer (jmax (16384, bufferSizeBytes)),
+      finished (false),
+      shouldFinish (false),
+      position (0),
+      result (Result::ok())
+{
+    createWriter (format, bitsPerSample, metadataValues, qualityOptionIndex);
+}
+
+AudioEncodingInputStream::~AudioEncodingInputStream()
+{
+    signalThreadShouldExit();
+    spaceAvailable.signal();
+    stopThread (5000);
+
+    // the thread is stopped so anything the writer has left to write is dropped
+    writer = nullptr;
+}
+
+//==============================================================================
+Result AudioEncodingInputStream::getResult() const
+{
+    const ScopedLock sl (callbackLock);
+    return result;
+}
+
+void AudioEncodingInputStream::finishEncoding()
+{
+    shouldFinish = true;
+}
+
+int AudioEncodingInputStream::getNumBytesReady() const
+{
+    return buffer.getNumAvailable();
+}
+
+int AudioEncodingInputStream::readAvailable (void* destBuffer, int maxBytesToRead)
+{
+    const int numToRead = jmin (maxBytesToRead, buffer.getNumAvailable());
+
+    if (numToRead <= 0)
+        return 0;
+
+    buffer.readSamples (static_cast<char*> (destBuffer), numToRead);
+    position += numToRead;
+    spaceAvailable.signal();
+
+    return numToRead;
+}
+
+void AudioEncodingInputStream::setDataReadyCallback (std::function<void()> newCallback)
+{
+    const ScopedLock sl (callbackLock);
+    dataReadyCallback = std::move (newCallback);
+}
+
+//==============================================================================
+int64 AudioEncodingInputStream::getTotalLength()
+{
+    return -1;
+}
+
+bool AudioEncodingInputStream::isExhausted()
+{
+    // finished is set after the last data has gone in the buffer so this can't miss any
+    return finished.load() && buffer.getNumAvailable() == 0;
+}
+
+int AudioEncodingInputStream::read (void* destBuffer, int maxBytesToRead)
+{
+    for (;;)
+    {
+        const bool hasFinished = finished.load();
+        const int numRead = readAvailable (destBuffer, maxBytesToRead);
+
+        if (numRead > 0 || hasFinished)
+            return numRead;
+
+        dataAvailable.wait (50);
+    }
+}
+
+int64 AudioEncodingInputStream::getPosition()
+{
+    return position.load();
+}
+
+bool AudioEncodingInputStream::setPosition (int64 newPosition)
+{
+    return newPosition == position.load();
+}
+
+//==============================================================================
+void AudioEncodingInputStream::createWriter (AudioFormat& format, int bitsPerSample,
+                                             const StringPairArray& metadataValues, int qualityOptionIndex)
+{
+    if ((reader == nullptr && source == nullptr) || numChannels <= 0 || sampleRate <= 0.0)
+    {
+        result = Result::fail ("There's no audio to encode");
+        finished = true;
+        return;
+    }
+
+    // if no writer can be created the stream isn't deleted
+    std::unique_ptr<BufferOutputStream> stream (new BufferOutputStream (*this));
+    writer.reset (format.createWriterFor (stream.get(), sampleRate, (unsigned int) numChannels,
+                                          bitsPerSample, metadataValues, qualityOptionIndex));
+
+    if (writer == nullptr)
+    {
+        result = Result::fail ("Couldn't create a " + format.getFormatName() + " writer");
+        finished = true;
+        return;
+    }
+
+    stream.release();
+    startThread();
+}
+
+void AudioEncodingInputStream::run()
+{
+    if (reader != nullptr)
+        encodeFromReader();
+    else
+        encodeFromSource();
+
+    // this writes anything the format has left, waiting for space if it needs to
+    writer = nullptr;
+
+    finished = true;
+    sendDataReady();
+}
+
+void AudioEncodingInputStream::encodeFromReader()
+{
+    const int blockSize = 8192;
+
+    for (int64 startSample = 0; startSample < numSamplesToEncode; startSample += blockSize)
+    {
+        if (threadShouldExit() || shouldFinish.load())
+            return;
+
+        const int numSamples = (int) jmin ((int64) blockSize, numSamplesToEncode - startSample);
+
+        if (! writer->writeFromAudioReader (*reader, startSample, numSamples))
+        {
+            const ScopedLock sl (callbackLock);
+            result = Result::fail ("The audio couldn't be encoded");
+            return;
+        }
+    }
+}
+
+void AudioEncodingInputStream::encodeFromSource()
+{
+    const int blockSize = 8192;
+    AudioSampleBuffer samples (numChannels, blockSize);
+
+    source->prepareToPlay (blockSize, sampleRate);
+
+    for (int64 numDone = 0; numSamplesToEncode < 0 || numDone < numSamplesToEncode;)
+    {
+        if (threadShouldExit() || shouldFinish.load())
+            break;
+
+        const int numSamples = numSamplesToEncode < 0 ? blockSize
+                                                      : (int) jmin ((int64) blockSize, numSamplesToEncode - numDone);
+
+        AudioSourceChannelInfo info (&samples, 0, numSamples);
+        info.clearActiveBufferRegion();
+        source->getNextAudioBlock (info);
+
+        if (! writer->writeFromAudioSampleBuffer (samples, 0, numSamples))
+        {
+            const ScopedLock sl (callbackLock);
+            result = Result::fail ("The audio couldn't be encoded");
+            break;
+        }
+
+        numDone += numSamples;
+    }
+
+    source->releaseResources();
+}
+
+void AudioEncodingInputStream::sendDataReady()
+{
+    dataAvailable.signal();
+
+    const ScopedLock sl (callbackLock);
+
+    if (dataReadyCallback != nullptr)
+        dataReadyCallback();
+}
+
+//==============================================================================
+#if DROWAUDIO_UNIT_TESTS && JUCE_USE_FLAC
+
+class AudioEncodingInputStreamTests  : public UnitTest
+{
+public:
+    AudioEncodingInputStreamTests() : UnitTest ("AudioEncodingInputStream") {}
+
+    static void encodeInBlocks (AudioFormatWriter& writer, AudioFormatReader& reader)
+    {
+        for (int64 start = 0; start < reader.lengthInSamples; start += 8192)
+            writer.writeFromAudioReader (reader, start, jmin ((int64) 8192, reader.lengthInSamples - start));
+    }
+
+    void runTest() override
+    {
+        const int numSamples = 88200;
+        WavAudioFormat wav;
+        FlacAudioFormat flac;
+
+        AudioSampleBuffer tone (2, numSamples);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float sample = 0.5f * std::sin (MathConstants<float>::twoPi * 440.0f * (float) i / 44100.0f);
+            tone.setSample (0, i, sample);
+            tone.setSample (1, i, -sample);
+        }
+
+        MemoryBlock wavData;
+
+        {
+            std::unique_ptr<AudioFormatWriter> writer (wav.createWriterFor (new MemoryOutputStream (wavData, false),
+                                                                            44100.0, 2, 16, StringPairArray(), 0));
+            writer->writeFromAudioSampleBuffer (tone, 0, numSamples);
+        }
+
+        std::unique_ptr<AudioFormatReader> reader (wav.createReaderFor (new MemoryInputStream (wavData, false), true));
+
+        beginTest ("Back pressure");
+        {
+            AudioEncodingInputStream stream (flac, reader.get(), false, 16, StringPairArray(), 0, 16384);
+            expect (stream.getResult().wasOk());
+
+            Thread::sleep (100);
+            expect (stream.getNumBytesReady() < 16384);
+            expect (! stream.isExhausted());
+        }
+
+        beginTest ("Encoded data");
+        {
+            MemoryBlock reference;
+
+            {
+                std::unique_ptr<AudioFormatWriter> writer (flac.createWriterFor (new MemoryOutputStream (reference, false),
+                                                                                 44100.0, 2, 16, StringPairArray(), 0));
+                encodeInBlocks (*writer, *reader);
+            }
+
+            AudioEncodingInputStream stream (flac, reader.get(), false, 16, StringPairArray(), 0, 16384);
+            MemoryOutputStream encoded;
+            char block[1000];
+
+            for (;;)
+            {
+                const int numRead = stream.read (block, sizeof (block));
+
+                if (numRead <= 0)
+                    break;
+
+                encoded.write (block, (size_t) numRead);
+            }
+
+            expect (stream.isExhausted());
+            expect (stream.getResult().wasOk());
+            expectEquals ((int64) encoded.getDataSize(), (int64) reference.getSize());
+
+            // only the STREAMINFO block at the start is updated once the encoding has finished
+            const size_t streamInfoEnd = 42;
+            expect (encoded.getDataSize() > streamInfoEnd
+                     && memcmp (addBytesToPointer (encoded.getData(), streamInfoEnd),
+                                addBytesToPointer (reference.getData(), streamInfoEnd),
+                                encoded.getDataSize() - streamInfoEnd) == 0);
+        }
+    }
+};
+
+static AudioEncodingInputStreamTests audioEncodingInputStreamTests;
+
+#endif // DROWAUDIO_UNIT_TESTS
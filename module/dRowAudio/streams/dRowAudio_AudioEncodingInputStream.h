@@ -0,0 +1,161 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef DROWAUDIO_AUDIOENCODINGINPUTSTREAM_H
+#define DROWAUDIO_AUDIOENCODINGINPUTSTREAM_H
+
+//==============================================================================
+/** An InputStream that encodes audio as it's read.
+
+    Audio is pulled from an AudioFormatReader or an AudioSource on a background
+    thread and encoded by an AudioFormatWriter into a fixed size buffer, which
+    this stream then reads from. When the buffer is full the encoding waits for
+    it to be read, so the memory used stays the same however long the audio is
+    and an AudioSource is only rendered as fast as the stream is consumed.
+
+    This makes it possible to upload a mix as it's rendered without writing it
+    to disk first, e.g. by passing one to CURLEasySession::setInputStream().
+
+    As the encoded data can't be changed once it's been read, this should be used
+    with formats that can be written as a stream such as FLAC or Ogg Vorbis. Any
+    changes a writer makes to its header when it finishes, like FLAC's total
+    length, are dropped. Formats that can only write their header by going back
+    to it, such as WAV and AIFF, aren't suitable.
+*/
+class AudioEncodingInputStream : public juce::InputStream,
+                                 private juce::Thread
+{
+public:
+    //==============================================================================
+    /** Creates a stream that encodes all of the audio from a reader.
+
+        The writer is created straight away, use getResult() to check it succeeded.
+    */
+    AudioEncodingInputStream (juce::AudioFormat& format,
+                              juce::AudioFormatReader* sourceReader,
+                              bool deleteReaderWhenThisIsDeleted,
+                              int bitsPerSample = 16,
+                              const juce::StringPairArray& metadataValues = juce::StringPairArray(),
+                              int qualityOptionIndex = 0,
+                              int bufferSizeBytes = 256 * 1024);
+
+    /** Creates a stream that encodes the output of an AudioSource.
+
+        If numSamplesToEncode is negative the source will be encoded until
+        finishEncoding() is called, which is useful for sets that are still being
+        recorded. The source will be prepared and released by this stream.
+    */
+    AudioEncodingInputStream (juce::AudioFormat& format,
+                              juce::AudioSource* source,
+                              bool deleteSourceWhenThisIsDeleted,
+                              double sampleRate,
+                              int numChannels,
+                              juce::int64 numSamplesToEncode,
+                              int bitsPerSample = 16,
+                              const juce::StringPairArray& metadataValues = juce::StringPairArray(),
+                              int qualityOptionIndex = 0,
+                              int bufferSizeBytes = 256 * 1024);
+
+    /** Destructor. */
+    ~AudioEncodingInputStream() override;
+
+    //==============================================================================
+    /** Returns an error if the audio couldn't be encoded. */
+    juce::Result getResult() const;
+
+    /** Stops encoding after the current block.
+        Any data that has already been encoded can still be read.
+    */
+    void finishEncoding();
+
+    /** Returns the number of encoded bytes waiting to be read. */
+    int getNumBytesReady() const;
+
+    /** Reads any encoded data that's ready without waiting for more.
+        This returns 0 if nothing is ready yet, use isExhausted() to tell if the end has
+        been reached.
+    */
+    int readAvailable (void* destBuffer, int maxBytesToRead);
+
+    /** Sets a function to be called from the encoding thread whenever there is new
+        data to read or the encoding has finished.
+    */
+    void setDataReadyCallback (std::function<void()> newCallback);
+
+    //==============================================================================
+    /** Returns -1 as the encoded length isn't known until the encoding has finished. */
+    juce::int64 getTotalLength() override;
+
+    /** Returns true once all of the encoded data has been read. */
+    bool isExhausted() override;
+
+    /** Reads some encoded data, waiting for it to be encoded if none is ready yet. */
+    int read (void* destBuffer, int maxBytesToRead) override;
+
+    /** @internal */
+    juce::int64 getPosition() override;
+
+    /** This can't seek so only succeeds if the position is already the current one. */
+    bool setPosition (juce::int64 newPosition) override;
+
+private:
+    //==============================================================================
+    class BufferOutputStream;
+
+    juce::OptionalScopedPointer<juce::AudioFormatReader> reader;
+    juce::OptionalScopedPointer<juce::AudioSource> source;
+    const double sampleRate;
+    const int numChannels;
+    const juce::int64 numSamplesToEncode;
+
+    FifoBuffer<char> buffer;
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+    juce::WaitableEvent dataAvailable, spaceAvailable;
+    std::atomic<bool> finished, shouldFinish;
+    std::atomic<juce::int64> position;
+
+    juce::CriticalSection callbackLock;
+    std::function<void()> dataReadyCallback;
+    juce::Result result;
+
+    //==============================================================================
+    void createWriter (juce::AudioFormat& format, int bitsPerSample,
+                       const juce::StringPairArray& metadataValues, int qualityOptionIndex);
+    void run() override;
+    void encodeFromReader();
+    void encodeFromSource();
+    void sendDataReady();
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioEncodingInputStream)
+};
+
+#endif  // DROWAUDIO_AUDIOENCODINGINPUTSTREAM_H
@@ -31,8 +31,173 @@
 
 #if JUCE_MODULE_AVAILABLE_juce_cryptography
 
+namespace EnvelopeHelpers
+{
+    static const char magic[] = { 'd', 'R', 'E', '1' };
+
+    enum
+    {
+        keySize = 32,
+        macKeySize = 32,
+        macSize = 32,
+        blockSize = 8
+    };
+
+    /** Fills a buffer from the operating system's cryptographically secure random
+        number generator. juce::Random is predictable so mustn't be used for keys.
+    */
+    static bool fillRandomly (uint8* dest, size_t numBytes)
+    {
+       #if JUCE_MAC || JUCE_IOS
+        return SecRandomCopyBytes (kSecRandomDefault, numBytes, dest) == errSecSuccess;
+       #elif JUCE_WINDOWS
+        return BCryptGenRandom (nullptr, dest, (ULONG) numBytes, BCRYPT_USE_SYSTEM_PREFERRED_RNG) >= 0;
+       #else
+        size_t numRead = 0;
+
+       #ifdef DROWAUDIO_USE_GETRANDOM
+        while (numRead < numBytes)
+        {
+            const ssize_t result = getrandom (dest + numRead, numBytes - numRead, 0);
+
+            if (result > 0)
+                numRead += (size_t) result;
+            else if (result < 0 && errno != EINTR)
+                break;
+        }
+
+        if (numRead == numBytes)
+            return true;
+       #endif
+
+        // older kernels and C libraries don't have getrandom so fall back to reading the device
+        const int fd = open ("/dev/urandom", O_RDONLY | O_CLOEXEC);
+
+        if (fd < 0)
+            return false;
+
+        while (numRead < numBytes)
+        {
+            const ssize_t result = read (fd, dest + numRead, numBytes - numRead);
+
+            if (result > 0)
+                numRead += (size_t) result;
+            else if (result == 0 || errno != EINTR)
+                break;
+        }
+
+        close (fd);
+        return numRead == numBytes;
+       #endif
+    }
+
+    /** HMAC-SHA256, used to check the IV and encrypted data haven't been changed before decrypting them. */
+    static juce::MemoryBlock createMac (const uint8* key, const uint8* data, size_t numBytes)
+    {
+        enum { shaBlockSize = 64 };
+        static_assert (macKeySize <= shaBlockSize, "longer keys would need to be hashed first");
+
+        uint8 innerPad[shaBlockSize], outerPad[shaBlockSize];
+
+        for (int i = 0; i < shaBlockSize; ++i)
+        {
+            const uint8 keyByte = i < macKeySize ? key[i] : 0;
+            innerPad[i] = (uint8) (keyByte ^ 0x36);
+            outerPad[i] = (uint8) (keyByte ^ 0x5c);
+        }
+
+        juce::MemoryBlock inner (innerPad, shaBlockSize);
+        inner.append (data, numBytes);
+
+        juce::MemoryBlock outer (outerPad, shaBlockSize);
+        outer.append (SHA256 (inner).getRawData());
+
+        zerostruct (innerPad);
+        zerostruct (outerPad);
+        inner.fillWith (0);
+
+        return SHA256 (outer).getRawData();
+    }
+
+    /** Compares two MACs in a time that doesn't depend on where they differ. */
+    static bool macsMatch (const uint8* a, const uint8* b) noexcept
+    {
+        uint8 difference = 0;
+
+        for (int i = 0; i < macSize; ++i)
+            difference |= (uint8) (a[i] ^ b[i]);
+
+        return difference == 0;
+    }
+
+    static void writeBigEndianInt (uint8* dest, uint32 value) noexcept
+    {
+        value = ByteOrder::swapIfLittleEndian (value);
+        std::memcpy (dest, &value, sizeof (value));
+    }
+
+    /** BlowFish in CBC mode so repeated blocks don't give away any patterns. */
+    static void encryptBlocks (const BlowFish& blowFish, uint8* data, size_t numBytes, const uint8* iv) noexcept
+    {
+        uint32 previousLeft = ByteOrder::bigEndianInt (iv);
+        uint32 previousRight = ByteOrder::bigEndianInt (iv + 4);
+
+        for (size_t i = 0; i < numBytes; i += blockSize)
+        {
+            uint32 left = ByteOrder::bigEndianInt (data + i) ^ previousLeft;
+            uint32 right = ByteOrder::bigEndianInt (data + i + 4) ^ previousRight;
+
+            blowFish.encrypt (left, right);
+
+            writeBigEndianInt (data + i, left);
+            writeBigEndianInt (data + i + 4, right);
+            previousLeft = left;
+            previousRight = right;
+        }
+    }
+
+    static void decryptBlocks (const BlowFish& blowFish, uint8* data, size_t numBytes, const uint8* iv) noexcept
+    {
+        uint32 previousLeft = ByteOrder::bigEndianInt (iv);
+        uint32 previousRight = ByteOrder::bigEndianInt (iv + 4);
+
+        for (size_t i = 0; i < numBytes; i += blockSize)
+        {
+            const uint32 cipherLeft = ByteOrder::bigEndianInt (data + i);
+            const uint32 cipherRight = ByteOrder::bigEndianInt (data + i + 4);
+            uint32 left = cipherLeft, right = cipherRight;
+
+            blowFish.decrypt (left, right);
+
+            writeBigEndianInt (data + i, left ^ previousLeft);
+            writeBigEndianInt (data + i + 4, right ^ previousRight);
+            previousLeft = cipherLeft;
+            previousRight = cipherRight;
+        }
+    }
+
+    static juce::String toString (const juce::MemoryBlock& data, bool asHex)
+    {
+        if (asHex)
+            return juce::String::toHexString ((char*) data.getData(), (int) data.getSize(), 0);
 
+        return data.toBase64Encoding();
+    }
 
+    static juce::MemoryBlock fromString (const juce::String& data, bool isHex)
+    {
+        juce::MemoryBlock block;
+
+        if (isHex)
+            block.loadFromHexString (data);
+        else
+            block.fromBase64Encoding (data);
+
+        return block;
+    }
+}
+
+//==============================================================================
 EncryptedString::EncryptedString()
 {
 }
@@ -87,6 +252,150 @@ String EncryptedString::decrypt (const juce::String& encryptedString, const juce
     return stringAsData.toMemoryBlock().toString();
 }
 
+//==============================================================================
+String EncryptedString::encryptEnvelope (const juce::String& stringToEncrypt, const juce::String& publicKey, bool resultAsHex)
+{
+    const juce::MemoryBlock stringMemoryBlock (stringToEncrypt.toRawUTF8(), stringToEncrypt.getNumBytesAsUTF8());
+
+    return EnvelopeHelpers::toString (encryptData (stringMemoryBlock, publicKey), resultAsHex);
+}
+
+String EncryptedString::decryptEnvelope (const juce::String& encryptedString, const juce::String& privateKey, bool inputIsHex)
+{
+    juce::MemoryBlock decryptedMemoryBlock;
+
+    if (decryptData (EnvelopeHelpers::fromString (encryptedString, inputIsHex), privateKey, decryptedMemoryBlock))
+        return juce::String::fromUTF8 ((const char*) decryptedMemoryBlock.getData(), (int) decryptedMemoryBlock.getSize());
+
+    return {};
+}
+
+juce::MemoryBlock EncryptedString::encryptData (const juce::MemoryBlock& data, const juce::String& publicKey)
+{
+    using namespace EnvelopeHelpers;
+
+    // the BlowFish key is followed by the MAC key, the top byte stops any
+    // leading zeros in the keys being lost by the BigInteger
+    uint8 key[keySize + macKeySize + 1];
+
+    if (! fillRandomly (key, keySize + macKeySize))
+        return {};
+
+    key[keySize + macKeySize] = 1;
+
+    BigInteger keyAsData;
+    keyAsData.loadFromMemoryBlock (juce::MemoryBlock (key, sizeof (key)));
+
+    if (! RSAKey (publicKey).applyToValue (keyAsData))
+    {
+        zerostruct (key);
+        return {};
+    }
+
+    const juce::MemoryBlock encryptedKey (keyAsData.toMemoryBlock());
+
+    uint8 iv[blockSize];
+
+    if (! fillRandomly (iv, blockSize))
+    {
+        zerostruct (key);
+        return {};
+    }
+
+    // pad to a whole number of blocks, each padding byte holds the amount of padding
+    const size_t paddedSize = (data.getSize() / blockSize + 1) * blockSize;
+    juce::MemoryBlock encryptedData (paddedSize);
+    encryptedData.copyFrom (data.getData(), 0, data.getSize());
+    std::memset (static_cast<uint8*> (encryptedData.getData()) + data.getSize(),
+                 (int) (paddedSize - data.getSize()), paddedSize - data.getSize());
+
+    encryptBlocks (BlowFish (key, keySize), static_cast<uint8*> (encryptedData.getData()), paddedSize, iv);
+
+    // encrypt-then-MAC so changes to the data are caught before it's decrypted
+    juce::MemoryBlock macData (iv, blockSize);
+    macData.append (encryptedData.getData(), paddedSize);
+    const juce::MemoryBlock mac (createMac (key + keySize, static_cast<const uint8*> (macData.getData()), macData.getSize()));
+    zerostruct (key);
+
+    MemoryOutputStream output (paddedSize + encryptedKey.getSize() + macSize + 16);
+    output.write (magic, sizeof (magic));
+    output.writeInt ((int) encryptedKey.getSize());
+    output << encryptedKey;
+    output << macData;
+    output << mac;
+
+    return output.getMemoryBlock();
+}
+
+bool EncryptedString::decryptData (const juce::MemoryBlock& encryptedData, const juce::String& privateKey,
+                                   juce::MemoryBlock& result)
+{
+    using namespace EnvelopeHelpers;
+
+    const uint8* data = static_cast<const uint8*> (encryptedData.getData());
+    const size_t headerSize = sizeof (magic) + sizeof (int32);
+
+    if (encryptedData.getSize() < headerSize || std::memcmp (data, magic, sizeof (magic)) != 0)
+        return false;
+
+    const size_t encryptedKeySize = (size_t) ByteOrder::littleEndianInt (data + sizeof (magic));
+    const size_t sizeAfterHeader = encryptedData.getSize() - headerSize;
+
+    // compared this way round so a huge key size can't wrap around to look valid
+    if (encryptedKeySize == 0
+         || sizeAfterHeader < (size_t) (blockSize + macSize)
+         || encryptedKeySize > sizeAfterHeader - (size_t) (blockSize + macSize))
+        return false;
+
+    const uint8* iv = data + headerSize + encryptedKeySize;
+    const uint8* encryptedBlocks = iv + blockSize;
+    const size_t encryptedSize = encryptedData.getSize() - headerSize - encryptedKeySize - blockSize - macSize;
+    const uint8* mac = encryptedBlocks + encryptedSize;
+
+    if (encryptedSize == 0 || encryptedSize % blockSize != 0)
+        return false;
+
+    BigInteger keyAsData;
+    keyAsData.loadFromMemoryBlock (juce::MemoryBlock (data + headerSize, encryptedKeySize));
+
+    if (! RSAKey (privateKey).applyToValue (keyAsData))
+        return false;
+
+    juce::MemoryBlock key (keyAsData.toMemoryBlock());
+
+    if (key.getSize() != keySize + macKeySize + 1 || key[keySize + macKeySize] != 1)
+        return false;
+
+    // check nothing has been changed before decrypting anything
+    const uint8* keyData = static_cast<const uint8*> (key.getData());
+
+    if (! macsMatch (mac, static_cast<const uint8*> (createMac (keyData + keySize, iv, blockSize + encryptedSize).getData())))
+    {
+        key.fillWith (0);
+        return false;
+    }
+
+    juce::MemoryBlock decryptedData (encryptedBlocks, encryptedSize);
+    uint8* decrypted = static_cast<uint8*> (decryptedData.getData());
+    decryptBlocks (BlowFish (key.getData(), keySize), decrypted, encryptedSize, iv);
+    key.fillWith (0);
+
+    // the MAC has been checked so the padding can only be wrong if the data wasn't made by encryptData
+    const size_t paddingSize = decrypted[encryptedSize - 1];
+
+    if (paddingSize == 0 || paddingSize > blockSize)
+        return false;
+
+    for (size_t i = encryptedSize - paddingSize; i < encryptedSize; ++i)
+        if (decrypted[i] != paddingSize)
+            return false;
+
+    decryptedData.setSize (encryptedSize - paddingSize);
+    result.swapWith (decryptedData);
+
+    return true;
+}
+
 //==============================================================================
 #if DROWAUDIO_UNIT_TESTS
 
@@ -121,6 +430,56 @@ public:
         juce::String decryptedString (EncryptedString::decrypt (encryptedString, privateKey.toString()));
 
         expectEquals (decryptedString, juce::String ("hello world!"));
+
+        beginTest ("Envelope");
+
+        juce::String largeString;
+
+        for (int i = 0; i < 1000; ++i)
+            largeString << "settings value " << i << newLine;
+
+        expectEquals (EncryptedString::decryptEnvelope (EncryptedString::encryptEnvelope (largeString, knownPublicKey),
+                                                        knownPrivateKey),
+                      largeString);
+        expectEquals (EncryptedString::decryptEnvelope (EncryptedString::encryptEnvelope (largeString, publicKey.toString(), true),
+                                                        privateKey.toString(), true),
+                      largeString);
+
+        // the same input shouldn't give the same output twice
+        expect (EncryptedString::encryptEnvelope ("hello world!", knownPublicKey)
+                 != EncryptedString::encryptEnvelope ("hello world!", knownPublicKey));
+
+        // exact multiples of the block size and empty blocks need a whole block of padding
+        for (int size : { 0, 8, 13 })
+        {
+            juce::MemoryBlock data ((size_t) size);
+            Random::getSystemRandom().fillBitsRandomly (data.getData(), data.getSize());
+
+            juce::MemoryBlock decryptedData;
+            expect (EncryptedString::decryptData (EncryptedString::encryptData (data, knownPublicKey),
+                                                  knownPrivateKey, decryptedData));
+            expect (decryptedData == data);
+        }
+
+        // the wrong key or corrupt data should fail rather than return garbage
+        juce::MemoryBlock encryptedData (EncryptedString::encryptData (juce::MemoryBlock ("hello world!", 12), knownPublicKey));
+        juce::MemoryBlock decryptedData;
+        expect (! EncryptedString::decryptData (encryptedData, privateKey.toString(), decryptedData));
+
+        // flipping a bit in a middle block would only garble part of the result without the MAC
+        const juce::MemoryBlock largeData (largeString.toRawUTF8(), largeString.getNumBytesAsUTF8());
+        juce::MemoryBlock tamperedData (EncryptedString::encryptData (largeData, knownPublicKey));
+        expect (EncryptedString::decryptData (tamperedData, knownPrivateKey, decryptedData));
+
+        for (size_t index : { tamperedData.getSize() / 2, tamperedData.getSize() - 1 })
+        {
+            juce::MemoryBlock corrupted (tamperedData);
+            corrupted[index] ^= 1;
+            expect (! EncryptedString::decryptData (corrupted, knownPrivateKey, decryptedData));
+        }
+
+        encryptedData.setSize (encryptedData.getSize() - 3);
+        expect (! EncryptedString::decryptData (encryptedData, knownPrivateKey, decryptedData));
     }
 };
 
@@ -50,6 +50,12 @@
         String decryptedString (EncryptedString::decrypt (encryptedString, privateKey.toString()));
         // decryptedString equals "hello world!"
     @endcode
+
+    Applying an RSA key to large amounts of data is very slow so for anything
+    more than a short string use the envelope methods. These encrypt the data
+    with BlowFish using a random key and only use RSA to encrypt that key.
+    The encrypted data is protected by an HMAC so any changes to it are detected
+    before it's decrypted.
  */
 class EncryptedString
 {
@@ -85,6 +91,55 @@ public:
     static juce::String decrypt (const juce::String& encryptedString, const juce::String& privateKey,
                            bool inputIsHex = false);
 
+    //==============================================================================
+    /** Encrypts a String using envelope encryption.
+
+        This is the same as encrypt() but much quicker for large strings as only
+        a randomly generated BlowFish key is encrypted with the RSA key.
+        The result can only be decrypted with decryptEnvelope().
+
+        @see encryptData
+     */
+    static juce::String encryptEnvelope (const juce::String& stringToEncrypt, const juce::String& publicKey,
+                                         bool resultAsHex = false);
+
+    /** Decrypts a String that was encrypted using the encryptEnvelope method.
+        If the key is wrong or the data has been corrupted this will return an empty String.
+     */
+    static juce::String decryptEnvelope (const juce::String& encryptedString, const juce::String& privateKey,
+                                         bool inputIsHex = false);
+
+    /** Encrypts a block of data using envelope encryption.
+
+        A random key is generated by the operating system's secure random number
+        generator and used to encrypt the data with BlowFish in CBC mode. An
+        HMAC-SHA256 of the IV and encrypted data is then made with a second random
+        key. Both keys are encrypted with the RSA key and stored along with the
+        encrypted data and the HMAC.
+
+        Note that the HMAC only shows the data hasn't been changed since it was
+        encrypted, anyone with the public key can still create a valid envelope.
+
+        @param data         The data to encrypt.
+        @param publicKey    The public key created from RSAKey::createKeyPair().
+        @returns            The encrypted data, or an empty block if no random
+                            keys could be generated or the public key is invalid.
+     */
+    static juce::MemoryBlock encryptData (const juce::MemoryBlock& data, const juce::String& publicKey);
+
+    /** Decrypts a block of data that was encrypted using the encryptData method.
+
+        @param encryptedData    The data to decrypt.
+        @param privateKey       The private key partner of the public key used to encrypt the data.
+        @param result           The block to put the decrypted data in.
+        @returns                true if the data was successfully decrypted, false if the key
+                                is wrong or the data isn't valid. Any change to the
+                                encrypted data fails the HMAC check so will return
+                                false rather than partly garbled data.
+     */
+    static bool decryptData (const juce::MemoryBlock& encryptedData, const juce::String& privateKey,
+                             juce::MemoryBlock& result);
+
 private:
     //==============================================================================
     EncryptedString();      // don't instantiate this object, just use its static methods!
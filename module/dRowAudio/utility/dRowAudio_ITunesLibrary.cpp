@@ -33,13 +33,43 @@
 
 juce_ImplementSingleton(ITunesLibrary)
 
+namespace ITunesLibraryHelpers
+{
+    /** How long the tree has to be left unchanged before a new snapshot is written. */
+    static const uint32 snapshotWriteDelayMs = 2000;
+
+    /** How many items are created from a snapshot each time the parser lock is taken. */
+    static const int snapshotItemsPerBatch = 1000;
+}
+
 ITunesLibrary::ITunesLibrary()
-    : libraryTree (MusicColumns::libraryIdentifier)
+    : libraryTree (MusicColumns::libraryIdentifier),
+      isLoadingSnapshot (false),
+      snapshotItemsLoaded (false),
+      stopLoadingSnapshot (false),
+      snapshotNeedsWriting (false),
+      lastTreeChangeTime (0),
+      snapshotPool (1),
+      snapshotWriteQueued (false)
 {
+    libraryTree.addListener (this);
 }
 
 ITunesLibrary::~ITunesLibrary()
 {
+    stopTimer();
+    parser = nullptr;
+    libraryTree.removeListener (this);
+
+    // let any write in progress finish then make sure the latest changes get saved,
+    // a half loaded snapshot is never written back
+    stopLoadingSnapshot = true;
+    snapshotPool.removeAllJobs (false, 10000);
+    loadingSnapshot = nullptr;
+
+    if ((snapshotNeedsWriting || snapshotWriteQueued) && snapshotFile != File() && ! isLoadingSnapshot)
+        writeSnapshot (libraryTree, snapshotFile);
+
     clearSingletonInstance();
 }
 
@@ -47,12 +77,21 @@ void ITunesLibrary::setLibraryFile (File newFile)
 {
     if (newFile.existsAsFile())
     {
-        listeners.call (&Listener::libraryChanged, this);
-        parser = std::make_unique<ITunesLibraryParser> (newFile, libraryTree, parserLock);
-        startTimer(500);
+        // the parser merges into the library tree so has to wait for a snapshot to be loaded
+        if (isLoadingSnapshot)
+            pendingLibraryFile = newFile;
+        else
+            startParsing (newFile);
     }
 }
 
+void ITunesLibrary::startParsing (const File& file)
+{
+    listeners.call (&Listener::libraryChanged, this);
+    parser = std::make_unique<ITunesLibraryParser> (file, libraryTree, parserLock);
+    startTimer (500);
+}
+
 //==============================================================================
 const File ITunesLibrary::getDefaultITunesLibraryFile()
 {
@@ -65,24 +104,151 @@ void ITunesLibrary::setLibraryTree (ValueTree& newTreeToUse)
     if (! newTreeToUse.isValid())
         newTreeToUse = juce::ValueTree (MusicColumns::libraryIdentifier);
 
+    libraryTree.removeListener (this);
     libraryTree = newTreeToUse;
+    libraryTree.addListener (this);
+    libraryTreeChanged();
+}
+
+bool ITunesLibrary::setSnapshotFile (const File& newSnapshotFile)
+{
+    // the library tree can't be replaced while it's being parsed into
+    jassert (parser == nullptr);
+
+    snapshotFile = newSnapshotFile;
+    bool snapshotIsValid = false;
+
+    if (snapshotFile != File() && parser == nullptr && ! isLoadingSnapshot)
+    {
+        // this just maps the file and checks its header, the items are created on the pool
+        auto snapshot = std::make_unique<MusicLibrarySnapshot> (snapshotFile);
+        snapshotIsValid = snapshot->isValid();
+
+        if (snapshotIsValid)
+        {
+            ValueTree tree (snapshot->getLibraryRoot());
+            setLibraryTree (tree);
+
+            isLoadingSnapshot = true;
+            snapshotItemsLoaded = false;
+            loadingSnapshot = std::move (snapshot);
+
+            MusicLibrarySnapshot* snapshotToLoad = loadingSnapshot.get();
+            snapshotPool.addJob ([this, snapshotToLoad, tree] { loadSnapshotItems (*snapshotToLoad, tree); });
+
+            listeners.call (&Listener::libraryChanged, this);
+        }
+    }
+
+    snapshotNeedsWriting = snapshotFile != File() && ! snapshotIsValid;
+
+    if (snapshotFile != File() && ! isTimerRunning())
+        startTimer (500);
+
+    return snapshotIsValid;
 }
 
 void ITunesLibrary::timerCallback()
 {
+    if (isLoadingSnapshot)
+    {
+        if (! snapshotItemsLoaded)
+        {
+            listeners.call (&Listener::libraryUpdated, this);
+            return;
+        }
+
+        finishLoadingSnapshot();
+    }
+
     if (parser != nullptr)
     {
         listeners.call (&Listener::libraryUpdated, this);
 
-        if (parser->hasFinished())
-        {
-            stopTimer();
-            parser = nullptr;
-            listeners.call (&Listener::libraryFinished, this);
-        }
+        if (! parser->hasFinished())
+            return;
+
+        parser = nullptr;
+        listeners.call (&Listener::libraryFinished, this);
     }
+
+    if (snapshotFile == File())
+    {
+        stopTimer();
+    }
+    else if (snapshotNeedsWriting
+              && ! snapshotWriteQueued
+              && Time::getMillisecondCounter() - lastTreeChangeTime >= ITunesLibraryHelpers::snapshotWriteDelayMs)
+    {
+        // the copy is cheap compared to encoding it, which is done on the pool
+        snapshotNeedsWriting = false;
+        snapshotWriteQueued = true;
+
+        const ValueTree treeCopy (libraryTree.createCopy());
+        const File file (snapshotFile);
+
+        snapshotPool.addJob ([this, treeCopy, file]
+                             {
+                                 writeSnapshot (treeCopy, file);
+                                 snapshotWriteQueued = false;
+                             });
+    }
+}
+
+//==============================================================================
+void ITunesLibrary::loadSnapshotItems (MusicLibrarySnapshot& snapshot, ValueTree tree)
+{
+    // the items are added in batches like the parser does so the lock isn't held for long
+    const int numItems = snapshot.getNumItems();
+
+    for (int start = 0; start < numItems && ! stopLoadingSnapshot; start += ITunesLibraryHelpers::snapshotItemsPerBatch)
+    {
+        const int end = jmin (numItems, start + ITunesLibraryHelpers::snapshotItemsPerBatch);
+        const ScopedLock sl (parserLock);
+
+        for (int i = start; i < end; ++i)
+            tree.appendChild (snapshot.getItem (i), nullptr);
+    }
+
+    snapshotItemsLoaded = true;
 }
 
+void ITunesLibrary::finishLoadingSnapshot()
+{
+    isLoadingSnapshot = false;
+    loadingSnapshot = nullptr;
+
+    // the tree is what was just read so doesn't need writing again straight away
+    snapshotNeedsWriting = false;
+
+    listeners.call (&Listener::libraryUpdated, this);
+    listeners.call (&Listener::libraryFinished, this);
+
+    if (pendingLibraryFile != File())
+    {
+        startParsing (pendingLibraryFile);
+        pendingLibraryFile = File();
+    }
+}
+
+void ITunesLibrary::libraryTreeChanged()
+{
+    snapshotNeedsWriting = true;
+    lastTreeChangeTime = Time::getMillisecondCounter();
+}
+
+void ITunesLibrary::writeSnapshot (const ValueTree& treeToWrite, const File& file)
+{
+    const ScopedLock sl (snapshotWriteLock);
+    MusicLibrarySnapshot::writeToFile (treeToWrite, file);
+}
+
+//==============================================================================
+void ITunesLibrary::valueTreePropertyChanged (ValueTree&, const Identifier&)    { libraryTreeChanged(); }
+void ITunesLibrary::valueTreeChildAdded (ValueTree&, ValueTree&)                { libraryTreeChanged(); }
+void ITunesLibrary::valueTreeChildRemoved (ValueTree&, ValueTree&, int)         { libraryTreeChanged(); }
+void ITunesLibrary::valueTreeChildOrderChanged (ValueTree&, int, int)           { libraryTreeChanged(); }
+
 //==============================================================================
 void ITunesLibrary::addListener (ITunesLibrary::Listener* const listener)
 {
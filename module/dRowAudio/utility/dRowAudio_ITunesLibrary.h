@@ -33,6 +33,7 @@
 #define DROWAUDIO_ITUNESLIBRARY_H
 
 #include "dRowAudio_ITunesLibraryParser.h"
+#include "dRowAudio_MusicLibrarySnapshot.h"
 
 /** An ITunesLibrary manages the parsing of an iTunes library into a ValueTree.
 
@@ -40,12 +41,15 @@
     content has changed.
 
     You can also load a previously generated library tree
-    for data to me merged into if it is newer.
+    for data to me merged into if it is newer. The quickest way to do this is
+    to give it a snapshot file with setSnapshotFile(), which will be loaded
+    if it exists and then kept up to date in the background.
 
     For an example of its use see the MusicLibraryTable class.
  */
 class ITunesLibrary : public juce::Timer,
-                      public juce::DeletedAtShutdown
+                      public juce::DeletedAtShutdown,
+                      private juce::ValueTree::Listener
 {
 public:
     //==============================================================================
@@ -77,6 +81,30 @@ public:
     */
     void setLibraryTree (juce::ValueTree& newTreeToUse);
 
+    /** Sets a file to keep a MusicLibrarySnapshot of the library tree in.
+
+        If the file holds a valid snapshot it becomes the library tree straight
+        away, so call this before setLibraryFile(). Only the memory mapped file's
+        header and the library's own properties are read here, the items are
+        created from the snapshot in batches on a background thread and added to
+        the tree while holding the parser lock, just as the parser does. Listeners
+        get a libraryChanged() callback immediately, libraryUpdated() callbacks as
+        the items are added so the first ones can be shown, and libraryFinished()
+        once they all have been. Any library file set in the meantime will start
+        being parsed after that.
+
+        After that, whenever the tree changes and the parser isn't running, a
+        copy of it will be encoded and written to the file on a background thread
+        once it hasn't changed for a couple of seconds.
+        Pass File() to stop writing snapshots.
+
+        @returns true if the file holds a valid snapshot which is being loaded
+    */
+    bool setSnapshotFile (const juce::File& newSnapshotFile);
+
+    /** Returns the file that snapshots of the library are written to. */
+    const juce::File& getSnapshotFile() const { return snapshotFile; }
+
     /** Returns the ValueTree that is being filled. */
     juce::ValueTree getLibraryTree() const { return libraryTree; }
 
@@ -142,6 +170,35 @@ private:
     std::unique_ptr<ITunesLibraryParser> parser;
     juce::ValueTree libraryTree;
 
+    juce::File snapshotFile, pendingLibraryFile;
+    bool isLoadingSnapshot;
+    std::unique_ptr<MusicLibrarySnapshot> loadingSnapshot;
+    std::atomic<bool> snapshotItemsLoaded, stopLoadingSnapshot;
+
+    // these are set by the tree's callbacks, which can come from the parser or loading thread
+    std::atomic<bool> snapshotNeedsWriting;
+    std::atomic<juce::uint32> lastTreeChangeTime;
+
+    juce::ThreadPool snapshotPool;
+    juce::CriticalSection snapshotWriteLock;
+    std::atomic<bool> snapshotWriteQueued;
+
+    //==============================================================================
+    void startParsing (const juce::File& file);
+    void loadSnapshotItems (MusicLibrarySnapshot& snapshot, juce::ValueTree tree);
+    void finishLoadingSnapshot();
+    void libraryTreeChanged();
+    void writeSnapshot (const juce::ValueTree& treeToWrite, const juce::File& file);
+
+    /** @internal */
+    void valueTreePropertyChanged (juce::ValueTree&, const juce::Identifier&) override;
+    /** @internal */
+    void valueTreeChildAdded (juce::ValueTree&, juce::ValueTree&) override;
+    /** @internal */
+    void valueTreeChildRemoved (juce::ValueTree&, juce::ValueTree&, int) override;
+    /** @internal */
+    void valueTreeChildOrderChanged (juce::ValueTree&, int, int) override;
+
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ITunesLibrary)
 };
@@ -49,171 +49,277 @@ ITunesLibraryParser::~ITunesLibraryParser()
 
 void ITunesLibraryParser::run()
 {
-    // parse the iTunes xml first
-    iTunesDatabase = XmlDocument::parse (iTunesLibraryFile);
-    if (! iTunesDatabase->hasTagName ("plist")
-        || iTunesDatabase->getStringAttribute ("version") != "1.0")
+    // map the file rather than parsing it all up front so memory use stays low
+    MemoryMappedFile mappedFile (iTunesLibraryFile, MemoryMappedFile::readOnly);
+    MemoryBlock fileData;
+
+    const void* data = mappedFile.getData();
+    size_t dataSize = mappedFile.getSize();
+
+    if (data == nullptr && iTunesLibraryFile.loadFileAsData (fileData))
+    {
+        data = fileData.getData();
+        dataSize = fileData.getSize();
+    }
+
+    PlistTokeniser tokeniser (data, dataSize);
+
+    if (! findTracksDictionary (tokeniser))
     {
         jassertfalse; // not a vlid iTunesLibrary file!
         finished = true;
         return;
     }
 
-    // find start of tracks library
-    iTunesLibraryTracks = iTunesDatabase->getFirstChildElement()->getChildByName ("dict");
-    currentElement = iTunesLibraryTracks->getFirstChildElement();
+    findExistingItems();
 
-    // find any existing elements
-    Array<int> existingIds;
-    Array<ValueTree> existingItems;
-
-    if (! threadShouldExit())
+    while (! threadShouldExit())
     {
-        const ScopedLock sl (lock);
+        const PlistTokeniser::TokenType type = tokeniser.readNext();
 
-        if (treeToFill.hasType (MusicColumns::libraryIdentifier))
+        // check to see if we have reached the end
+        if (type != PlistTokeniser::key)
         {
-            for (int i = 0; i < treeToFill.getNumChildren(); ++i)
-            {
-                juce::ValueTree currentItem (treeToFill.getChild (i));
-                int idOfChild = int (currentItem.getProperty (MusicColumns::columnNames[MusicColumns::ID]));
+            addPendingTracks();
+            finished = true;
+            signalThreadShouldExit();
+            break;
+        }
 
-                existingIds.add (idOfChild);
-                existingItems.add (currentItem);
-            }
+        const int trackId = (int) tokeniser.getIntValue(); // e.g. <key>13452</key>
+
+        if (tokeniser.readNext() != PlistTokeniser::dictStart)
+        {
+            tokeniser.skipValue();
+            continue;
         }
+
+        processTrack (trackId, tokeniser);
+
+        if (tracksToAdd.size() + tracksToUpdate.size() >= 256)
+            addPendingTracks();
     }
+}
 
-    while (! threadShouldExit())
+//==============================================================================
+void ITunesLibraryParser::TrackDetails::clear()
+{
+    for (int i = 0; i < MusicColumns::numColumns; ++i)
+        hasValue[i] = false;
+
+    isAudioFile = isRemote = false;
+}
+
+bool ITunesLibraryParser::findTracksDictionary (PlistTokeniser& tokeniser)
+{
+    if (tokeniser.readNext() != PlistTokeniser::dictStart)
+        return false;
+
+    // look through the top level keys for the tracks, skipping the other values
+    while (tokeniser.readNext() == PlistTokeniser::key)
     {
-        int currentItemId = -1;
-        juce::ValueTree newElement;
+        const bool isTracks = tokeniser.textEquals ("Tracks");
+        const PlistTokeniser::TokenType valueType = tokeniser.readNext();
+
+        if (isTracks)
+            return valueType == PlistTokeniser::dictStart;
 
-        bool alreadyExists = false;
-        bool needToModify = false;
-        bool isAudioFile = false;
+        tokeniser.skipValue();
+    }
 
-        while (currentElement != nullptr)
+    return false;
+}
+
+void ITunesLibraryParser::readTrackDetails (PlistTokeniser& tokeniser, TrackDetails& details)
+{
+    details.clear();
+
+    while (tokeniser.readNext() == PlistTokeniser::key)
+    {
+        int column = -1;
+        bool isKind = false, isTrackType = false;
+
+        if (tokeniser.textEquals ("Track Type"))
+        {
+            isTrackType = true;
+        }
+        else
         {
-            if (currentElement->getTagName() == "key")
+            // ID has already been taken from the track's key
+            for (int i = MusicColumns::ID + 1; i < MusicColumns::numColumns; ++i)
             {
-                currentItemId = currentElement->getAllSubText().getIntValue();  // e.g. <key>13452</key>
-                alreadyExists = existingIds.contains (currentItemId);
-
-                if (alreadyExists)
+                if (tokeniser.textEquals (MusicColumns::iTunesNames[i]))
                 {
-                    // first get the relevant tree item
-                    lock.enter();
-                    const int index = existingIds.indexOf (currentItemId);
-                    juce::ValueTree existingElement (existingItems.getUnchecked (index));
-                    lock.exit();
-
-                    // and then check the modification dates
-                    XmlElement* trackDetails = currentElement->getNextElement(); // move on to the <dict>
-
-                    for (auto e : trackDetails->getChildIterator())
-                    {
-                        if (e->getAllSubText() == MusicColumns::iTunesNames[MusicColumns::Modified])
-                        {
-                            const int64 newModifiedTime = parseITunesDateString (e->getNextElement()->getAllSubText()).toMilliseconds();
-                            const int64 currentModifiedTime = int64 (existingElement.getProperty (MusicColumns::columnNames[MusicColumns::Modified]));
-
-                            if (newModifiedTime > currentModifiedTime)
-                            {
-                                const ScopedLock sl (lock);
-                                treeToFill.removeChild (existingElement, nullptr);
-                                needToModify = true;
-                            }
-
-                            break;
-                        }
-                    }
+                    column = i;
+                    isKind = (i == MusicColumns::Kind);
+                    break;
                 }
-
-                newElement = juce::ValueTree (MusicColumns::libraryItemIdentifier);
-                newElement.setProperty (MusicColumns::columnNames[MusicColumns::ID], currentItemId, nullptr);
             }
+        }
 
-            currentElement = currentElement->getNextElement(); // move on to the <dict>
+        const PlistTokeniser::TokenType valueType = tokeniser.readNext();
 
-            if (! alreadyExists || needToModify)
-                break;
+        if (valueType == PlistTokeniser::dictStart || valueType == PlistTokeniser::arrayStart)
+        {
+            tokeniser.skipValue();
+            continue;
         }
 
-        // check to see if we have reached the end
-        if (currentElement == nullptr)
+        if (valueType == PlistTokeniser::endOfInput || valueType == PlistTokeniser::error)
+            return;
+
+        if (isKind && tokeniser.textContains ("audio file"))
+            details.isAudioFile = true;
+
+        // this is a file in iCloud, not a local, readable one
+        if (isTrackType && tokeniser.textContains ("Remote"))
+            details.isRemote = true;
+
+        if (column >= 0)
         {
-            finished = true;
-            signalThreadShouldExit();
-            break;
+            details.values[column] = tokeniser.getText();
+            details.hasValue[column] = true;
+        }
+    }
+}
+
+juce::int64 ITunesLibraryParser::readModifiedTime (PlistTokeniser& tokeniser)
+{
+    int64 modifiedTime = 0;
+
+    while (tokeniser.readNext() == PlistTokeniser::key)
+    {
+        const bool isModified = tokeniser.textEquals (MusicColumns::iTunesNames[MusicColumns::Modified]);
+        const PlistTokeniser::TokenType valueType = tokeniser.readNext();
+
+        if (isModified && valueType == PlistTokeniser::date)
+            modifiedTime = parseITunesDateString (tokeniser.getText()).toMilliseconds();
+        else
+            tokeniser.skipValue();
+    }
+
+    return modifiedTime;
+}
+
+void ITunesLibraryParser::findExistingItems()
+{
+    const ScopedLock sl (lock);
+
+    if (treeToFill.hasType (MusicColumns::libraryIdentifier))
+    {
+        const int numChildren = treeToFill.getNumChildren();
+        existingItems.remapTable (numChildren * 2);
+
+        for (int i = 0; i < numChildren; ++i)
+        {
+            juce::ValueTree currentItem (treeToFill.getChild (i));
+            const int idOfChild = int (currentItem.getProperty (MusicColumns::columnNames[MusicColumns::ID]));
+            const int64 modifiedTime = int64 (currentItem.getProperty (MusicColumns::columnNames[MusicColumns::Modified]));
+            const int libId = int (currentItem.getProperty (MusicColumns::columnNames[MusicColumns::LibID]));
+
+            existingItems.set (idOfChild, { currentItem, modifiedTime, libId });
+
+            // carry on numbering new items after the existing ones
+            numAdded = jmax (numAdded, libId + 1);
         }
+    }
+}
+
+void ITunesLibraryParser::processTrack (int trackId, PlistTokeniser& tokeniser)
+{
+    if (! existingItems.contains (trackId))
+    {
+        readTrackDetails (tokeniser, currentTrack);
+
+        if (currentTrack.isAudioFile && ! currentTrack.isRemote)
+            tracksToAdd.add (createTrackTree (trackId, currentTrack));
 
-        if (currentElement->getTagName() == "dict")
+        return;
+    }
+
+    // only fully parse existing items if they have been modified since
+    const PlistTokeniser trackStart (tokeniser);
+    const ExistingItem existingItem (existingItems[trackId]);
+
+    if (readModifiedTime (tokeniser) <= existingItem.modifiedTime)
+        return;
+
+    tokeniser = trackStart;
+    readTrackDetails (tokeniser, currentTrack);
+
+    if (currentTrack.isAudioFile && ! currentTrack.isRemote)
+    {
+        juce::ValueTree updatedTrack (createTrackTree (trackId, currentTrack));
+        updatedTrack.setProperty (MusicColumns::columnNames[MusicColumns::LibID], existingItem.libId, nullptr);
+
+        tracksToUpdate.add (existingItem.tree);
+        updatedTracks.add (updatedTrack);
+    }
+}
+
+juce::ValueTree ITunesLibraryParser::createTrackTree (int trackId, const TrackDetails& details)
+{
+    juce::ValueTree newElement (MusicColumns::libraryItemIdentifier);
+    newElement.setProperty (MusicColumns::columnNames[MusicColumns::ID], trackId, nullptr);
+    newElement.setProperty (MusicColumns::columnNames[MusicColumns::LibID], numAdded++, nullptr);
+
+    for (int i = MusicColumns::ID + 1; i < MusicColumns::numColumns; ++i)
+    {
+        if (! details.hasValue[i])
+            continue;
+
+        const juce::String& elementValue = details.values[i];
+
+        if (i == MusicColumns::Length
+            || i == MusicColumns::BPM)
         {
-            // cycle through items of each track
-            for (auto e2 : currentElement->getChildIterator())
-            {
-                const juce::String elementKey (e2->getAllSubText());
-                //const juce::String elementValue (e2->getNextElement()->getAllSubText());
+            newElement.setProperty (MusicColumns::columnNames[i], elementValue.getIntValue(), nullptr);
+        }
+        else if (i == MusicColumns::Added
+                 || i == MusicColumns::Modified)
+        {
+            const int64 timeInMilliseconds (parseITunesDateString (elementValue).toMilliseconds());
+            newElement.setProperty (MusicColumns::columnNames[i], timeInMilliseconds, nullptr);
+        }
+        else if (i == MusicColumns::Location)
+        {
+            newElement.setProperty (MusicColumns::columnNames[i], stripFileProtocolForLocal (elementValue), nullptr);
+        }
+        else
+        {
+            newElement.setProperty (MusicColumns::columnNames[i], elementValue, nullptr);
+        }
+    }
 
-                if (elementKey == "Kind")
-                {
-                    if (e2->getNextElement()->getAllSubText().contains ("audio file"))
-                    {
-                        isAudioFile = true;
-                        newElement.setProperty (MusicColumns::columnNames[MusicColumns::LibID], numAdded, nullptr);
-                        numAdded++;
-                    }
-                }
-                else if (elementKey == "Track Type")
-                {
-                    // this is a file in iCloud, not a local, readable one
-                    if (e2->getNextElement()->getAllSubText().contains ("Remote"))
-                    {
-                        isAudioFile = false;
-                        break;
-                    }
-                }
+    return newElement;
+}
 
-                // and check the entry against each column
-                for (int i = 2; i < MusicColumns::numColumns; ++i)
-                {
-                    if (elementKey == MusicColumns::iTunesNames[i])
-                    {
-                        const juce::String elementValue = e2->getNextElement()->getAllSubText();
-
-                        if (i == MusicColumns::Length
-                            || i == MusicColumns::BPM
-                            || i == MusicColumns::LibID)
-                        {
-                            newElement.setProperty (MusicColumns::columnNames[i], elementValue.getIntValue(), nullptr);
-                        }
-                        else if (i == MusicColumns::Added
-                                 || i == MusicColumns::Modified)
-                        {
-                            const int64 timeInMilliseconds (parseITunesDateString (elementValue).toMilliseconds());
-                            newElement.setProperty (MusicColumns::columnNames[i], timeInMilliseconds, nullptr);
-                        }
-                        else
-                        {
-                            juce::String textEntry (elementValue);
-
-                            if (i == MusicColumns::Location)
-                                textEntry = stripFileProtocolForLocal (elementValue);
-
-                            newElement.setProperty (MusicColumns::columnNames[i], textEntry, nullptr);
-                        }
-                    }
-                }
-            }
+void ITunesLibraryParser::addPendingTracks()
+{
+    if (tracksToAdd.isEmpty() && tracksToUpdate.isEmpty())
+        return;
+
+    {
+        const ScopedLock sl (lock);
+
+        // update modified items in-place so any sub-trees such as cues and loops are kept
+        for (int i = 0; i < tracksToUpdate.size(); ++i)
+        {
+            juce::ValueTree existingTrack (tracksToUpdate.getReference (i));
+            const juce::ValueTree& updatedTrack = updatedTracks.getReference (i);
 
-            if (isAudioFile)
+            for (int p = 0; p < updatedTrack.getNumProperties(); ++p)
             {
-                const ScopedLock sl (lock);
-                treeToFill.addChild (newElement, -1, nullptr);
+                const juce::Identifier name (updatedTrack.getPropertyName (p));
+                existingTrack.setProperty (name, updatedTrack.getProperty (name), nullptr);
             }
-
-            currentElement = currentElement->getNextElement(); // move to next track
         }
+
+        for (auto& track : tracksToAdd)
+            treeToFill.addChild (track, -1, nullptr);
     }
+
+    tracksToAdd.clearQuick();
+    tracksToUpdate.clearQuick();
+    updatedTracks.clearQuick();
 }
@@ -32,13 +32,21 @@
 #ifndef DROWAUDIO_ITUNESLIBRARYPARSER_H
 #define DROWAUDIO_ITUNESLIBRARYPARSER_H
 
-#include "dRowAudio_Utility.h"
+#include "dRowAudio_MusicLibraryHelpers.h"
+#include "dRowAudio_PlistTokeniser.h"
 
 /** Parses an iTunes Xml library into a ValueTree using a background thread.
 
+    The file is memory-mapped and read as a stream of plist tokens so only one
+    track needs to be held in memory at a time. Tracks are added to the tree in
+    batches as they are parsed so the library can be displayed before the whole
+    file has been read.
+
     If the tree passed in already contains a generated library this will merge
     any new data from the file into it preserving any sub-trees or attributes
-    that may have been added.
+    that may have been added. Existing tracks are looked up by ID in a hash map
+    and only those with a newer modification date are updated, so re-syncing an
+    unchanged library is very quick.
 
     You shouldn't need to use this directly, use the higher-level iTunesLibrary
     instead.
@@ -68,17 +76,45 @@ public:
     void run() override;
 
 private:
+    //==============================================================================
+    struct TrackDetails
+    {
+        void clear();
+
+        juce::String values[MusicColumns::numColumns];
+        bool hasValue[MusicColumns::numColumns];
+        bool isAudioFile, isRemote;
+    };
+
     //==============================================================================
     const juce::CriticalSection& lock;
 
     const juce::File iTunesLibraryFile;
-    juce::ValueTree treeToFill, partialTree;
-    std::unique_ptr<juce::XmlElement> iTunesDatabase;
-    juce::XmlElement *iTunesLibraryTracks, *currentElement;
+    juce::ValueTree treeToFill;
+
+    struct ExistingItem
+    {
+        juce::ValueTree tree;
+        juce::int64 modifiedTime;
+        int libId;
+    };
+
+    juce::HashMap<int, ExistingItem> existingItems;
+    juce::Array<juce::ValueTree> tracksToAdd, tracksToUpdate, updatedTracks;
+    TrackDetails currentTrack;
 
     int numAdded;
     bool finished;
 
+    //==============================================================================
+    static bool findTracksDictionary (PlistTokeniser& tokeniser);
+    static void readTrackDetails (PlistTokeniser& tokeniser, TrackDetails& details);
+    static juce::int64 readModifiedTime (PlistTokeniser& tokeniser);
+    void findExistingItems();
+    void processTrack (int trackId, PlistTokeniser& tokeniser);
+    juce::ValueTree createTrackTree (int trackId, const TrackDetails& details);
+    void addPendingTracks();
+
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ITunesLibraryParser)
 };
@@ -44,6 +44,9 @@
 
         // as pointer goes out of scope the lock will be released
     @endcode
+
+    This shouldn't be used to share state with the audio thread as it may block,
+    use a TripleBuffer or SeqLock to publish snapshots of the state instead.
  */
 template<typename Type, typename LockType>
 class LockedPointer
@@ -0,0 +1,544 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+namespace MusicLibraryAnalyserHelpers
+{
+    /** How often files that couldn't be found are looked for again. */
+    static const int missingFileRetryMs = 60000;
+
+    //==============================================================================
+    /** Measures integrated loudness following ITU-R BS.1770.
+        The K-weighted power of each 400ms block is stored and then gated at the end.
+    */
+    class LoudnessMeter
+    {
+    public:
+        LoudnessMeter (double sampleRate, int numChannels, int maxBlockSize)
+            : filtered (numChannels, maxBlockSize),
+              samplesPerBlock (jmax (1, roundToInt (sampleRate * 0.4))),
+              blockPower (0.0),
+              numSamplesInBlock (0)
+        {
+            const IIRCoefficients shelf (IIRCoefficients::makeHighShelf (sampleRate, 1500.0, 1.0 / MathConstants<double>::sqrt2,
+                                                                         Decibels::decibelsToGain (4.0f)));
+            const IIRCoefficients highPass (IIRCoefficients::makeHighPass (sampleRate, 38.0, 0.5));
+
+            for (int i = 0; i < numChannels; ++i)
+            {
+                shelfFilters.add (new IIRFilter())->setCoefficients (shelf);
+                highPassFilters.add (new IIRFilter())->setCoefficients (highPass);
+            }
+        }
+
+        void process (const AudioBuffer<float>& buffer, int numSamples)
+        {
+            const int numChannels = filtered.getNumChannels();
+
+            for (int c = 0; c < numChannels; ++c)
+            {
+                filtered.copyFrom (c, 0, buffer, c, 0, numSamples);
+                shelfFilters.getUnchecked (c)->processSamples (filtered.getWritePointer (c), numSamples);
+                highPassFilters.getUnchecked (c)->processSamples (filtered.getWritePointer (c), numSamples);
+            }
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                for (int c = 0; c < numChannels; ++c)
+                    blockPower += square ((double) filtered.getSample (c, i));
+
+                if (++numSamplesInBlock == samplesPerBlock)
+                {
+                    blockPowers.add (blockPower / samplesPerBlock);
+                    blockPower = 0.0;
+                    numSamplesInBlock = 0;
+                }
+            }
+        }
+
+        double getIntegratedLoudness() const
+        {
+            const double absoluteGate = getPowerForLoudness (-70.0);
+            const double relativeGate = getPowerForLoudness (getLoudnessForPower (getMeanPower (absoluteGate)) - 10.0);
+
+            return jmax (-70.0, getLoudnessForPower (getMeanPower (jmax (absoluteGate, relativeGate))));
+        }
+
+    private:
+        AudioBuffer<float> filtered;
+        OwnedArray<IIRFilter> shelfFilters, highPassFilters;
+        const int samplesPerBlock;
+        double blockPower;
+        int numSamplesInBlock;
+        Array<double> blockPowers;
+
+        double getMeanPower (double gate) const
+        {
+            double total = 0.0;
+            int numBlocks = 0;
+
+            for (auto power : blockPowers)
+            {
+                if (power > gate)
+                {
+                    total += power;
+                    ++numBlocks;
+                }
+            }
+
+            return numBlocks > 0 ? total / numBlocks : 0.0;
+        }
+
+        static double getLoudnessForPower (double power)    { return power > 0.0 ? -0.691 + 10.0 * std::log10 (power) : -70.0; }
+        static double getPowerForLoudness (double loudness) { return std::pow (10.0, (loudness + 0.691) / 10.0); }
+
+        JUCE_DECLARE_NON_COPYABLE (LoudnessMeter)
+    };
+
+   #if DROWAUDIO_USE_FFTREAL || DROWAUDIO_USE_VDSP
+    /** Averages the spectrum of a whole file and reduces it to a few log spaced bands. */
+    class SpectrumAccumulator
+    {
+    public:
+        SpectrumAccumulator()
+            : fftEngine (11),
+              fftSize (fftEngine.getFFTSize()),
+              numBins (fftEngine.getFFTProperties().fftSizeHalved + 1),
+              frame ((size_t) fftSize),
+              fftBuffer ((size_t) fftSize),
+              magnitudeSums ((size_t) numBins, true),
+              numInFrame (0),
+              numFrames (0)
+        {
+        }
+
+        void process (const float* samples, int numSamples)
+        {
+            while (numSamples > 0)
+            {
+                const int numToCopy = jmin (numSamples, fftSize - numInFrame);
+                FloatVectorOperations::copy (frame + numInFrame, samples, numToCopy);
+                numInFrame += numToCopy;
+                samples += numToCopy;
+                numSamples -= numToCopy;
+
+                if (numInFrame == fftSize)
+                {
+                    FloatVectorOperations::copy (fftBuffer, frame, fftSize);
+                    fftEngine.performFFT (fftBuffer);
+                    fftEngine.findMagnitudes();
+
+                    Buffer& magnitudes (fftEngine.getMagnitudesBuffer());
+
+                    for (int i = 0; i < numBins; ++i)
+                        magnitudeSums[i] += magnitudes[i];
+
+                    ++numFrames;
+                    numInFrame = 0;
+                }
+            }
+        }
+
+        MemoryBlock getFingerprint (double sampleRate) const
+        {
+            MemoryBlock fingerprint;
+
+            if (numFrames == 0)
+                return fingerprint;
+
+            const int numBands = MusicLibraryAnalyser::numFingerprintBands;
+            const double lowestFrequency = 40.0;
+            const double highestFrequency = jmin (16000.0, sampleRate * 0.5);
+            const double binsPerHz = fftSize / sampleRate;
+
+            HeapBlock<double> bandLevels ((size_t) numBands);
+            double loudestBand = -200.0;
+
+            for (int b = 0; b < numBands; ++b)
+            {
+                const double bandStart = lowestFrequency * std::pow (highestFrequency / lowestFrequency, b / (double) numBands);
+                const double bandEnd = lowestFrequency * std::pow (highestFrequency / lowestFrequency, (b + 1) / (double) numBands);
+                const int firstBin = jlimit (0, numBins - 1, (int) (bandStart * binsPerHz));
+                const int lastBin = jlimit (firstBin + 1, numBins, (int) (bandEnd * binsPerHz));
+
+                double sum = 0.0;
+
+                for (int i = firstBin; i < lastBin; ++i)
+                    sum += magnitudeSums[i];
+
+                bandLevels[b] = 20.0 * std::log10 (sum / ((lastBin - firstBin) * (double) numFrames) + 1.0e-9);
+                loudestBand = jmax (loudestBand, bandLevels[b]);
+            }
+
+            // a 60dB range relative to the loudest band so the overall level doesn't matter
+            fingerprint.setSize ((size_t) numBands);
+
+            for (int b = 0; b < numBands; ++b)
+                fingerprint[b] = (char) jlimit (0, 255, roundToInt ((bandLevels[b] - loudestBand + 60.0) * 255.0 / 60.0));
+
+            return fingerprint;
+        }
+
+    private:
+        FFTEngine fftEngine;
+        const int fftSize, numBins;
+        HeapBlock<float> frame, fftBuffer;
+        HeapBlock<double> magnitudeSums;
+        int numInFrame, numFrames;
+
+        JUCE_DECLARE_NON_COPYABLE (SpectrumAccumulator)
+    };
+   #endif
+}
+
+//==============================================================================
+const int MusicLibraryAnalyser::analysisVersion = 1;
+
+const Identifier MusicLibraryAnalyser::versionProperty ("Version");
+const Identifier MusicLibraryAnalyser::modifiedProperty ("Modified");
+const Identifier MusicLibraryAnalyser::failedProperty ("Failed");
+const Identifier MusicLibraryAnalyser::bpmProperty ("BPM");
+const Identifier MusicLibraryAnalyser::loudnessProperty ("Loudness");
+const Identifier MusicLibraryAnalyser::fingerprintProperty ("Fingerprint");
+
+//==============================================================================
+MusicLibraryAnalyser::MusicLibraryAnalyser (ITunesLibrary& libraryToAnalyse)
+    : Thread ("MusicLibraryAnalyser"),
+      library (libraryToAnalyse),
+      cpuBudget (0.25f),
+      numItemsAnalysed (0),
+      nextPendingItem (0)
+{
+    formatManager.registerBasicFormats();
+    library.addListener (this);
+}
+
+MusicLibraryAnalyser::~MusicLibraryAnalyser()
+{
+    library.removeListener (this);
+    stop();
+    cancelPendingUpdate();
+}
+
+//==============================================================================
+void MusicLibraryAnalyser::start()
+{
+    if (isThreadRunning())
+        return;
+
+    numItemsAnalysed = 0;
+    findItemsToAnalyse();
+
+    startThread (Thread::Priority::background);
+}
+
+void MusicLibraryAnalyser::stop()
+{
+    signalThreadShouldExit();
+    notify();
+    stopThread (5000);
+}
+
+void MusicLibraryAnalyser::setCpuBudget (float proportionOfOneCore)
+{
+    cpuBudget = jlimit (0.01f, 1.0f, proportionOfOneCore);
+}
+
+//==============================================================================
+bool MusicLibraryAnalyser::analyseFile (AudioFormatManager& formatManager,
+                                        const File& audioFile, Analysis& result,
+                                        const std::function<bool()>& shouldExit)
+{
+    using namespace MusicLibraryAnalyserHelpers;
+
+    std::unique_ptr<AudioFormatReader> reader (formatManager.createReaderFor (audioFile));
+
+    if (reader == nullptr || reader->sampleRate <= 0.0 || reader->lengthInSamples <= 0)
+        return false;
+
+    const int numChannels = jlimit (1, 2, (int) reader->numChannels);
+    const int blockSize = 16384;
+
+    AudioBuffer<float> buffer (numChannels, blockSize);
+    HeapBlock<float> mono ((size_t) blockSize);
+    LoudnessMeter loudnessMeter (reader->sampleRate, numChannels, blockSize);
+
+   #if DROWAUDIO_USE_SOUNDTOUCH
+    soundtouch::BPMDetect bpmDetect (1, (int) reader->sampleRate);
+   #endif
+
+   #if DROWAUDIO_USE_FFTREAL || DROWAUDIO_USE_VDSP
+    SpectrumAccumulator spectrum;
+   #endif
+
+    for (int64 position = 0; position < reader->lengthInSamples; position += blockSize)
+    {
+        if (shouldExit != nullptr && shouldExit())
+            return false;
+
+        const int numSamples = (int) jmin ((int64) blockSize, reader->lengthInSamples - position);
+        reader->read (&buffer, 0, numSamples, position, true, numChannels > 1);
+
+        loudnessMeter.process (buffer, numSamples);
+
+        FloatVectorOperations::copy (mono, buffer.getReadPointer (0), numSamples);
+
+        if (numChannels > 1)
+        {
+            FloatVectorOperations::add (mono, buffer.getReadPointer (1), numSamples);
+            FloatVectorOperations::multiply (mono, 0.5f, numSamples);
+        }
+
+       #if DROWAUDIO_USE_FFTREAL || DROWAUDIO_USE_VDSP
+        spectrum.process (mono, numSamples);
+       #endif
+
+       #if DROWAUDIO_USE_SOUNDTOUCH
+        // this can change the samples so has to come last
+        bpmDetect.inputSamples (mono, numSamples);
+       #endif
+    }
+
+    result.loudness = loudnessMeter.getIntegratedLoudness();
+
+   #if DROWAUDIO_USE_SOUNDTOUCH
+    result.bpm = bpmDetect.getBpm();
+   #endif
+
+   #if DROWAUDIO_USE_FFTREAL || DROWAUDIO_USE_VDSP
+    result.fingerprint = spectrum.getFingerprint (reader->sampleRate);
+   #endif
+
+    return true;
+}
+
+bool MusicLibraryAnalyser::hasAnalysis (const ValueTree& item)
+{
+    const ValueTree analysis (item.getChildWithName (MusicColumns::libraryAnalysisIdentifier));
+
+    return analysis.isValid()
+            && (int) analysis[versionProperty] == analysisVersion
+            && analysis[modifiedProperty] == item[MusicColumns::columnNames[MusicColumns::Modified]];
+}
+
+MemoryBlock MusicLibraryAnalyser::getFingerprint (const ValueTree& item)
+{
+    MemoryBlock fingerprint;
+    const ValueTree analysis (item.getChildWithName (MusicColumns::libraryAnalysisIdentifier));
+
+    if (analysis.hasProperty (fingerprintProperty))
+        fingerprint.loadFromHexString (analysis[fingerprintProperty].toString());
+
+    return fingerprint;
+}
+
+//==============================================================================
+void MusicLibraryAnalyser::findItemsToAnalyse()
+{
+    // this is the only time the whole tree is scanned, items are then looked up by LibID
+    Array<PendingItem> newPendingItems;
+    itemsByLibId.clear();
+
+    {
+        const ScopedLock sl (library.getParserLock());
+        const ValueTree libraryTree (library.getLibraryTree());
+        const int numItems = libraryTree.getNumChildren();
+
+        itemsByLibId.reserve ((size_t) numItems);
+
+        for (int i = 0; i < numItems; ++i)
+        {
+            const ValueTree item (libraryTree.getChild (i));
+            const int libId = item[MusicColumns::columnNames[MusicColumns::LibID]];
+
+            itemsByLibId[libId] = item;
+
+            if (! hasAnalysis (item))
+                newPendingItems.add ({ libId,
+                                       item[MusicColumns::columnNames[MusicColumns::Modified]],
+                                       item[MusicColumns::columnNames[MusicColumns::Location]].toString() });
+        }
+    }
+
+    {
+        const ScopedLock sl (pendingLock);
+        pendingItems.swapWith (newPendingItems);
+        missingItems.clearQuick();
+        nextPendingItem = 0;
+    }
+
+    notify();
+}
+
+bool MusicLibraryAnalyser::getNextItem (PendingItem& item)
+{
+    const ScopedLock sl (pendingLock);
+
+    if (nextPendingItem >= pendingItems.size())
+        return false;
+
+    item = pendingItems.getReference (nextPendingItem++);
+
+    return true;
+}
+
+void MusicLibraryAnalyser::retryMissingItems()
+{
+    const ScopedLock sl (pendingLock);
+
+    if (nextPendingItem < pendingItems.size() || missingItems.isEmpty())
+        return;
+
+    pendingItems.swapWith (missingItems);
+    missingItems.clearQuick();
+    nextPendingItem = 0;
+}
+
+void MusicLibraryAnalyser::addResult (const Result& result)
+{
+    {
+        const ScopedLock sl (resultsLock);
+        results.add (result);
+    }
+
+    triggerAsyncUpdate();
+}
+
+void MusicLibraryAnalyser::run()
+{
+    double lastCheckTime = Time::getMillisecondCounterHiRes();
+
+    // keeps the analysis within the CPU budget by sleeping in proportion to the time spent working
+    auto throttle = [this, &lastCheckTime]
+    {
+        const double busyTime = Time::getMillisecondCounterHiRes() - lastCheckTime;
+        const double budget = cpuBudget.get();
+        const int idleTime = roundToInt (busyTime * (1.0 - budget) / budget);
+
+        if (idleTime > 0)
+            wait (idleTime);
+
+        lastCheckTime = Time::getMillisecondCounterHiRes();
+
+        return threadShouldExit();
+    };
+
+    while (! threadShouldExit())
+    {
+        PendingItem item;
+
+        if (! getNextItem (item))
+        {
+            // new items will be found when the library is reloaded, which will wake us up
+            wait (MusicLibraryAnalyserHelpers::missingFileRetryMs);
+            retryMissingItems();
+            continue;
+        }
+
+        const File file (File::isAbsolutePath (item.location) ? File (item.location) : File());
+
+        // the file may be on a drive that isn't connected so try it again later
+        if (! file.existsAsFile())
+        {
+            const ScopedLock sl (pendingLock);
+            missingItems.add (item);
+            continue;
+        }
+
+        Result result;
+        result.libId = item.libId;
+        result.modified = item.modified;
+
+        lastCheckTime = Time::getMillisecondCounterHiRes();
+        result.succeeded = analyseFile (formatManager, file, result.analysis, throttle);
+
+        if (threadShouldExit())
+            break;
+
+        addResult (result);
+    }
+}
+
+void MusicLibraryAnalyser::handleAsyncUpdate()
+{
+    Array<Result> newResults;
+
+    {
+        const ScopedLock sl (resultsLock);
+        newResults.swapWith (results);
+    }
+
+    {
+        const ScopedLock sl (library.getParserLock());
+        ValueTree libraryTree (library.getLibraryTree());
+        const Identifier& bpmColumn (MusicColumns::columnNames[MusicColumns::BPM]);
+
+        for (auto& result : newResults)
+        {
+            const auto found = itemsByLibId.find (result.libId);
+
+            // the item may have been removed or the library replaced since it was analysed
+            if (found == itemsByLibId.end() || found->second.getParent() != libraryTree)
+                continue;
+
+            ValueTree item (found->second);
+
+            ValueTree analysis (item.getOrCreateChildWithName (MusicColumns::libraryAnalysisIdentifier, nullptr));
+            analysis.setProperty (versionProperty, analysisVersion, nullptr);
+            analysis.setProperty (modifiedProperty, result.modified, nullptr);
+
+            if (result.succeeded)
+            {
+                analysis.removeProperty (failedProperty, nullptr);
+                analysis.setProperty (bpmProperty, result.analysis.bpm, nullptr);
+                analysis.setProperty (loudnessProperty, result.analysis.loudness, nullptr);
+                analysis.setProperty (fingerprintProperty, String::toHexString (result.analysis.fingerprint.getData(),
+                                                                                (int) result.analysis.fingerprint.getSize(), 0),
+                                      nullptr);
+
+                if (result.analysis.bpm > 0.0 && (int) item[bpmColumn] <= 0)
+                    item.setProperty (bpmColumn, roundToInt (result.analysis.bpm), nullptr);
+            }
+            else
+            {
+                analysis.setProperty (failedProperty, true, nullptr);
+            }
+
+            ++numItemsAnalysed;
+        }
+    }
+}
+
+void MusicLibraryAnalyser::libraryFinished (ITunesLibrary* changedLibrary)
+{
+    // pick up any items that are new or have changed
+    if (changedLibrary == &library && isThreadRunning())
+        findItemsToAnalyse();
+}
@@ -0,0 +1,194 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef DROWAUDIO_MUSICLIBRARYANALYSER_H
+#define DROWAUDIO_MUSICLIBRARYANALYSER_H
+
+#include "dRowAudio_ITunesLibrary.h"
+
+#if DROWAUDIO_USE_SOUNDTOUCH
+} // namespace drow
+
+#include "../audio/soundtouch/BPMDetect.h"
+
+namespace drow
+{
+#endif
+
+//==============================================================================
+/** Analyses the audio files in an ITunesLibrary on a low priority background thread.
+
+    Each item in the library that hasn't been analysed yet has its file decoded
+    once to find its BPM, integrated loudness and a spectral fingerprint. The
+    results are stored in an ANALYSIS child tree of the item, alongside any cue
+    or loop trees, and the item's BPM is filled in if iTunes didn't have one.
+
+    As the results are kept in the library tree, they'll be saved along with it
+    (e.g. with ITunesLibrary::setSnapshotFile()) and analysis will carry on where
+    it left off the next time the library is loaded. Items are analysed again if
+    their Modified date changes. The items to analyse are found when analysis
+    starts and whenever the library finishes loading, and files that can't be
+    found are tried again every so often in case they're on a drive that isn't
+    connected.
+
+    To avoid getting in the way of anything else the analysis is limited to a
+    proportion of the time of one CPU core, see setCpuBudget().
+
+    @code
+        MusicLibraryAnalyser analyser (*ITunesLibrary::getInstance());
+        analyser.setCpuBudget (0.25f);
+        analyser.start();
+    @endcode
+*/
+class MusicLibraryAnalyser : private juce::Thread,
+                             private juce::AsyncUpdater,
+                             private ITunesLibrary::Listener
+{
+public:
+    //==============================================================================
+    /** Creates an analyser for a library.
+        This won't start analysing until start() is called. The library must
+        outlive the analyser.
+    */
+    explicit MusicLibraryAnalyser (ITunesLibrary& libraryToAnalyse);
+
+    /** Destructor. */
+    ~MusicLibraryAnalyser() override;
+
+    //==============================================================================
+    /** Starts analysing any items that need it. */
+    void start();
+
+    /** Stops analysing, an item being analysed will be started again next time. */
+    void stop();
+
+    /** Sets the proportion of one CPU core the analysis can use, from 0.01 to 1.0.
+        The default is 0.25.
+    */
+    void setCpuBudget (float proportionOfOneCore);
+
+    /** Returns the current CPU budget. */
+    float getCpuBudget() const noexcept                 { return cpuBudget.get(); }
+
+    /** Returns the number of items that have been analysed since start() was called. */
+    int getNumItemsAnalysed() const noexcept            { return numItemsAnalysed.get(); }
+
+    //==============================================================================
+    /** The results of analysing a file. */
+    struct Analysis
+    {
+        /** The tempo in beats per minute, or 0 if it couldn't be found. */
+        double bpm = 0.0;
+
+        /** The integrated loudness in LUFS. */
+        double loudness = -70.0;
+
+        /** The average level of the file in numFingerprintBands logarithmically
+            spaced bands, scaled from 0 to 255 relative to the loudest band.
+        */
+        juce::MemoryBlock fingerprint;
+    };
+
+    /** Decodes a file and analyses it, using a format manager to create its reader.
+        This can take some time so the shouldExit function is called periodically
+        and the analysis abandoned if it returns true.
+    */
+    static bool analyseFile (juce::AudioFormatManager& formatManager,
+                             const juce::File& audioFile, Analysis& result,
+                             const std::function<bool()>& shouldExit = nullptr);
+
+    /** Returns true if an item has an up to date analysis. */
+    static bool hasAnalysis (const juce::ValueTree& item);
+
+    /** Returns the fingerprint stored in an item's analysis, or an empty block if there isn't one. */
+    static juce::MemoryBlock getFingerprint (const juce::ValueTree& item);
+
+    /** The number of bands in a fingerprint. */
+    enum { numFingerprintBands = 32 };
+
+    /** This is increased whenever the analysis changes so items get analysed again. */
+    static const int analysisVersion;
+
+    /** Properties of the ANALYSIS tree. */
+    static const juce::Identifier versionProperty, modifiedProperty, failedProperty,
+                                  bpmProperty, loudnessProperty, fingerprintProperty;
+
+private:
+    //==============================================================================
+    struct PendingItem
+    {
+        int libId;
+        juce::var modified;
+        juce::String location;
+    };
+
+    struct Result
+    {
+        int libId;
+        juce::var modified;
+        bool succeeded;
+        Analysis analysis;
+    };
+
+    ITunesLibrary& library;
+    juce::AudioFormatManager formatManager;
+    juce::Atomic<float> cpuBudget;
+    juce::Atomic<int> numItemsAnalysed;
+
+    std::unordered_map<int, juce::ValueTree> itemsByLibId;
+
+    juce::CriticalSection pendingLock;
+    juce::Array<PendingItem> pendingItems, missingItems;
+    int nextPendingItem;
+
+    juce::CriticalSection resultsLock;
+    juce::Array<Result> results;
+
+    //==============================================================================
+    void findItemsToAnalyse();
+    bool getNextItem (PendingItem& item);
+    void retryMissingItems();
+    void addResult (const Result& result);
+
+    /** @internal */
+    void run() override;
+    /** @internal */
+    void handleAsyncUpdate() override;
+    /** @internal */
+    void libraryUpdated (ITunesLibrary*) override {}
+    /** @internal */
+    void libraryFinished (ITunesLibrary*) override;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MusicLibraryAnalyser)
+};
+
+#endif // DROWAUDIO_MUSICLIBRARYANALYSER_H
@@ -0,0 +1,662 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+namespace MusicLibraryDuplicateFinderHelpers
+{
+    enum
+    {
+        numHashBands = 8,
+        bitsPerHashBand = 8,
+        numHashBits = numHashBands * bitsPerHashBand,
+        maxBucketComparisons = 1000
+    };
+
+    const float minVerifiedSimilarity = 0.8f;
+
+    /** Random hyperplanes, the same every time so buckets are repeatable. */
+    struct Hyperplanes
+    {
+        Hyperplanes()
+        {
+            Random random (0x64526f77);
+
+            for (auto& plane : planes)
+                for (auto& v : plane)
+                    v = random.nextFloat() * 2.0f - 1.0f;
+        }
+
+        float planes[numHashBits][MusicLibraryAnalyser::numFingerprintBands];
+    };
+
+    /** Returns one bit per hyperplane for which side of it the fingerprint lies.
+        The fingerprint is centred first so the overall tilt of the spectrum
+        counts rather than its level.
+    */
+    static uint64 getSignature (const Hyperplanes& hyperplanes, const MemoryBlock& fingerprint)
+    {
+        const int numBands = MusicLibraryAnalyser::numFingerprintBands;
+        const uint8* bytes = static_cast<const uint8*> (fingerprint.getData());
+        float centred[MusicLibraryAnalyser::numFingerprintBands];
+        float mean = 0.0f;
+
+        for (int b = 0; b < numBands; ++b)
+            mean += bytes[b];
+
+        mean /= numBands;
+
+        for (int b = 0; b < numBands; ++b)
+            centred[b] = bytes[b] - mean;
+
+        uint64 signature = 0;
+
+        for (int h = 0; h < numHashBits; ++h)
+        {
+            float dot = 0.0f;
+
+            for (int b = 0; b < numBands; ++b)
+                dot += centred[b] * hyperplanes.planes[h][b];
+
+            if (dot >= 0.0f)
+                signature |= ((uint64) 1 << h);
+        }
+
+        return signature;
+    }
+
+    static uint64 getBucketKey (int hashBand, uint64 signature, int64 lengthBin)
+    {
+        const uint64 bits = (signature >> (hashBand * bitsPerHashBand)) & ((1 << bitsPerHashBand) - 1);
+
+        return ((uint64) hashBand << 56) | (bits << 40) | ((uint64) lengthBin & 0xffffffffff);
+    }
+
+    //==============================================================================
+    /** Reads the log RMS level of a section of a file in 50ms frames. */
+    static Array<float> getLoudnessEnvelope (AudioFormatReader& reader, double startTime, int numFrames)
+    {
+        const int framesPerSecond = 20;
+        const int samplesPerFrame = jmax (1, roundToInt (reader.sampleRate / framesPerSecond));
+        const int numChannels = jlimit (1, 2, (int) reader.numChannels);
+
+        AudioBuffer<float> buffer (numChannels, samplesPerFrame * numFrames);
+        reader.read (&buffer, 0, buffer.getNumSamples(), (int64) (startTime * reader.sampleRate), true, numChannels > 1);
+
+        Array<float> envelope;
+        envelope.ensureStorageAllocated (numFrames);
+
+        for (int f = 0; f < numFrames; ++f)
+        {
+            float rms = 0.0f;
+
+            for (int c = 0; c < numChannels; ++c)
+                rms += buffer.getRMSLevel (c, f * samplesPerFrame, samplesPerFrame);
+
+            envelope.add (std::log10 (rms / numChannels + 1.0e-5f));
+        }
+
+        return envelope;
+    }
+
+    /** Returns the highest correlation of a short envelope at any offset within a longer one. */
+    static float getBestCorrelation (const Array<float>& shortEnvelope, const Array<float>& longEnvelope)
+    {
+        const int length = shortEnvelope.size();
+        float best = 0.0f;
+
+        for (int offset = 0; offset + length <= longEnvelope.size(); ++offset)
+        {
+            double sumA = 0.0, sumB = 0.0, sumAA = 0.0, sumBB = 0.0, sumAB = 0.0;
+
+            for (int i = 0; i < length; ++i)
+            {
+                const double a = shortEnvelope.getUnchecked (i);
+                const double b = longEnvelope.getUnchecked (offset + i);
+                sumA += a;
+                sumB += b;
+                sumAA += a * a;
+                sumBB += b * b;
+                sumAB += a * b;
+            }
+
+            const double covariance = sumAB - sumA * sumB / length;
+            const double variance = (sumAA - sumA * sumA / length) * (sumBB - sumB * sumB / length);
+
+            if (variance > 1.0e-12)
+                best = jmax (best, (float) (covariance / std::sqrt (variance)));
+        }
+
+        return best;
+    }
+}
+
+//==============================================================================
+MusicLibraryDuplicateFinder::MusicLibraryDuplicateFinder (ITunesLibrary& libraryToSearch)
+    : Thread ("MusicLibraryDuplicateFinder"),
+      library (libraryToSearch),
+      verifyCandidates (true),
+      maxFingerprintDifference (1.5f),
+      maxLengthDifference (2.0),
+      numCandidates (0)
+{
+    formatManager.registerBasicFormats();
+}
+
+MusicLibraryDuplicateFinder::~MusicLibraryDuplicateFinder()
+{
+    stop();
+    cancelPendingUpdate();
+}
+
+//==============================================================================
+void MusicLibraryDuplicateFinder::start()
+{
+    stop();
+    startThread (Thread::Priority::low);
+}
+
+void MusicLibraryDuplicateFinder::stop()
+{
+    stopThread (10000);
+}
+
+void MusicLibraryDuplicateFinder::setCandidateTolerances (float maxFingerprintDifferenceDb,
+                                                          double maxLengthDifferenceSeconds) noexcept
+{
+    maxFingerprintDifference = jmax (0.0f, maxFingerprintDifferenceDb);
+    maxLengthDifference = jmax (0.0, maxLengthDifferenceSeconds);
+}
+
+Array<Array<int>> MusicLibraryDuplicateFinder::getDuplicateGroups() const
+{
+    const ScopedLock sl (groupsLock);
+    return duplicateGroups;
+}
+
+//==============================================================================
+float MusicLibraryDuplicateFinder::getFingerprintDifference (const MemoryBlock& first, const MemoryBlock& second)
+{
+    if (first.getSize() != second.getSize() || first.isEmpty())
+        return -1.0f;
+
+    const uint8* a = static_cast<const uint8*> (first.getData());
+    const uint8* b = static_cast<const uint8*> (second.getData());
+    int sum = 0;
+
+    for (size_t i = 0; i < first.getSize(); ++i)
+        sum += std::abs ((int) a[i] - (int) b[i]);
+
+    // the bands of a fingerprint cover 60dB in 255 steps
+    return sum * (60.0f / 255.0f) / (float) first.getSize();
+}
+
+float MusicLibraryDuplicateFinder::compareFiles (AudioFormatManager& formatManager,
+                                                 const File& first, const File& second,
+                                                 const std::function<bool()>& shouldExit)
+{
+    using namespace MusicLibraryDuplicateFinderHelpers;
+
+    std::unique_ptr<AudioFormatReader> firstReader (formatManager.createReaderFor (first));
+    std::unique_ptr<AudioFormatReader> secondReader (formatManager.createReaderFor (second));
+
+    if (firstReader == nullptr || secondReader == nullptr
+        || firstReader->sampleRate <= 0.0 || secondReader->sampleRate <= 0.0)
+        return 0.0f;
+
+    // 6s sections of the first file are looked for within 10s of the second to
+    // allow for encoders adding or trimming silence at the start
+    const int sectionFrames = 120;
+    const int searchFrames = 40;
+    const double searchSeconds = searchFrames / 20.0;
+    const double firstLength = firstReader->lengthInSamples / firstReader->sampleRate;
+    const double sectionPositions[] = { 0.25, 0.5, 0.75 };
+
+    float totalSimilarity = 0.0f;
+
+    for (double position : sectionPositions)
+    {
+        if (shouldExit != nullptr && shouldExit())
+            return 0.0f;
+
+        const double startTime = firstLength * position - 3.0;
+
+        const Array<float> firstEnvelope (getLoudnessEnvelope (*firstReader, startTime, sectionFrames));
+        const Array<float> secondEnvelope (getLoudnessEnvelope (*secondReader, startTime - searchSeconds,
+                                                                sectionFrames + 2 * searchFrames));
+
+        totalSimilarity += getBestCorrelation (firstEnvelope, secondEnvelope);
+    }
+
+    return totalSimilarity / (float) numElementsInArray (sectionPositions);
+}
+
+//==============================================================================
+Array<MusicLibraryDuplicateFinder::Item> MusicLibraryDuplicateFinder::getAnalysedItems()
+{
+    Array<Item> items;
+
+    const ScopedLock sl (library.getParserLock());
+    const ValueTree libraryTree (library.getLibraryTree());
+    items.ensureStorageAllocated (libraryTree.getNumChildren());
+
+    for (int i = 0; i < libraryTree.getNumChildren(); ++i)
+    {
+        const ValueTree item (libraryTree.getChild (i));
+
+        if (! MusicLibraryAnalyser::hasAnalysis (item))
+            continue;
+
+        Item newItem;
+        newItem.fingerprint = MusicLibraryAnalyser::getFingerprint (item);
+
+        if (newItem.fingerprint.getSize() != (size_t) MusicLibraryAnalyser::numFingerprintBands)
+            continue;
+
+        newItem.libId = item[MusicColumns::columnNames[MusicColumns::LibID]];
+        newItem.lengthSeconds = (double) item[MusicColumns::columnNames[MusicColumns::Length]] / 1000.0;
+        newItem.location = item[MusicColumns::columnNames[MusicColumns::Location]].toString();
+        items.add (newItem);
+    }
+
+    return items;
+}
+
+Array<MusicLibraryDuplicateFinder::Candidate> MusicLibraryDuplicateFinder::findCandidates (const Array<Item>& items)
+{
+    using namespace MusicLibraryDuplicateFinderHelpers;
+
+    const Hyperplanes hyperplanes;
+    const float maxDifference = maxFingerprintDifference.load();
+    const double maxLength = maxLengthDifference.load();
+
+    // items within the length tolerance are always in the same or a neighbouring bin
+    const double lengthBinSize = jmax (1.0, maxLength);
+
+    std::unordered_map<uint64, std::vector<int>> buckets;
+    std::unordered_set<int> compared;
+    Array<Candidate> candidates;
+
+    for (int i = 0; i < items.size(); ++i)
+    {
+        if ((i & 1023) == 0 && threadShouldExit())
+            return {};
+
+        const Item& item = items.getReference (i);
+        const uint64 signature = getSignature (hyperplanes, item.fingerprint);
+        const int64 lengthBin = (int64) std::floor (item.lengthSeconds / lengthBinSize);
+
+        compared.clear();
+
+        // only the items before this one are in the buckets so each pair is found once
+        for (int band = 0; band < numHashBands; ++band)
+        {
+            for (int64 bin = lengthBin - 1; bin <= lengthBin + 1; ++bin)
+            {
+                auto found = buckets.find (getBucketKey (band, signature, bin));
+
+                if (found == buckets.end())
+                    continue;
+
+                const std::vector<int>& bucket = found->second;
+                const size_t firstToCompare = bucket.size() > (size_t) maxBucketComparisons
+                                                ? bucket.size() - (size_t) maxBucketComparisons : 0;
+
+                for (size_t j = firstToCompare; j < bucket.size(); ++j)
+                {
+                    const int other = bucket[j];
+
+                    if (! compared.insert (other).second)
+                        continue;
+
+                    const Item& otherItem = items.getReference (other);
+
+                    if (std::abs (item.lengthSeconds - otherItem.lengthSeconds) > maxLength)
+                        continue;
+
+                    const float difference = getFingerprintDifference (item.fingerprint, otherItem.fingerprint);
+
+                    if (difference >= 0.0f && difference <= maxDifference)
+                        candidates.add ({ other, i });
+                }
+            }
+        }
+
+        for (int band = 0; band < numHashBands; ++band)
+            buckets[getBucketKey (band, signature, lengthBin)].push_back (i);
+    }
+
+    return candidates;
+}
+
+Array<MusicLibraryDuplicateFinder::Candidate> MusicLibraryDuplicateFinder::verify (const Array<Item>& items,
+                                                                                  const Array<Candidate>& candidates)
+{
+    using namespace MusicLibraryDuplicateFinderHelpers;
+
+    CriticalSection verifiedLock;
+    Array<Candidate> verified;
+    std::atomic<int> nextCandidate (0);
+
+    auto shouldExit = [this] { return threadShouldExit(); };
+
+    auto verifyNext = [&]
+    {
+        for (;;)
+        {
+            const int index = nextCandidate++;
+
+            if (index >= candidates.size() || shouldExit())
+                return;
+
+            const Candidate& candidate = candidates.getReference (index);
+            const String& firstLocation = items.getReference (candidate.first).location;
+            const String& secondLocation = items.getReference (candidate.second).location;
+
+            if (! File::isAbsolutePath (firstLocation) || ! File::isAbsolutePath (secondLocation))
+                continue;
+
+            if (compareFiles (formatManager, File (firstLocation), File (secondLocation), shouldExit) >= minVerifiedSimilarity)
+            {
+                const ScopedLock sl (verifiedLock);
+                verified.add (candidate);
+            }
+        }
+    };
+
+    {
+        const int numThreads = jmax (1, SystemStats::getNumCpus());
+        ThreadPool pool (numThreads);
+
+        for (int i = 0; i < numThreads; ++i)
+            pool.addJob (verifyNext);
+
+        while (pool.getNumJobs() > 0)
+            wait (50);
+    }
+
+    return verified;
+}
+
+Array<Array<int>> MusicLibraryDuplicateFinder::groupDuplicates (const Array<Item>& items,
+                                                                const Array<Candidate>& duplicates)
+{
+    // a union-find so items that match each other through a third are in the same group
+    std::vector<int> parents ((size_t) items.size());
+
+    for (size_t i = 0; i < parents.size(); ++i)
+        parents[i] = (int) i;
+
+    auto findRoot = [&parents] (int i)
+    {
+        while (parents[(size_t) i] != i)
+        {
+            parents[(size_t) i] = parents[(size_t) parents[(size_t) i]];
+            i = parents[(size_t) i];
+        }
+
+        return i;
+    };
+
+    for (auto& d : duplicates)
+    {
+        const int first = findRoot (d.first);
+        const int second = findRoot (d.second);
+
+        if (first != second)
+            parents[(size_t) jmax (first, second)] = jmin (first, second);
+    }
+
+    std::unordered_map<int, Array<int>> groupsByRoot;
+
+    for (auto& d : duplicates)
+    {
+        for (int index : { d.first, d.second })
+        {
+            Array<int>& group = groupsByRoot[findRoot (index)];
+            group.addIfNotAlreadyThere (items.getReference (index).libId);
+        }
+    }
+
+    Array<Array<int>> groups;
+
+    for (auto& g : groupsByRoot)
+    {
+        g.second.sort();
+        groups.add (g.second);
+    }
+
+    return groups;
+}
+
+//==============================================================================
+void MusicLibraryDuplicateFinder::run()
+{
+    const Array<Item> items (getAnalysedItems());
+    const Array<Candidate> candidates (findCandidates (items));
+    numCandidates = candidates.size();
+
+    if (threadShouldExit())
+        return;
+
+    const Array<Candidate> duplicates (verifyCandidates.load() ? verify (items, candidates) : candidates);
+
+    if (threadShouldExit())
+        return;
+
+    Array<Array<int>> groups (groupDuplicates (items, duplicates));
+
+    {
+        const ScopedLock sl (groupsLock);
+        duplicateGroups.swapWith (groups);
+    }
+
+    triggerAsyncUpdate();
+}
+
+void MusicLibraryDuplicateFinder::handleAsyncUpdate()
+{
+    listeners.call ([this] (Listener& l) { l.duplicateSearchFinished (this); });
+}
+
+//==============================================================================
+#if DROWAUDIO_UNIT_TESTS
+
+class MusicLibraryDuplicateFinderTests  : public UnitTest
+{
+public:
+    MusicLibraryDuplicateFinderTests() : UnitTest ("MusicLibraryDuplicateFinder") {}
+
+    void runTest() override
+    {
+        using namespace MusicLibraryDuplicateFinderHelpers;
+
+        Random random (0x1234);
+        MemoryBlock base ((size_t) MusicLibraryAnalyser::numFingerprintBands);
+
+        for (size_t i = 0; i < base.getSize(); ++i)
+            base[i] = (char) (20 + random.nextInt (180));
+
+        const MemoryBlock shifted5 (getShiftedFingerprint (base, 5));
+        const MemoryBlock shifted10 (getShiftedFingerprint (base, 10));
+
+        MemoryBlock different ((size_t) MusicLibraryAnalyser::numFingerprintBands);
+
+        for (size_t i = 0; i < different.getSize(); ++i)
+            different[i] = (char) (20 + random.nextInt (180));
+
+        beginTest ("SimHash bucketing");
+        {
+            const Hyperplanes hyperplanes;
+            const uint64 signature = getSignature (hyperplanes, base);
+
+            // fingerprints are centred so a change in level doesn't change the buckets
+            expect (getSignature (hyperplanes, shifted10) == signature);
+            expect (getSignature (hyperplanes, different) != signature);
+
+            expect (getBucketKey (0, signature, 10) == getBucketKey (0, signature, 10));
+            expect (getBucketKey (0, signature, 10) != getBucketKey (0, signature, 11));
+            expect (getBucketKey (0, signature, 10) != getBucketKey (1, signature, 10));
+        }
+
+        beginTest ("Fingerprint difference");
+        {
+            expectEquals (MusicLibraryDuplicateFinder::getFingerprintDifference (base, base), 0.0f);
+            expectWithinAbsoluteError (MusicLibraryDuplicateFinder::getFingerprintDifference (base, shifted5),
+                                       5.0f * 60.0f / 255.0f, 0.0001f);
+            expect (MusicLibraryDuplicateFinder::getFingerprintDifference (base, MemoryBlock (4, true)) < 0.0f);
+        }
+
+        beginTest ("Grouping");
+        {
+            ITunesLibrary library;
+            ValueTree libraryTree (MusicColumns::libraryIdentifier);
+
+            // 1 and 3 are too far apart to be candidates but both match 2
+            libraryTree.appendChild (createItem (1, 200.0, base), nullptr);
+            libraryTree.appendChild (createItem (2, 200.5, shifted5), nullptr);
+            libraryTree.appendChild (createItem (3, 201.0, shifted10), nullptr);
+            libraryTree.appendChild (createItem (4, 200.0, different), nullptr);
+            libraryTree.appendChild (createItem (5, 260.0, base), nullptr);
+            library.setLibraryTree (libraryTree);
+
+            MusicLibraryDuplicateFinder finder (library);
+            finder.setVerifiesCandidates (false);
+
+            Array<Array<int>> groups (runSearch (finder));
+            expectEquals (finder.getNumCandidates(), 2);
+            expectEquals (groups.size(), 1);
+
+            if (groups.size() == 1)
+                expect (groups.getReference (0) == Array<int> (1, 2, 3));
+
+            // with a tighter tolerance none of them match
+            finder.setCandidateTolerances (1.0f, 2.0f);
+            groups = runSearch (finder);
+            expectEquals (finder.getNumCandidates(), 0);
+            expectEquals (groups.size(), 0);
+        }
+
+        beginTest ("Verification threshold");
+        {
+            const TemporaryFile tempDir;
+            const File dir (tempDir.getFile());
+            dir.createDirectory();
+
+            const File original (dir.getChildFile ("original.wav"));
+            const File quieterAndLater (dir.getChildFile ("copy.wav"));
+            const File otherRecording (dir.getChildFile ("other.wav"));
+
+            writeTestFile (original, 0x100, 1.0f, 0.0);
+            writeTestFile (quieterAndLater, 0x100, 0.5f, 0.3);
+            writeTestFile (otherRecording, 0x200, 1.0f, 0.0);
+
+            AudioFormatManager formatManager;
+            formatManager.registerBasicFormats();
+
+            expect (MusicLibraryDuplicateFinder::compareFiles (formatManager, original, quieterAndLater) >= minVerifiedSimilarity);
+            expect (MusicLibraryDuplicateFinder::compareFiles (formatManager, original, otherRecording) < minVerifiedSimilarity);
+            expectEquals (MusicLibraryDuplicateFinder::compareFiles (formatManager, original, dir.getChildFile ("missing.wav")), 0.0f);
+        }
+    }
+
+private:
+    static MemoryBlock getShiftedFingerprint (const MemoryBlock& fingerprint, int amount)
+    {
+        MemoryBlock shifted (fingerprint);
+
+        for (size_t i = 0; i < shifted.getSize(); ++i)
+            shifted[i] = (char) jlimit (0, 255, (int) (uint8) fingerprint[i] + amount);
+
+        return shifted;
+    }
+
+    static ValueTree createItem (int libId, double lengthSeconds, const MemoryBlock& fingerprint)
+    {
+        const var modified ((int64) 1000);
+
+        ValueTree item (MusicColumns::libraryItemIdentifier);
+        item.setProperty (MusicColumns::columnNames[MusicColumns::LibID], libId, nullptr);
+        item.setProperty (MusicColumns::columnNames[MusicColumns::Length], lengthSeconds * 1000.0, nullptr);
+        item.setProperty (MusicColumns::columnNames[MusicColumns::Modified], modified, nullptr);
+
+        ValueTree analysis (MusicColumns::libraryAnalysisIdentifier);
+        analysis.setProperty (MusicLibraryAnalyser::versionProperty, MusicLibraryAnalyser::analysisVersion, nullptr);
+        analysis.setProperty (MusicLibraryAnalyser::modifiedProperty, modified, nullptr);
+        analysis.setProperty (MusicLibraryAnalyser::fingerprintProperty,
+                              String::toHexString (fingerprint.getData(), (int) fingerprint.getSize(), 0), nullptr);
+        item.appendChild (analysis, nullptr);
+
+        return item;
+    }
+
+    Array<Array<int>> runSearch (MusicLibraryDuplicateFinder& finder)
+    {
+        finder.start();
+
+        for (int i = 0; i < 500 && finder.isSearching(); ++i)
+            Thread::sleep (10);
+
+        expect (! finder.isSearching(), "search didn't finish");
+
+        return finder.getDuplicateGroups();
+    }
+
+    /** Writes 20s of noise with a random envelope that changes every 250ms. */
+    static void writeTestFile (const File& file, int64 envelopeSeed, float gain, double offsetSeconds)
+    {
+        const double sampleRate = 8000.0;
+        const int numSamples = (int) (20.0 * sampleRate);
+        const int offset = roundToInt (offsetSeconds * sampleRate);
+        const int samplesPerSegment = roundToInt (0.25 * sampleRate);
+
+        AudioBuffer<float> buffer (1, numSamples + offset);
+        buffer.clear();
+
+        Random envelopeRandom (envelopeSeed), noiseRandom (0x5678);
+        float level = 0.0f;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            if (i % samplesPerSegment == 0)
+                level = 0.05f + 0.9f * envelopeRandom.nextFloat();
+
+            buffer.setSample (0, offset + i, gain * level * (noiseRandom.nextFloat() * 2.0f - 1.0f));
+        }
+
+        WavAudioFormat wav;
+        std::unique_ptr<AudioFormatWriter> writer (wav.createWriterFor (new FileOutputStream (file),
+                                                                        sampleRate, 1, 16, StringPairArray(), 0));
+        writer->writeFromAudioSampleBuffer (buffer, 0, buffer.getNumSamples());
+    }
+};
+
+static MusicLibraryDuplicateFinderTests musicLibraryDuplicateFinderTests;
+
+#endif // DROWAUDIO_UNIT_TESTS
@@ -0,0 +1,184 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef DROWAUDIO_MUSICLIBRARYDUPLICATEFINDER_H
+#define DROWAUDIO_MUSICLIBRARYDUPLICATEFINDER_H
+
+#include "dRowAudio_MusicLibraryAnalyser.h"
+
+//==============================================================================
+/** Finds items in an ITunesLibrary that are likely to be the same recording,
+    e.g. the same track encoded at different bitrates or stored in two places.
+
+    This uses the spectral fingerprints the MusicLibraryAnalyser stores with
+    each item, so only items that have been analysed can be found. Rather than
+    comparing every pair of items the fingerprints are hashed into buckets with
+    random hyperplanes (SimHash) so only items that share a bucket and have a
+    similar length are compared. Those with close fingerprints are the candidates.
+
+    Candidates can then be verified by decoding a few short sections of both
+    files and comparing their loudness envelopes. This is done on a pool of
+    threads, one per CPU core, as it's the slowest part of the search.
+
+    @code
+        MusicLibraryDuplicateFinder finder (*ITunesLibrary::getInstance());
+        finder.addListener (this);
+        finder.start();
+
+        // in duplicateSearchFinished()
+        for (auto& group : finder.getDuplicateGroups())
+            DBG (group.size() << " copies of item " << group[0]);
+    @endcode
+
+    @see MusicLibraryAnalyser
+*/
+class MusicLibraryDuplicateFinder : private juce::Thread,
+                                    private juce::AsyncUpdater
+{
+public:
+    //==============================================================================
+    /** Creates a finder for a library.
+        This won't start searching until start() is called. The library must
+        outlive the finder.
+    */
+    explicit MusicLibraryDuplicateFinder (ITunesLibrary& libraryToSearch);
+
+    /** Destructor. */
+    ~MusicLibraryDuplicateFinder() override;
+
+    //==============================================================================
+    /** Starts searching the library, stopping any search in progress first. */
+    void start();
+
+    /** Stops searching. */
+    void stop();
+
+    /** Returns true while a search is in progress. */
+    bool isSearching() const                                { return isThreadRunning(); }
+
+    //==============================================================================
+    /** Sets whether candidates should be verified by decoding their files.
+        If this is off, candidates found from their fingerprints alone are
+        returned, which is much quicker but less certain. The default is on.
+    */
+    void setVerifiesCandidates (bool shouldVerify) noexcept     { verifyCandidates = shouldVerify; }
+
+    /** Sets how close two items need to be to be candidates.
+        @param maxFingerprintDifferenceDb   the largest mean difference between the
+                                            bands of the fingerprints, the default is 1.5dB
+        @param maxLengthDifferenceSeconds   the largest difference in length, the default is 2s
+    */
+    void setCandidateTolerances (float maxFingerprintDifferenceDb, double maxLengthDifferenceSeconds) noexcept;
+
+    //==============================================================================
+    /** Returns the groups of duplicates found by the last search.
+        Each group is a list of LibIDs, sorted in ascending order.
+    */
+    juce::Array<juce::Array<int>> getDuplicateGroups() const;
+
+    /** Returns the number of candidate pairs found from fingerprints by the last search. */
+    int getNumCandidates() const noexcept                   { return numCandidates.load(); }
+
+    //==============================================================================
+    /** Returns the mean difference in dB between the bands of two fingerprints,
+        or a negative number if they can't be compared.
+    */
+    static float getFingerprintDifference (const juce::MemoryBlock& first, const juce::MemoryBlock& second);
+
+    /** Decodes short sections of two files and compares their loudness envelopes.
+        The format manager is used to create the readers for the files.
+        @returns a similarity from 0 to 1, or 0 if either file can't be read
+    */
+    static float compareFiles (juce::AudioFormatManager& formatManager,
+                               const juce::File& first, const juce::File& second,
+                               const std::function<bool()>& shouldExit = nullptr);
+
+    //==============================================================================
+    /** Receives a callback on the message thread when a search has finished. */
+    class Listener
+    {
+    public:
+        /** Destructor. */
+        virtual ~Listener() = default;
+
+        /** Called when a search has finished, see getDuplicateGroups() for the results. */
+        virtual void duplicateSearchFinished (MusicLibraryDuplicateFinder* finder) = 0;
+    };
+
+    /** Adds a listener. */
+    void addListener (Listener* listener)                   { listeners.add (listener); }
+
+    /** Removes a previously added listener. */
+    void removeListener (Listener* listener)                { listeners.remove (listener); }
+
+private:
+    //==============================================================================
+    struct Item
+    {
+        int libId;
+        double lengthSeconds;
+        juce::String location;
+        juce::MemoryBlock fingerprint;
+    };
+
+    struct Candidate
+    {
+        int first, second;
+    };
+
+    ITunesLibrary& library;
+    juce::AudioFormatManager formatManager;
+    std::atomic<bool> verifyCandidates;
+    std::atomic<float> maxFingerprintDifference;
+    std::atomic<double> maxLengthDifference;
+    std::atomic<int> numCandidates;
+
+    juce::CriticalSection groupsLock;
+    juce::Array<juce::Array<int>> duplicateGroups;
+    juce::ListenerList<Listener> listeners;
+
+    //==============================================================================
+    juce::Array<Item> getAnalysedItems();
+    juce::Array<Candidate> findCandidates (const juce::Array<Item>& items);
+    juce::Array<Candidate> verify (const juce::Array<Item>& items, const juce::Array<Candidate>& candidates);
+    static juce::Array<juce::Array<int>> groupDuplicates (const juce::Array<Item>& items,
+                                                          const juce::Array<Candidate>& duplicates);
+
+    /** @internal */
+    void run() override;
+    /** @internal */
+    void handleAsyncUpdate() override;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MusicLibraryDuplicateFinder)
+};
+
+#endif // DROWAUDIO_MUSICLIBRARYDUPLICATEFINDER_H
@@ -90,6 +90,7 @@ namespace MusicColumns
     static const juce::Identifier libraryItemIdentifier ("ITEM");
     static const juce::Identifier libraryCuePointIdentifier ("CUE");
     static const juce::Identifier libraryLoopIdentifier ("LOOP");
+    static const juce::Identifier libraryAnalysisIdentifier ("ANALYSIS");
 
     enum Columns
     {
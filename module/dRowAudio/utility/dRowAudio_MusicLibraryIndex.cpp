@@ -0,0 +1,425 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+const int64 MusicLibraryIndex::missingNumber = std::numeric_limits<int64>::min();
+
+//==============================================================================
+int MusicLibraryIndex::Column::internString (const String& s)
+{
+    if (stringLookup.contains (s))
+        return stringLookup[s];
+
+    const int newId = strings.size();
+    strings.add (s);
+    stringLookup.set (s, newId);
+
+    return newId;
+}
+
+//==============================================================================
+MusicLibraryIndex::MusicLibraryIndex()
+    : treeLock (nullptr),
+      version (0),
+      needsRebuild (false)
+{
+    for (int i = 0; i < MusicColumns::numColumns; ++i)
+    {
+        Column* column = columns.add (new Column());
+        column->isNumeric = isNumericColumn (i);
+    }
+}
+
+MusicLibraryIndex::~MusicLibraryIndex()
+{
+    if (treeLock != nullptr)
+    {
+        const ScopedLock sl (*treeLock);
+        libraryTree.removeListener (this);
+    }
+}
+
+//==============================================================================
+void MusicLibraryIndex::setLibraryTree (const ValueTree& newLibraryTree, const CriticalSection& newTreeLock)
+{
+    if (treeLock != nullptr)
+    {
+        const ScopedLock sl (*treeLock);
+        libraryTree.removeListener (this);
+    }
+
+    treeLock = &newTreeLock;
+
+    {
+        const ScopedLock sl (*treeLock);
+        libraryTree = newLibraryTree;
+        libraryTree.addListener (this);
+    }
+
+    {
+        const ScopedLock sl (pendingLock);
+        pendingAdded.clearQuick();
+        pendingChanged.clearQuick();
+        needsRebuild = true;
+    }
+
+    update();
+}
+
+bool MusicLibraryIndex::update()
+{
+    Array<ValueTree> added, changed;
+    bool rebuildNeeded;
+
+    {
+        const ScopedLock sl (pendingLock);
+        added.swapWith (pendingAdded);
+        changed.swapWith (pendingChanged);
+        rebuildNeeded = needsRebuild;
+        needsRebuild = false;
+    }
+
+    if (treeLock == nullptr || (! rebuildNeeded && added.isEmpty() && changed.isEmpty()))
+        return false;
+
+    Array<int> updatedRecords;
+
+    {
+        const ScopedWriteLock swl (indexLock);
+        const ScopedLock sl (*treeLock);
+
+        if (rebuildNeeded)
+        {
+            rebuild();
+        }
+        else
+        {
+            for (auto& item : added)
+            {
+                items.add (item);
+                readRecord (items.size() - 1, item);
+                updatedRecords.add (items.size() - 1);
+            }
+
+            for (auto& item : changed)
+            {
+                const int libId = int (item[MusicColumns::columnNames[MusicColumns::LibID]]);
+
+                if (libIdToRecord.contains (libId))
+                {
+                    const int record = libIdToRecord[libId];
+                    readRecord (record, item);
+                    updatedRecords.add (record);
+                }
+            }
+
+            // items often have several properties changed at once
+            updatedRecords.sort();
+            updatedRecords.removeRange ((int) (std::unique (updatedRecords.begin(), updatedRecords.end()) - updatedRecords.begin()),
+                                        updatedRecords.size());
+        }
+
+        invalidateSortPositions();
+        ++version;
+    }
+
+    if (rebuildNeeded)
+        listeners.call ([this] (Listener& l) { l.indexRebuilt (*this); });
+    else
+        listeners.call ([this, &updatedRecords] (Listener& l) { l.recordsUpdated (*this, updatedRecords); });
+
+    return true;
+}
+
+//==============================================================================
+bool MusicLibraryIndex::isNumericColumn (int column) noexcept
+{
+    return column == MusicColumns::LibID
+        || column == MusicColumns::ID
+        || column == MusicColumns::Length
+        || column == MusicColumns::BPM
+        || column == MusicColumns::Added
+        || column == MusicColumns::Modified;
+}
+
+int64 MusicLibraryIndex::getNumber (int record, int column) const noexcept
+{
+    const Column& c = *columns.getUnchecked (column);
+
+    return c.isNumeric ? c.numbers[record] : missingNumber;
+}
+
+const String& MusicLibraryIndex::getString (int record, int column) const noexcept
+{
+    const Column& c = *columns.getUnchecked (column);
+
+    if (c.isNumeric || ! isPositiveAndBelow (record, c.stringIds.size()))
+    {
+        static const String emptyString;
+        return emptyString;
+    }
+
+    return c.strings.getReference (c.stringIds.getUnchecked (record));
+}
+
+String MusicLibraryIndex::getText (int record, int column) const
+{
+    if (! isNumericColumn (column))
+        return getString (record, column);
+
+    const int64 number = getNumber (record, column);
+
+    return number != missingNumber ? String (number) : String();
+}
+
+int MusicLibraryIndex::getLibId (int record) const noexcept
+{
+    return (int) getNumber (record, MusicColumns::LibID);
+}
+
+int MusicLibraryIndex::getRecordForLibId (int libId) const noexcept
+{
+    return libIdToRecord.contains (libId) ? libIdToRecord[libId] : -1;
+}
+
+ValueTree MusicLibraryIndex::getItem (int record) const
+{
+    return items[record];
+}
+
+//==============================================================================
+void MusicLibraryIndex::sortRows (Array<int>& rows, int columnIndex, bool forwards) const
+{
+    if (! isPositiveAndBelow (columnIndex, (int) MusicColumns::numColumns))
+        return;
+
+    Column& column = *columns.getUnchecked (columnIndex);
+
+    const ScopedLock sl (sortLock);
+
+    if (! column.sortPositionsValid)
+        updateSortPositions (column);
+
+    const int* positions = column.sortPositions.getRawDataPointer();
+    const int numRecords = column.sortPositions.size();
+
+    rows.removeIf ([numRecords] (int record) { return ! isPositiveAndBelow (record, numRecords); });
+
+    if (forwards)
+        std::sort (rows.begin(), rows.end(), [positions] (int a, int b) { return positions[a] < positions[b]; });
+    else
+        std::sort (rows.begin(), rows.end(), [positions] (int a, int b) { return positions[a] > positions[b]; });
+}
+
+void MusicLibraryIndex::updateSortPositions (Column& column) const
+{
+    const int numRecords = items.size();
+    const int64* libIds = columns.getUnchecked (MusicColumns::LibID)->numbers.getRawDataPointer();
+
+    Array<int> order;
+    order.resize (numRecords);
+
+    for (int i = 0; i < numRecords; ++i)
+        order.setUnchecked (i, i);
+
+    if (column.isNumeric)
+    {
+        const int64* numbers = column.numbers.getRawDataPointer();
+
+        std::sort (order.begin(), order.end(),
+                   [numbers, libIds] (int a, int b)
+                   {
+                       return numbers[a] != numbers[b] ? numbers[a] < numbers[b]
+                                                       : libIds[a] < libIds[b];
+                   });
+    }
+    else
+    {
+        // rank each unique string once so records can then be sorted by comparing integers
+        const int numStrings = column.strings.size();
+        Array<int> stringOrder, stringRanks;
+        stringOrder.resize (numStrings);
+        stringRanks.resize (numStrings);
+
+        for (int i = 0; i < numStrings; ++i)
+            stringOrder.setUnchecked (i, i);
+
+        const StringArray& strings = column.strings;
+
+        std::sort (stringOrder.begin(), stringOrder.end(),
+                   [&strings] (int a, int b) { return strings[a].compareNatural (strings[b]) < 0; });
+
+        for (int i = 0, rank = 0; i < numStrings; ++i)
+        {
+            if (i > 0 && strings[stringOrder[i - 1]].compareNatural (strings[stringOrder[i]]) != 0)
+                ++rank;
+
+            stringRanks.setUnchecked (stringOrder[i], rank);
+        }
+
+        const int* ids = column.stringIds.getRawDataPointer();
+        const int* ranks = stringRanks.getRawDataPointer();
+
+        std::sort (order.begin(), order.end(),
+                   [ids, ranks, libIds] (int a, int b)
+                   {
+                       const int rankA = ranks[ids[a]], rankB = ranks[ids[b]];
+                       return rankA != rankB ? rankA < rankB
+                                             : libIds[a] < libIds[b];
+                   });
+    }
+
+    column.sortPositions.resize (numRecords);
+
+    for (int i = 0; i < numRecords; ++i)
+        column.sortPositions.setUnchecked (order.getUnchecked (i), i);
+
+    column.sortPositionsValid = true;
+}
+
+void MusicLibraryIndex::invalidateSortPositions()
+{
+    const ScopedLock sl (sortLock);
+
+    for (auto* column : columns)
+        column->sortPositionsValid = false;
+}
+
+//==============================================================================
+void MusicLibraryIndex::clear()
+{
+    for (auto* column : columns)
+    {
+        column->numbers.clearQuick();
+        column->stringIds.clearQuick();
+        column->strings.clearQuick();
+        column->stringLookup.clear();
+    }
+
+    items.clearQuick();
+    libIdToRecord.clear();
+}
+
+void MusicLibraryIndex::rebuild()
+{
+    clear();
+
+    const int numChildren = libraryTree.getNumChildren();
+    items.ensureStorageAllocated (numChildren);
+    libIdToRecord.remapTable (numChildren * 2);
+
+    for (int i = 0; i < numChildren; ++i)
+    {
+        const ValueTree item (libraryTree.getChild (i));
+        items.add (item);
+        readRecord (i, item);
+    }
+}
+
+void MusicLibraryIndex::readRecord (int record, const ValueTree& item)
+{
+    const bool isNewRecord = record >= columns.getUnchecked (MusicColumns::LibID)->numbers.size();
+
+    if (! isNewRecord)
+    {
+        const int oldLibId = getLibId (record);
+
+        if (libIdToRecord.contains (oldLibId) && libIdToRecord[oldLibId] == record)
+            libIdToRecord.remove (oldLibId);
+    }
+
+    items.set (record, item);
+
+    for (int c = 0; c < MusicColumns::numColumns; ++c)
+    {
+        Column& column = *columns.getUnchecked (c);
+        const var& value = item[MusicColumns::columnNames[c]];
+
+        if (column.isNumeric)
+        {
+            const int64 number = value.isVoid() ? missingNumber : (int64) value;
+
+            if (isNewRecord)
+                column.numbers.add (number);
+            else
+                column.numbers.set (record, number);
+        }
+        else
+        {
+            const int stringId = column.internString (value.toString());
+
+            if (isNewRecord)
+                column.stringIds.add (stringId);
+            else
+                column.stringIds.set (record, stringId);
+        }
+    }
+
+    libIdToRecord.set (getLibId (record), record);
+}
+
+//==============================================================================
+void MusicLibraryIndex::valueTreePropertyChanged (ValueTree& tree, const Identifier&)
+{
+    if (tree.getParent() == libraryTree)
+    {
+        const ScopedLock sl (pendingLock);
+        pendingChanged.add (tree);
+    }
+}
+
+void MusicLibraryIndex::valueTreeChildAdded (ValueTree& parent, ValueTree& child)
+{
+    if (parent == libraryTree)
+    {
+        const ScopedLock sl (pendingLock);
+        pendingAdded.add (child);
+    }
+}
+
+void MusicLibraryIndex::valueTreeChildRemoved (ValueTree& parent, ValueTree&, int)
+{
+    if (parent == libraryTree)
+    {
+        const ScopedLock sl (pendingLock);
+        needsRebuild = true;
+    }
+}
+
+void MusicLibraryIndex::valueTreeChildOrderChanged (ValueTree&, int, int)
+{
+    // records are independent of the order of the tree so there's nothing to do
+}
+
+void MusicLibraryIndex::valueTreeRedirected (ValueTree&)
+{
+    const ScopedLock sl (pendingLock);
+    needsRebuild = true;
+}
@@ -0,0 +1,202 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef DROWAUDIO_MUSICLIBRARYINDEX_H
+#define DROWAUDIO_MUSICLIBRARYINDEX_H
+
+#include "dRowAudio_MusicLibraryHelpers.h"
+
+//==============================================================================
+/** A columnar index of a music library tree for fast sorting and filtering.
+
+    Rather than comparing ValueTree properties through vars, this keeps a copy
+    of each column of the library in flat arrays. Numeric columns are held as
+    int64s and text columns as indices into a table of unique, interned strings,
+    so each distinct artist, album or genre only needs to be compared once.
+
+    Records are referred to by their index in the library, use these to look up
+    the values of a particular track. The sort order of each column is worked out
+    the first time it is needed and cached until the library changes, after which
+    sorting any set of rows is just a matter of comparing integers.
+
+    The index listens to the library tree for changes and applies them to itself
+    the next time update() is called, so while a library is being parsed only the
+    new or modified tracks need to be read.
+
+    @see MusicLibraryTable
+*/
+class MusicLibraryIndex : private juce::ValueTree::Listener
+{
+public:
+    //==============================================================================
+    /** Creates an empty index. */
+    MusicLibraryIndex();
+
+    /** Destructor. */
+    ~MusicLibraryIndex() override;
+
+    //==============================================================================
+    /** Sets the library tree to index.
+        This will rebuild the index from scratch. The lock should be the one that is
+        held when the tree is modified, e.g. ITunesLibrary::getParserLock().
+    */
+    void setLibraryTree (const juce::ValueTree& libraryTree, const juce::CriticalSection& treeLock);
+
+    /** Applies any changes made to the library tree since the last update.
+        This should be called from the message thread, returning true if anything changed.
+    */
+    bool update();
+
+    /** Receives callbacks when the records in a MusicLibraryIndex change.
+        These are made from update() on the message thread.
+    */
+    class Listener
+    {
+    public:
+        /** Destructor. */
+        virtual ~Listener() {}
+
+        /** Called when some records have been added or modified. */
+        virtual void recordsUpdated (MusicLibraryIndex& index, const juce::Array<int>& records) = 0;
+
+        /** Called when the index has been rebuilt from scratch.
+            All the record numbers may have changed so any data based on them should be discarded.
+        */
+        virtual void indexRebuilt (MusicLibraryIndex& index) = 0;
+    };
+
+    /** Registers a listener to be told when the records change. */
+    void addListener (Listener* listener)                   { listeners.add (listener); }
+
+    /** Removes a previously registered listener. */
+    void removeListener (Listener* listener)                { listeners.remove (listener); }
+
+    /** Returns a number that changes each time the contents of the index change.
+        This can be used to find out if any results based on the index are still valid.
+    */
+    juce::uint32 getVersion() const noexcept                { return version; }
+
+    //==============================================================================
+    /** Returns the number of records in the index. */
+    int getNumRecords() const noexcept                      { return items.size(); }
+
+    /** Returns true if the column is held as a number rather than text. */
+    static bool isNumericColumn (int column) noexcept;
+
+    /** Returns the value of a numeric column for a record. */
+    juce::int64 getNumber (int record, int column) const noexcept;
+
+    /** Returns the value of a text column for a record. */
+    const juce::String& getString (int record, int column) const noexcept;
+
+    /** Returns the value of any column for a record as text. */
+    juce::String getText (int record, int column) const;
+
+    /** Returns the LibID of a record. */
+    int getLibId (int record) const noexcept;
+
+    /** Returns the record with a given LibID or -1 if it isn't in the index. */
+    int getRecordForLibId (int libId) const noexcept;
+
+    /** Returns the library tree item a record was read from. */
+    juce::ValueTree getItem (int record) const;
+
+    //==============================================================================
+    /** Sorts a set of records by the given column.
+        Records with the same value are ordered by their LibID.
+    */
+    void sortRows (juce::Array<int>& rows, int column, bool forwards) const;
+
+    /** Returns the lock used to protect the index.
+        A read lock is taken when reading, a write lock when updating.
+    */
+    const juce::ReadWriteLock& getLock() const noexcept     { return indexLock; }
+
+    /** Value returned by getNumber() if a record doesn't have a value for a column. */
+    static const juce::int64 missingNumber;
+
+private:
+    //==============================================================================
+    struct Column
+    {
+        bool isNumeric = false;
+        juce::Array<juce::int64> numbers;
+        juce::Array<int> stringIds;
+        juce::StringArray strings;
+        juce::HashMap<juce::String, int> stringLookup;
+
+        // position of each record in the column's sorted order, worked out when first needed
+        juce::Array<int> sortPositions;
+        bool sortPositionsValid = false;
+
+        int internString (const juce::String& s);
+    };
+
+    juce::OwnedArray<Column> columns;
+    juce::Array<juce::ValueTree> items;
+    juce::HashMap<int, int> libIdToRecord;
+
+    juce::ValueTree libraryTree;
+    const juce::CriticalSection* treeLock;
+    juce::ReadWriteLock indexLock;
+    mutable juce::CriticalSection sortLock;
+    juce::uint32 version;
+
+    juce::ListenerList<Listener> listeners;
+
+    juce::CriticalSection pendingLock;
+    juce::Array<juce::ValueTree> pendingAdded, pendingChanged;
+    bool needsRebuild;
+
+    //==============================================================================
+    void clear();
+    void rebuild();
+    void readRecord (int record, const juce::ValueTree& item);
+    void invalidateSortPositions();
+    void updateSortPositions (Column& column) const;
+
+    //==============================================================================
+    /** @internal */
+    void valueTreePropertyChanged (juce::ValueTree& tree, const juce::Identifier& property) override;
+    /** @internal */
+    void valueTreeChildAdded (juce::ValueTree& parent, juce::ValueTree& child) override;
+    /** @internal */
+    void valueTreeChildRemoved (juce::ValueTree& parent, juce::ValueTree& child, int index) override;
+    /** @internal */
+    void valueTreeChildOrderChanged (juce::ValueTree& parent, int oldIndex, int newIndex) override;
+    /** @internal */
+    void valueTreeRedirected (juce::ValueTree& tree) override;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MusicLibraryIndex)
+};
+
+#endif // DROWAUDIO_MUSICLIBRARYINDEX_H
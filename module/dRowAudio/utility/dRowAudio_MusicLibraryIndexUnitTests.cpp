@@ -0,0 +1,216 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#if DROWAUDIO_UNIT_TESTS
+
+//==============================================================================
+class MusicLibraryIndexTests  : public UnitTest
+{
+public:
+    MusicLibraryIndexTests() : UnitTest ("MusicLibraryIndex") {}
+
+    void runTest() override
+    {
+        beginTest ("Tokenising");
+        testTokenising();
+
+        ValueTree library (MusicColumns::libraryIdentifier);
+        library.appendChild (createItem (3, "Daft Punk", "One More Time", "Discovery", "House", 123), nullptr);
+        library.appendChild (createItem (1, CharPointer_UTF8 ("Beyonc\xc3\xa9"), "Crazy in Love", "Dangerously in Love", "R&B", 99), nullptr);
+        library.appendChild (createItem (2, "Punk Rockers", "Daft Song", "Track 10", "Punk", 128), nullptr);
+        library.appendChild (createItem (0, "Daft Punk", "Track 2", "Track 9", "House", 130), nullptr);
+
+        CriticalSection treeLock;
+        MusicLibraryIndex index;
+        index.setLibraryTree (library, treeLock);
+        MusicLibrarySearchIndex searchIndex (index);
+
+        beginTest ("Prefix matching");
+        expectSearch (searchIndex, "", { 0, 1, 2, 3 });
+        expectSearch (searchIndex, "BEYONCE", { 1 });
+        expectSearch (searchIndex, "daf", { 0, 2, 3 });
+        expectSearch (searchIndex, "daft pun", { 0, 2, 3 });
+        expectSearch (searchIndex, "one time", { 0 });
+        expectSearch (searchIndex, "ime", {});
+        expectSearch (searchIndex, "daft zzz", {});
+
+        {
+            const Array<int> candidates { 2, 3 };
+            Array<int> results;
+            expect (searchIndex.search ("daft", &candidates, results));
+            expect (results == Array<int> { 2, 3 });
+        }
+
+        {
+            Array<int> results;
+            expect (! searchIndex.search ("daft", nullptr, results, [] { return true; }));
+            expect (results.isEmpty());
+        }
+
+        beginTest ("Field queries");
+        expectSearch (searchIndex, "artist:daft", { 0, 3 });
+        expectSearch (searchIndex, "song:daft", { 2 });
+        expectSearch (searchIndex, "ARTIST:punk", { 0, 2, 3 });
+        expectSearch (searchIndex, "genre:punk", { 2 });
+        expectSearch (searchIndex, "title:track", { 3 });
+        expectSearch (searchIndex, "album:track", { 2, 3 });
+        expectSearch (searchIndex, "artist:daft track", { 3 });
+        expectSearch (searchIndex, "bpm:120-128", { 0, 2 });
+        expectSearch (searchIndex, "bpm:128-120", { 0, 2 });
+        expectSearch (searchIndex, "bpm:99", { 1 });
+        expectSearch (searchIndex, "house bpm:125-135", { 3 });
+
+        expect (MusicLibrarySearchIndex::isRefinement ("daf", "daft p"));
+        expect (! MusicLibrarySearchIndex::isRefinement ("", "daft"));
+        expect (! MusicLibrarySearchIndex::isRefinement ("bpm:12", "bpm:120"));
+
+        beginTest ("Sorting");
+        expectSorted (index, MusicColumns::Album, true, { 1, 0, 3, 2 });
+        expectSorted (index, MusicColumns::Album, false, { 2, 3, 0, 1 });
+        expectSorted (index, MusicColumns::BPM, true, { 1, 0, 2, 3 });
+
+        // records with the same value are kept in LibID order
+        expectSorted (index, MusicColumns::Artist, true, { 1, 3, 0, 2 });
+        expectSorted (index, MusicColumns::Genre, true, { 3, 0, 2, 1 });
+        expectSorted (index, MusicColumns::Genre, false, { 1, 2, 0, 3 });
+
+        beginTest ("Incremental updates");
+        expect (! index.update());
+
+        const uint32 oldVersion = index.getVersion();
+
+        {
+            const ScopedLock sl (treeLock);
+            library.appendChild (createItem (4, "Aphex Twin", "Xtal", "Selected Ambient Works", "Ambient", 120), nullptr);
+            library.getChild (1).setProperty (MusicColumns::columnNames[MusicColumns::Artist], "Solange", nullptr);
+        }
+
+        // nothing is applied until update() is called
+        expectEquals (index.getNumRecords(), 4);
+        expectSearch (searchIndex, "aphex", {});
+
+        expect (index.update());
+        expect (index.getVersion() != oldVersion);
+        expectEquals (index.getNumRecords(), 5);
+        expectEquals (index.getRecordForLibId (4), 4);
+        expectEquals (index.getString (1, MusicColumns::Artist), String ("Solange"));
+
+        expectSearch (searchIndex, "aphex", { 4 });
+        expectSearch (searchIndex, "beyonce", {});
+        expectSearch (searchIndex, "artist:solange", { 1 });
+        expectSearch (searchIndex, "crazy", { 1 });
+        expectSearch (searchIndex, "bpm:120-128", { 0, 2, 4 });
+        expectSorted (index, MusicColumns::Artist, true, { 4, 3, 0, 2, 1 });
+
+        {
+            const ScopedLock sl (treeLock);
+            library.removeChild (0, nullptr);
+        }
+
+        // removing an item renumbers the records so the search index is rebuilt
+        expect (index.update());
+        expectEquals (index.getNumRecords(), 4);
+        expectEquals (index.getRecordForLibId (3), -1);
+        expectEquals (index.getRecordForLibId (4), 3);
+
+        expectSearch (searchIndex, "one more", {});
+        expectSearch (searchIndex, "aphex", { 3 });
+        expectSearch (searchIndex, "artist:daft", { 2 });
+        expectSorted (index, MusicColumns::Artist, true, { 3, 2, 1, 0 });
+    }
+
+private:
+    //==============================================================================
+    static ValueTree createItem (int libId, const String& artist, const String& song,
+                                 const String& album, const String& genre, int bpm)
+    {
+        ValueTree item (MusicColumns::libraryItemIdentifier);
+        item.setProperty (MusicColumns::columnNames[MusicColumns::LibID], libId, nullptr);
+        item.setProperty (MusicColumns::columnNames[MusicColumns::Artist], artist, nullptr);
+        item.setProperty (MusicColumns::columnNames[MusicColumns::Song], song, nullptr);
+        item.setProperty (MusicColumns::columnNames[MusicColumns::Album], album, nullptr);
+        item.setProperty (MusicColumns::columnNames[MusicColumns::Genre], genre, nullptr);
+        item.setProperty (MusicColumns::columnNames[MusicColumns::BPM], bpm, nullptr);
+
+        return item;
+    }
+
+    static String toString (const Array<int>& records)
+    {
+        StringArray s;
+
+        for (auto record : records)
+            s.add (String (record));
+
+        return "{ " + s.joinIntoString (", ") + " }";
+    }
+
+    void expectSearch (const MusicLibrarySearchIndex& searchIndex, const String& query, const Array<int>& expected)
+    {
+        Array<int> results;
+        expect (searchIndex.search (query, nullptr, results));
+        expect (results == expected, "\"" + query + "\" found " + toString (results) + " not " + toString (expected));
+    }
+
+    void expectSorted (const MusicLibraryIndex& index, int column, bool forwards, const Array<int>& expected)
+    {
+        Array<int> rows;
+
+        for (int i = index.getNumRecords(); --i >= 0;)
+            rows.add (i);
+
+        index.sortRows (rows, column, forwards);
+        expect (rows == expected, MusicColumns::columnNames[column].toString() + " sorted as " + toString (rows)
+                                    + " not " + toString (expected));
+    }
+
+    //==============================================================================
+    void testTokenising()
+    {
+        expect (MusicLibrarySearchIndex::tokenise ("Daft Punk") == StringArray ("daft", "punk"));
+        expect (MusicLibrarySearchIndex::tokenise ("  AC/DC -- Back in Black! ")
+                    == StringArray ("ac", "dc", "back", "in", "black"));
+        expect (MusicLibrarySearchIndex::tokenise ("Track 10 (Remix)") == StringArray ("track", "10", "remix"));
+        expect (MusicLibrarySearchIndex::tokenise (" - ").isEmpty());
+
+        // diacritics are folded to their base letters and ligatures expanded
+        expect (MusicLibrarySearchIndex::tokenise (CharPointer_UTF8 ("Beyonc\xc3\xa9 & Jay-Z"))
+                    == StringArray ("beyonce", "jay", "z"));
+        expect (MusicLibrarySearchIndex::tokenise (CharPointer_UTF8 ("Sigur R\xc3\xb3s \xc3\x86gis"))
+                    == StringArray ("sigur", "ros", "aegis"));
+        expect (MusicLibrarySearchIndex::tokenise (CharPointer_UTF8 ("Stra\xc3\x9f" "e Dvo\xc5\x99\xc3\xa1k"))
+                    == StringArray ("strasse", "dvorak"));
+    }
+};
+
+static MusicLibraryIndexTests musicLibraryIndexTests;
+
+#endif // DROWAUDIO_UNIT_TESTS
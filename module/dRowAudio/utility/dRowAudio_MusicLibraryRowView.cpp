@@ -0,0 +1,161 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+MusicLibraryRowView::MusicLibraryRowView (const MusicLibraryIndex& indexToView)
+    : index (indexToView),
+      rowsForRecordsValid (false)
+{
+}
+
+MusicLibraryRowView::~MusicLibraryRowView()
+{
+}
+
+//==============================================================================
+void MusicLibraryRowView::setRecords (const Array<int>& newRecords)
+{
+    records = newRecords;
+    rowsForRecordsValid = false;
+}
+
+void MusicLibraryRowView::sort (int columnId, bool forwards)
+{
+    index.sortRows (records, columnId, forwards);
+    rowsForRecordsValid = false;
+}
+
+int MusicLibraryRowView::getRecord (int row) const noexcept
+{
+    return isPositiveAndBelow (row, records.size()) ? records.getUnchecked (row) : -1;
+}
+
+int MusicLibraryRowView::getRowForRecord (int record) const
+{
+    if (! rowsForRecordsValid)
+    {
+        rowsForRecords.clearQuick();
+        rowsForRecords.insertMultiple (0, -1, index.getNumRecords());
+
+        for (int row = 0; row < records.size(); ++row)
+        {
+            const int r = records.getUnchecked (row);
+
+            if (isPositiveAndBelow (r, rowsForRecords.size()))
+                rowsForRecords.setUnchecked (r, row);
+        }
+
+        rowsForRecordsValid = true;
+    }
+
+    return isPositiveAndBelow (record, rowsForRecords.size()) ? rowsForRecords.getUnchecked (record) : -1;
+}
+
+String MusicLibraryRowView::getCellText (int row, int columnId) const
+{
+    const int record = getRecord (row);
+
+    if (! isPositiveAndBelow (record, index.getNumRecords()))
+        return {};
+
+    if (columnId == MusicColumns::Length
+        || columnId == MusicColumns::Added
+        || columnId == MusicColumns::Modified)
+    {
+        const int64 number = index.getNumber (record, columnId);
+
+        if (number == MusicLibraryIndex::missingNumber)
+            return {};
+
+        if (columnId == MusicColumns::Length)
+            return secondsToTimeLength ((double) number);
+
+        return Time (number).formatted ("%d/%m/%Y - %H:%M");
+    }
+
+    return index.getText (record, columnId);
+}
+
+//==============================================================================
+void MusicLibraryRowView::rememberSelection (const SparseSet<int>& selectedRows)
+{
+    selectedLibIds.clear();
+
+    for (int i = 0; i < selectedRows.getNumRanges(); ++i)
+    {
+        const Range<int> range (selectedRows.getRange (i).getIntersectionWith (Range<int> (0, records.size())));
+
+        for (int row = range.getStart(); row < range.getEnd(); ++row)
+        {
+            const int record = records.getUnchecked (row);
+
+            if (isPositiveAndBelow (record, index.getNumRecords()))
+                selectedLibIds.insert (index.getLibId (record));
+        }
+    }
+}
+
+SparseSet<int> MusicLibraryRowView::getRememberedSelection() const
+{
+    Array<int> selectedRows;
+    selectedRows.ensureStorageAllocated ((int) selectedLibIds.size());
+
+    for (auto libId : selectedLibIds)
+    {
+        const int record = index.getRecordForLibId (libId);
+
+        // the item may have been removed from the library
+        if (record < 0)
+            continue;
+
+        const int row = getRowForRecord (record);
+
+        if (row >= 0)
+            selectedRows.add (row);
+    }
+
+    selectedRows.sort();
+
+    // add the rows as contiguous ranges as adding ranges one at a time to a SparseSet is slow
+    SparseSet<int> selection;
+
+    for (int i = 0; i < selectedRows.size();)
+    {
+        const int start = selectedRows.getUnchecked (i);
+        int end = start + 1;
+
+        while (++i < selectedRows.size() && selectedRows.getUnchecked (i) == end)
+            ++end;
+
+        selection.addRange (Range<int> (start, end));
+    }
+
+    return selection;
+}
@@ -0,0 +1,101 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef DROWAUDIO_MUSICLIBRARYROWVIEW_H
+#define DROWAUDIO_MUSICLIBRARYROWVIEW_H
+
+#include "dRowAudio_MusicLibraryIndex.h"
+
+//==============================================================================
+/** A list of rows to display from a MusicLibraryIndex.
+
+    Each row just refers to a record in the index so the rows can be filtered
+    and sorted without copying any of the library. The text for a cell is only
+    formatted when it is asked for, so only the visible cells are ever created.
+
+    A selection can be remembered by the LibIDs of its items, so it can be
+    restored after the rows have been filtered, sorted or the library changed.
+
+    @see MusicLibraryTable
+*/
+class MusicLibraryRowView
+{
+public:
+    //==============================================================================
+    /** Creates an empty view of an index.
+        The MusicLibraryIndex must outlive this object.
+    */
+    explicit MusicLibraryRowView (const MusicLibraryIndex& indexToView);
+
+    /** Destructor. */
+    ~MusicLibraryRowView();
+
+    //==============================================================================
+    /** Sets the records to show, in the order given. */
+    void setRecords (const juce::Array<int>& newRecords);
+
+    /** Sorts the rows by a column. */
+    void sort (int columnId, bool forwards);
+
+    /** Returns the number of rows. */
+    int getNumRows() const noexcept                         { return records.size(); }
+
+    /** Returns the record shown in a row or -1 if the row is out of range. */
+    int getRecord (int row) const noexcept;
+
+    /** Returns the row showing a record or -1 if it isn't in the view. */
+    int getRowForRecord (int record) const;
+
+    /** Returns the text to display for a cell. */
+    juce::String getCellText (int row, int columnId) const;
+
+    //==============================================================================
+    /** Remembers the items in some selected rows. */
+    void rememberSelection (const juce::SparseSet<int>& selectedRows);
+
+    /** Returns the rows that now show the remembered items. */
+    juce::SparseSet<int> getRememberedSelection() const;
+
+private:
+    //==============================================================================
+    const MusicLibraryIndex& index;
+    juce::Array<int> records;
+    std::unordered_set<int> selectedLibIds;
+
+    // the row for each record, only built when a selection needs restoring
+    mutable juce::Array<int> rowsForRecords;
+    mutable bool rowsForRecordsValid;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MusicLibraryRowView)
+};
+
+#endif // DROWAUDIO_MUSICLIBRARYROWVIEW_H
@@ -0,0 +1,441 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+namespace MusicLibrarySearchIndexHelpers
+{
+    /** Base letters for U+00C0 to U+017F, '?' means there isn't a single letter equivalent. */
+    static const char* const latin1Supplement   = "aaaaaa?ceeeeiiiidnooooo?ouuuuy??aaaaaa?ceeeeiiiidnooooo?ouuuuy?y";
+    static const char* const latinExtendedA     = "aaaaaaccccccccddddeeeeeeeeeegggggggghhhhiiiiiiiiii??jjkkkllllllllllnnnnnnnnnoooooo??rrrrrrssssssssttttttuuuuuuuuuuuuwwyyyzzzzzzs";
+
+    static void appendFolded (String& word, juce_wchar c)
+    {
+        if (c >= 0xc0 && c < 0x180)
+        {
+            switch (c)
+            {
+                case 0xc6: case 0xe6:   word << "ae"; return;
+                case 0xdf:              word << "ss"; return;
+                case 0x132: case 0x133: word << "ij"; return;
+                case 0x152: case 0x153: word << "oe"; return;
+                default: break;
+            }
+
+            const char folded = c < 0x100 ? latin1Supplement[c - 0xc0]
+                                          : latinExtendedA[c - 0x100];
+
+            if (folded != '?')
+            {
+                word += folded;
+                return;
+            }
+        }
+
+        word += c;
+    }
+
+    static bool isWordCharacter (juce_wchar c) noexcept
+    {
+        // the C library's idea of what's a letter outside of ASCII depends on the locale
+        if (c >= 0x80)
+            return ! (CharacterFunctions::isWhitespace (c) || c == 0xd7 || c == 0xf7);
+
+        return CharacterFunctions::isLetterOrDigit (c);
+    }
+
+    static void sortAndRemoveDuplicates (Array<int>& records)
+    {
+        std::sort (records.begin(), records.end());
+        records.removeRange ((int) (std::unique (records.begin(), records.end()) - records.begin()),
+                             records.size());
+    }
+}
+
+//==============================================================================
+const int MusicLibrarySearchIndex::fieldColumns[numFields] =
+{
+    MusicColumns::Artist,
+    MusicColumns::Song,
+    MusicColumns::Album,
+    MusicColumns::Genre,
+    MusicColumns::SubGenre,
+    MusicColumns::Label
+};
+
+//==============================================================================
+MusicLibrarySearchIndex::MusicLibrarySearchIndex (MusicLibraryIndex& indexToSearch)
+    : index (indexToSearch),
+      sortedTermsValid (false)
+{
+    index.addListener (this);
+    rebuild();
+}
+
+MusicLibrarySearchIndex::~MusicLibrarySearchIndex()
+{
+    index.removeListener (this);
+}
+
+//==============================================================================
+bool MusicLibrarySearchIndex::search (const String& query,
+                                      const Array<int>* candidates,
+                                      Array<int>& results,
+                                      const std::function<bool()>& shouldExit) const
+{
+    results.clearQuick();
+
+    const ScopedReadLock sl (lock);
+    const ScopedReadLock isl (index.getLock());
+
+    Array<int> matches;
+    bool hasConstraint = false;
+
+    auto addConstraint = [&] (Array<int>& records)
+    {
+        if (hasConstraint)
+            intersect (matches, records);
+        else
+            matches.swapWith (records);
+
+        hasConstraint = true;
+    };
+
+    if (candidates != nullptr)
+    {
+        Array<int> sortedCandidates (*candidates);
+        sortedCandidates.sort();
+        addConstraint (sortedCandidates);
+    }
+
+    const StringArray clauses (StringArray::fromTokens (query, " \t", "\""));
+
+    for (auto& clause : clauses)
+    {
+        if (hasConstraint && matches.isEmpty())
+            break;
+
+        if (shouldExit != nullptr && shouldExit())
+            return false;
+
+        int fields = allFields;
+        String text (clause);
+
+        const int colon = clause.indexOfChar (':');
+
+        if (colon > 0)
+        {
+            const String name (clause.substring (0, colon).toLowerCase());
+
+            if (name == "bpm")
+            {
+                Array<int> records;
+
+                if (! findRecordsInBPMRange (clause.substring (colon + 1), records, shouldExit))
+                    return false;
+
+                addConstraint (records);
+                continue;
+            }
+
+            if (const int namedFields = getFieldsForName (name))
+            {
+                fields = namedFields;
+                text = clause.substring (colon + 1);
+            }
+        }
+
+        for (auto& token : tokenise (text))
+        {
+            Array<int> records;
+
+            if (! findRecordsWithPrefix (token, fields, records, shouldExit))
+                return false;
+
+            addConstraint (records);
+        }
+    }
+
+    if (! hasConstraint)
+    {
+        matches.resize (index.getNumRecords());
+
+        for (int i = 0; i < matches.size(); ++i)
+            matches.setUnchecked (i, i);
+    }
+
+    results.swapWith (matches);
+    return true;
+}
+
+bool MusicLibrarySearchIndex::isRefinement (const String& previousQuery, const String& newQuery)
+{
+    // field values such as bpm:12 -> bpm:120 aren't prefixes of each other
+    return previousQuery.isNotEmpty()
+            && ! previousQuery.containsChar (':')
+            && ! newQuery.containsChar (':')
+            && newQuery.startsWithIgnoreCase (previousQuery);
+}
+
+StringArray MusicLibrarySearchIndex::tokenise (const String& text)
+{
+    using namespace MusicLibrarySearchIndexHelpers;
+
+    StringArray tokens;
+    String word;
+
+    for (auto t = text.getCharPointer(); ! t.isEmpty();)
+    {
+        const juce_wchar c = CharacterFunctions::toLowerCase (t.getAndAdvance());
+
+        if (isWordCharacter (c))
+        {
+            appendFolded (word, c);
+        }
+        else if (word.isNotEmpty())
+        {
+            tokens.add (word);
+            word.clear();
+        }
+    }
+
+    if (word.isNotEmpty())
+        tokens.add (word);
+
+    return tokens;
+}
+
+//==============================================================================
+bool MusicLibrarySearchIndex::findRecordsWithPrefix (const String& prefix, int fields, Array<int>& records,
+                                                     const std::function<bool()>& shouldExit) const
+{
+    updateSortedTerms();
+
+    const ScopedLock sl (sortedTermsLock);
+
+    const int* first = std::lower_bound (sortedTermIds.begin(), sortedTermIds.end(), prefix,
+                                         [this] (int termId, const String& p) { return terms[termId] < p; });
+    int numTermsMatched = 0;
+
+    for (const int* termId = first; termId != sortedTermIds.end(); ++termId)
+    {
+        if (! terms[*termId].startsWith (prefix))
+            break;
+
+        if ((numTermsMatched & 255) == 0 && shouldExit != nullptr && shouldExit())
+            return false;
+
+        for (auto entry : *postings.getUnchecked (*termId))
+            if ((fields & (1 << (entry & fieldMask))) != 0)
+                records.add ((int) (entry >> fieldBits));
+
+        ++numTermsMatched;
+    }
+
+    // a single term's postings are already in order but may list a record for several fields
+    if (numTermsMatched > 1)
+        MusicLibrarySearchIndexHelpers::sortAndRemoveDuplicates (records);
+    else
+        records.removeRange ((int) (std::unique (records.begin(), records.end()) - records.begin()), records.size());
+
+    return true;
+}
+
+bool MusicLibrarySearchIndex::findRecordsInBPMRange (const String& range, Array<int>& records,
+                                                     const std::function<bool()>& shouldExit) const
+{
+    int64 low = range.upToFirstOccurrenceOf ("-", false, false).getLargeIntValue();
+    int64 high = range.containsChar ('-') ? range.fromFirstOccurrenceOf ("-", false, false).getLargeIntValue()
+                                          : low;
+
+    if (high < low)
+        std::swap (low, high);
+
+    const int numRecords = index.getNumRecords();
+
+    for (int i = 0; i < numRecords; ++i)
+    {
+        if ((i & 1023) == 0 && shouldExit != nullptr && shouldExit())
+            return false;
+
+        const int64 bpm = index.getNumber (i, MusicColumns::BPM);
+
+        if (bpm != MusicLibraryIndex::missingNumber && bpm >= low && bpm <= high)
+            records.add (i);
+    }
+
+    return true;
+}
+
+void MusicLibrarySearchIndex::updateSortedTerms() const
+{
+    const ScopedLock sl (sortedTermsLock);
+
+    if (sortedTermsValid)
+        return;
+
+    sortedTermIds.resize (terms.size());
+
+    for (int i = 0; i < sortedTermIds.size(); ++i)
+        sortedTermIds.setUnchecked (i, i);
+
+    std::sort (sortedTermIds.begin(), sortedTermIds.end(),
+               [this] (int a, int b) { return terms[a] < terms[b]; });
+
+    sortedTermsValid = true;
+}
+
+int MusicLibrarySearchIndex::getFieldsForName (const String& name)
+{
+    if (name == "artist")                                               return 1 << artistField;
+    if (name == "song" || name == "title" || name == "name")            return 1 << songField;
+    if (name == "album")                                                return 1 << albumField;
+    if (name == "genre")                                                return 1 << genreField;
+    if (name == "subgenre" || name == "sub_genre" || name == "grouping") return 1 << subGenreField;
+    if (name == "label" || name == "comments" || name == "comment")     return 1 << labelField;
+
+    return 0;
+}
+
+void MusicLibrarySearchIndex::intersect (Array<int>& results, const Array<int>& records)
+{
+    int* end = std::set_intersection (results.begin(), results.end(),
+                                      records.begin(), records.end(),
+                                      results.begin());
+
+    results.removeRange ((int) (end - results.begin()), results.size());
+}
+
+//==============================================================================
+void MusicLibrarySearchIndex::rebuild()
+{
+    const ScopedWriteLock sl (lock);
+
+    terms.clearQuick();
+    termIds.clear();
+    postings.clear();
+    recordTerms.clearQuick();
+
+    const int numRecords = index.getNumRecords();
+    recordTerms.ensureStorageAllocated (numRecords);
+
+    for (int i = 0; i < numRecords; ++i)
+        addRecord (i);
+
+    const ScopedLock ssl (sortedTermsLock);
+    sortedTermsValid = false;
+}
+
+void MusicLibrarySearchIndex::addRecord (int record)
+{
+    while (recordTerms.size() <= record)
+        recordTerms.add ({});
+
+    Array<uint32>& termsForRecord = recordTerms.getReference (record);
+
+    for (int field = 0; field < numFields; ++field)
+    {
+        for (auto& token : tokenise (index.getString (record, fieldColumns[field])))
+        {
+            const int termId = getTermId (token);
+            const uint32 entry = ((uint32) record << fieldBits) | (uint32) field;
+            Array<uint32>& termPostings = *postings.getUnchecked (termId);
+
+            // records are usually added in order so this is normally just an append
+            if (termPostings.isEmpty() || termPostings.getLast() < entry)
+            {
+                termPostings.add (entry);
+            }
+            else
+            {
+                uint32* position = std::lower_bound (termPostings.begin(), termPostings.end(), entry);
+
+                if (position != termPostings.end() && *position == entry)
+                    continue;
+
+                termPostings.insert ((int) (position - termPostings.begin()), entry);
+            }
+
+            termsForRecord.add (((uint32) termId << fieldBits) | (uint32) field);
+        }
+    }
+}
+
+void MusicLibrarySearchIndex::removeRecord (int record)
+{
+    if (! isPositiveAndBelow (record, recordTerms.size()))
+        return;
+
+    Array<uint32>& termsForRecord = recordTerms.getReference (record);
+
+    for (auto termEntry : termsForRecord)
+    {
+        Array<uint32>& termPostings = *postings.getUnchecked ((int) (termEntry >> fieldBits));
+        const uint32 entry = ((uint32) record << fieldBits) | (termEntry & fieldMask);
+        uint32* position = std::lower_bound (termPostings.begin(), termPostings.end(), entry);
+
+        if (position != termPostings.end() && *position == entry)
+            termPostings.remove ((int) (position - termPostings.begin()));
+    }
+
+    termsForRecord.clearQuick();
+}
+
+int MusicLibrarySearchIndex::getTermId (const String& term)
+{
+    if (termIds.contains (term))
+        return termIds[term];
+
+    const int termId = terms.size();
+    terms.add (term);
+    termIds.set (term, termId);
+    postings.add (new Array<uint32>());
+
+    const ScopedLock sl (sortedTermsLock);
+    sortedTermsValid = false;
+
+    return termId;
+}
+
+//==============================================================================
+void MusicLibrarySearchIndex::recordsUpdated (MusicLibraryIndex&, const Array<int>& records)
+{
+    const ScopedWriteLock sl (lock);
+
+    for (auto record : records)
+    {
+        removeRecord (record);
+        addRecord (record);
+    }
+}
+
+void MusicLibrarySearchIndex::indexRebuilt (MusicLibraryIndex&)
+{
+    rebuild();
+}
@@ -0,0 +1,161 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef DROWAUDIO_MUSICLIBRARYSEARCHINDEX_H
+#define DROWAUDIO_MUSICLIBRARYSEARCHINDEX_H
+
+#include "dRowAudio_MusicLibraryIndex.h"
+
+//==============================================================================
+/** An inverted index of the words in a MusicLibraryIndex for fast searching.
+
+    The Artist, Song, Album, Genre, Sub_Genre and Label (iTunes comments) columns
+    are split into words which are case and diacritic folded, so "Beyoncé" can be
+    found by searching for "beyonce". Each word maps to the records it appears in,
+    so a search only has to look at the records that could possibly match.
+
+    Queries are made up of space separated terms which must all match. Each term
+    matches any word it is a prefix of. Terms can be restricted to a single field
+    by prefixing them with its name, and the BPM can be searched for by value or
+    range, e.g.
+    @code
+    daft artist:punk bpm:120-128
+    @endcode
+
+    The fields that can be used are artist, song (or title), album, genre,
+    subgenre (or grouping), label (or comments) and bpm.
+
+    The search index keeps itself up to date as records are added or changed in
+    the MusicLibraryIndex.
+
+    @see MusicLibraryIndex, MusicLibraryTable
+*/
+class MusicLibrarySearchIndex : private MusicLibraryIndex::Listener
+{
+public:
+    //==============================================================================
+    /** Creates a search index for a MusicLibraryIndex.
+        The MusicLibraryIndex must outlive this object.
+    */
+    explicit MusicLibrarySearchIndex (MusicLibraryIndex& indexToSearch);
+
+    /** Destructor. */
+    ~MusicLibrarySearchIndex() override;
+
+    //==============================================================================
+    /** Finds the records matching a query.
+
+        If some candidates are given the results will only contain records from
+        this set. This can be used to speed up searches which are refinements of
+        a previous one. The results will be in record order.
+
+        The shouldExit function will be called periodically and the search
+        abandoned if it returns true, in which case this returns false and the
+        results will be empty. This can be called from a background thread.
+    */
+    bool search (const juce::String& query,
+                 const juce::Array<int>* candidates,
+                 juce::Array<int>& results,
+                 const std::function<bool()>& shouldExit = nullptr) const;
+
+    /** Returns true if the results of a new query will be a subset of the results
+        of a previous one, i.e. it just adds more characters to the end.
+    */
+    static bool isRefinement (const juce::String& previousQuery, const juce::String& newQuery);
+
+    /** Splits some text into its case and diacritic folded words. */
+    static juce::StringArray tokenise (const juce::String& text);
+
+private:
+    //==============================================================================
+    enum Field
+    {
+        artistField = 0,
+        songField,
+        albumField,
+        genreField,
+        subGenreField,
+        labelField,
+        numFields
+    };
+
+    enum
+    {
+        fieldBits = 3,
+        fieldMask = (1 << fieldBits) - 1,
+        allFields = (1 << numFields) - 1
+    };
+
+    static const int fieldColumns[numFields];
+
+    //==============================================================================
+    MusicLibraryIndex& index;
+    juce::ReadWriteLock lock;
+
+    juce::StringArray terms;
+    juce::HashMap<juce::String, int> termIds;
+
+    // for each term, the records it appears in as (record << fieldBits | field), in order
+    juce::OwnedArray<juce::Array<juce::uint32>> postings;
+
+    // for each record, the terms it contains as (term << fieldBits | field)
+    juce::Array<juce::Array<juce::uint32>> recordTerms;
+
+    mutable juce::CriticalSection sortedTermsLock;
+    mutable juce::Array<int> sortedTermIds;
+    mutable bool sortedTermsValid;
+
+    //==============================================================================
+    void rebuild();
+    void addRecord (int record);
+    void removeRecord (int record);
+    int getTermId (const juce::String& term);
+
+    bool findRecordsWithPrefix (const juce::String& prefix, int fields, juce::Array<int>& records,
+                                const std::function<bool()>& shouldExit) const;
+    bool findRecordsInBPMRange (const juce::String& range, juce::Array<int>& records,
+                                const std::function<bool()>& shouldExit) const;
+    void updateSortedTerms() const;
+
+    static int getFieldsForName (const juce::String& name);
+    static void intersect (juce::Array<int>& results, const juce::Array<int>& records);
+
+    //==============================================================================
+    /** @internal */
+    void recordsUpdated (MusicLibraryIndex&, const juce::Array<int>& records) override;
+    /** @internal */
+    void indexRebuilt (MusicLibraryIndex&) override;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MusicLibrarySearchIndex)
+};
+
+#endif // DROWAUDIO_MUSICLIBRARYSEARCHINDEX_H
@@ -0,0 +1,673 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+namespace MusicLibrarySnapshotHelpers
+{
+    /*  All values are little endian and each section starts on an 8 byte boundary.
+
+        header          magic, version, total size, then the counts and offsets of the sections below
+        string table    (numStrings + 1) offsets into the string data, then the UTF-8 string data
+        columns         for each item property: its kind for every item (1 byte) then its value (8 bytes)
+        column table    name, kinds offset, values offset, reserved
+        records         type, first node, number of nodes for each item
+        nodes           type, first property, number of properties, first child, number of children
+        properties      name, kind, value
+    */
+    enum
+    {
+        headerSize          = 64,
+        columnEntrySize     = 16,
+        recordEntrySize     = 12,
+        nodeEntrySize       = 20,
+        propertyEntrySize   = 16
+    };
+
+    enum ValueKind
+    {
+        missingValue = 0,
+        stringValue,
+        intValue,
+        int64Value,
+        doubleValue,
+        boolValue
+    };
+
+    static const uint32 magicNumber = ByteOrder::littleEndianInt ("dRLS");
+
+    static void padToBoundary (MemoryOutputStream& out)
+    {
+        while ((out.getPosition() & 7) != 0)
+            out.writeByte (0);
+    }
+
+    //==============================================================================
+    class Builder
+    {
+    public:
+        Builder() = default;
+
+        MemoryBlock build (const ValueTree& libraryTree)
+        {
+            const int numItems = libraryTree.getNumChildren();
+
+            // the root node only holds the library's own properties, its items are stored as records
+            nodes.add (Node());
+            nodes.getReference (0).typeId = addString (libraryTree.getType().toString());
+            nodes.getReference (0).firstProperty = addProperties (libraryTree);
+            nodes.getReference (0).numProperties = (uint32) libraryTree.getNumProperties();
+
+            for (int i = 0; i < numItems; ++i)
+            {
+                const ValueTree item (libraryTree.getChild (i));
+
+                for (int p = 0; p < item.getNumProperties(); ++p)
+                {
+                    const String name (item.getPropertyName (p).toString());
+
+                    if (! columnIds.contains (name))
+                    {
+                        columnIds.set (name, columns.size());
+                        columns.add (new Column (addString (name), numItems));
+                    }
+                }
+            }
+
+            Array<uint32> records;
+            records.ensureStorageAllocated (numItems * 3);
+
+            for (int i = 0; i < numItems; ++i)
+            {
+                const ValueTree item (libraryTree.getChild (i));
+
+                for (int p = 0; p < item.getNumProperties(); ++p)
+                {
+                    const Identifier name (item.getPropertyName (p));
+                    Column& column = *columns.getUnchecked (columnIds[name.toString()]);
+
+                    uint32 kind;
+                    encodeValue (item.getProperty (name), kind, column.values[i]);
+                    column.kinds[i] = (uint8) kind;
+                }
+
+                records.add (addString (item.getType().toString()));
+                records.add (addChildren (item));
+                records.add ((uint32) item.getNumChildren());
+            }
+
+            return write (numItems, records);
+        }
+
+    private:
+        //==============================================================================
+        struct Column
+        {
+            Column (uint32 nameId_, int numItems)
+                : nameId (nameId_),
+                  kinds ((size_t) numItems, true),
+                  values ((size_t) numItems, true)
+            {
+            }
+
+            uint32 nameId;
+            HeapBlock<uint8> kinds;
+            HeapBlock<int64> values;
+        };
+
+        struct Node
+        {
+            uint32 typeId = 0, firstProperty = 0, numProperties = 0, firstChild = 0, numChildren = 0;
+        };
+
+        struct Property
+        {
+            uint32 nameId = 0, kind = 0;
+            int64 value = 0;
+        };
+
+        StringArray strings;
+        HashMap<String, int> stringIds;
+        HashMap<String, int> columnIds;
+        OwnedArray<Column> columns;
+        Array<Node> nodes;
+        Array<Property> properties;
+
+        //==============================================================================
+        uint32 addString (const String& string)
+        {
+            if (stringIds.contains (string))
+                return (uint32) stringIds[string];
+
+            const int stringId = strings.size();
+            strings.add (string);
+            stringIds.set (string, stringId);
+
+            return (uint32) stringId;
+        }
+
+        void encodeValue (const var& value, uint32& kind, int64& encoded)
+        {
+            if (value.isVoid())
+            {
+                kind = missingValue;
+                encoded = 0;
+            }
+            else if (value.isInt())
+            {
+                kind = intValue;
+                encoded = (int) value;
+            }
+            else if (value.isInt64())
+            {
+                kind = int64Value;
+                encoded = (int64) value;
+            }
+            else if (value.isDouble())
+            {
+                const double number = value;
+                kind = doubleValue;
+                memcpy (&encoded, &number, sizeof (encoded));
+            }
+            else if (value.isBool())
+            {
+                kind = boolValue;
+                encoded = (bool) value ? 1 : 0;
+            }
+            else
+            {
+                kind = stringValue;
+                encoded = addString (value.toString());
+            }
+        }
+
+        uint32 addProperties (const ValueTree& tree)
+        {
+            const uint32 firstProperty = (uint32) properties.size();
+
+            for (int i = 0; i < tree.getNumProperties(); ++i)
+            {
+                const Identifier name (tree.getPropertyName (i));
+
+                Property property;
+                property.nameId = addString (name.toString());
+                encodeValue (tree.getProperty (name), property.kind, property.value);
+                properties.add (property);
+            }
+
+            return firstProperty;
+        }
+
+        /** Adds a tree's children next to each other, followed by their own children. */
+        uint32 addChildren (const ValueTree& parent)
+        {
+            const int firstNode = nodes.size();
+            const int numChildren = parent.getNumChildren();
+            nodes.insertMultiple (-1, Node(), numChildren);
+
+            for (int i = 0; i < numChildren; ++i)
+            {
+                const ValueTree child (parent.getChild (i));
+
+                Node node;
+                node.typeId = addString (child.getType().toString());
+                node.firstProperty = addProperties (child);
+                node.numProperties = (uint32) child.getNumProperties();
+                node.firstChild = addChildren (child);
+                node.numChildren = (uint32) child.getNumChildren();
+
+                nodes.setUnchecked (firstNode + i, node);
+            }
+
+            return (uint32) firstNode;
+        }
+
+        //==============================================================================
+        MemoryBlock write (int numItems, const Array<uint32>& records)
+        {
+            MemoryBlock data;
+
+            {
+                MemoryOutputStream out (data, false);
+                out.writeRepeatedByte (0, headerSize);
+
+                const uint32 stringOffsetsOffset = (uint32) out.getPosition();
+                uint32 stringDataSize = 0;
+                out.writeInt (0);
+
+                for (auto& string : strings)
+                {
+                    stringDataSize += (uint32) string.getNumBytesAsUTF8();
+                    out.writeInt ((int) stringDataSize);
+                }
+
+                const uint32 stringDataOffset = (uint32) out.getPosition();
+
+                for (auto& string : strings)
+                    out.write (string.toRawUTF8(), string.getNumBytesAsUTF8());
+
+                padToBoundary (out);
+
+                Array<uint32> columnOffsets;
+
+                for (auto* column : columns)
+                {
+                    columnOffsets.add ((uint32) out.getPosition());
+                    out.write (column->kinds, (size_t) numItems);
+                    padToBoundary (out);
+
+                    columnOffsets.add ((uint32) out.getPosition());
+
+                    for (int i = 0; i < numItems; ++i)
+                        out.writeInt64 (column->values[i]);
+                }
+
+                const uint32 columnsOffset = (uint32) out.getPosition();
+
+                for (int i = 0; i < columns.size(); ++i)
+                {
+                    out.writeInt ((int) columns.getUnchecked (i)->nameId);
+                    out.writeInt ((int) columnOffsets.getUnchecked (i * 2));
+                    out.writeInt ((int) columnOffsets.getUnchecked (i * 2 + 1));
+                    out.writeInt (0);
+                }
+
+                const uint32 recordsOffset = (uint32) out.getPosition();
+
+                for (auto value : records)
+                    out.writeInt ((int) value);
+
+                const uint32 nodesOffset = (uint32) out.getPosition();
+
+                for (auto& node : nodes)
+                {
+                    out.writeInt ((int) node.typeId);
+                    out.writeInt ((int) node.firstProperty);
+                    out.writeInt ((int) node.numProperties);
+                    out.writeInt ((int) node.firstChild);
+                    out.writeInt ((int) node.numChildren);
+                }
+
+                padToBoundary (out);
+                const uint32 propertiesOffset = (uint32) out.getPosition();
+
+                for (auto& property : properties)
+                {
+                    out.writeInt ((int) property.nameId);
+                    out.writeInt ((int) property.kind);
+                    out.writeInt64 (property.value);
+                }
+
+                const uint32 totalSize = (uint32) out.getPosition();
+
+                out.setPosition (0);
+                out.writeInt ((int) magicNumber);
+                out.writeInt ((int) MusicLibrarySnapshot::formatVersion);
+                out.writeInt ((int) totalSize);
+                out.writeInt (strings.size());
+                out.writeInt ((int) stringOffsetsOffset);
+                out.writeInt ((int) stringDataOffset);
+                out.writeInt ((int) stringDataSize);
+                out.writeInt (numItems);
+                out.writeInt (columns.size());
+                out.writeInt ((int) columnsOffset);
+                out.writeInt ((int) recordsOffset);
+                out.writeInt (nodes.size());
+                out.writeInt ((int) nodesOffset);
+                out.writeInt (properties.size());
+                out.writeInt ((int) propertiesOffset);
+                out.writeInt (0);
+            }
+
+            return data;
+        }
+
+        JUCE_DECLARE_NON_COPYABLE (Builder)
+    };
+}
+
+//==============================================================================
+const uint32 MusicLibrarySnapshot::formatVersion = 1;
+
+MusicLibrarySnapshot::MusicLibrarySnapshot (const File& snapshotFile)
+    : data (nullptr),
+      dataSize (0),
+      numStrings (0), numRecords (0), numColumns (0), numNodes (0), numProperties (0),
+      stringOffsetsOffset (0), stringDataOffset (0), stringDataSize (0),
+      columnsOffset (0), recordsOffset (0), nodesOffset (0), propertiesOffset (0)
+{
+    if (snapshotFile.existsAsFile())
+    {
+        mappedFile = std::make_unique<MemoryMappedFile> (snapshotFile, MemoryMappedFile::readOnly);
+        data = static_cast<const char*> (mappedFile->getData());
+        dataSize = mappedFile->getSize();
+    }
+
+    if (data == nullptr || ! readHeader())
+    {
+        data = nullptr;
+        dataSize = 0;
+        numRecords = 0;
+        columns.clear();
+        mappedFile = nullptr;
+    }
+}
+
+MusicLibrarySnapshot::~MusicLibrarySnapshot()
+{
+}
+
+//==============================================================================
+var MusicLibrarySnapshot::getItemProperty (int itemIndex, const Identifier& property) const
+{
+    if (! isPositiveAndBelow (itemIndex, (int) numRecords))
+        return {};
+
+    for (auto& column : columns)
+        if (column.name == property)
+            return decodeValue ((uint8) data[column.kindsOffset + (size_t) itemIndex],
+                                readInt64 (column.valuesOffset + (size_t) itemIndex * 8));
+
+    return {};
+}
+
+ValueTree MusicLibrarySnapshot::getItem (int itemIndex)
+{
+    using namespace MusicLibrarySnapshotHelpers;
+
+    if (! isPositiveAndBelow (itemIndex, (int) numRecords))
+        return {};
+
+    if (items.isEmpty())
+        items.resize ((int) numRecords);
+
+    ValueTree& item = items.getReference (itemIndex);
+
+    if (! item.isValid())
+    {
+        const size_t entry = recordsOffset + (size_t) itemIndex * recordEntrySize;
+        const Identifier type (getIdentifier (readUInt32 (entry)));
+
+        item = ValueTree (type.isValid() ? type : MusicColumns::libraryItemIdentifier);
+
+        for (auto& column : columns)
+        {
+            const uint32 kind = (uint8) data[column.kindsOffset + (size_t) itemIndex];
+
+            if (kind != missingValue)
+                item.setProperty (column.name, decodeValue (kind, readInt64 (column.valuesOffset + (size_t) itemIndex * 8)), nullptr);
+        }
+
+        addNodes (item, 0, readUInt32 (entry + 4), readUInt32 (entry + 8));
+    }
+
+    return item;
+}
+
+ValueTree MusicLibrarySnapshot::getLibraryRoot()
+{
+    if (libraryTree.isValid() || ! isValid())
+        return libraryTree;
+
+    libraryTree = createNode (0);
+
+    if (! libraryTree.isValid())
+        libraryTree = ValueTree (MusicColumns::libraryIdentifier);
+
+    return libraryTree;
+}
+
+ValueTree MusicLibrarySnapshot::getLibraryTree()
+{
+    ValueTree tree (getLibraryRoot());
+
+    // items are always added in order so carry on from any that already have been
+    for (int i = tree.getNumChildren(); i < (int) numRecords; ++i)
+        tree.appendChild (getItem (i), nullptr);
+
+    return tree;
+}
+
+//==============================================================================
+MemoryBlock MusicLibrarySnapshot::createSnapshotData (const ValueTree& libraryTree)
+{
+    MusicLibrarySnapshotHelpers::Builder builder;
+    return builder.build (libraryTree);
+}
+
+bool MusicLibrarySnapshot::writeSnapshotData (const MemoryBlock& snapshotData, const File& file)
+{
+    if (! file.getParentDirectory().createDirectory())
+        return false;
+
+    TemporaryFile tempFile (file);
+
+    {
+        FileOutputStream out (tempFile.getFile());
+
+        if (! out.openedOk()
+            || ! out.write (snapshotData.getData(), snapshotData.getSize()))
+            return false;
+
+        out.flush();
+
+        if (out.getStatus().failed())
+            return false;
+    }
+
+    return tempFile.overwriteTargetFileWithTemporary();
+}
+
+bool MusicLibrarySnapshot::writeToFile (const ValueTree& libraryTree, const File& file)
+{
+    return writeSnapshotData (createSnapshotData (libraryTree), file);
+}
+
+//==============================================================================
+bool MusicLibrarySnapshot::readHeader()
+{
+    using namespace MusicLibrarySnapshotHelpers;
+
+    if (dataSize < headerSize
+        || readUInt32 (0) != magicNumber
+        || readUInt32 (4) != formatVersion
+        || readUInt32 (8) != dataSize)
+        return false;
+
+    numStrings          = readUInt32 (12);
+    stringOffsetsOffset = readUInt32 (16);
+    stringDataOffset    = readUInt32 (20);
+    stringDataSize      = readUInt32 (24);
+    numRecords          = readUInt32 (28);
+    numColumns          = readUInt32 (32);
+    columnsOffset       = readUInt32 (36);
+    recordsOffset       = readUInt32 (40);
+    numNodes            = readUInt32 (44);
+    nodesOffset         = readUInt32 (48);
+    numProperties       = readUInt32 (52);
+    propertiesOffset    = readUInt32 (56);
+
+    if (! (containsRange (stringOffsetsOffset, ((uint64) numStrings + 1) * 4)
+           && containsRange (stringDataOffset, stringDataSize)
+           && containsRange (columnsOffset, (uint64) numColumns * columnEntrySize)
+           && containsRange (recordsOffset, (uint64) numRecords * recordEntrySize)
+           && containsRange (nodesOffset, (uint64) numNodes * nodeEntrySize)
+           && containsRange (propertiesOffset, (uint64) numProperties * propertyEntrySize)
+           && numRecords < (uint32) std::numeric_limits<int>::max()))
+        return false;
+
+    strings.insertMultiple (0, var(), (int) numStrings);
+
+    for (uint32 i = 0; i < numColumns; ++i)
+    {
+        const size_t entry = columnsOffset + (size_t) i * columnEntrySize;
+        const String name (getString (readUInt32 (entry)).toString());
+
+        Column column;
+        column.kindsOffset = readUInt32 (entry + 4);
+        column.valuesOffset = readUInt32 (entry + 8);
+
+        if (name.isEmpty()
+            || ! containsRange (column.kindsOffset, numRecords)
+            || ! containsRange (column.valuesOffset, (uint64) numRecords * 8))
+            return false;
+
+        column.name = Identifier (name);
+        columns.add (column);
+    }
+
+    return true;
+}
+
+uint32 MusicLibrarySnapshot::readUInt32 (size_t offset) const noexcept
+{
+    return ByteOrder::littleEndianInt (data + offset);
+}
+
+int64 MusicLibrarySnapshot::readInt64 (size_t offset) const noexcept
+{
+    return (int64) ByteOrder::littleEndianInt64 (data + offset);
+}
+
+bool MusicLibrarySnapshot::containsRange (uint32 offset, uint64 size) const noexcept
+{
+    return offset + size <= (uint64) dataSize;
+}
+
+//==============================================================================
+const var& MusicLibrarySnapshot::getString (uint32 stringId) const
+{
+    static const var missingString;
+
+    if (stringId >= numStrings)
+        return missingString;
+
+    var& string = strings.getReference ((int) stringId);
+
+    if (string.isVoid())
+    {
+        const size_t entry = stringOffsetsOffset + (size_t) stringId * 4;
+        const uint32 start = readUInt32 (entry);
+        const uint32 end = readUInt32 (entry + 4);
+
+        if (start <= end && end <= stringDataSize)
+            string = String::fromUTF8 (data + stringDataOffset + start, (int) (end - start));
+        else
+            string = String();
+    }
+
+    return string;
+}
+
+Identifier MusicLibrarySnapshot::getIdentifier (uint32 stringId)
+{
+    if (identifiers.contains ((int) stringId))
+        return identifiers[(int) stringId];
+
+    const String name (getString (stringId).toString());
+    const Identifier identifier (name.isNotEmpty() ? Identifier (name) : Identifier());
+    identifiers.set ((int) stringId, identifier);
+
+    return identifier;
+}
+
+var MusicLibrarySnapshot::decodeValue (uint32 kind, int64 value) const
+{
+    using namespace MusicLibrarySnapshotHelpers;
+
+    switch (kind)
+    {
+        case stringValue:   return getString ((uint32) value);
+        case intValue:      return (int) value;
+        case int64Value:    return value;
+        case boolValue:     return value != 0;
+
+        case doubleValue:
+        {
+            double number;
+            memcpy (&number, &value, sizeof (number));
+            return number;
+        }
+
+        default:            return {};
+    }
+}
+
+//==============================================================================
+ValueTree MusicLibrarySnapshot::createNode (uint32 nodeIndex)
+{
+    using namespace MusicLibrarySnapshotHelpers;
+
+    if (nodeIndex >= numNodes)
+        return {};
+
+    const size_t entry = nodesOffset + (size_t) nodeIndex * nodeEntrySize;
+    const Identifier type (getIdentifier (readUInt32 (entry)));
+
+    if (! type.isValid())
+        return {};
+
+    ValueTree node (type);
+
+    const uint32 firstProperty = readUInt32 (entry + 4);
+    const uint32 numNodeProperties = readUInt32 (entry + 8);
+
+    if ((uint64) firstProperty + numNodeProperties <= numProperties)
+    {
+        for (uint32 i = 0; i < numNodeProperties; ++i)
+        {
+            const size_t property = propertiesOffset + (size_t) (firstProperty + i) * propertyEntrySize;
+            const Identifier name (getIdentifier (readUInt32 (property)));
+
+            if (name.isValid())
+                node.setProperty (name, decodeValue (readUInt32 (property + 4), readInt64 (property + 8)), nullptr);
+        }
+    }
+
+    addNodes (node, nodeIndex, readUInt32 (entry + 12), readUInt32 (entry + 16));
+
+    return node;
+}
+
+void MusicLibrarySnapshot::addNodes (ValueTree& parent, uint32 parentNode, uint32 firstNode, uint32 numNodesToAdd)
+{
+    // children are always stored after their parents so a damaged file can't make us loop
+    if (numNodesToAdd == 0
+        || firstNode <= parentNode
+        || (uint64) firstNode + numNodesToAdd > numNodes)
+        return;
+
+    for (uint32 i = 0; i < numNodesToAdd; ++i)
+    {
+        ValueTree child (createNode (firstNode + i));
+
+        if (child.isValid())
+            parent.appendChild (child, nullptr);
+    }
+}
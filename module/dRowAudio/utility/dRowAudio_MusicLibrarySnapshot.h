@@ -0,0 +1,156 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef DROWAUDIO_MUSICLIBRARYSNAPSHOT_H
+#define DROWAUDIO_MUSICLIBRARYSNAPSHOT_H
+
+#include "dRowAudio_MusicLibraryHelpers.h"
+
+//==============================================================================
+/** A compact binary snapshot of a music library tree.
+
+    Loading a library that has been saved as XML means parsing the whole file
+    and creating every ValueTree up front. A snapshot instead stores each
+    unique string once and the item properties column by column, so opening
+    one just memory maps the file and checks its header. Items are only turned
+    into ValueTrees as they're asked for, along with any cue or loop trees
+    they hold.
+
+    Snapshots are versioned, if the file is from a different version or is
+    damaged isValid() will return false and the library should be re-parsed.
+
+    @code
+        MusicLibrarySnapshot snapshot (snapshotFile);
+
+        if (snapshot.isValid())
+            libraryTree = snapshot.getLibraryTree();
+    @endcode
+
+    The methods that create ValueTrees aren't thread safe so should only be
+    called from one thread at a time.
+
+    @see ITunesLibrary::setSnapshotFile
+*/
+class MusicLibrarySnapshot
+{
+public:
+    //==============================================================================
+    /** Opens a snapshot file. */
+    explicit MusicLibrarySnapshot (const juce::File& snapshotFile);
+
+    /** Destructor. */
+    ~MusicLibrarySnapshot();
+
+    /** Returns true if the file was a snapshot that can be read. */
+    bool isValid() const noexcept                       { return data != nullptr; }
+
+    /** Returns the number of items in the library. */
+    int getNumItems() const noexcept                    { return (int) numRecords; }
+
+    /** Returns one of the item's properties without creating its ValueTree. */
+    juce::var getItemProperty (int itemIndex, const juce::Identifier& property) const;
+
+    /** Returns the ValueTree for an item, creating it the first time it's asked for.
+        This will be the same ValueTree that is used in the library tree.
+    */
+    juce::ValueTree getItem (int itemIndex);
+
+    /** Returns the library tree holding only the library's own properties.
+        Items can then be added to it as they're needed with getItem(), e.g. in
+        batches so the first ones can be shown before the rest have been created.
+        This will return an invalid tree if the snapshot isn't valid.
+    */
+    juce::ValueTree getLibraryRoot();
+
+    /** Returns the whole library tree, creating and adding any items that haven't been yet.
+        This will return an invalid tree if the snapshot isn't valid.
+    */
+    juce::ValueTree getLibraryTree();
+
+    //==============================================================================
+    /** Encodes a library tree as snapshot data.
+        The tree shouldn't be modified while this is being called.
+    */
+    static juce::MemoryBlock createSnapshotData (const juce::ValueTree& libraryTree);
+
+    /** Writes some snapshot data to a file.
+        This writes to a temporary file first and then replaces the target so
+        a reader will never see a partially written snapshot.
+    */
+    static bool writeSnapshotData (const juce::MemoryBlock& snapshotData, const juce::File& file);
+
+    /** Writes a library tree to a snapshot file. */
+    static bool writeToFile (const juce::ValueTree& libraryTree, const juce::File& file);
+
+    /** The version of the snapshot format written by this class. */
+    static const juce::uint32 formatVersion;
+
+private:
+    //==============================================================================
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    const char* data;
+    size_t dataSize;
+
+    juce::uint32 numStrings, numRecords, numColumns, numNodes, numProperties;
+    juce::uint32 stringOffsetsOffset, stringDataOffset, stringDataSize;
+    juce::uint32 columnsOffset, recordsOffset, nodesOffset, propertiesOffset;
+
+    struct Column
+    {
+        juce::Identifier name;
+        juce::uint32 kindsOffset, valuesOffset;
+    };
+
+    juce::Array<Column> columns;
+    mutable juce::Array<juce::var> strings;
+    juce::HashMap<int, juce::Identifier> identifiers;
+
+    juce::ValueTree libraryTree;
+    juce::Array<juce::ValueTree> items;
+
+    //==============================================================================
+    bool readHeader();
+    juce::uint32 readUInt32 (size_t offset) const noexcept;
+    juce::int64 readInt64 (size_t offset) const noexcept;
+    bool containsRange (juce::uint32 offset, juce::uint64 size) const noexcept;
+
+    const juce::var& getString (juce::uint32 stringId) const;
+    juce::Identifier getIdentifier (juce::uint32 stringId);
+    juce::var decodeValue (juce::uint32 kind, juce::int64 value) const;
+
+    juce::ValueTree createNode (juce::uint32 nodeIndex);
+    void addNodes (juce::ValueTree& parent, juce::uint32 parentNode, juce::uint32 firstNode, juce::uint32 numNodesToAdd);
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MusicLibrarySnapshot)
+};
+
+#endif // DROWAUDIO_MUSICLIBRARYSNAPSHOT_H
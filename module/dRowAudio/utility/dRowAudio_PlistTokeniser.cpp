@@ -0,0 +1,379 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+namespace PlistTokeniserHelpers
+{
+    static bool isNameCharacter (char c) noexcept
+    {
+        return ! (c == '>' || c == '/' || CharacterFunctions::isWhitespace (c));
+    }
+
+    static bool nameIs (const char* nameStart, const char* nameEnd, const char* name) noexcept
+    {
+        const size_t length = strlen (name);
+
+        return (size_t) (nameEnd - nameStart) == length
+                && memcmp (nameStart, name, length) == 0;
+    }
+
+    static bool startsWith (const char* text, const char* end, const char* prefix) noexcept
+    {
+        const size_t length = strlen (prefix);
+
+        return (size_t) (end - text) >= length
+                && memcmp (text, prefix, length) == 0;
+    }
+
+    static const char* find (const char* text, const char* end, const char* toFind) noexcept
+    {
+        const char* const toFindEnd = toFind + strlen (toFind);
+        const char* found = std::search (text, end, toFind, toFindEnd);
+
+        return found != end ? found : nullptr;
+    }
+}
+
+//==============================================================================
+PlistTokeniser::PlistTokeniser (const void* sourceData, size_t sourceDataSize) noexcept :
+    start (static_cast<const char*> (sourceData)),
+    end (start + sourceDataSize),
+    current (start),
+    textStart (nullptr),
+    textEnd (nullptr),
+    type (dictEnd),
+    depth (0),
+    textNeedsDecoding (false),
+    pendingEmptyContainerEnd (false)
+{
+    if (start == nullptr)
+        type = endOfInput;
+}
+
+//==============================================================================
+PlistTokeniser::TokenType PlistTokeniser::readNext()
+{
+    using namespace PlistTokeniserHelpers;
+
+    if (type == endOfInput || type == error)
+        return type;
+
+    textStart = textEnd = nullptr;
+
+    if (pendingEmptyContainerEnd)
+    {
+        pendingEmptyContainerEnd = false;
+        --depth;
+        return type = (type == dictStart ? dictEnd : arrayEnd);
+    }
+
+    for (;;)
+    {
+        while (current < end && CharacterFunctions::isWhitespace (*current))
+            ++current;
+
+        if (current >= end)
+            return type = endOfInput;
+
+        if (*current != '<')
+            return type = error;
+
+        if (startsWith (current, end, "<?"))
+        {
+            if (! skipPast ("?>"))
+                return type = error;
+        }
+        else if (startsWith (current, end, "<!--"))
+        {
+            if (! skipPast ("-->"))
+                return type = error;
+        }
+        else if (startsWith (current, end, "<!"))
+        {
+            if (! skipPast (">"))
+                return type = error;
+        }
+        else if (startsWith (current, end, "</"))
+        {
+            const TokenType closingType = readClosingTag();
+
+            // the closing </plist> isn't reported
+            if (closingType != endOfInput)
+                return type = closingType;
+        }
+        else
+        {
+            const TokenType elementType = readElement();
+
+            // the opening <plist> isn't reported
+            if (elementType != endOfInput)
+                return type = elementType;
+        }
+    }
+}
+
+PlistTokeniser::TokenType PlistTokeniser::readElement()
+{
+    using namespace PlistTokeniserHelpers;
+
+    const char* const nameStart = ++current;
+
+    while (current < end && isNameCharacter (*current))
+        ++current;
+
+    const char* const nameEnd = current;
+
+    // skip any attributes
+    while (current < end && *current != '>')
+        ++current;
+
+    if (current >= end)
+        return error;
+
+    const bool isEmptyElement = *(current - 1) == '/';
+    ++current;
+
+    if (nameIs (nameStart, nameEnd, "plist"))
+        return endOfInput;
+
+    if (nameIs (nameStart, nameEnd, "dict") || nameIs (nameStart, nameEnd, "array"))
+    {
+        ++depth;
+        pendingEmptyContainerEnd = isEmptyElement;
+        return *nameStart == 'd' ? dictStart : arrayStart;
+    }
+
+    if (nameIs (nameStart, nameEnd, "true") || nameIs (nameStart, nameEnd, "false"))
+    {
+        if (! isEmptyElement && ! skipPast (">"))
+            return error;
+
+        return *nameStart == 't' ? trueValue : falseValue;
+    }
+
+    if (nameIs (nameStart, nameEnd, "key"))      return readTextContent (key, isEmptyElement);
+    if (nameIs (nameStart, nameEnd, "string"))   return readTextContent (string, isEmptyElement);
+    if (nameIs (nameStart, nameEnd, "integer"))  return readTextContent (integer, isEmptyElement);
+    if (nameIs (nameStart, nameEnd, "real"))     return readTextContent (real, isEmptyElement);
+    if (nameIs (nameStart, nameEnd, "date"))     return readTextContent (date, isEmptyElement);
+    if (nameIs (nameStart, nameEnd, "data"))     return readTextContent (data, isEmptyElement);
+
+    return error;
+}
+
+PlistTokeniser::TokenType PlistTokeniser::readClosingTag()
+{
+    using namespace PlistTokeniserHelpers;
+
+    const char* const nameStart = current + 2;
+    current = nameStart;
+
+    while (current < end && isNameCharacter (*current))
+        ++current;
+
+    const char* const nameEnd = current;
+
+    if (! skipPast (">"))
+        return error;
+
+    if (nameIs (nameStart, nameEnd, "plist"))
+        return endOfInput;
+
+    if (depth <= 0)
+        return error;
+
+    if (nameIs (nameStart, nameEnd, "dict"))
+    {
+        --depth;
+        return dictEnd;
+    }
+
+    if (nameIs (nameStart, nameEnd, "array"))
+    {
+        --depth;
+        return arrayEnd;
+    }
+
+    return error;
+}
+
+PlistTokeniser::TokenType PlistTokeniser::readTextContent (TokenType typeOfText, bool isEmptyElement)
+{
+    textStart = textEnd = current;
+    textNeedsDecoding = false;
+
+    if (isEmptyElement)
+        return typeOfText;
+
+    // text can't contain a raw '<' so the next one will be the closing tag
+    const char* const closingTag = static_cast<const char*> (memchr (current, '<', (size_t) (end - current)));
+
+    if (closingTag == nullptr)
+        return error;
+
+    textEnd = closingTag;
+    textNeedsDecoding = memchr (textStart, '&', (size_t) (textEnd - textStart)) != nullptr;
+    current = closingTag;
+
+    if (! skipPast (">"))
+        return error;
+
+    return typeOfText;
+}
+
+bool PlistTokeniser::skipPast (const char* terminator) noexcept
+{
+    if (const char* found = PlistTokeniserHelpers::find (current, end, terminator))
+    {
+        current = found + strlen (terminator);
+        return true;
+    }
+
+    current = end;
+    return false;
+}
+
+void PlistTokeniser::skipValue()
+{
+    if (type != dictStart && type != arrayStart)
+        return;
+
+    const int targetDepth = depth - 1;
+
+    while (depth > targetDepth)
+    {
+        const TokenType nextType = readNext();
+
+        if (nextType == endOfInput || nextType == error)
+            break;
+    }
+}
+
+//==============================================================================
+String PlistTokeniser::getText() const
+{
+    if (textStart == nullptr || textStart == textEnd)
+        return {};
+
+    if (! textNeedsDecoding)
+        return String::fromUTF8 (textStart, (int) (textEnd - textStart));
+
+    String decoded;
+    decoded.preallocateBytes ((size_t) (textEnd - textStart));
+
+    const char* chunkStart = textStart;
+    const char* t = textStart;
+
+    while (t < textEnd)
+    {
+        if (*t != '&')
+        {
+            ++t;
+            continue;
+        }
+
+        const char* const entityEnd = static_cast<const char*> (memchr (t, ';', (size_t) (textEnd - t)));
+
+        if (entityEnd == nullptr)
+            break;
+
+        decoded += String::fromUTF8 (chunkStart, (int) (t - chunkStart));
+
+        const String entity (t + 1, (size_t) (entityEnd - t - 1));
+
+        if (entity == "amp")            decoded += '&';
+        else if (entity == "lt")        decoded += '<';
+        else if (entity == "gt")        decoded += '>';
+        else if (entity == "quot")      decoded += '"';
+        else if (entity == "apos")      decoded += '\'';
+        else if (entity.startsWithChar ('#'))
+        {
+            const juce_wchar c = (juce_wchar) (entity[1] == 'x' || entity[1] == 'X'
+                                                  ? entity.substring (2).getHexValue32()
+                                                  : entity.substring (1).getIntValue());
+            if (c != 0)
+                decoded += c;
+        }
+        else
+        {
+            decoded += String (t, (size_t) (entityEnd - t + 1));
+        }
+
+        t = chunkStart = entityEnd + 1;
+    }
+
+    decoded += String::fromUTF8 (chunkStart, (int) (textEnd - chunkStart));
+
+    return decoded;
+}
+
+int64 PlistTokeniser::getIntValue() const noexcept
+{
+    const char* t = textStart;
+
+    if (t == nullptr)
+        return 0;
+
+    while (t < textEnd && CharacterFunctions::isWhitespace (*t))
+        ++t;
+
+    const bool isNegative = t < textEnd && *t == '-';
+
+    if (isNegative || (t < textEnd && *t == '+'))
+        ++t;
+
+    int64 value = 0;
+
+    while (t < textEnd && CharacterFunctions::isDigit (*t))
+        value = value * 10 + (*t++ - '0');
+
+    return isNegative ? -value : value;
+}
+
+bool PlistTokeniser::textEquals (const char* textToCompare) const noexcept
+{
+    if (textStart == nullptr)
+        return false;
+
+    return PlistTokeniserHelpers::nameIs (textStart, textEnd, textToCompare);
+}
+
+bool PlistTokeniser::textContains (const char* textToFind) const noexcept
+{
+    if (textStart == nullptr)
+        return false;
+
+    return PlistTokeniserHelpers::find (textStart, textEnd, textToFind) != nullptr;
+}
+
+double PlistTokeniser::getProgress() const noexcept
+{
+    return end > start ? (current - start) / (double) (end - start) : 1.0;
+}
@@ -0,0 +1,143 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef DROWAUDIO_PLISTTOKENISER_H
+#define DROWAUDIO_PLISTTOKENISER_H
+
+//==============================================================================
+/** Reads an XML property list as a stream of tokens.
+
+    Rather than building a whole XmlDocument this walks over a block of memory,
+    usually a memory-mapped file, returning each key, value and container as it
+    goes. This means very large files such as iTunes libraries can be read using
+    an amount of memory proportional to a single entry rather than the whole file.
+
+    Text is only decoded when you ask for it, and keys can be compared in-place
+    without creating any Strings. Tokenisers are cheap to copy so you can take a
+    copy to come back to a position later on.
+
+    @code
+    PlistTokeniser tokeniser (data, size);
+
+    while (tokeniser.readNext() != PlistTokeniser::endOfInput)
+        if (tokeniser.getTokenType() == PlistTokeniser::key && tokeniser.textEquals ("Tracks"))
+            ...
+    @endcode
+
+    @see ITunesLibraryParser
+*/
+class PlistTokeniser
+{
+public:
+    //==============================================================================
+    /** The types of token that can be read. */
+    enum TokenType
+    {
+        dictStart = 0,  //< A <dict> element has been opened.
+        dictEnd,        //< The current <dict> has been closed.
+        arrayStart,     //< An <array> element has been opened.
+        arrayEnd,       //< The current <array> has been closed.
+        key,            //< A <key>, use getText() to find its name.
+        string,         //< A <string> value.
+        integer,        //< An <integer> value.
+        real,           //< A <real> value.
+        date,           //< A <date> value in ISO 8601 format.
+        data,           //< A base-64 encoded <data> value.
+        trueValue,      //< A <true/> value.
+        falseValue,     //< A <false/> value.
+        endOfInput,     //< The end of the data has been reached.
+        error           //< The data was malformed.
+    };
+
+    //==============================================================================
+    /** Creates a tokeniser to read a block of UTF-8 data.
+        The data must remain valid for the lifetime of the tokeniser.
+    */
+    PlistTokeniser (const void* sourceData, size_t sourceDataSize) noexcept;
+
+    //==============================================================================
+    /** Moves on to the next token and returns its type.
+        Once endOfInput or error has been returned this will keep returning it.
+    */
+    TokenType readNext();
+
+    /** Returns the type of the last token read. */
+    TokenType getTokenType() const noexcept         { return type; }
+
+    /** Returns the number of containers currently open. */
+    int getDepth() const noexcept                   { return depth; }
+
+    /** Skips over the value that has just been read.
+        If this is a dict or an array this will move past its matching end token,
+        otherwise this does nothing.
+    */
+    void skipValue();
+
+    //==============================================================================
+    /** Returns the decoded text of the last key or value read. */
+    juce::String getText() const;
+
+    /** Returns the text of the last key or value read as an integer. */
+    juce::int64 getIntValue() const noexcept;
+
+    /** Returns true if the raw text of the last token matches the given string exactly.
+        This doesn't allocate so is the quickest way to look for a particular key.
+    */
+    bool textEquals (const char* textToCompare) const noexcept;
+
+    /** Returns true if the raw text of the last token contains the given string. */
+    bool textContains (const char* textToFind) const noexcept;
+
+    /** Returns the proportion of the data that has been read so far, from 0 to 1. */
+    double getProgress() const noexcept;
+
+private:
+    //==============================================================================
+    const char* start;
+    const char* end;
+    const char* current;
+    const char* textStart;
+    const char* textEnd;
+
+    TokenType type;
+    int depth;
+    bool textNeedsDecoding, pendingEmptyContainerEnd;
+
+    bool skipPast (const char* terminator) noexcept;
+    TokenType readElement();
+    TokenType readClosingTag();
+    TokenType readTextContent (TokenType typeOfText, bool isEmptyElement);
+
+    //==============================================================================
+    JUCE_LEAK_DETECTOR (PlistTokeniser)
+};
+
+#endif // DROWAUDIO_PLISTTOKENISER_H
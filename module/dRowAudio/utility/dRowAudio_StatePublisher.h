@@ -0,0 +1,337 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#ifndef DROWAUDIO_STATEPUBLISHER_H
+#define DROWAUDIO_STATEPUBLISHER_H
+
+//==============================================================================
+/** Passes snapshots of some state from one thread to another without locking.
+
+    This is a triple buffer; one slot is owned by the writer, one by the reader
+    and the third holds the most recently published snapshot. Publishing and
+    reading just swap slot indexes so neither side ever waits for the other,
+    making it ideal for sending state from the audio thread to the UI. Only the
+    latest snapshot is kept, any the reader doesn't get to are simply dropped.
+
+    There must only be a single writer and a single reader thread. If several
+    threads need to read the state use a SeqLock instead.
+
+    In debug builds the number of stale reads, where no new snapshot had been
+    published since the last read, and torn reads, which can only happen if
+    there is more than one writer or reader, are counted.
+
+    @code
+    struct MeterState { float peak, rms; };
+    TripleBuffer<MeterState> meterState;
+
+    // audio thread
+    meterState.publish ({ peak, rms });
+
+    // message thread
+    MeterState state;
+    if (meterState.read (state))
+        repaint();
+    @endcode
+
+    @see SeqLock
+*/
+template <typename Type>
+class TripleBuffer
+{
+public:
+    static_assert (std::is_trivially_copyable<Type>::value, "TripleBuffer can only hold trivially copyable types");
+
+    //==============================================================================
+    /** Creates a TripleBuffer with an initial state. */
+    explicit TripleBuffer (const Type& initialState = Type())
+        : middleIndex (1), writeIndex (0), readIndex (2)
+    {
+        for (auto& slot : slots)
+            slot.state = initialState;
+    }
+
+    //==============================================================================
+    /** Publishes a new snapshot of the state.
+        This should only be called from the writer thread.
+    */
+    void publish (const Type& newState) noexcept
+    {
+        getWriteState() = newState;
+        commit();
+    }
+
+    /** Returns the writer's slot so the state can be built in place.
+        Call commit() once it's complete to publish it.
+    */
+    Type& getWriteState() noexcept
+    {
+       #if JUCE_DEBUG
+        // an odd sequence marks the slot as being written to
+        if ((slots[writeIndex].sequence.load (std::memory_order_relaxed) & 1) == 0)
+            slots[writeIndex].sequence.fetch_add (1, std::memory_order_relaxed);
+       #endif
+
+        return slots[writeIndex].state;
+    }
+
+    /** Publishes the state in the writer's slot. */
+    void commit() noexcept
+    {
+       #if JUCE_DEBUG
+        if ((slots[writeIndex].sequence.load (std::memory_order_relaxed) & 1) != 0)
+            slots[writeIndex].sequence.fetch_add (1, std::memory_order_release);
+       #endif
+
+        writeIndex = middleIndex.exchange (writeIndex | newStateFlag, std::memory_order_acq_rel) & indexMask;
+    }
+
+    //==============================================================================
+    /** Copies the latest snapshot into destination.
+        This should only be called from the reader thread.
+        @returns true if the snapshot is newer than the one returned by the previous read
+    */
+    bool read (Type& destination) noexcept
+    {
+        const bool isNew = update();
+
+       #if JUCE_DEBUG
+        const juce::uint32 sequenceBefore = slots[readIndex].sequence.load (std::memory_order_acquire);
+       #endif
+
+        destination = slots[readIndex].state;
+
+       #if JUCE_DEBUG
+        if ((sequenceBefore & 1) != 0 || sequenceBefore != slots[readIndex].sequence.load (std::memory_order_relaxed))
+            ++numTornReads;
+       #endif
+
+        return isNew;
+    }
+
+    /** Returns the latest snapshot.
+        The reference is valid until the next call to read() or getLatest() on the reader thread.
+    */
+    const Type& getLatest() noexcept
+    {
+        update();
+        return slots[readIndex].state;
+    }
+
+    /** Returns true if a snapshot has been published that the reader hasn't yet seen. */
+    bool hasNewState() const noexcept
+    {
+        return (middleIndex.load (std::memory_order_relaxed) & newStateFlag) != 0;
+    }
+
+   #if JUCE_DEBUG
+    /** Returns the number of reads made when no new snapshot was available. */
+    juce::int64 getNumStaleReads() const noexcept   { return numStaleReads.load(); }
+
+    /** Returns the number of reads that were overwritten as they were made.
+        This should always be 0 and indicates there is more than one writer or reader.
+    */
+    juce::int64 getNumTornReads() const noexcept    { return numTornReads.load(); }
+   #endif
+
+private:
+    //==============================================================================
+    struct alignas (64) Slot
+    {
+        Type state;
+
+       #if JUCE_DEBUG
+        std::atomic<juce::uint32> sequence { 0 };
+       #endif
+    };
+
+    enum
+    {
+        indexMask = 3,
+        newStateFlag = 4
+    };
+
+    Slot slots[3];
+    std::atomic<int> middleIndex;
+    int writeIndex, readIndex;
+
+   #if JUCE_DEBUG
+    std::atomic<juce::int64> numStaleReads { 0 }, numTornReads { 0 };
+   #endif
+
+    //==============================================================================
+    bool update() noexcept
+    {
+        if (! hasNewState())
+        {
+           #if JUCE_DEBUG
+            ++numStaleReads;
+           #endif
+
+            return false;
+        }
+
+        readIndex = middleIndex.exchange (readIndex, std::memory_order_acq_rel) & indexMask;
+
+        return true;
+    }
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE (TripleBuffer)
+};
+
+//==============================================================================
+/** Publishes snapshots of some state from one thread to any number of readers.
+
+    The writer never waits; it bumps a sequence number before and after each
+    write. Readers copy the state and then check the sequence number hasn't changed,
+    trying again if the writer was part way through. The state is stored as atomic
+    words so these copies are well defined even when they overlap a write.
+
+    This is best suited to small states that are read more often than written,
+    e.g. the playback position of a player shown in several components.
+
+    In debug builds the number of stale reads, where the state hadn't changed since
+    the reader last looked, and torn reads, that had to be retried, are counted.
+
+    @see TripleBuffer
+*/
+template <typename Type>
+class SeqLock
+{
+public:
+    static_assert (std::is_trivially_copyable<Type>::value, "SeqLock can only hold trivially copyable types");
+
+    //==============================================================================
+    /** Creates a SeqLock with an initial state. */
+    explicit SeqLock (const Type& initialState = Type())
+        : sequence (0)
+    {
+        publish (initialState);
+        sequence.store (0, std::memory_order_relaxed);
+    }
+
+    //==============================================================================
+    /** Publishes a new snapshot of the state.
+        This should only be called from a single writer thread.
+    */
+    void publish (const Type& newState) noexcept
+    {
+        Word words[numWords] = {};
+        std::memcpy (words, &newState, sizeof (Type));
+
+        const juce::uint32 start = sequence.load (std::memory_order_relaxed);
+        sequence.store (start + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence (std::memory_order_release);
+
+        for (int i = 0; i < numWords; ++i)
+            storage[i].store (words[i], std::memory_order_relaxed);
+
+        sequence.store (start + 2, std::memory_order_release);
+    }
+
+    /** Returns a consistent copy of the latest snapshot.
+        This can be called from any number of threads.
+    */
+    Type read() const noexcept
+    {
+        // an odd number is never published so this read won't be counted as stale
+        juce::uint32 sequenceNumber = 1;
+        return read (sequenceNumber);
+    }
+
+    /** Returns a consistent copy of the latest snapshot along with the sequence
+        number it was published with.
+        Pass in the number returned by the reader's previous call; if it's unchanged
+        the state hasn't been published since.
+    */
+    Type read (juce::uint32& sequenceNumber) const noexcept
+    {
+        Word words[numWords];
+
+        for (;;)
+        {
+            const juce::uint32 start = sequence.load (std::memory_order_acquire);
+
+            if ((start & 1) == 0)
+            {
+                for (int i = 0; i < numWords; ++i)
+                    words[i] = storage[i].load (std::memory_order_relaxed);
+
+                std::atomic_thread_fence (std::memory_order_acquire);
+
+                if (sequence.load (std::memory_order_relaxed) == start)
+                {
+                   #if JUCE_DEBUG
+                    if (start == sequenceNumber)
+                        ++numStaleReads;
+                   #endif
+
+                    sequenceNumber = start;
+                    break;
+                }
+            }
+
+           #if JUCE_DEBUG
+            ++numTornReads;
+           #endif
+        }
+
+        Type state;
+        std::memcpy (&state, words, sizeof (Type));
+
+        return state;
+    }
+
+   #if JUCE_DEBUG
+    /** Returns the number of reads made with a sequence number that was already up to date. */
+    juce::int64 getNumStaleReads() const noexcept   { return numStaleReads.load(); }
+
+    /** Returns the number of times a read overlapped a write and had to be retried. */
+    juce::int64 getNumTornReads() const noexcept    { return numTornReads.load(); }
+   #endif
+
+private:
+    //==============================================================================
+    typedef juce::uint64 Word;
+    enum { numWords = (int) ((sizeof (Type) + sizeof (Word) - 1) / sizeof (Word)) };
+
+    std::atomic<juce::uint32> sequence;
+    std::atomic<Word> storage[numWords];
+
+   #if JUCE_DEBUG
+    mutable std::atomic<juce::int64> numStaleReads { 0 }, numTornReads { 0 };
+   #endif
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE (SeqLock)
+};
+
+#endif // DROWAUDIO_STATEPUBLISHER_H
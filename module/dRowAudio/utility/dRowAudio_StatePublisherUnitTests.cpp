@@ -0,0 +1,198 @@
+/*
+  ==============================================================================
+
+  This file is part of the dRowAudio JUCE module
+  Copyright 2004-13 by dRowAudio.
+
+  ------------------------------------------------------------------------------
+
+  dRowAudio is provided under the terms of The MIT License (MIT):
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+  ==============================================================================
+*/
+
+#if DROWAUDIO_UNIT_TESTS
+
+//==============================================================================
+class StatePublisherTests  : public UnitTest
+{
+public:
+    StatePublisherTests() : UnitTest ("StatePublisher") {}
+
+    void runTest() override
+    {
+        beginTest ("TripleBuffer");
+        testTripleBuffer();
+
+        beginTest ("SeqLock");
+        testSeqLock();
+    }
+
+private:
+    //==============================================================================
+    /*  Each snapshot is several words long with the second and third derived from
+        the first, so a read that mixed two snapshots can be spotted.
+    */
+    struct State
+    {
+        int64 count, check;
+        double value;
+    };
+
+    enum { numWrites = 200000 };
+
+    static State makeState (int64 count) noexcept
+    {
+        return { count, ~count, (double) count * 0.5 };
+    }
+
+    static bool isConsistent (const State& state) noexcept
+    {
+        return state.check == ~state.count && state.value == (double) state.count * 0.5;
+    }
+
+    //==============================================================================
+    class TestThread  : public Thread
+    {
+    public:
+        TestThread (const String& name, std::function<void()> f)
+            : Thread (name), function (std::move (f))
+        {
+            startThread();
+        }
+
+        ~TestThread() override
+        {
+            stopThread (-1);
+        }
+
+        void run() override
+        {
+            function();
+        }
+
+        std::function<void()> function;
+    };
+
+    //==============================================================================
+    void testTripleBuffer()
+    {
+        TripleBuffer<State> buffer (makeState (0));
+        std::atomic<bool> writerFinished (false);
+        int numInconsistent = 0, numOutOfOrder = 0;
+        int64 lastCount = 0;
+
+        {
+            TestThread writer ("TripleBuffer writer", [&]
+                               {
+                                   for (int64 i = 1; i <= numWrites; ++i)
+                                       buffer.publish (makeState (i));
+
+                                   writerFinished = true;
+                               });
+
+            for (;;)
+            {
+                const bool wasFinished = writerFinished;
+                State state;
+                buffer.read (state);
+
+                if (! isConsistent (state))
+                    ++numInconsistent;
+
+                if (state.count < lastCount)
+                    ++numOutOfOrder;
+
+                lastCount = state.count;
+
+                if (wasFinished)
+                    break;
+            }
+        }
+
+        expectEquals (numInconsistent, 0);
+        expectEquals (numOutOfOrder, 0);
+
+        // once the writer has finished the reader must end up with the last snapshot
+        expectEquals (lastCount, (int64) numWrites);
+        expect (! buffer.hasNewState());
+
+       #if JUCE_DEBUG
+        expectEquals (buffer.getNumTornReads(), (int64) 0);
+       #endif
+    }
+
+    void testSeqLock()
+    {
+        SeqLock<State> lock (makeState (0));
+        std::atomic<bool> writerFinished (false);
+        std::atomic<int> numInconsistent (0), numOutOfOrder (0);
+        std::atomic<int64> finalCounts[2] = { { 0 }, { 0 } };
+
+        {
+            TestThread writer ("SeqLock writer", [&]
+                               {
+                                   for (int64 i = 1; i <= numWrites; ++i)
+                                       lock.publish (makeState (i));
+
+                                   writerFinished = true;
+                               });
+
+            OwnedArray<TestThread> readers;
+
+            for (int r = 0; r < 2; ++r)
+            {
+                readers.add (new TestThread ("SeqLock reader", [&, r]
+                                             {
+                                                 int64 lastCount = 0;
+
+                                                 for (;;)
+                                                 {
+                                                     const bool wasFinished = writerFinished;
+                                                     const State state (lock.read());
+
+                                                     if (! isConsistent (state))
+                                                         ++numInconsistent;
+
+                                                     if (state.count < lastCount)
+                                                         ++numOutOfOrder;
+
+                                                     lastCount = state.count;
+
+                                                     if (wasFinished)
+                                                         break;
+                                                 }
+
+                                                 finalCounts[r] = lastCount;
+                                             }));
+            }
+        }
+
+        expectEquals (numInconsistent.load(), 0);
+        expectEquals (numOutOfOrder.load(), 0);
+        expectEquals (finalCounts[0].load(), (int64) numWrites);
+        expectEquals (finalCounts[1].load(), (int64) numWrites);
+    }
+};
+
+static StatePublisherTests statePublisherTests;
+
+#endif // DROWAUDIO_UNIT_TESTS
@@ -37,6 +37,9 @@
     This can be used instead of keeping track of a current and previous state
     of a primitive variable. Just calling set() will automatically update the
     new and previous states.
+
+    This isn't synchronised so shouldn't be used to pass state between threads,
+    use a TripleBuffer or SeqLock for that.
  */
 template<class Type>
 class StateVariable
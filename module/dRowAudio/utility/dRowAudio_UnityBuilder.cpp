@@ -29,88 +29,374 @@
   ==============================================================================
 */
 
+//==============================================================================
+namespace UnityBuilderHelpers
+{
+    /** FNV-1a, this only needs to detect changes so doesn't have to be cryptographic. */
+    static int64 hashData (const void* data, size_t numBytes) noexcept
+    {
+        uint64 hash = 14695981039346656037ULL;
+        const uint8* bytes = static_cast<const uint8*> (data);
+
+        for (size_t i = 0; i < numBytes; ++i)
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
+
+        return (int64) hash;
+    }
+
+    /** Calls function (i) for each of numTasks on a pool of threads and waits for them all to finish. */
+    template <typename FunctionType>
+    static void runInParallel (int numTasks, FunctionType function)
+    {
+        if (numTasks <= 0)
+            return;
+
+        ThreadPool pool (jmin (numTasks, SystemStats::getNumCpus()));
+        std::atomic<int> numRemaining (numTasks);
+        WaitableEvent finished;
+
+        for (int i = 0; i < numTasks; ++i)
+        {
+            pool.addJob ([i, &function, &numRemaining, &finished]
+                         {
+                             function (i);
+
+                             if (--numRemaining == 0)
+                                 finished.signal();
+                         });
+        }
+
+        finished.wait();
+    }
+
+    /** Returns the files a source file #includes with quotes that can be found,
+        either next to it or relative to the source directory.
+    */
+    static Array<File> findLocalIncludes (const File& file, const juce::String& contents, const File& sourceDirectory)
+    {
+        Array<File> includes;
+        StringArray lines;
+        lines.addLines (contents);
+
+        for (auto& line : lines)
+        {
+            const juce::String trimmed (line.trimStart());
+
+            if (! trimmed.startsWith ("#include"))
+                continue;
+
+            const juce::String path (trimmed.substring (8).trimStart());
+
+            if (! path.startsWithChar ('"'))
+                continue;
+
+            const juce::String includePath (path.substring (1).upToFirstOccurrenceOf ("\"", false, false));
+            File included (file.getSiblingFile (includePath));
+
+            if (! included.existsAsFile())
+                included = sourceDirectory.getChildFile (includePath);
+
+            if (included.existsAsFile())
+                includes.addIfNotAlreadyThere (included);
+        }
+
+        return includes;
+    }
+
+    struct ScannedFile
+    {
+        int64 hash = 0, size = 0;
+        Array<File> includes;
+    };
+
+    static ScannedFile scanFile (const File& file, const File& sourceDirectory)
+    {
+        ScannedFile scanned;
+        MemoryBlock data;
+        file.loadFileAsData (data);
+
+        scanned.hash = hashData (data.getData(), data.getSize());
+        scanned.size = (int64) data.getSize();
+        scanned.includes = findLocalIncludes (file, data.toString(), sourceDirectory);
+
+        return scanned;
+    }
+
+    struct CachedFile
+    {
+        int64 hash;
+        double measuredCost;
+    };
+
+    static const Identifier cacheTag    ("UNITY_CACHE");
+    static const Identifier fileTag     ("FILE");
+    static const Identifier pathAttr    ("path");
+    static const Identifier hashAttr    ("hash");
+    static const Identifier costAttr    ("cost");
+}
+
 //==============================================================================
 UnityBuilder::UnityBuilder()
+    : numChunks (1),
+      incremental (false)
 {
 }
 
 bool UnityBuilder::processDirectory (const File& sourceDirectory)
 {
-    if (sourceDirectory.isDirectory())
+    using namespace UnityBuilderHelpers;
+
+    changedChunks.clearQuick();
+
+    if (! sourceDirectory.isDirectory())
+        return false;
+
+    File outputFile (destinationFile == File() ? sourceDirectory : destinationFile);
+
+    if (! outputFile.hasWriteAccess())
+        return false;
+
+    const File outputDir (outputFile.isDirectory() ? outputFile : outputFile.getParentDirectory());
+    const juce::String baseName (outputFile.isDirectory() ? juce::String ("UnityBuild") : outputFile.getFileNameWithoutExtension());
+
+    auto getOutputFile = [&] (const juce::String& name, const juce::String& extension)
     {
-        Array<File> files;
-        sourceDirectory.findChildFiles (files, juce::File::findFiles + juce::File::ignoreHiddenFiles, true);
+        return incremental ? outputDir.getChildFile (name + extension)
+                           : outputDir.getNonexistentChildFile (name, extension);
+    };
+
+    const File headerFile (getOutputFile (baseName, ".h"));
+    Array<File> chunkFiles;
+
+    for (int i = 0; i < numChunks; ++i)
+        chunkFiles.add (getOutputFile (numChunks == 1 ? baseName : baseName + juce::String (i), ".cpp"));
+
+    // find the sources and hash them in parallel
+    const Array<File> files (findFiles (sourceDirectory));
+    juce::String includeString;
+    StringArray sourcePaths;
+    Array<File> sourceFiles, headerFiles;
 
-        juce::String includeString, sourceString;
+    for (auto& file : files)
+    {
+        const juce::String relativePath (file.getRelativePathFrom (sourceDirectory));
 
-        for (int i = 0; i < files.size(); ++i)
+        if (file.hasFileExtension (".h"))
+        {
+            includeString << "#include \"" << relativePath << "\"" << newLine;
+            headerFiles.add (file);
+        }
+        else if (file.hasFileExtension (".cpp"))
         {
-            bool includeFile = true;
-            const File& currentFile = files.getReference (i);
+            sourcePaths.add (relativePath);
+            sourceFiles.add (file);
+        }
+    }
+
+    // the sources come first followed by the headers, which are included by every chunk
+    const int numSources = sourceFiles.size();
+    Array<File> scannedFiles (sourceFiles);
+    scannedFiles.addArray (headerFiles);
+
+    std::vector<ScannedFile> scanned ((size_t) scannedFiles.size());
+
+    runInParallel (scannedFiles.size(), [&] (int i)
+                   {
+                       scanned[(size_t) i] = scanFile (scannedFiles.getReference (i), sourceDirectory);
+                   });
+
+    // follow any includes that weren't in the tree so edits to them are picked up too
+    HashMap<juce::String, int> scannedIndexes;
+
+    for (int i = 0; i < scannedFiles.size(); ++i)
+        scannedIndexes.set (scannedFiles.getReference (i).getFullPathName(), i);
+
+    std::vector<Array<int>> includedIndexes;
 
-            // first check files
-            if (! filesToIgnore.contains (currentFile))
+    for (size_t i = 0; i < scanned.size(); ++i)
+    {
+        const Array<File> includes (scanned[i].includes);
+        Array<int> indexes;
+
+        for (auto& included : includes)
+        {
+            const juce::String fullPath (included.getFullPathName());
+
+            if (! scannedIndexes.contains (fullPath))
             {
-                // now check for directories
-                for (int f = 0; f < filesToIgnore.size(); ++f)
-                {
-                    const File& currentDir = filesToIgnore.getReference (f);
-
-                    if (currentDir.isDirectory()
-                        && currentFile.isAChildOf (currentDir))
-                    {
-                        includeFile = false;
-                        break;
-                    }
-                }
-
-                if (includeFile)
-                {
-                    const juce::String relativePath (currentFile.getRelativePathFrom (sourceDirectory));
-
-                    if (currentFile.hasFileExtension (".h"))
-                        includeString << "#include \"" << relativePath << "\"" << newLine;
-                    else if (currentFile.hasFileExtension (".cpp"))
-                        sourceString << "#include \"" << relativePath << "\"" << newLine;
-                }
+                scannedIndexes.set (fullPath, scannedFiles.size());
+                scannedFiles.add (included);
+                scanned.push_back (scanFile (included, sourceDirectory));
             }
+
+            indexes.add (scannedIndexes[fullPath]);
         }
 
-        // now write the output files
-        File outputFile (destinationFile == File() ? sourceDirectory : destinationFile);
+        includedIndexes.push_back (indexes);
+    }
 
-        if (outputFile.hasWriteAccess())
-        {
-            File headerFile, cppFile;
+    StringArray scannedPaths;
 
-            if (outputFile.isDirectory())
-            {
-                const juce::String baseName ("UnityBuild");
+    for (auto& file : scannedFiles)
+        scannedPaths.add (file.getRelativePathFrom (sourceDirectory));
 
-                headerFile = outputFile.getNonexistentChildFile (baseName, ".h");
-                cppFile = outputFile.getNonexistentChildFile (baseName, ".cpp");
-            }
-            else
+    // look up what we knew about the sources on the last run
+    const File cacheFile (outputDir.getChildFile (baseName + ".unitycache"));
+    HashMap<juce::String, CachedFile> cache;
+
+    if (incremental)
+    {
+        if (std::unique_ptr<XmlElement> cacheXml = XmlDocument::parse (cacheFile))
+        {
+            for (auto* e = cacheXml->getChildByName (fileTag); e != nullptr; e = e->getNextElementWithTagName (fileTag))
             {
-                headerFile = outputFile.getNonexistentSibling().withFileExtension (".h");
-                cppFile = outputFile.getNonexistentSibling().withFileExtension (".cpp");
+                CachedFile cached;
+                cached.hash = e->getStringAttribute (hashAttr).getHexValue64();
+                cached.measuredCost = e->getDoubleAttribute (costAttr, -1.0);
+                cache.set (e->getStringAttribute (pathAttr), cached);
             }
+        }
+    }
+
+    // measured costs are only valid until a file changes, estimate the rest from their size
+    Array<double> costs;
+    double totalMeasuredCost = 0.0, totalMeasuredSize = 0.0;
 
-            juce::String headerOutput (preInclusionString);
-            juce::String sourceOutput (preInclusionString);
+    for (int i = 0; i < numSources; ++i)
+    {
+        const juce::String& path = sourcePaths[i];
+        const juce::String fullPath (sourceFiles.getReference (i).getFullPathName());
+        double cost = measuredCosts.contains (fullPath) ? measuredCosts[fullPath] : -1.0;
 
-            headerOutput << includeString << postInclusionString;
-            sourceOutput << "#include \"" << headerFile.getFileName() << "\"" << newLine << newLine
-                << sourceString << postInclusionString;
+        if (cost < 0.0 && cache.contains (path) && cache[path].hash == scanned[(size_t) i].hash)
+            cost = cache[path].measuredCost;
 
-            headerFile.replaceWithText (headerOutput);
-            cppFile.replaceWithText (sourceOutput);
+        if (cost >= 0.0)
+        {
+            totalMeasuredCost += cost;
+            totalMeasuredSize += (double) scanned[(size_t) i].size;
+        }
 
-            return true;
+        costs.add (cost);
+    }
+
+    const double costPerByte = totalMeasuredSize > 0.0 ? totalMeasuredCost / totalMeasuredSize : 1.0;
+    Array<double> balancingCosts;
+
+    for (int i = 0; i < numSources; ++i)
+        balancingCosts.add (costs[i] >= 0.0 ? costs[i] : (double) scanned[(size_t) i].size * costPerByte);
+
+    // keep files in the chunks they were in before
+    Array<int> previousChunks;
+    previousChunks.insertMultiple (0, -1, numSources);
+
+    if (incremental)
+    {
+        for (int c = 0; c < numChunks; ++c)
+        {
+            const StringArray includes (readIncludes (chunkFiles.getReference (c)));
+
+            for (int i = 0; i < numSources; ++i)
+                if (includes.contains (sourcePaths[i]))
+                    previousChunks.set (i, c);
         }
     }
 
-    return false;
+    const Array<int> chunks (assignChunks (balancingCosts, previousChunks, numChunks));
+
+    // a chunk needs recompiling if any of its sources or anything they include has changed
+    auto haveInputsChanged = [&] (int chunk)
+    {
+        std::vector<bool> visited (scanned.size(), false);
+        Array<int> toVisit;
+
+        for (int i = 0; i < numSources; ++i)
+            if (chunks[i] == chunk)
+                toVisit.add (i);
+
+        for (int i = numSources; i < numSources + headerFiles.size(); ++i)
+            toVisit.add (i);
+
+        while (! toVisit.isEmpty())
+        {
+            const int i = toVisit.removeAndReturn (toVisit.size() - 1);
+
+            if (visited[(size_t) i])
+                continue;
+
+            visited[(size_t) i] = true;
+            const juce::String& path = scannedPaths[i];
+
+            if (! (cache.contains (path) && cache[path].hash == scanned[(size_t) i].hash))
+                return true;
+
+            toVisit.addArray (includedIndexes[(size_t) i]);
+        }
+
+        return false;
+    };
+
+    // now write the output files
+    replaceFileIfChanged (headerFile, preInclusionString + includeString + postInclusionString);
+
+    for (int c = 0; c < numChunks; ++c)
+    {
+        const File& chunkFile = chunkFiles.getReference (c);
+        juce::String sourceOutput (preInclusionString);
+
+        sourceOutput << "#include \"" << headerFile.getFileName() << "\"" << newLine << newLine;
+
+        for (int i = 0; i < numSources; ++i)
+            if (chunks[i] == c)
+                sourceOutput << "#include \"" << sourcePaths[i] << "\"" << newLine;
+
+        sourceOutput << postInclusionString;
+
+        const bool inputsChanged = haveInputsChanged (c);
+
+        if ((incremental ? replaceFileIfChanged (chunkFile, sourceOutput) : chunkFile.replaceWithText (sourceOutput))
+             || inputsChanged)
+            changedChunks.add (chunkFile);
+    }
+
+    if (incremental)
+    {
+        // remove any chunks left over from a run that used more of them
+        for (int i = (numChunks == 1 ? 0 : numChunks);; ++i)
+        {
+            const File staleFile (outputDir.getChildFile (baseName + juce::String (i) + ".cpp"));
+
+            if (! staleFile.existsAsFile())
+                break;
+
+            if (readIncludes (staleFile).contains (headerFile.getFileName()))
+                staleFile.deleteFile();
+        }
+
+        if (numChunks > 1)
+        {
+            const File staleFile (outputDir.getChildFile (baseName + ".cpp"));
+
+            if (readIncludes (staleFile).contains (headerFile.getFileName()))
+                staleFile.deleteFile();
+        }
+
+        XmlElement cacheXml (cacheTag);
+
+        for (int i = 0; i < scannedFiles.size(); ++i)
+        {
+            XmlElement* e = cacheXml.createNewChildElement (fileTag);
+            e->setAttribute (pathAttr, scannedPaths[i]);
+            e->setAttribute (hashAttr, juce::String::toHexString (scanned[(size_t) i].hash));
+
+            if (i < numSources && costs[i] >= 0.0)
+                e->setAttribute (costAttr, costs[i]);
+        }
+
+        replaceFileIfChanged (cacheFile, cacheXml.toString());
+    }
+
+    return true;
 }
 
 void UnityBuilder::setDestinationFile (const File& newDestinationFile)
@@ -129,3 +415,288 @@ void UnityBuilder::setPreAndPostString (const juce::String& preInclusionString_,
     preInclusionString = preInclusionString_;
     postInclusionString = postInclusionString_;
 }
+
+void UnityBuilder::setNumChunks (int newNumChunks)
+{
+    jassert (newNumChunks > 0);
+    numChunks = jmax (1, newNumChunks);
+}
+
+void UnityBuilder::setIncremental (bool shouldBeIncremental)
+{
+    incremental = shouldBeIncremental;
+}
+
+void UnityBuilder::setCompileCost (const File& sourceFile, double cost)
+{
+    measuredCosts.set (sourceFile.getFullPathName(), jmax (0.0, cost));
+}
+
+//==============================================================================
+Array<int> UnityBuilder::assignChunks (const Array<double>& costs, const Array<int>& previousChunks, int numChunks)
+{
+    jassert (costs.size() == previousChunks.size());
+    numChunks = jmax (1, numChunks);
+
+    const int numFiles = costs.size();
+    Array<int> chunks;
+    Array<double> chunkCosts;
+    chunkCosts.insertMultiple (0, 0.0, numChunks);
+
+    auto getCheapestChunk = [&chunkCosts, numChunks]
+    {
+        int cheapest = 0;
+
+        for (int c = 1; c < numChunks; ++c)
+            if (chunkCosts[c] < chunkCosts[cheapest])
+                cheapest = c;
+
+        return cheapest;
+    };
+
+    auto getMaxChunkCost = [&chunkCosts]
+    {
+        double maxCost = 0.0;
+
+        for (auto cost : chunkCosts)
+            maxCost = jmax (maxCost, cost);
+
+        return maxCost;
+    };
+
+    // the most expensive files are placed first as they are the hardest to balance
+    Array<int> order;
+
+    for (int i = 0; i < numFiles; ++i)
+        order.add (i);
+
+    std::stable_sort (order.begin(), order.end(), [&costs] (int a, int b) { return costs[a] > costs[b]; });
+
+    for (int i = 0; i < numFiles; ++i)
+    {
+        const int previous = previousChunks[i];
+        chunks.add (isPositiveAndBelow (previous, numChunks) ? previous : -1);
+
+        if (chunks[i] >= 0)
+            chunkCosts.getReference (chunks[i]) += costs[i];
+    }
+
+    for (auto i : order)
+    {
+        if (chunks[i] < 0)
+        {
+            const int cheapest = getCheapestChunk();
+            chunks.set (i, cheapest);
+            chunkCosts.getReference (cheapest) += costs[i];
+        }
+    }
+
+    // if keeping files where they were has left things too uneven start again from scratch
+    double totalCost = 0.0;
+
+    for (auto cost : costs)
+        totalCost += cost;
+
+    const double maxChunkCost = getMaxChunkCost();
+
+    if (maxChunkCost > 1.25 * totalCost / numChunks)
+    {
+        Array<int> rebalancedChunks;
+        rebalancedChunks.insertMultiple (0, 0, numFiles);
+        chunkCosts.fill (0.0);
+
+        for (auto i : order)
+        {
+            const int cheapest = getCheapestChunk();
+            rebalancedChunks.set (i, cheapest);
+            chunkCosts.getReference (cheapest) += costs[i];
+        }
+
+        if (getMaxChunkCost() < maxChunkCost)
+            return rebalancedChunks;
+    }
+
+    return chunks;
+}
+
+StringArray UnityBuilder::readIncludes (const File& unityFile)
+{
+    StringArray includes;
+
+    if (unityFile.existsAsFile())
+    {
+        StringArray lines;
+        unityFile.readLines (lines);
+
+        for (auto& line : lines)
+            if (line.trimStart().startsWith ("#include \""))
+                includes.add (line.fromFirstOccurrenceOf ("\"", false, false).upToLastOccurrenceOf ("\"", false, false));
+    }
+
+    return includes;
+}
+
+bool UnityBuilder::replaceFileIfChanged (const File& file, const juce::String& newContents)
+{
+    if (file.existsAsFile() && file.loadFileAsString() == newContents)
+        return false;
+
+    return file.replaceWithText (newContents);
+}
+
+//==============================================================================
+Array<File> UnityBuilder::findFiles (const File& sourceDirectory) const
+{
+    // each sub-directory is scanned on its own thread
+    Array<File> directories;
+    Array<File> files;
+
+    for (DirectoryEntry entry : RangedDirectoryIterator (sourceDirectory, false, "*",
+                                                         File::findFilesAndDirectories + File::ignoreHiddenFiles))
+    {
+        const File& file = entry.getFile();
+
+        if (shouldIgnore (file))
+            continue;
+
+        if (entry.isDirectory())
+            directories.add (file);
+        else
+            files.add (file);
+    }
+
+    OwnedArray<Array<File>> directoryFiles;
+
+    for (int i = 0; i < directories.size(); ++i)
+        directoryFiles.add (new Array<File>());
+
+    UnityBuilderHelpers::runInParallel (directories.size(), [&] (int i)
+                                        {
+                                            Array<File>& found = *directoryFiles.getUnchecked (i);
+                                            directories.getReference (i).findChildFiles (found, File::findFiles + File::ignoreHiddenFiles, true);
+                                        });
+
+    for (auto* found : directoryFiles)
+        for (auto& file : *found)
+            if (! shouldIgnore (file))
+                files.add (file);
+
+    // sort so the output doesn't depend on the order the threads finished in
+    files.sort();
+
+    return files;
+}
+
+bool UnityBuilder::shouldIgnore (const File& file) const
+{
+    if (filesToIgnore.contains (file))
+        return true;
+
+    for (auto& ignored : filesToIgnore)
+        if (ignored.isDirectory() && file.isAChildOf (ignored))
+            return true;
+
+    return false;
+}
+
+//==============================================================================
+#if DROWAUDIO_UNIT_TESTS
+
+class UnityBuilderTests  : public UnitTest
+{
+public:
+    UnityBuilderTests() : UnitTest ("UnityBuilder") {}
+
+    void runTest() override
+    {
+        beginTest ("Chunk balancing");
+        {
+            const Array<double> costs { 8.0, 7.0, 6.0, 5.0, 4.0, 2.0 };
+            Array<int> previous;
+            previous.insertMultiple (0, -1, costs.size());
+
+            Array<int> chunks (UnityBuilder::assignChunks (costs, previous, 2));
+            expect (std::abs (getChunkCost (costs, chunks, 0) - getChunkCost (costs, chunks, 1)) <= 2.0);
+
+            // adding a file shouldn't move any of the others
+            Array<double> newCosts (costs);
+            newCosts.add (1.0);
+            previous = chunks;
+            previous.add (-1);
+
+            const Array<int> newChunks (UnityBuilder::assignChunks (newCosts, previous, 2));
+
+            for (int i = 0; i < chunks.size(); ++i)
+                expectEquals (newChunks[i], chunks[i]);
+        }
+
+        beginTest ("Incremental output");
+        {
+            const TemporaryFile tempDir;
+            const File sourceDir (tempDir.getFile());
+            sourceDir.createDirectory();
+            sourceDir.getChildFile ("a.cpp").replaceWithText ("#include \"a.inl\"\nint a;");
+            sourceDir.getChildFile ("a.inl").replaceWithText ("int c;");
+            sourceDir.getChildFile ("sub/b.cpp").create();
+            sourceDir.getChildFile ("sub/b.cpp").replaceWithText ("int b;");
+            sourceDir.getChildFile ("sub/b.h").replaceWithText ("extern int b;");
+
+            const File outputDir (sourceDir.getChildFile ("unity"));
+            outputDir.createDirectory();
+
+            UnityBuilder builder;
+            builder.setDestinationFile (outputDir);
+            builder.setFilesToIgnore ({ outputDir });
+            builder.setNumChunks (2);
+            builder.setIncremental (true);
+
+            expect (builder.processDirectory (sourceDir));
+            expectEquals (builder.getChangedChunks().size(), 2);
+            expect (outputDir.getChildFile ("UnityBuild0.cpp").existsAsFile());
+            expect (outputDir.getChildFile ("UnityBuild1.cpp").existsAsFile());
+
+            expect (builder.processDirectory (sourceDir));
+            expectEquals (builder.getChangedChunks().size(), 0);
+
+            sourceDir.getChildFile ("a.cpp").replaceWithText ("#include \"a.inl\"\nint a = 1;");
+            expect (builder.processDirectory (sourceDir));
+            expectEquals (builder.getChangedChunks().size(), 1);
+            expect (! outputDir.getChildFile ("UnityBuild(2).cpp").exists());
+
+            // files included by a source only affect its chunk
+            sourceDir.getChildFile ("a.inl").replaceWithText ("int c = 1;");
+            expect (builder.processDirectory (sourceDir));
+            expectEquals (builder.getChangedChunks().size(), 1);
+
+            // but every chunk includes the headers
+            sourceDir.getChildFile ("sub/b.h").replaceWithText ("extern int b, d;");
+            expect (builder.processDirectory (sourceDir));
+            expectEquals (builder.getChangedChunks().size(), 2);
+
+            // chunks that are no longer used should be removed
+            builder.setNumChunks (1);
+            expect (builder.processDirectory (sourceDir));
+            expect (outputDir.getChildFile ("UnityBuild.cpp").existsAsFile());
+            expect (! outputDir.getChildFile ("UnityBuild0.cpp").exists());
+            expect (! outputDir.getChildFile ("UnityBuild1.cpp").exists());
+
+            sourceDir.deleteRecursively();
+        }
+    }
+
+private:
+    static double getChunkCost (const Array<double>& costs, const Array<int>& chunks, int chunk)
+    {
+        double total = 0.0;
+
+        for (int i = 0; i < costs.size(); ++i)
+            if (chunks[i] == chunk)
+                total += costs[i];
+
+        return total;
+    }
+};
+
+static UnityBuilderTests unityBuilderTests;
+
+#endif // DROWAUDIO_UNIT_TESTS
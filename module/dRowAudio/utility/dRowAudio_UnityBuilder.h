@@ -42,6 +42,14 @@
     speed up build times.
 
     If you need to set custom defines or pragmas use the setPreAndPostString method.
+
+    The sources can be split between several cpp files, or chunks, which are
+    balanced by their compile cost so they can be built in parallel. In incremental
+    mode the output files keep the same names between runs and are only rewritten
+    when their contents change, files stay in the same chunk unless they become
+    unbalanced and the hashes and costs of the sources, along with the headers
+    they include, are cached alongside the output. This means a change to the
+    source tree only causes the affected chunks to be recompiled.
 */
 class UnityBuilder
 {
@@ -59,9 +67,14 @@ public:
         and cpp file.
 
         If the destination file has not been set this will generate files in the
-        source directory named UnityBuild.h and UnityBuild.cpp.
-        Note that this will not delete any exisiting files, if the target files
-        already exist non-existent ones will be created with numbers in brackets.
+        source directory named UnityBuild.h and UnityBuild.cpp. If the sources are
+        split into several chunks the cpp files will be named UnityBuild0.cpp,
+        UnityBuild1.cpp etc.
+        Note that unless incremental mode is on this will not delete any exisiting
+        files, if the target files already exist non-existent ones will be created
+        with numbers in brackets.
+
+        The directory is scanned and the files hashed on several threads.
 
         @param sourceDirectory  The source directory to "unify".
     */
@@ -94,11 +107,75 @@ public:
     void setPreAndPostString (const juce::String& preInclusionString,
                               const juce::String& postInclusionString);
 
+    //==============================================================================
+    /** Sets the number of cpp files to split the sources between.
+        The sources are balanced between them by their compile cost.
+        By default this is 1.
+    */
+    void setNumChunks (int numChunks);
+
+    /** Turns incremental mode on or off.
+
+        In incremental mode the output files are overwritten rather than new ones
+        being created, but only if their contents have changed, and any chunks left
+        over from a run with more of them are deleted. The hashes and costs of the
+        source files and the files they include are stored in a .unitycache file
+        next to the output so changes can be detected on the next run.
+    */
+    void setIncremental (bool shouldBeIncremental);
+
+    /** Sets the measured cost of compiling a source file, e.g. its compile time.
+
+        Files without a measured cost are estimated from their size. Measured costs
+        are kept in the cache until the file's contents change.
+    */
+    void setCompileCost (const juce::File& sourceFile, double cost);
+
+    /** Returns the cpp files whose inputs changed in the last call to processDirectory().
+        These are the chunks that need to be recompiled, either because one of their
+        sources or a file that they #include has changed. As every chunk includes the
+        unity header an edit to any header in the tree changes all of them. In
+        non-incremental mode this will be all of them.
+    */
+    const juce::Array<juce::File>& getChangedChunks() const noexcept    { return changedChunks; }
+
+    //==============================================================================
+    /** Assigns a number of files to chunks so their costs are balanced.
+
+        Files keep their previous chunk where possible to avoid invalidating other
+        chunks, new files are added to the cheapest chunks and everything is only
+        rebalanced if the most expensive chunk becomes too costly.
+
+        @param costs            The cost of each file.
+        @param previousChunks   The chunk each file was in previously or -1 for new files.
+        @param numChunks        The number of chunks to split the files between.
+        @returns                The chunk index for each file.
+    */
+    static juce::Array<int> assignChunks (const juce::Array<double>& costs,
+                                          const juce::Array<int>& previousChunks,
+                                          int numChunks);
+
+    /** Returns the paths of the files #included by a unity file. */
+    static juce::StringArray readIncludes (const juce::File& unityFile);
+
+    /** Replaces the contents of a file only if they're different.
+        @returns true if the file was written
+    */
+    static bool replaceFileIfChanged (const juce::File& file, const juce::String& newContents);
+
 private:
     //==============================================================================
     juce::String preInclusionString, postInclusionString;
     juce::Array<juce::File> filesToIgnore;
     juce::File destinationFile;
+    int numChunks;
+    bool incremental;
+    juce::HashMap<juce::String, double> measuredCosts;
+    juce::Array<juce::File> changedChunks;
+
+    //==============================================================================
+    juce::Array<juce::File> findFiles (const juce::File& sourceDirectory) const;
+    bool shouldIgnore (const juce::File& file) const;
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (UnityBuilder)
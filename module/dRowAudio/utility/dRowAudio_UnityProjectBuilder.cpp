@@ -167,35 +167,64 @@ Array<File> UnityProjectBuilder::buildUnityCpp (const File& destDir)
     if (filesToAdd.size() == 0)
         return files;
 
-    const int filesPerUnityFile = (int) std::ceil (filesToAdd.size() / (float) numFiles);
+    // balance the files by size, keeping them in the same files as the last run where possible
+    Array<double> costs;
+    Array<int> previousFiles;
+
+    for (auto& path : filesToAdd)
+    {
+        costs.add ((double) destDir.getChildFile (path).getSize());
+        previousFiles.add (-1);
+    }
 
     for (int i = 0; i < numFiles; ++i)
     {
-        const int start = i * filesPerUnityFile;
-        const int end = jmin (filesToAdd.size(), start + filesPerUnityFile);
+        const StringArray includes (UnityBuilder::readIncludes (getUnityCppFile (destDir, i)));
 
-        files.add (buildUnityCpp (destDir, i, Range<int> (start, end)));
+        for (int f = 0; f < filesToAdd.size(); ++f)
+            if (includes.contains (filesToAdd[f]))
+                previousFiles.set (f, i);
+    }
+
+    const Array<int> unityFiles (UnityBuilder::assignChunks (costs, previousFiles, numFiles));
+
+    for (int i = 0; i < numFiles; ++i)
+    {
+        StringArray unityFilesToAdd;
+
+        for (int f = 0; f < filesToAdd.size(); ++f)
+            if (unityFiles[f] == i)
+                unityFilesToAdd.add (filesToAdd[f]);
+
+        files.add (buildUnityCpp (destDir, i, unityFilesToAdd));
     }
 
     return files;
 }
 
-File UnityProjectBuilder::buildUnityCpp (const File& destDir, int unityNum, const Range<int> fileRange)
+File UnityProjectBuilder::buildUnityCpp (const File& destDir, int unityNum, const StringArray& unityFilesToAdd)
 {
-    const File cppFile (destDir.getChildFile (unityName + juce::String (unityNum)).withFileExtension (".cpp"));
-    logOutput ("Building Unity cpp file \"" + cppFile.getFullPathName() + "\"...");
+    const File cppFile (getUnityCppFile (destDir, unityNum));
 
-    if (cppFile.existsAsFile())
-        cppFile.deleteFile();
+    juce::String output;
 
-    FileOutputStream s (cppFile);
+    for (auto& path : unityFilesToAdd)
+        output << "#include \"" << path << "\"" << newLine;
 
-    for (int i = fileRange.getStart(); i < fileRange.getEnd(); ++i)
-        s << "#include \"" << filesToAdd[i] << "\"" << newLine;
+    // leave unchanged files alone so they don't get rebuilt
+    if (UnityBuilder::replaceFileIfChanged (cppFile, output))
+        logOutput ("Building Unity cpp file \"" + cppFile.getFullPathName() + "\"...");
+    else
+        logOutput ("Unity cpp file \"" + cppFile.getFullPathName() + "\" is up to date");
 
     return cppFile;
 }
 
+File UnityProjectBuilder::getUnityCppFile (const File& destDir, int unityNum) const
+{
+    return destDir.getChildFile (unityName + juce::String (unityNum)).withFileExtension (".cpp");
+}
+
 void UnityProjectBuilder::updateBuildDirectories()
 {
     if (buildDir.isEmpty())
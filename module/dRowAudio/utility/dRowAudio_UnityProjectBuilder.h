@@ -63,6 +63,10 @@ public:
     /** Optionally sets a number of files to split the unity build into. This could
         speed up compile times on multicore CPUs. A good idea might be to set
         SystemStats::getNumCpus()
+
+        Source files are balanced between the unity files by size and stay in the
+        same one between runs where possible. Unity files are only rewritten if
+        their contents change so unaffected ones won't need to be recompiled.
     */
     void setNumFilesToSplitBetween (int numFiles);
 
@@ -105,7 +109,8 @@ private:
     void recurseGroup (juce::ValueTree group, const juce::File& sourceDir);
     void parseFile (juce::ValueTree file, const juce::File& sourceDir);
     juce::Array<juce::File> buildUnityCpp (const juce::File& destDir);
-    juce::File buildUnityCpp (const juce::File& destDir, int unityNum, const juce::Range<int> fileRange);
+    juce::File buildUnityCpp (const juce::File& destDir, int unityNum, const juce::StringArray& unityFilesToAdd);
+    juce::File getUnityCppFile (const juce::File& destDir, int unityNum) const;
     void updateBuildDirectories();
     void logOutput (const juce::String& output);
 